@@ -0,0 +1,269 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+/**
+ * A single chunk of arena memory. Chunks are chained in allocation order,
+ * and every chunk after the current one is free for reuse.
+ */
+typedef struct LsArenaChunk {
+        struct LsArenaChunk *next;
+        size_t size;        /**<Usable bytes in data */
+        size_t used;        /**<Bytes handed out so far */
+        max_align_t data[]; /**<Storage, aligned for any type */
+} LsArenaChunk;
+
+/**
+ * Opaque LsArena implementation
+ */
+struct LsArena {
+        LsArenaChunk *first;   /**<Oldest chunk */
+        LsArenaChunk *current; /**<Chunk we're bump allocating from */
+        size_t chunk_size;     /**<Size of regular chunks */
+        LsAllocator allocator; /**<Exposes the arena to containers */
+};
+
+/**
+ * LsAllocator glue, the arena has no per-allocation free
+ */
+static void *ls_arena_allocator_alloc(void *context, size_t size)
+{
+        return ls_arena_alloc(context, size);
+}
+
+static void *ls_arena_allocator_realloc(void *context, void *ptr, size_t old_size,
+                                        size_t new_size)
+{
+        return ls_arena_realloc(context, ptr, old_size, new_size);
+}
+
+LsArena *ls_arena_new(size_t chunk_size)
+{
+        LsArena *ret = NULL;
+
+        ret = calloc(1, sizeof(struct LsArena));
+        if (!ret) {
+                return NULL;
+        }
+        ret->chunk_size = chunk_size ? chunk_size : LS_ARENA_DEFAULT_CHUNK_SIZE;
+        ret->allocator = (LsAllocator){
+                .alloc = ls_arena_allocator_alloc,
+                .realloc = ls_arena_allocator_realloc,
+                .free = NULL,
+                .context = ret,
+        };
+        return ret;
+}
+
+const LsAllocator *ls_arena_allocator(LsArena *self)
+{
+        return &self->allocator;
+}
+
+void ls_arena_free(LsArena *self)
+{
+        LsArenaChunk *next = NULL;
+
+        if (ls_unlikely(!self)) {
+                return;
+        }
+
+        for (LsArenaChunk *chunk = self->first; chunk; chunk = next) {
+                next = chunk->next;
+                free(chunk);
+        }
+        free(self);
+}
+
+/**
+ * Try to carve @size bytes at @alignment from the chunk
+ */
+static inline void *ls_arena_chunk_take(LsArenaChunk *chunk, size_t size, size_t alignment)
+{
+        uintptr_t base = (uintptr_t)chunk->data;
+        uintptr_t start = (base + chunk->used + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        size_t offset = (size_t)(start - base);
+
+        if (offset > chunk->size || chunk->size - offset < size) {
+                return NULL;
+        }
+        chunk->used = offset + size;
+        return (void *)start;
+}
+
+void *ls_arena_alloc_aligned(LsArena *self, size_t size, size_t alignment)
+{
+        LsArenaChunk *chunk = NULL;
+        LsArenaChunk *last = NULL;
+        void *ret = NULL;
+        size_t chunk_size;
+
+        if (ls_unlikely(!self || alignment == 0 || (alignment & (alignment - 1)) != 0)) {
+                return NULL;
+        }
+
+        /* Walk forward through chunks retained by a rewind or reset */
+        for (chunk = self->current; chunk; chunk = chunk->next) {
+                if (chunk != self->current) {
+                        chunk->used = 0;
+                }
+                ret = ls_arena_chunk_take(chunk, size, alignment);
+                if (ret) {
+                        self->current = chunk;
+                        return ret;
+                }
+                last = chunk;
+        }
+
+        /* Out of space, so chain a new chunk big enough for this request */
+        chunk_size = self->chunk_size;
+        if (size > SIZE_MAX - alignment) {
+                return NULL;
+        }
+        if (chunk_size < size + alignment) {
+                chunk_size = size + alignment;
+        }
+
+        chunk = malloc(sizeof(LsArenaChunk) + chunk_size);
+        if (!chunk) {
+                return NULL;
+        }
+        chunk->next = NULL;
+        chunk->size = chunk_size;
+        chunk->used = 0;
+
+        if (last) {
+                last->next = chunk;
+        } else {
+                self->first = chunk;
+        }
+        self->current = chunk;
+
+        return ls_arena_chunk_take(chunk, size, alignment);
+}
+
+void *ls_arena_alloc(LsArena *self, size_t size)
+{
+        return ls_arena_alloc_aligned(self, size, _Alignof(max_align_t));
+}
+
+void *ls_arena_alloc0(LsArena *self, size_t size)
+{
+        void *ret = ls_arena_alloc(self, size);
+
+        if (ret) {
+                memset(ret, 0, size);
+        }
+        return ret;
+}
+
+void *ls_arena_realloc(LsArena *self, void *ptr, size_t old_size, size_t new_size)
+{
+        LsArenaChunk *chunk = NULL;
+        void *ret = NULL;
+
+        if (ls_unlikely(!self)) {
+                return NULL;
+        }
+        if (!ptr) {
+                return ls_arena_alloc(self, new_size);
+        }
+
+        /* The most recent allocation can simply move the bump pointer */
+        chunk = self->current;
+        if (chunk && (char *)ptr + old_size == (char *)chunk->data + chunk->used) {
+                size_t offset = (size_t)((char *)ptr - (char *)chunk->data);
+                if (new_size <= chunk->size - offset) {
+                        chunk->used = offset + new_size;
+                        return ptr;
+                }
+        }
+
+        if (new_size <= old_size) {
+                return ptr;
+        }
+
+        ret = ls_arena_alloc(self, new_size);
+        if (ret) {
+                memcpy(ret, ptr, old_size);
+        }
+        return ret;
+}
+
+LsArenaSavepoint ls_arena_save(LsArena *self)
+{
+        LsArenaSavepoint ret = { 0 };
+
+        if (ls_likely(self && self->current)) {
+                ret.chunk = self->current;
+                ret.used = self->current->used;
+        }
+        return ret;
+}
+
+void ls_arena_rewind(LsArena *self, LsArenaSavepoint savepoint)
+{
+        LsArenaChunk *chunk = savepoint.chunk;
+
+        if (ls_unlikely(!self)) {
+                return;
+        }
+
+        /* Saved before the first allocation */
+        if (!chunk) {
+                ls_arena_reset(self);
+                return;
+        }
+
+        chunk->used = savepoint.used;
+        self->current = chunk;
+}
+
+void ls_arena_reset(LsArena *self)
+{
+        if (ls_unlikely(!self)) {
+                return;
+        }
+
+        self->current = self->first;
+        if (self->current) {
+                self->current->used = 0;
+        }
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
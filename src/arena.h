@@ -0,0 +1,132 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "macros.h"
+
+/**
+ * LsArena is a chunked bump allocator. Allocations are carved linearly
+ * out of large chunks and are never freed individually. Instead, the
+ * whole arena is rewound to a savepoint or reset in one go, making it
+ * ideal for data sharing a lifetime, such as everything loaded for a
+ * level or built for a single request.
+ *
+ * Chunks are kept across resets and reused, so a steady state workload
+ * stops touching the system allocator entirely.
+ */
+typedef struct LsArena LsArena;
+
+/**
+ * LsArenaSavepoint records the allocation position of an arena, so that
+ * everything allocated after it can be released at once.
+ */
+typedef struct LsArenaSavepoint {
+        void *chunk;
+        size_t used;
+} LsArenaSavepoint;
+
+/**
+ * Chunk size used when 0 is passed to ls_arena_new
+ */
+#define LS_ARENA_DEFAULT_CHUNK_SIZE (64 * 1024)
+
+/**
+ * Construct a new LsArena
+ *
+ * @param chunk_size Size of each chunk, or 0 for the default. Larger
+ *                   allocations get a dedicated chunk.
+ *
+ * @note Free with ls_arena_free
+ */
+LsArena *ls_arena_new(size_t chunk_size);
+
+/**
+ * Free the arena and every chunk it owns, invalidating all allocations
+ */
+void ls_arena_free(LsArena *arena);
+
+/**
+ * Allocate @size bytes, aligned for any type. The memory is uninitialised.
+ */
+void *ls_arena_alloc(LsArena *arena, size_t size);
+
+/**
+ * Allocate @size zeroed bytes, aligned for any type
+ */
+void *ls_arena_alloc0(LsArena *arena, size_t size);
+
+/**
+ * Allocate @size bytes with the given power of two @alignment
+ */
+void *ls_arena_alloc_aligned(LsArena *arena, size_t size, size_t alignment);
+
+/**
+ * Resize an allocation. The most recent allocation is grown or shrunk in
+ * place when there is room, otherwise a new block is allocated and the
+ * contents copied. The old block is not reclaimed until the arena is
+ * rewound or reset.
+ *
+ * @param ptr Previous allocation, or NULL
+ * @param old_size Size of the previous allocation
+ * @param new_size Requested size
+ */
+void *ls_arena_realloc(LsArena *arena, void *ptr, size_t old_size, size_t new_size);
+
+/**
+ * Return an LsAllocator drawing from @arena, valid for the lifetime of the
+ * arena. Its free is a no-op, so containers built on it skip walking their
+ * storage when freed.
+ */
+const LsAllocator *ls_arena_allocator(LsArena *arena);
+
+/**
+ * Record the current allocation position
+ */
+LsArenaSavepoint ls_arena_save(LsArena *arena);
+
+/**
+ * Release everything allocated since @savepoint was taken. Savepoints
+ * taken after @savepoint become invalid.
+ */
+void ls_arena_rewind(LsArena *arena, LsArenaSavepoint savepoint);
+
+/**
+ * Release every allocation in O(1), keeping the chunks for reuse
+ */
+void ls_arena_reset(LsArena *arena);
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -21,28 +21,122 @@
  * 3. This notice may not be removed or altered from any source distribution.
  */
 
+#include "config.h"
+
+#include <string.h>
+
 #include "array.h"
 
+/**
+ * Runs of items handed to each thread when picking a grain
+ */
+#define LS_ARRAY_RUNS_PER_THREAD 4
+
+/**
+ * Each reduce accumulator gets whole cache lines to itself, so workers
+ * folding neighbouring runs never write to the same line
+ */
+#define LS_ARRAY_CACHE_LINE 64
+
+/**
+ * Heap storage is only accounted when built with `with-stats`, so that
+ * the default build pays nothing for it.
+ */
+#ifdef LS_ENABLE_STATS
+#define ls_array_account(allocator, op, size)                                                      \
+        do {                                                                                       \
+                if (!(allocator)) {                                                                \
+                        ls_memory_account_##op(LS_MEMORY_TYPE_ARRAY, size);                        \
+                }                                                                                  \
+        } while (0)
+#else
+#define ls_array_account(allocator, op, size)                                                      \
+        do {                                                                                       \
+        } while (0)
+#endif
+
 LsArray *ls_array_new(size_t item_size)
 {
         return ls_array_new_size(item_size, 0);
 }
 
 LsArray *ls_array_new_size(size_t item_size, uint16_t reserved)
+{
+        return ls_array_new_with_allocator(NULL, item_size, reserved);
+}
+
+LsArray *ls_array_new_arena(LsArena *arena, size_t item_size, uint16_t reserved)
+{
+        return ls_array_new_with_allocator(ls_arena_allocator(arena), item_size, reserved);
+}
+
+LsArray *ls_array_new_frame(LsFrameAllocator *frame, size_t item_size, uint16_t reserved)
+{
+        return ls_array_new_with_allocator(ls_frame_allocator_allocator(frame),
+                                           item_size,
+                                           reserved);
+}
+
+/**
+ * Allocate zeroed storage through the array's allocator
+ */
+static inline void *ls_array_alloc0(const LsAllocator *allocator, size_t size)
+{
+        void *ret = ls_allocator_alloc0(allocator, size);
+
+        if (ret) {
+                ls_array_account(allocator, alloc, size);
+        }
+        return ret;
+}
+
+/**
+ * Release storage of @size bytes through the array's allocator
+ */
+static inline void ls_array_release(const LsAllocator *allocator, void *ptr, size_t size)
+{
+        if (ptr) {
+                ls_array_account(allocator, free, size);
+        }
+        ls_allocator_free(allocator, ptr, size);
+}
+
+/**
+ * Resize the data blob through the array's allocator
+ */
+static inline void **ls_array_realloc(LsArray *self, size_t new_size)
+{
+        void **ret = ls_allocator_realloc(self->allocator,
+                                          self->data,
+                                          self->item_size * self->size,
+                                          self->item_size * new_size);
+
+        if (ret) {
+                if (self->data) {
+                        ls_array_account(self->allocator, free, self->item_size * self->size);
+                }
+                ls_array_account(self->allocator, alloc, self->item_size * new_size);
+        }
+        return ret;
+}
+
+LsArray *ls_array_new_with_allocator(const LsAllocator *allocator, size_t item_size,
+                                     uint16_t reserved)
 {
         LsArray *ret = NULL;
 
-        ret = calloc(1, sizeof(struct LsArray));
+        ret = ls_array_alloc0(allocator, sizeof(struct LsArray));
         if (!ret) {
                 return NULL;
         }
         ret->item_size = item_size;
+        ret->allocator = allocator;
 
         /* Try to reserve the data. */
         if (reserved > 0) {
-                ret->data = calloc(reserved, item_size);
+                ret->data = ls_array_alloc0(allocator, reserved * item_size);
                 if (!ret->data) {
-                        free(ret);
+                        ls_array_release(allocator, ret, sizeof(struct LsArray));
                         return NULL;
                 }
         }
@@ -62,7 +156,7 @@ bool ls_array_add(LsArray *self, void *data)
 
         /* First allocation of data blob */
         if (ls_unlikely(!self->data)) {
-                self->data = calloc(1, self->item_size);
+                self->data = ls_array_alloc0(self->allocator, self->item_size);
                 if (!self->data) {
                         return false;
                 }
@@ -71,7 +165,7 @@ bool ls_array_add(LsArray *self, void *data)
 
         /* Or do we need to resize? */
         if (new_size > self->size) {
-                self->data = realloc(self->data, self->item_size * new_size);
+                self->data = ls_array_realloc(self, new_size);
                 if (!self->data) {
                         return false;
                 }
@@ -100,8 +194,373 @@ void ls_array_free(LsArray *self, ls_free_func freer)
         }
 
 cleanup_array:
-        free(self->data);
-        free(self);
+        ls_array_release(self->allocator, self->data, self->item_size * self->size);
+        ls_array_release(self->allocator, self, sizeof(struct LsArray));
+}
+
+bool ls_array_memory_usage(LsArray *self, LsMemoryUsage *usage)
+{
+        if (ls_unlikely(!self || !usage)) {
+                return false;
+        }
+
+        usage->used = self->item_size * self->len;
+        usage->reserved = self->item_size * self->size;
+        usage->overhead = sizeof(struct LsArray);
+        return true;
+}
+
+const void *ls_array_view_search(const LsArrayView *view, const void *key,
+                                 ls_compare_func compare)
+{
+        if (ls_unlikely(!view || !view->data || !compare)) {
+                return NULL;
+        }
+        return bsearch(key, view->data, view->len, view->item_size, compare);
+}
+
+/**
+ * Shared state of a parallel pass over an array, split into runs of
+ * grain items
+ */
+typedef struct LsArrayParallel {
+        LsArray *self;
+        size_t grain;
+        void *user_data;
+        ls_array_foreach_func foreach;
+        ls_array_reduce_func reduce;
+        ls_array_filter_func filter;
+        char *partials; /**<One accumulator per run, for reduce */
+        size_t stride;  /**<Cache line padded size of each accumulator */
+        uint8_t *keep;  /**<Per item verdict, for filter */
+        size_t *counts; /**<Survivors per run, then output offsets */
+        LsArray *out;
+} LsArrayParallel;
+
+/**
+ * Resolve the job system and grain for a parallel pass
+ */
+static LsJobSystem *ls_array_parallel_init(LsArrayParallel *parallel, LsJobSystem *system,
+                                           LsArray *self, size_t grain, void *user_data)
+{
+        if (!system) {
+                system = ls_job_system_get_default();
+                if (ls_unlikely(!system)) {
+                        return NULL;
+                }
+        }
+
+        if (grain == 0) {
+                size_t n_runs =
+                    (size_t)(ls_job_system_n_workers(system) + 1) * LS_ARRAY_RUNS_PER_THREAD;
+                grain = (self->len + n_runs - 1) / n_runs;
+        }
+
+        memset(parallel, 0, sizeof(*parallel));
+        parallel->self = self;
+        parallel->grain = grain > 0 ? grain : 1;
+        parallel->user_data = user_data;
+        return system;
+}
+
+/**
+ * Number of runs the array is split into
+ */
+static inline size_t ls_array_parallel_runs(LsArrayParallel *parallel)
+{
+        return (parallel->self->len + parallel->grain - 1) / parallel->grain;
+}
+
+/**
+ * Bounds of the run @run
+ */
+static inline void ls_array_parallel_run_bounds(LsArrayParallel *parallel, size_t run,
+                                                size_t *begin, size_t *end)
+{
+        *begin = run * parallel->grain;
+        *end = *begin + parallel->grain;
+        if (*end > parallel->self->len) {
+                *end = parallel->self->len;
+        }
+}
+
+static void ls_array_parallel_foreach_range(void *v, size_t begin, size_t end)
+{
+        LsArrayParallel *parallel = v;
+
+        for (size_t i = begin; i < end; i++) {
+                parallel->foreach(parallel->self->data[i], parallel->user_data);
+        }
+}
+
+bool ls_array_parallel_foreach(LsJobSystem *system, LsArray *self, size_t grain,
+                               ls_array_foreach_func func, void *user_data)
+{
+        LsArrayParallel parallel;
+
+        if (ls_unlikely(!self || !func)) {
+                return false;
+        }
+
+        system = ls_array_parallel_init(&parallel, system, self, grain, user_data);
+        if (ls_unlikely(!system)) {
+                return false;
+        }
+        parallel.foreach = func;
+
+        ls_job_system_parallel_for(system,
+                                   0,
+                                   self->len,
+                                   parallel.grain,
+                                   ls_array_parallel_foreach_range,
+                                   &parallel);
+        return true;
+}
+
+/**
+ * Fold each run in [begin, end) into its own accumulator
+ */
+static void ls_array_parallel_reduce_runs(void *v, size_t begin, size_t end)
+{
+        LsArrayParallel *parallel = v;
+
+        for (size_t run = begin; run < end; run++) {
+                void *accumulator = parallel->partials + run * parallel->stride;
+                size_t first = 0;
+                size_t last = 0;
+
+                ls_array_parallel_run_bounds(parallel, run, &first, &last);
+                for (size_t i = first; i < last; i++) {
+                        parallel->reduce(accumulator, parallel->self->data[i], parallel->user_data);
+                }
+        }
+}
+
+bool ls_array_parallel_reduce(LsJobSystem *system, LsArray *self, size_t grain, void *result,
+                              size_t result_size, ls_array_reduce_func reduce,
+                              ls_array_combine_func combine, void *user_data)
+{
+        LsArrayParallel parallel;
+        size_t n_runs = 0;
+
+        if (ls_unlikely(!self || !result || result_size == 0 || !reduce || !combine)) {
+                return false;
+        }
+
+        system = ls_array_parallel_init(&parallel, system, self, grain, user_data);
+        if (ls_unlikely(!system)) {
+                return false;
+        }
+        parallel.reduce = reduce;
+
+        n_runs = ls_array_parallel_runs(&parallel);
+        if (n_runs == 0) {
+                return true;
+        }
+
+        /* Pad each accumulator to its own cache lines, every one starting
+         * as the identity */
+        parallel.stride =
+            (result_size + LS_ARRAY_CACHE_LINE - 1) & ~(size_t)(LS_ARRAY_CACHE_LINE - 1);
+        parallel.partials = aligned_alloc(LS_ARRAY_CACHE_LINE, n_runs * parallel.stride);
+        if (ls_unlikely(!parallel.partials)) {
+                return false;
+        }
+        for (size_t run = 0; run < n_runs; run++) {
+                memcpy(parallel.partials + run * parallel.stride, result, result_size);
+        }
+
+        ls_job_system_parallel_for(system,
+                                   0,
+                                   n_runs,
+                                   1,
+                                   ls_array_parallel_reduce_runs,
+                                   &parallel);
+
+        for (size_t run = 0; run < n_runs; run++) {
+                combine(result, parallel.partials + run * parallel.stride, user_data);
+        }
+
+        free(parallel.partials);
+        return true;
+}
+
+/**
+ * First filter pass: test every item and count the survivors of each run
+ */
+static void ls_array_parallel_filter_count(void *v, size_t begin, size_t end)
+{
+        LsArrayParallel *parallel = v;
+
+        for (size_t run = begin; run < end; run++) {
+                size_t first = 0;
+                size_t last = 0;
+                size_t count = 0;
+
+                ls_array_parallel_run_bounds(parallel, run, &first, &last);
+                for (size_t i = first; i < last; i++) {
+                        bool keep = parallel->filter(parallel->self->data[i], parallel->user_data);
+                        parallel->keep[i] = keep;
+                        count += keep;
+                }
+                parallel->counts[run] = count;
+        }
+}
+
+/**
+ * Second filter pass: copy each run's survivors to its output offset
+ */
+static void ls_array_parallel_filter_copy(void *v, size_t begin, size_t end)
+{
+        LsArrayParallel *parallel = v;
+
+        for (size_t run = begin; run < end; run++) {
+                size_t first = 0;
+                size_t last = 0;
+                size_t offset = parallel->counts[run];
+
+                ls_array_parallel_run_bounds(parallel, run, &first, &last);
+                for (size_t i = first; i < last; i++) {
+                        if (parallel->keep[i]) {
+                                parallel->out->data[offset++] = parallel->self->data[i];
+                        }
+                }
+        }
+}
+
+LsArray *ls_array_parallel_filter(LsJobSystem *system, LsArray *self, size_t grain,
+                                  ls_array_filter_func func, void *user_data)
+{
+        LsArrayParallel parallel;
+        size_t n_runs = 0;
+        size_t total = 0;
+
+        if (ls_unlikely(!self || !func)) {
+                return NULL;
+        }
+
+        system = ls_array_parallel_init(&parallel, system, self, grain, user_data);
+        if (ls_unlikely(!system)) {
+                return NULL;
+        }
+        parallel.filter = func;
+
+        n_runs = ls_array_parallel_runs(&parallel);
+        if (n_runs == 0) {
+                return ls_array_new_with_allocator(self->allocator, self->item_size, 0);
+        }
+
+        parallel.keep = malloc(self->len);
+        parallel.counts = malloc(n_runs * sizeof(size_t));
+        if (ls_unlikely(!parallel.keep || !parallel.counts)) {
+                goto cleanup;
+        }
+
+        ls_job_system_parallel_for(system,
+                                   0,
+                                   n_runs,
+                                   1,
+                                   ls_array_parallel_filter_count,
+                                   &parallel);
+
+        /* Exclusive prefix sum turns the counts into output offsets */
+        for (size_t run = 0; run < n_runs; run++) {
+                size_t count = parallel.counts[run];
+                parallel.counts[run] = total;
+                total += count;
+        }
+
+        parallel.out =
+            ls_array_new_with_allocator(self->allocator, self->item_size, (uint16_t)total);
+        if (ls_unlikely(!parallel.out)) {
+                goto cleanup;
+        }
+
+        if (total > 0) {
+                ls_job_system_parallel_for(system,
+                                           0,
+                                           n_runs,
+                                           1,
+                                           ls_array_parallel_filter_copy,
+                                           &parallel);
+        }
+        parallel.out->len = (uint16_t)total;
+
+cleanup:
+        free(parallel.counts);
+        free(parallel.keep);
+        return parallel.out;
+}
+
+bool ls_array_save(LsArray *self, const char *path, ls_snapshot_write_func item_write)
+{
+        LsSnapshotWriter *writer = NULL;
+        bool ret = false;
+
+        if (ls_unlikely(!self || !path || !item_write)) {
+                return false;
+        }
+
+        writer = ls_snapshot_writer_new(LS_SNAPSHOT_KIND_ARRAY, 0);
+        if (!writer) {
+                return false;
+        }
+
+        for (uint16_t i = 0; i < self->len; i++) {
+                if (!ls_snapshot_writer_put_item(writer, item_write, self->data[i])) {
+                        goto cleanup;
+                }
+        }
+
+        ret = ls_snapshot_writer_commit(writer, self->len, path);
+
+cleanup:
+        ls_snapshot_writer_free(writer);
+        return ret;
+}
+
+bool ls_array_load(LsArray *self, const char *path, ls_snapshot_read_func item_read)
+{
+        LsSnapshotReader reader = { 0 };
+        bool ret = false;
+
+        if (ls_unlikely(!self || !path || !item_read)) {
+                return false;
+        }
+
+        if (!ls_snapshot_reader_open(&reader, path, LS_SNAPSHOT_KIND_ARRAY)) {
+                return false;
+        }
+
+        if (reader.count > (uint64_t)(UINT16_MAX - self->len)) {
+                goto cleanup;
+        }
+
+        /* Reserve everything at once rather than growing per item */
+        if (self->len + reader.count > self->size) {
+                uint16_t new_size = (uint16_t)(self->len + reader.count);
+                void **data = ls_array_realloc(self, new_size);
+                if (!data) {
+                        goto cleanup;
+                }
+                self->data = data;
+                self->size = new_size;
+        }
+
+        for (uint64_t i = 0; i < reader.count; i++) {
+                void *item = NULL;
+
+                if (!ls_snapshot_reader_get_item(&reader, item_read, &item)) {
+                        goto cleanup;
+                }
+                self->data[self->len++] = item;
+        }
+
+        ret = true;
+
+cleanup:
+        ls_snapshot_reader_close(&reader);
+        return ret;
 }
 
 /*
@@ -30,7 +30,12 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include "arena.h"
+#include "frame-allocator.h"
+#include "job-system.h"
 #include "macros.h"
+#include "memory-usage.h"
+#include "snapshot.h"
 
 /**
  * LsArray is a dynamically growing array that allows items to sit
@@ -46,12 +51,24 @@
  *
  */
 typedef struct LsArray {
-        uint16_t len;     /*< Current length */
-        uint16_t size;    /*< Current allocated size */
-        size_t item_size; /*< Size of each allocated item. */
-        void **data;      /*<Blob to access data */
+        uint16_t len;                 /*< Current length */
+        uint16_t size;                /*< Current allocated size */
+        size_t item_size;             /*< Size of each allocated item. */
+        void **data;                  /*<Blob to access data */
+        const LsAllocator *allocator; /*<Source of storage, NULL for the heap */
 } LsArray;
 
+/**
+ * LsArrayView is a read-only window over contiguous fixed-size records
+ * held by value, such as a table inside a memory-mapped file. It owns
+ * nothing, and is only valid as long as the memory it points into.
+ */
+typedef struct LsArrayView {
+        const void *data; /**<First record */
+        size_t item_size; /**<Size of each record */
+        size_t len;       /**<Number of records */
+} LsArrayView;
+
 /**
  * Construct a new LsArray with no pre-allocated member regions
  */
@@ -63,6 +80,27 @@ LsArray *ls_array_new(size_t item_size);
  */
 LsArray *ls_array_new_size(size_t item_size, uint16_t reserved);
 
+/**
+ * Construct a new LsArray whose header and storage are obtained from
+ * @allocator, which must outlive the array. A NULL allocator is identical
+ * to ls_array_new_size.
+ */
+LsArray *ls_array_new_with_allocator(const LsAllocator *allocator, size_t item_size,
+                                     uint16_t reserved);
+
+/**
+ * Construct a new LsArray whose header and storage live in @arena. The
+ * array is released along with the arena, so ls_array_free will only
+ * call the free function on each item.
+ */
+LsArray *ls_array_new_arena(LsArena *arena, size_t item_size, uint16_t reserved);
+
+/**
+ * Construct a new LsArray in the current frame of @frame. The array is
+ * released when its frame is recycled, so it need never be freed.
+ */
+LsArray *ls_array_new_frame(LsFrameAllocator *frame, size_t item_size, uint16_t reserved);
+
 /**
  * Add a new element of data to the array. It must have the same
  * fixed size as at construction time.
@@ -72,6 +110,122 @@ bool ls_array_add(LsArray *self, void *data);
 
 void ls_array_free(LsArray *self, ls_free_func freer);
 
+/**
+ * Report the memory held by the array itself, not by the items it points
+ * to. Slack capacity shows up as reserved but unused bytes.
+ *
+ * @returns True if the usage could be collected
+ */
+bool ls_array_memory_usage(LsArray *self, LsMemoryUsage *usage);
+
+/**
+ * Point @view at @len records of @item_size bytes starting at @data
+ */
+static inline void ls_array_view_init(LsArrayView *view, const void *data, size_t item_size,
+                                      size_t len)
+{
+        view->data = data;
+        view->item_size = item_size;
+        view->len = len;
+}
+
+/**
+ * Return the record at @index, or NULL if out of range
+ */
+static inline const void *ls_array_view_get(const LsArrayView *view, size_t index)
+{
+        if (ls_unlikely(index >= view->len)) {
+                return NULL;
+        }
+        return (const char *)view->data + index * view->item_size;
+}
+
+/**
+ * Binary search a view whose records are sorted by @compare, which is
+ * called with @key and a record
+ *
+ * @returns The matching record, or NULL if there is none
+ */
+const void *ls_array_view_search(const LsArrayView *view, const void *key,
+                                 ls_compare_func compare);
+
+/**
+ * Called on each item by ls_array_parallel_foreach
+ */
+typedef void (*ls_array_foreach_func)(void *item, void *user_data);
+
+/**
+ * Fold @item into the partial result at @accumulator
+ */
+typedef void (*ls_array_reduce_func)(void *accumulator, void *item, void *user_data);
+
+/**
+ * Fold the partial result @partial into @accumulator
+ */
+typedef void (*ls_array_combine_func)(void *accumulator, const void *partial, void *user_data);
+
+/**
+ * Return true if @item should be kept by ls_array_parallel_filter
+ */
+typedef bool (*ls_array_filter_func)(void *item, void *user_data);
+
+/**
+ * Call @func on every item in the array from the workers of @system, or
+ * the default job system if NULL, and wait for them all to finish.
+ *
+ * Items are handed out in runs of @grain, which should be large enough to
+ * outweigh the cost of a job. A @grain of 0 gives a few runs per worker.
+ *
+ * @returns True if every item was visited
+ */
+bool ls_array_parallel_foreach(LsJobSystem *system, LsArray *self, size_t grain,
+                               ls_array_foreach_func func, void *user_data);
+
+/**
+ * Reduce the array into @result, a value of @result_size bytes that must
+ * hold the identity of the reduction on entry.
+ *
+ * Each run of @grain items is folded with @reduce into its own copy of
+ * the identity, in parallel, and the partial results are then folded
+ * into @result with @combine in array order. The reduction therefore
+ * needs to be associative, but not commutative.
+ *
+ * @returns True if @result holds the reduction of every item
+ */
+bool ls_array_parallel_reduce(LsJobSystem *system, LsArray *self, size_t grain, void *result,
+                              size_t result_size, ls_array_reduce_func reduce,
+                              ls_array_combine_func combine, void *user_data);
+
+/**
+ * Construct a new array, from the same allocator as @self, holding the
+ * items for which @func returns true, in their original order.
+ *
+ * The first pass tests every item in parallel and counts survivors per
+ * run of @grain items. A prefix sum over those counts gives each run its
+ * offset in the output, and the second pass copies survivors in parallel.
+ *
+ * @returns A newly allocated array, or NULL if memory is exhausted
+ */
+LsArray *ls_array_parallel_filter(LsJobSystem *system, LsArray *self, size_t grain,
+                                  ls_array_filter_func func, void *user_data);
+
+/**
+ * Save every item in the array to a snapshot at @path, in order.
+ *
+ * @param item_write Function to serialise each item
+ * @returns True if the snapshot was written
+ */
+bool ls_array_save(LsArray *self, const char *path, ls_snapshot_write_func item_write);
+
+/**
+ * Append every item from the snapshot at @path to the array. Storage for
+ * the whole snapshot is reserved up front.
+ *
+ * @param item_read Function to deserialise each item
+ * @returns True if the entire snapshot was loaded
+ */
+bool ls_array_load(LsArray *self, const char *path, ls_snapshot_read_func item_read);
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
@@ -0,0 +1,263 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "config.h"
+
+#include "atomic-list.h"
+
+/**
+ * Nodes are ordinary heap LsList nodes, handed out by take_all and freed
+ * with ls_list_free, so they are accounted exactly as list.c does when
+ * built with `with-stats`.
+ */
+#ifdef LS_ENABLE_STATS
+#define ls_atomic_list_account(op)                                                                 \
+        ls_memory_account_##op(LS_MEMORY_TYPE_LIST, sizeof(struct LsList))
+#else
+#define ls_atomic_list_account(op)                                                                 \
+        do {                                                                                       \
+        } while (0)
+#endif
+
+/**
+ * The head pointer is paired with a counter that is bumped on every
+ * update, and both are swapped together with a double-width CAS.
+ */
+typedef struct LsAtomicListHead {
+        LsList *node;
+        uintptr_t tag;
+} LsAtomicListHead;
+
+/**
+ * Opaque LsAtomicList implementation
+ */
+struct LsAtomicList {
+        _Atomic LsAtomicListHead head; /**<Tagged head of the stack */
+        atomic_uint poppers;           /**<Threads currently inside pop */
+
+        /**
+         * Popped nodes awaiting reclamation. These are chained through
+         * their data field, as a racing pop may still read their next
+         * pointer.
+         */
+        _Atomic(LsList *) retired;
+};
+
+LsAtomicList *ls_atomic_list_new(void)
+{
+        LsAtomicList *ret = NULL;
+        LsAtomicListHead empty = { NULL, 0 };
+
+        ret = calloc(1, sizeof(struct LsAtomicList));
+        if (!ret) {
+                return NULL;
+        }
+
+        atomic_init(&ret->head, empty);
+        atomic_init(&ret->poppers, 0);
+        atomic_init(&ret->retired, NULL);
+        return ret;
+}
+
+/**
+ * Free a chain of retired nodes, linked through data
+ */
+static void ls_atomic_list_free_retired(LsList *node)
+{
+        LsList *next = NULL;
+
+        for (; node; node = next) {
+                next = node->data;
+                ls_atomic_list_account(free);
+                free(node);
+        }
+}
+
+void ls_atomic_list_free(LsAtomicList *self)
+{
+        ls_atomic_list_free_full(self, NULL);
+}
+
+void ls_atomic_list_free_full(LsAtomicList *self, ls_free_func freer)
+{
+        LsAtomicListHead head;
+
+        if (ls_unlikely(!self)) {
+                return;
+        }
+
+        head = atomic_load(&self->head);
+        if (freer) {
+                ls_list_free_full(head.node, freer);
+        } else {
+                ls_list_free(head.node);
+        }
+        ls_atomic_list_free_retired(atomic_load(&self->retired));
+        free(self);
+}
+
+bool ls_atomic_list_push(LsAtomicList *self, void *data)
+{
+        LsAtomicListHead old;
+        LsAtomicListHead new;
+        LsList *node = NULL;
+
+        if (ls_unlikely(!self)) {
+                return false;
+        }
+
+        node = malloc(sizeof(struct LsList));
+        if (!node) {
+                return false;
+        }
+        ls_atomic_list_account(alloc);
+        node->data = data;
+
+        old = atomic_load(&self->head);
+        do {
+                node->next = old.node;
+                new.node = node;
+                new.tag = old.tag + 1;
+        } while (!atomic_compare_exchange_weak(&self->head, &old, new));
+
+        return true;
+}
+
+/**
+ * Push a chain of nodes, linked through data, onto the retired list
+ */
+static void ls_atomic_list_retire(LsAtomicList *self, LsList *first, LsList *last)
+{
+        LsList *old = atomic_load(&self->retired);
+
+        do {
+                last->data = old;
+        } while (!atomic_compare_exchange_weak(&self->retired, &old, first));
+}
+
+/**
+ * Dispose of a node we just popped. If we're the only thread inside pop
+ * then nobody else can be holding a pointer to it, or to anything that
+ * was retired before we entered, so both can be freed. Otherwise the
+ * node is deferred until the last popper leaves.
+ */
+static void ls_atomic_list_reclaim(LsAtomicList *self, LsList *node)
+{
+        LsList *pending = NULL;
+        LsList *last = NULL;
+
+        if (atomic_load(&self->poppers) != 1) {
+                ls_atomic_list_retire(self, node, node);
+                atomic_fetch_sub(&self->poppers, 1);
+                return;
+        }
+
+        pending = atomic_exchange(&self->retired, NULL);
+        if (atomic_fetch_sub(&self->poppers, 1) == 1) {
+                ls_atomic_list_free_retired(pending);
+        } else if (pending) {
+                /* Somebody arrived meanwhile and may see these nodes */
+                last = pending;
+                while (last->data) {
+                        last = last->data;
+                }
+                ls_atomic_list_retire(self, pending, last);
+        }
+        ls_atomic_list_account(free);
+        free(node);
+}
+
+bool ls_atomic_list_pop(LsAtomicList *self, void **data)
+{
+        LsAtomicListHead old;
+        LsAtomicListHead new;
+
+        if (ls_unlikely(!self)) {
+                return false;
+        }
+
+        atomic_fetch_add(&self->poppers, 1);
+
+        old = atomic_load(&self->head);
+        do {
+                if (!old.node) {
+                        atomic_fetch_sub(&self->poppers, 1);
+                        return false;
+                }
+                new.node = old.node->next;
+                new.tag = old.tag + 1;
+        } while (!atomic_compare_exchange_weak(&self->head, &old, new));
+
+        if (data) {
+                *data = old.node->data;
+        }
+        ls_atomic_list_reclaim(self, old.node);
+
+        return true;
+}
+
+LsList *ls_atomic_list_take_all(LsAtomicList *self)
+{
+        LsAtomicListHead old;
+        LsAtomicListHead new;
+
+        if (ls_unlikely(!self)) {
+                return NULL;
+        }
+
+        /* Only retries if a producer pushed in between */
+        old = atomic_load(&self->head);
+        do {
+                if (!old.node) {
+                        return NULL;
+                }
+                new.node = NULL;
+                new.tag = old.tag + 1;
+        } while (!atomic_compare_exchange_weak(&self->head, &old, new));
+
+        return old.node;
+}
+
+bool ls_atomic_list_is_empty(LsAtomicList *self)
+{
+        if (ls_unlikely(!self)) {
+                return true;
+        }
+        return atomic_load(&self->head).node == NULL;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,102 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#include "list.h"
+
+/**
+ * LsAtomicList is a lock-free LIFO stack (Treiber stack) of data pointers,
+ * intended for handing items from worker threads to a consumer without a
+ * mutex.
+ *
+ * Any number of threads may push and pop concurrently. The head is a
+ * tagged pointer updated with a double-width compare-and-swap, so a node
+ * that is popped and pushed again cannot be mistaken for the original
+ * (ABA). Popped nodes are only freed once no other pop is in flight.
+ */
+typedef struct LsAtomicList LsAtomicList;
+
+/**
+ * Construct a new, empty, atomic list
+ */
+LsAtomicList *ls_atomic_list_new(void);
+
+/**
+ * Free a previously allocated atomic list and any remaining nodes.
+ * No other thread may be using the list at this point.
+ */
+void ls_atomic_list_free(LsAtomicList *list);
+
+/**
+ * Identical to ls_atomic_list_free, but will additionally call the
+ * passed free_func to deallocate any remaining data pointers.
+ */
+void ls_atomic_list_free_full(LsAtomicList *list, ls_free_func freer);
+
+/**
+ * Atomically push data onto the head of the list
+ *
+ * @returns True if the data was pushed
+ */
+bool ls_atomic_list_push(LsAtomicList *list, void *data);
+
+/**
+ * Atomically pop the most recently pushed data pointer
+ *
+ * @param data Storage for the popped data pointer
+ *
+ * @returns True if an item was popped, false if the list was empty
+ */
+bool ls_atomic_list_pop(LsAtomicList *list, void **data);
+
+/**
+ * Atomically detach every node in the list, returning them as an ordinary
+ * LsList chain owned by the caller, newest first. Use ls_list_reverse to
+ * obtain them in push order, and ls_list_free once done.
+ *
+ * This is safe against concurrent pushes. As the detached nodes are no
+ * longer tracked by the list, it must not race with ls_atomic_list_pop
+ * on other threads: a consumer should either pop or drain.
+ */
+LsList *ls_atomic_list_take_all(LsAtomicList *list);
+
+/**
+ * Determine whether the list is currently empty. This is only a hint
+ * when other threads are pushing or popping.
+ */
+bool ls_atomic_list_is_empty(LsAtomicList *list);
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,952 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The AVX2 search is compiled for any x86 target and only used when the
+ * CPU supports it at runtime, so the default build doesn't need -mavx2
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define LS_BTREE_AVX2 1
+#include <immintrin.h>
+#endif
+
+#include "btree.h"
+
+/**
+ * Each node spans 16 cache lines
+ */
+#define LS_BTREE_NODE_SIZE 1024
+
+/**
+ * Require at least this many keys per node, or splits and merges stop
+ * making sense.
+ */
+#define LS_BTREE_MIN_CAPACITY 4
+
+/**
+ * Nodes hold their keys first, followed by either the values (leaves) or
+ * the child pointers (branches). Both arrays have room for one more
+ * entry than the capacity, so that an insert can overflow a node before
+ * it is split.
+ */
+typedef struct LsBTreeNode {
+        unsigned int count;       /**<Keys in this node */
+        bool leaf;                /**<Whether this node holds values */
+        struct LsBTreeNode *next; /**<Next leaf in key order, or next spare */
+        uint64_t blob[];          /**<Keys, then values or children */
+} LsBTreeNode;
+
+/**
+ * Per node-type geometry, computed from the key and value sizes
+ */
+typedef struct LsBTreeLayout {
+        unsigned int cap; /**<Most keys a node may hold */
+        unsigned int min; /**<Fewest keys a non-root node may hold */
+        size_t offset;    /**<Offset of the values or children */
+} LsBTreeLayout;
+
+/**
+ * Opaque LsBTree implementation
+ */
+struct LsBTree {
+        LsBTreeNode *root;       /**<Root node, always allocated */
+        unsigned int height;     /**<Levels above the leaves */
+        size_t size;             /**<Number of stored keys */
+        size_t key_size;         /**<Bytes per key */
+        size_t value_size;       /**<Bytes per value */
+        ls_compare_func compare; /**<Key ordering, NULL for uint64_t */
+        LsBTreeLayout leaf;      /**<Leaf geometry */
+        LsBTreeLayout branch;    /**<Branch geometry */
+        unsigned char *scratch;  /**<Separator key promoted by a split */
+
+        /**
+         * Preallocated nodes, so that a put never fails half way through
+         * splitting a path. Linked through next.
+         */
+        struct {
+                LsBTreeNode *nodes;
+                unsigned int len;
+        } spares;
+};
+
+static inline unsigned char *ls_btree_key(LsBTree *self, LsBTreeNode *node, unsigned int index)
+{
+        return (unsigned char *)node->blob + index * self->key_size;
+}
+
+static inline unsigned char *ls_btree_value(LsBTree *self, LsBTreeNode *node, unsigned int index)
+{
+        return (unsigned char *)node->blob + self->leaf.offset + index * self->value_size;
+}
+
+/**
+ * Copy a single key between two slots, possibly in different nodes
+ */
+static inline void ls_btree_key_copy(LsBTree *self, LsBTreeNode *dst, unsigned int to,
+                                     LsBTreeNode *src, unsigned int from)
+{
+        memcpy(ls_btree_key(self, dst, to), ls_btree_key(self, src, from), self->key_size);
+}
+
+static inline LsBTreeNode **ls_btree_children(LsBTree *self, LsBTreeNode *node)
+{
+        return (LsBTreeNode **)((unsigned char *)node->blob + self->branch.offset);
+}
+
+static inline unsigned int ls_btree_min(LsBTree *self, LsBTreeNode *node)
+{
+        return node->leaf ? self->leaf.min : self->branch.min;
+}
+
+/**
+ * Round up to a multiple of the pointer size
+ */
+static inline size_t ls_btree_align(size_t size)
+{
+        return (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+}
+
+/**
+ * Work out how many keys fit in a node when each key is accompanied by
+ * @entry_size bytes, with one slot held back for overflow.
+ */
+static unsigned int ls_btree_capacity(size_t key_size, size_t entry_size, size_t extra)
+{
+        size_t avail = LS_BTREE_NODE_SIZE - offsetof(LsBTreeNode, blob) - sizeof(void *) - extra;
+        size_t slots = avail / (key_size + entry_size);
+
+        return slots > 1 ? (unsigned int)(slots - 1) : 0;
+}
+
+LsBTree *ls_btree_new(size_t key_size, size_t value_size, ls_compare_func compare)
+{
+        LsBTree *ret = NULL;
+
+        if (ls_unlikely(key_size == 0 || (!compare && key_size != sizeof(uint64_t)))) {
+                return NULL;
+        }
+
+        ret = calloc(1, sizeof(struct LsBTree));
+        if (!ret) {
+                return NULL;
+        }
+
+        ret->key_size = key_size;
+        ret->value_size = value_size;
+        ret->compare = compare;
+
+        /* Leaves hold cap + 1 values, branches hold cap + 2 children */
+        ret->leaf.cap = ls_btree_capacity(key_size, value_size, 0);
+        ret->leaf.min = ret->leaf.cap / 2;
+        ret->leaf.offset = ls_btree_align((ret->leaf.cap + 1) * key_size);
+
+        ret->branch.cap = ls_btree_capacity(key_size, sizeof(void *), sizeof(void *));
+        ret->branch.min = ret->branch.cap / 2;
+        ret->branch.offset = ls_btree_align((ret->branch.cap + 1) * key_size);
+
+        if (ret->leaf.cap < LS_BTREE_MIN_CAPACITY || ret->branch.cap < LS_BTREE_MIN_CAPACITY) {
+                free(ret);
+                return NULL;
+        }
+
+        ret->scratch = malloc(key_size);
+        ret->root = aligned_alloc(64, LS_BTREE_NODE_SIZE);
+        if (!ret->scratch || !ret->root) {
+                ls_btree_free(ret);
+                return NULL;
+        }
+        ret->root->count = 0;
+        ret->root->leaf = true;
+        ret->root->next = NULL;
+
+        return ret;
+}
+
+/**
+ * Recursively free a subtree
+ */
+static void ls_btree_free_node(LsBTree *self, LsBTreeNode *node)
+{
+        if (!node->leaf) {
+                LsBTreeNode **children = ls_btree_children(self, node);
+                for (unsigned int i = 0; i <= node->count; i++) {
+                        ls_btree_free_node(self, children[i]);
+                }
+        }
+        free(node);
+}
+
+void ls_btree_free(LsBTree *self)
+{
+        LsBTreeNode *next = NULL;
+
+        if (ls_unlikely(!self)) {
+                return;
+        }
+
+        if (self->root) {
+                ls_btree_free_node(self, self->root);
+        }
+        for (LsBTreeNode *node = self->spares.nodes; node; node = next) {
+                next = node->next;
+                free(node);
+        }
+        free(self->scratch);
+        free(self);
+}
+
+/**
+ * Ensure there are enough spare nodes to split every level of the tree
+ * and grow a new root.
+ */
+static bool ls_btree_reserve(LsBTree *self)
+{
+        while (self->spares.len < self->height + 2) {
+                LsBTreeNode *node = aligned_alloc(64, LS_BTREE_NODE_SIZE);
+                if (!node) {
+                        return false;
+                }
+                node->next = self->spares.nodes;
+                self->spares.nodes = node;
+                ++self->spares.len;
+        }
+        return true;
+}
+
+/**
+ * Take a reserved node, which cannot fail after ls_btree_reserve
+ */
+static LsBTreeNode *ls_btree_node_take(LsBTree *self, bool leaf)
+{
+        LsBTreeNode *node = self->spares.nodes;
+
+        self->spares.nodes = node->next;
+        --self->spares.len;
+
+        node->count = 0;
+        node->leaf = leaf;
+        node->next = NULL;
+        return node;
+}
+
+/**
+ * Keep a few released nodes around for the next split
+ */
+static void ls_btree_node_release(LsBTree *self, LsBTreeNode *node)
+{
+        if (self->spares.len >= self->height + 2) {
+                free(node);
+                return;
+        }
+        node->next = self->spares.nodes;
+        self->spares.nodes = node;
+        ++self->spares.len;
+}
+
+static inline int ls_btree_compare(LsBTree *self, const void *a, const void *b)
+{
+        uint64_t x, y;
+
+        if (self->compare) {
+                return self->compare(a, b);
+        }
+        memcpy(&x, a, sizeof(x));
+        memcpy(&y, b, sizeof(y));
+        return (x > y) - (x < y);
+}
+
+#ifdef LS_BTREE_AVX2
+/**
+ * Count keys as ls_btree_search_u64 does, over whole vectors of 4 keys
+ * from *@pos, leaving *@pos at the remaining tail
+ */
+__attribute__((target("avx2"))) static unsigned int ls_btree_search_u64_avx2(
+    const uint64_t *keys, unsigned int n, uint64_t key, bool upper, unsigned int *pos)
+{
+        /* AVX2 only has signed compares, so flip the sign bits first */
+        const __m256i bias = _mm256_set1_epi64x(INT64_MIN);
+        const __m256i needle = _mm256_xor_si256(_mm256_set1_epi64x((long long)key), bias);
+        unsigned int ret = 0;
+        unsigned int i = *pos;
+
+        for (; i + 4 <= n; i += 4) {
+                __m256i chunk = _mm256_loadu_si256((const __m256i *)(keys + i));
+                __m256i mask;
+                unsigned int bits;
+
+                chunk = _mm256_xor_si256(chunk, bias);
+
+                /* keys <= key is the complement of keys > key */
+                if (upper) {
+                        mask = _mm256_cmpgt_epi64(chunk, needle);
+                } else {
+                        mask = _mm256_cmpgt_epi64(needle, chunk);
+                }
+                bits = (unsigned int)_mm256_movemask_pd(_mm256_castsi256_pd(mask));
+                ret += upper ? 4 - (unsigned int)__builtin_popcount(bits)
+                             : (unsigned int)__builtin_popcount(bits);
+        }
+
+        *pos = i;
+        return ret;
+}
+#endif
+
+/**
+ * Count the sorted uint64_t keys that are less than @key, or less than
+ * or equal when @upper is set. As the keys are sorted, this is also the
+ * index of the lower or upper bound.
+ */
+static unsigned int ls_btree_search_u64(const uint64_t *keys, unsigned int n, uint64_t key,
+                                        bool upper)
+{
+        unsigned int ret = 0;
+        unsigned int i = 0;
+
+#ifdef LS_BTREE_AVX2
+        if (n >= 4 && __builtin_cpu_supports("avx2")) {
+                ret = ls_btree_search_u64_avx2(keys, n, key, upper, &i);
+        }
+#endif
+
+        /* Branchless, so the compiler is free to vectorise it */
+        if (upper) {
+                for (; i < n; i++) {
+                        ret += keys[i] <= key;
+                }
+        } else {
+                for (; i < n; i++) {
+                        ret += keys[i] < key;
+                }
+        }
+
+        return ret;
+}
+
+/**
+ * Find the index of the first key not less than @key, or greater than
+ * @key when @upper is set.
+ */
+static unsigned int ls_btree_search(LsBTree *self, LsBTreeNode *node, const void *key, bool upper)
+{
+        unsigned int lo = 0;
+        unsigned int hi = node->count;
+
+        if (!self->compare) {
+                uint64_t k;
+                memcpy(&k, key, sizeof(k));
+                return ls_btree_search_u64(node->blob, node->count, k, upper);
+        }
+
+        while (lo < hi) {
+                unsigned int mid = lo + (hi - lo) / 2;
+                int c = self->compare(ls_btree_key(self, node, mid), key);
+
+                if (c < 0 || (upper && c == 0)) {
+                        lo = mid + 1;
+                } else {
+                        hi = mid;
+                }
+        }
+
+        return lo;
+}
+
+/**
+ * Store a value, which may be NULL for a tree without values
+ */
+static inline void ls_btree_value_set(LsBTree *self, LsBTreeNode *node, unsigned int index,
+                                      const void *value)
+{
+        if (self->value_size) {
+                memcpy(ls_btree_value(self, node, index), value, self->value_size);
+        }
+}
+
+/**
+ * Check whether slot @index holds a key equal to @key
+ */
+static inline bool ls_btree_key_matches(LsBTree *self, LsBTreeNode *node, unsigned int index,
+                                        const void *key)
+{
+        return index < node->count &&
+               ls_btree_compare(self, ls_btree_key(self, node, index), key) == 0;
+}
+
+/**
+ * Move @n keys (and values) within a leaf
+ */
+static void ls_btree_leaf_move(LsBTree *self, LsBTreeNode *node, unsigned int to,
+                               unsigned int from, unsigned int n)
+{
+        memmove(ls_btree_key(self, node, to), ls_btree_key(self, node, from), n * self->key_size);
+        memmove(ls_btree_value(self, node, to),
+                ls_btree_value(self, node, from),
+                n * self->value_size);
+}
+
+/**
+ * Copy @n keys (and values) from one leaf to another
+ */
+static void ls_btree_leaf_copy(LsBTree *self, LsBTreeNode *dst, unsigned int to,
+                               LsBTreeNode *src, unsigned int from, unsigned int n)
+{
+        memcpy(ls_btree_key(self, dst, to), ls_btree_key(self, src, from), n * self->key_size);
+        memcpy(ls_btree_value(self, dst, to),
+               ls_btree_value(self, src, from),
+               n * self->value_size);
+}
+
+/**
+ * Split an overflowing leaf in half, promoting the first key of the new
+ * right sibling.
+ */
+static LsBTreeNode *ls_btree_split_leaf(LsBTree *self, LsBTreeNode *node)
+{
+        LsBTreeNode *right = ls_btree_node_take(self, true);
+        unsigned int keep = node->count / 2;
+
+        right->count = node->count - keep;
+        ls_btree_leaf_copy(self, right, 0, node, keep, right->count);
+        node->count = keep;
+
+        right->next = node->next;
+        node->next = right;
+
+        memcpy(self->scratch, ls_btree_key(self, right, 0), self->key_size);
+        return right;
+}
+
+/**
+ * Split an overflowing branch, promoting its middle key
+ */
+static LsBTreeNode *ls_btree_split_branch(LsBTree *self, LsBTreeNode *node)
+{
+        LsBTreeNode *right = ls_btree_node_take(self, false);
+        unsigned int mid = node->count / 2;
+
+        right->count = node->count - mid - 1;
+        memcpy(ls_btree_key(self, right, 0),
+               ls_btree_key(self, node, mid + 1),
+               right->count * self->key_size);
+        memcpy(ls_btree_children(self, right),
+               ls_btree_children(self, node) + mid + 1,
+               (right->count + 1) * sizeof(LsBTreeNode *));
+        memcpy(self->scratch, ls_btree_key(self, node, mid), self->key_size);
+        node->count = mid;
+
+        return right;
+}
+
+/**
+ * Insert into the subtree at @node, returning the new right sibling if
+ * @node had to be split. The separator is left in the scratch key.
+ */
+static LsBTreeNode *ls_btree_insert(LsBTree *self, LsBTreeNode *node, const void *key,
+                                    const void *value)
+{
+        LsBTreeNode **children = NULL;
+        LsBTreeNode *split = NULL;
+        unsigned int i;
+
+        if (node->leaf) {
+                i = ls_btree_search(self, node, key, false);
+                if (ls_btree_key_matches(self, node, i, key)) {
+                        ls_btree_value_set(self, node, i, value);
+                        return NULL;
+                }
+
+                ls_btree_leaf_move(self, node, i + 1, i, node->count - i);
+                memcpy(ls_btree_key(self, node, i), key, self->key_size);
+                ls_btree_value_set(self, node, i, value);
+                ++node->count;
+                ++self->size;
+
+                return node->count > self->leaf.cap ? ls_btree_split_leaf(self, node) : NULL;
+        }
+
+        children = ls_btree_children(self, node);
+        i = ls_btree_search(self, node, key, true);
+        split = ls_btree_insert(self, children[i], key, value);
+        if (!split) {
+                return NULL;
+        }
+
+        /* Adopt the new child and its separator */
+        memmove(ls_btree_key(self, node, i + 1),
+                ls_btree_key(self, node, i),
+                (node->count - i) * self->key_size);
+        memcpy(ls_btree_key(self, node, i), self->scratch, self->key_size);
+        memmove(&children[i + 2], &children[i + 1], (node->count - i) * sizeof(LsBTreeNode *));
+        children[i + 1] = split;
+        ++node->count;
+
+        return node->count > self->branch.cap ? ls_btree_split_branch(self, node) : NULL;
+}
+
+bool ls_btree_put(LsBTree *self, const void *key, const void *value)
+{
+        LsBTreeNode *split = NULL;
+        LsBTreeNode *root = NULL;
+
+        if (ls_unlikely(!self || !key || (!value && self->value_size))) {
+                return false;
+        }
+
+        if (!ls_btree_reserve(self)) {
+                return false;
+        }
+
+        split = ls_btree_insert(self, self->root, key, value);
+        if (!split) {
+                return true;
+        }
+
+        /* Grow a new root above the old one */
+        root = ls_btree_node_take(self, false);
+        root->count = 1;
+        memcpy(ls_btree_key(self, root, 0), self->scratch, self->key_size);
+        ls_btree_children(self, root)[0] = self->root;
+        ls_btree_children(self, root)[1] = split;
+        self->root = root;
+        ++self->height;
+
+        return true;
+}
+
+/**
+ * Descend to the leaf that would hold @key
+ */
+static LsBTreeNode *ls_btree_find_leaf(LsBTree *self, const void *key)
+{
+        LsBTreeNode *node = self->root;
+
+        while (!node->leaf) {
+                node = ls_btree_children(self, node)[ls_btree_search(self, node, key, true)];
+        }
+        return node;
+}
+
+void *ls_btree_get(LsBTree *self, const void *key)
+{
+        LsBTreeNode *node = NULL;
+        unsigned int i;
+
+        if (ls_unlikely(!self || !key)) {
+                return NULL;
+        }
+
+        node = ls_btree_find_leaf(self, key);
+        i = ls_btree_search(self, node, key, false);
+        if (!ls_btree_key_matches(self, node, i, key)) {
+                return NULL;
+        }
+        return ls_btree_value(self, node, i);
+}
+
+/**
+ * Move the last entry of the left sibling into the underfull child @i
+ */
+static void ls_btree_borrow_left(LsBTree *self, LsBTreeNode *parent, unsigned int i)
+{
+        LsBTreeNode **children = ls_btree_children(self, parent);
+        LsBTreeNode *child = children[i];
+        LsBTreeNode *left = children[i - 1];
+
+        if (child->leaf) {
+                ls_btree_leaf_move(self, child, 1, 0, child->count);
+                ls_btree_leaf_copy(self, child, 0, left, left->count - 1, 1);
+                ls_btree_key_copy(self, parent, i - 1, child, 0);
+        } else {
+                LsBTreeNode **cc = ls_btree_children(self, child);
+                LsBTreeNode **lc = ls_btree_children(self, left);
+
+                memmove(ls_btree_key(self, child, 1),
+                        ls_btree_key(self, child, 0),
+                        child->count * self->key_size);
+                memmove(&cc[1], &cc[0], (child->count + 1) * sizeof(LsBTreeNode *));
+                ls_btree_key_copy(self, child, 0, parent, i - 1);
+                cc[0] = lc[left->count];
+                ls_btree_key_copy(self, parent, i - 1, left, left->count - 1);
+        }
+
+        --left->count;
+        ++child->count;
+}
+
+/**
+ * Move the first entry of the right sibling into the underfull child @i
+ */
+static void ls_btree_borrow_right(LsBTree *self, LsBTreeNode *parent, unsigned int i)
+{
+        LsBTreeNode **children = ls_btree_children(self, parent);
+        LsBTreeNode *child = children[i];
+        LsBTreeNode *right = children[i + 1];
+
+        if (child->leaf) {
+                ls_btree_leaf_copy(self, child, child->count, right, 0, 1);
+                ls_btree_leaf_move(self, right, 0, 1, right->count - 1);
+                ls_btree_key_copy(self, parent, i, right, 0);
+        } else {
+                LsBTreeNode **cc = ls_btree_children(self, child);
+                LsBTreeNode **rc = ls_btree_children(self, right);
+
+                ls_btree_key_copy(self, child, child->count, parent, i);
+                cc[child->count + 1] = rc[0];
+                ls_btree_key_copy(self, parent, i, right, 0);
+                memmove(ls_btree_key(self, right, 0),
+                        ls_btree_key(self, right, 1),
+                        (right->count - 1) * self->key_size);
+                memmove(&rc[0], &rc[1], right->count * sizeof(LsBTreeNode *));
+        }
+
+        --right->count;
+        ++child->count;
+}
+
+/**
+ * Fold child @i + 1 into child @i and drop their separator
+ */
+static void ls_btree_merge(LsBTree *self, LsBTreeNode *parent, unsigned int i)
+{
+        LsBTreeNode **children = ls_btree_children(self, parent);
+        LsBTreeNode *left = children[i];
+        LsBTreeNode *right = children[i + 1];
+
+        if (left->leaf) {
+                ls_btree_leaf_copy(self, left, left->count, right, 0, right->count);
+                left->count += right->count;
+                left->next = right->next;
+        } else {
+                ls_btree_key_copy(self, left, left->count, parent, i);
+                memcpy(ls_btree_key(self, left, left->count + 1),
+                       ls_btree_key(self, right, 0),
+                       right->count * self->key_size);
+                memcpy(ls_btree_children(self, left) + left->count + 1,
+                       ls_btree_children(self, right),
+                       (right->count + 1) * sizeof(LsBTreeNode *));
+                left->count += right->count + 1;
+        }
+
+        memmove(ls_btree_key(self, parent, i),
+                ls_btree_key(self, parent, i + 1),
+                (parent->count - i - 1) * self->key_size);
+        memmove(&children[i + 1],
+                &children[i + 2],
+                (parent->count - i - 1) * sizeof(LsBTreeNode *));
+        --parent->count;
+
+        ls_btree_node_release(self, right);
+}
+
+/**
+ * Restore the minimum occupancy of child @i by borrowing from a sibling,
+ * or merging with one if neither can spare an entry.
+ */
+static void ls_btree_rebalance(LsBTree *self, LsBTreeNode *parent, unsigned int i)
+{
+        LsBTreeNode **children = ls_btree_children(self, parent);
+        LsBTreeNode *left = i > 0 ? children[i - 1] : NULL;
+        LsBTreeNode *right = i < parent->count ? children[i + 1] : NULL;
+
+        if (left && left->count > ls_btree_min(self, left)) {
+                ls_btree_borrow_left(self, parent, i);
+        } else if (right && right->count > ls_btree_min(self, right)) {
+                ls_btree_borrow_right(self, parent, i);
+        } else if (left) {
+                ls_btree_merge(self, parent, i - 1);
+        } else {
+                ls_btree_merge(self, parent, i);
+        }
+}
+
+/**
+ * Remove @key from the subtree at @node, fixing up underfull children on
+ * the way back up.
+ */
+static bool ls_btree_delete(LsBTree *self, LsBTreeNode *node, const void *key)
+{
+        LsBTreeNode *child = NULL;
+        unsigned int i;
+
+        if (node->leaf) {
+                i = ls_btree_search(self, node, key, false);
+                if (!ls_btree_key_matches(self, node, i, key)) {
+                        return false;
+                }
+                ls_btree_leaf_move(self, node, i, i + 1, node->count - i - 1);
+                --node->count;
+                return true;
+        }
+
+        /* Stale separators are fine, they still bound their subtrees */
+        i = ls_btree_search(self, node, key, true);
+        child = ls_btree_children(self, node)[i];
+        if (!ls_btree_delete(self, child, key)) {
+                return false;
+        }
+        if (child->count < ls_btree_min(self, child)) {
+                ls_btree_rebalance(self, node, i);
+        }
+        return true;
+}
+
+bool ls_btree_remove(LsBTree *self, const void *key)
+{
+        LsBTreeNode *root = NULL;
+
+        if (ls_unlikely(!self || !key)) {
+                return false;
+        }
+
+        if (!ls_btree_delete(self, self->root, key)) {
+                return false;
+        }
+        --self->size;
+
+        /* Collapse a root that has been merged down to a single child */
+        root = self->root;
+        if (!root->leaf && root->count == 0) {
+                self->root = ls_btree_children(self, root)[0];
+                --self->height;
+                ls_btree_node_release(self, root);
+        }
+
+        return true;
+}
+
+size_t ls_btree_size(LsBTree *self)
+{
+        if (ls_unlikely(!self)) {
+                return 0;
+        }
+        return self->size;
+}
+
+/**
+ * Smallest key stored beneath @node
+ */
+static const unsigned char *ls_btree_low_key(LsBTree *self, LsBTreeNode *node)
+{
+        while (!node->leaf) {
+                node = ls_btree_children(self, node)[0];
+        }
+        return ls_btree_key(self, node, 0);
+}
+
+/**
+ * Free a partially built level
+ */
+static void ls_btree_free_level(LsBTree *self, LsBTreeNode **level, size_t n)
+{
+        for (size_t i = 0; i < n; i++) {
+                ls_btree_free_node(self, level[i]);
+        }
+        free(level);
+}
+
+bool ls_btree_bulk_load(LsBTree *self, LsArray *array)
+{
+        LsBTreeNode **level = NULL;
+        size_t n_level = 0;
+        size_t n;
+        size_t per;
+        size_t extra;
+        size_t item = 0;
+        unsigned int height = 0;
+
+        if (ls_unlikely(!self || !array || self->size != 0)) {
+                return false;
+        }
+        if (ls_unlikely(array->item_size != self->key_size + self->value_size)) {
+                return false;
+        }
+
+        n = array->len;
+        if (n == 0) {
+                return true;
+        }
+
+        for (size_t i = 1; i < n; i++) {
+                if (ls_btree_compare(self, array->data[i - 1], array->data[i]) >= 0) {
+                        return false;
+                }
+        }
+
+        /* Spread the items evenly, so no leaf falls below the minimum */
+        n_level = (n + self->leaf.cap - 1) / self->leaf.cap;
+        level = calloc(n_level, sizeof(LsBTreeNode *));
+        if (!level) {
+                return false;
+        }
+        per = n / n_level;
+        extra = n % n_level;
+
+        for (size_t l = 0; l < n_level; l++) {
+                LsBTreeNode *leaf = aligned_alloc(64, LS_BTREE_NODE_SIZE);
+                if (!leaf) {
+                        ls_btree_free_level(self, level, l);
+                        return false;
+                }
+                leaf->leaf = true;
+                leaf->next = NULL;
+                leaf->count = (unsigned int)(per + (l < extra));
+                for (unsigned int j = 0; j < leaf->count; j++, item++) {
+                        const unsigned char *src = array->data[item];
+                        memcpy(ls_btree_key(self, leaf, j), src, self->key_size);
+                        memcpy(ls_btree_value(self, leaf, j),
+                               src + self->key_size,
+                               self->value_size);
+                }
+                if (l > 0) {
+                        level[l - 1]->next = leaf;
+                }
+                level[l] = leaf;
+        }
+
+        /* Build each branch level over the one below, again evenly */
+        while (n_level > 1) {
+                size_t fanout = self->branch.cap + 1;
+                size_t n_parents = (n_level + fanout - 1) / fanout;
+                LsBTreeNode **parents = calloc(n_parents, sizeof(LsBTreeNode *));
+                size_t child = 0;
+
+                if (!parents) {
+                        ls_btree_free_level(self, level, n_level);
+                        return false;
+                }
+                per = n_level / n_parents;
+                extra = n_level % n_parents;
+
+                for (size_t p = 0; p < n_parents; p++) {
+                        LsBTreeNode *branch = aligned_alloc(64, LS_BTREE_NODE_SIZE);
+                        size_t n_children = per + (p < extra);
+
+                        if (!branch) {
+                                /* Children not yet adopted are still in the lower level */
+                                ls_btree_free_level(self, parents, p);
+                                for (; child < n_level; child++) {
+                                        ls_btree_free_node(self, level[child]);
+                                }
+                                free(level);
+                                return false;
+                        }
+                        branch->leaf = false;
+                        branch->next = NULL;
+                        branch->count = (unsigned int)(n_children - 1);
+                        for (unsigned int j = 0; j < n_children; j++, child++) {
+                                ls_btree_children(self, branch)[j] = level[child];
+                                if (j > 0) {
+                                        memcpy(ls_btree_key(self, branch, j - 1),
+                                               ls_btree_low_key(self, level[child]),
+                                               self->key_size);
+                                }
+                        }
+                        parents[p] = branch;
+                }
+
+                free(level);
+                level = parents;
+                n_level = n_parents;
+                ++height;
+        }
+
+        free(self->root);
+        self->root = level[0];
+        self->height = height;
+        self->size = n;
+        free(level);
+
+        return true;
+}
+
+void ls_btree_iter_init(LsBTree *self, LsBTreeIter *iter)
+{
+        LsBTreeNode *node = self ? self->root : NULL;
+
+        while (node && !node->leaf) {
+                node = ls_btree_children(self, node)[0];
+        }
+        iter->tree = self;
+        iter->node = node;
+        iter->index = 0;
+}
+
+void ls_btree_iter_init_at(LsBTree *self, const void *key, LsBTreeIter *iter)
+{
+        LsBTreeNode *node = NULL;
+
+        iter->tree = self;
+        iter->node = NULL;
+        iter->index = 0;
+
+        if (ls_unlikely(!self || !key)) {
+                return;
+        }
+
+        node = ls_btree_find_leaf(self, key);
+        iter->node = node;
+        iter->index = ls_btree_search(self, node, key, false);
+}
+
+bool ls_btree_iter_next(LsBTreeIter *iter, const void **key, void **value)
+{
+        LsBTreeNode *node = iter->node;
+
+        /* Follow the leaf links once this leaf is exhausted */
+        while (node && iter->index >= node->count) {
+                node = node->next;
+                iter->node = node;
+                iter->index = 0;
+        }
+
+        if (!node) {
+                return false;
+        }
+
+        if (key) {
+                *key = ls_btree_key(iter->tree, node, iter->index);
+        }
+        if (value) {
+                *value = ls_btree_value(iter->tree, node, iter->index);
+        }
+        iter->index++;
+        return true;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
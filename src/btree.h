@@ -0,0 +1,154 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "array.h"
+#include "macros.h"
+
+/**
+ * LsBTree is an in-memory B+ tree mapping fixed-size keys to fixed-size
+ * values, both stored inline within 1KiB cache-line aligned nodes.
+ * Interior nodes only hold separator keys and children, so each level is
+ * a single dense node, and the leaves are linked in key order for fast
+ * range scans.
+ *
+ * Keys and values are copied in on insert. Pointers returned for keys
+ * and values refer to storage inside the tree, and only remain valid
+ * until the next modification.
+ *
+ * When constructed without a comparison function, keys are treated as
+ * native uint64_t, and nodes are searched with a branchless scan that
+ * uses AVX2 when the CPU supports it.
+ */
+typedef struct LsBTree LsBTree;
+
+/**
+ * LsBTreeIter is used to walk a tree in key order. The tree must not be
+ * modified while an iterator is in use.
+ */
+typedef struct LsBTreeIter {
+        LsBTree *tree;
+        void *node;
+        unsigned int index;
+} LsBTreeIter;
+
+/**
+ * Construct a new LsBTree
+ *
+ * @param key_size Size of each key in bytes
+ * @param value_size Size of each value in bytes, may be 0 for a set
+ * @param compare Function ordering two keys, given pointers to them. If
+ *                NULL, @key_size must be 8 and keys are native uint64_t.
+ *
+ * @note Free with ls_btree_free
+ *
+ * @return A newly allocated LsBTree, or NULL if the sizes are too large
+ * for several entries to fit in a node
+ */
+LsBTree *ls_btree_new(size_t key_size, size_t value_size, ls_compare_func compare);
+
+/**
+ * Free a previously allocated tree
+ */
+void ls_btree_free(LsBTree *tree);
+
+/**
+ * Copy a key/value pair into the tree, replacing the value if the key is
+ * already present.
+ *
+ * @param key Pointer to key_size bytes of key
+ * @param value Pointer to value_size bytes of value, may be NULL if 0
+ *
+ * @returns True if the pair could be stored
+ */
+bool ls_btree_put(LsBTree *tree, const void *key, const void *value);
+
+/**
+ * Find the value stored for @key
+ *
+ * @returns Pointer to the value inside the tree, or NULL if not found
+ */
+void *ls_btree_get(LsBTree *tree, const void *key);
+
+/**
+ * Remove @key and its value from the tree
+ *
+ * @returns True if we deleted a matching key/value
+ */
+bool ls_btree_remove(LsBTree *tree, const void *key);
+
+/**
+ * Return the number of keys stored in the tree
+ */
+size_t ls_btree_size(LsBTree *tree);
+
+/**
+ * Build the tree bottom-up from an array sorted in ascending key order,
+ * packing every node. This is considerably faster than repeated puts.
+ *
+ * Each item in @array must point to a key immediately followed by its
+ * value, so the array's item_size must be key_size + value_size. Keys
+ * must be strictly ascending.
+ *
+ * @returns True if the tree was built. The tree must be empty, and is
+ * left untouched on failure.
+ */
+bool ls_btree_bulk_load(LsBTree *tree, LsArray *array);
+
+/**
+ * Prepare @iter to walk @tree from the smallest key
+ */
+void ls_btree_iter_init(LsBTree *tree, LsBTreeIter *iter);
+
+/**
+ * Prepare @iter to walk @tree from the first key that does not compare
+ * less than @key
+ */
+void ls_btree_iter_init_at(LsBTree *tree, const void *key, LsBTreeIter *iter);
+
+/**
+ * Advance the iterator, storing pointers to the next key and value.
+ *
+ * @param iter Pointer to an initialised iterator
+ * @param key Storage for the key pointer, may be NULL
+ * @param value Storage for the value pointer, may be NULL
+ *
+ * @returns False once the iterator has been exhausted
+ */
+bool ls_btree_iter_next(LsBTreeIter *iter, const void **key, void **value);
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
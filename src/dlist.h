@@ -0,0 +1,299 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "macros.h"
+
+/**
+ * LsDListNode is embedded directly within the objects to be listed, so
+ * that membership of a list requires no allocation at all. The owning
+ * object is recovered from a node with ls_dlist_entry.
+ *
+ * An unlinked node points at itself, so unlinking twice is harmless.
+ */
+typedef struct LsDListNode {
+        struct LsDListNode *prev;
+        struct LsDListNode *next;
+} LsDListNode;
+
+/**
+ * LsDList is a circular, doubly-linked intrusive list. The head is a
+ * sentinel node, so no operation needs to special case an empty list and
+ * every insert, unlink, move and splice is O(1).
+ */
+typedef struct LsDList {
+        LsDListNode head;
+} LsDList;
+
+/**
+ * Static initialiser for a LsDList named @name
+ */
+#define LS_DLIST_INIT(name)                                                                        \
+        {                                                                                          \
+                {                                                                                  \
+                        &(name).head, &(name).head                                                 \
+                }                                                                                  \
+        }
+
+/**
+ * Recover the containing structure of @type from a node embedded as @member
+ */
+#define ls_dlist_entry(node, type, member) ls_container_of(node, type, member)
+
+/**
+ * Walk every node in the list from front to back. The list must not be
+ * modified during the walk, use ls_dlist_foreach_safe for that.
+ */
+#define ls_dlist_foreach(list, node)                                                               \
+        for ((node) = (list)->head.next; (node) != &(list)->head; (node) = (node)->next)
+
+/**
+ * Walk every node in the list from back to front
+ */
+#define ls_dlist_foreach_reverse(list, node)                                                       \
+        for ((node) = (list)->head.prev; (node) != &(list)->head; (node) = (node)->prev)
+
+/**
+ * Walk every node in the list from front to back, permitting @node to be
+ * unlinked or moved to another list during the walk. @tmp is scratch
+ * storage for the next node.
+ */
+#define ls_dlist_foreach_safe(list, node, tmp)                                                     \
+        for ((node) = (list)->head.next, (tmp) = (node)->next; (node) != &(list)->head;            \
+             (node) = (tmp), (tmp) = (node)->next)
+
+/**
+ * Initialise an empty list
+ */
+static inline void ls_dlist_init(LsDList *list)
+{
+        list->head.prev = &list->head;
+        list->head.next = &list->head;
+}
+
+/**
+ * Initialise a node as being unlinked
+ */
+static inline void ls_dlist_node_init(LsDListNode *node)
+{
+        node->prev = node;
+        node->next = node;
+}
+
+/**
+ * Return true if the list has no members
+ */
+static inline bool ls_dlist_is_empty(const LsDList *list)
+{
+        return list->head.next == &list->head;
+}
+
+/**
+ * Return true if the node is currently a member of a list
+ */
+static inline bool ls_dlist_node_is_linked(const LsDListNode *node)
+{
+        return node->next != node;
+}
+
+/**
+ * Link @node between two adjacent nodes
+ */
+static inline void ls_dlist_link_between(LsDListNode *node, LsDListNode *prev, LsDListNode *next)
+{
+        node->prev = prev;
+        node->next = next;
+        prev->next = node;
+        next->prev = node;
+}
+
+/**
+ * Insert @node directly after @pos
+ */
+static inline void ls_dlist_insert_after(LsDListNode *pos, LsDListNode *node)
+{
+        ls_dlist_link_between(node, pos, pos->next);
+}
+
+/**
+ * Insert @node directly before @pos
+ */
+static inline void ls_dlist_insert_before(LsDListNode *pos, LsDListNode *node)
+{
+        ls_dlist_link_between(node, pos->prev, pos);
+}
+
+/**
+ * Insert @node at the front of the list
+ */
+static inline void ls_dlist_push_front(LsDList *list, LsDListNode *node)
+{
+        ls_dlist_insert_after(&list->head, node);
+}
+
+/**
+ * Insert @node at the back of the list
+ */
+static inline void ls_dlist_push_back(LsDList *list, LsDListNode *node)
+{
+        ls_dlist_insert_before(&list->head, node);
+}
+
+/**
+ * Remove @node from whichever list it is in, leaving it unlinked
+ */
+static inline void ls_dlist_unlink(LsDListNode *node)
+{
+        node->prev->next = node->next;
+        node->next->prev = node->prev;
+        ls_dlist_node_init(node);
+}
+
+/**
+ * Return the first node in the list, or NULL if empty
+ */
+static inline LsDListNode *ls_dlist_first(const LsDList *list)
+{
+        return ls_dlist_is_empty(list) ? NULL : list->head.next;
+}
+
+/**
+ * Return the last node in the list, or NULL if empty
+ */
+static inline LsDListNode *ls_dlist_last(const LsDList *list)
+{
+        return ls_dlist_is_empty(list) ? NULL : list->head.prev;
+}
+
+/**
+ * Unlink and return the first node in the list, or NULL if empty
+ */
+static inline LsDListNode *ls_dlist_pop_front(LsDList *list)
+{
+        LsDListNode *node = ls_dlist_first(list);
+
+        if (node) {
+                ls_dlist_unlink(node);
+        }
+        return node;
+}
+
+/**
+ * Unlink and return the last node in the list, or NULL if empty
+ */
+static inline LsDListNode *ls_dlist_pop_back(LsDList *list)
+{
+        LsDListNode *node = ls_dlist_last(list);
+
+        if (node) {
+                ls_dlist_unlink(node);
+        }
+        return node;
+}
+
+/**
+ * Move @node, which may be in any list, to the front of @list
+ */
+static inline void ls_dlist_move_to_front(LsDList *list, LsDListNode *node)
+{
+        ls_dlist_unlink(node);
+        ls_dlist_push_front(list, node);
+}
+
+/**
+ * Move @node, which may be in any list, to the back of @list
+ */
+static inline void ls_dlist_move_to_back(LsDList *list, LsDListNode *node)
+{
+        ls_dlist_unlink(node);
+        ls_dlist_push_back(list, node);
+}
+
+/**
+ * Move every node from @other to the back of @list, leaving @other empty
+ */
+static inline void ls_dlist_splice_back(LsDList *list, LsDList *other)
+{
+        LsDListNode *first = other->head.next;
+        LsDListNode *last = other->head.prev;
+
+        if (ls_dlist_is_empty(other)) {
+                return;
+        }
+
+        first->prev = list->head.prev;
+        list->head.prev->next = first;
+        last->next = &list->head;
+        list->head.prev = last;
+
+        ls_dlist_init(other);
+}
+
+/**
+ * Move every node from @other to the front of @list, leaving @other empty
+ */
+static inline void ls_dlist_splice_front(LsDList *list, LsDList *other)
+{
+        LsDListNode *first = other->head.next;
+        LsDListNode *last = other->head.prev;
+
+        if (ls_dlist_is_empty(other)) {
+                return;
+        }
+
+        last->next = list->head.next;
+        list->head.next->prev = last;
+        first->prev = &list->head;
+        list->head.next = first;
+
+        ls_dlist_init(other);
+}
+
+/**
+ * Count the members of the list, O(N)
+ */
+static inline size_t ls_dlist_length(const LsDList *list)
+{
+        size_t ret = 0;
+
+        for (const LsDListNode *node = list->head.next; node != &list->head; node = node->next) {
+                ++ret;
+        }
+        return ret;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
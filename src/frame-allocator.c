@@ -0,0 +1,149 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdlib.h>
+
+#include "arena.h"
+#include "frame-allocator.h"
+
+/**
+ * Opaque LsFrameAllocator implementation
+ */
+struct LsFrameAllocator {
+        LsArena **regions;     /**<Ring of per-frame arenas */
+        unsigned int n_frames; /**<Size of the ring */
+        uint64_t frame;        /**<Current frame number */
+        LsArena *current;      /**<Region for the current frame */
+        LsAllocator allocator; /**<Exposes the current frame to containers */
+};
+
+/**
+ * LsAllocator glue, always targets the current frame
+ */
+static void *ls_frame_allocator_glue_alloc(void *context, size_t size)
+{
+        return ls_frame_allocator_alloc(context, size);
+}
+
+static void *ls_frame_allocator_glue_realloc(void *context, void *ptr, size_t old_size,
+                                             size_t new_size)
+{
+        LsFrameAllocator *self = context;
+
+        /* Blocks from an earlier frame are never the arena tail, so get copied */
+        return ls_arena_realloc(self->current, ptr, old_size, new_size);
+}
+
+LsFrameAllocator *ls_frame_allocator_new(unsigned int n_frames, size_t chunk_size)
+{
+        LsFrameAllocator *ret = NULL;
+
+        if (ls_unlikely(n_frames == 0)) {
+                return NULL;
+        }
+
+        ret = calloc(1, sizeof(struct LsFrameAllocator));
+        if (!ret) {
+                return NULL;
+        }
+        ret->n_frames = n_frames;
+
+        ret->regions = calloc(n_frames, sizeof(LsArena *));
+        if (!ret->regions) {
+                goto failed;
+        }
+        for (unsigned int i = 0; i < n_frames; i++) {
+                ret->regions[i] = ls_arena_new(chunk_size);
+                if (!ret->regions[i]) {
+                        goto failed;
+                }
+        }
+
+        ret->current = ret->regions[0];
+        ret->allocator = (LsAllocator){
+                .alloc = ls_frame_allocator_glue_alloc,
+                .realloc = ls_frame_allocator_glue_realloc,
+                .free = NULL,
+                .context = ret,
+        };
+
+        return ret;
+
+failed:
+        ls_frame_allocator_free(ret);
+        return NULL;
+}
+
+void ls_frame_allocator_free(LsFrameAllocator *self)
+{
+        if (ls_unlikely(!self)) {
+                return;
+        }
+        if (self->regions) {
+                for (unsigned int i = 0; i < self->n_frames; i++) {
+                        ls_arena_free(self->regions[i]);
+                }
+                free(self->regions);
+        }
+        free(self);
+}
+
+uint64_t ls_frame_allocator_next_frame(LsFrameAllocator *self)
+{
+        ++self->frame;
+        self->current = self->regions[self->frame % self->n_frames];
+        ls_arena_reset(self->current);
+        return self->frame;
+}
+
+uint64_t ls_frame_allocator_frame(LsFrameAllocator *self)
+{
+        return self->frame;
+}
+
+void *ls_frame_allocator_alloc(LsFrameAllocator *self, size_t size)
+{
+        return ls_arena_alloc(self->current, size);
+}
+
+void *ls_frame_allocator_alloc0(LsFrameAllocator *self, size_t size)
+{
+        return ls_arena_alloc0(self->current, size);
+}
+
+const LsAllocator *ls_frame_allocator_allocator(LsFrameAllocator *self)
+{
+        return &self->allocator;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,104 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "macros.h"
+
+/**
+ * LsFrameAllocator hands out transient memory for a game loop or any
+ * other frame-driven workload. It owns a ring of arenas, one per frame in
+ * flight, and each call to ls_frame_allocator_next_frame moves on to the
+ * next arena in the ring and resets it.
+ *
+ * With n_frames regions, data allocated in frame N remains valid up to
+ * and including frame N + n_frames - 1, so 2 gives classic double
+ * buffering. Region chunks are retained across resets, so a steady state
+ * loop stops touching the heap entirely.
+ *
+ * The frame allocator is not thread-safe.
+ */
+typedef struct LsFrameAllocator LsFrameAllocator;
+
+/**
+ * Construct a new LsFrameAllocator
+ *
+ * @param n_frames Number of frames each allocation survives, at least 1
+ * @param chunk_size Chunk size of each region, or 0 for the arena default
+ *
+ * @note Free with ls_frame_allocator_free
+ */
+LsFrameAllocator *ls_frame_allocator_new(unsigned int n_frames, size_t chunk_size);
+
+/**
+ * Free the frame allocator and every region, invalidating all allocations
+ */
+void ls_frame_allocator_free(LsFrameAllocator *frame);
+
+/**
+ * Start a new frame, releasing everything allocated n_frames ago
+ *
+ * @returns The new frame number, starting from 0 at construction
+ */
+uint64_t ls_frame_allocator_next_frame(LsFrameAllocator *frame);
+
+/**
+ * Return the current frame number
+ */
+uint64_t ls_frame_allocator_frame(LsFrameAllocator *frame);
+
+/**
+ * Allocate @size bytes in the current frame, aligned for any type. The
+ * memory is uninitialised.
+ */
+void *ls_frame_allocator_alloc(LsFrameAllocator *frame, size_t size);
+
+/**
+ * Allocate @size zeroed bytes in the current frame
+ */
+void *ls_frame_allocator_alloc0(LsFrameAllocator *frame, size_t size);
+
+/**
+ * Return an LsAllocator drawing from whichever frame is current at the
+ * time of each call, valid for the lifetime of the frame allocator. Its
+ * free is a no-op.
+ *
+ * @note A container grown in a later frame than it was created in holds
+ * storage from both, and is only valid as long as the oldest of them.
+ */
+const LsAllocator *ls_frame_allocator_allocator(LsFrameAllocator *frame);
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
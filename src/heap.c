@@ -0,0 +1,349 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdlib.h>
+
+#include "heap.h"
+
+/**
+ * A single inline entry
+ */
+typedef struct LsHeapEntry {
+        double priority;
+        void *data;
+        LsHeapHandle handle;
+} LsHeapEntry;
+
+/**
+ * Opaque LsHeap implementation
+ */
+struct LsHeap {
+        unsigned int arity; /**<Children per node */
+
+        struct {
+                LsHeapEntry *blob; /**<Entries in heap order */
+                uint32_t len;      /**<Live entries */
+                uint32_t size;     /**<Allocated entries */
+        } entries;
+
+        /**
+         * Maps a handle to its current index in the entries. Unused
+         * handles are kept on a stack for reuse.
+         */
+        struct {
+                uint32_t *positions; /**<Index of each handle, or INVALID */
+                uint32_t *unused;    /**<Stack of free handles */
+                uint32_t n_unused;   /**<Depth of the stack */
+                uint32_t len;        /**<Handles issued so far */
+                uint32_t size;       /**<Allocated handles */
+        } handles;
+};
+
+LsHeap *ls_heap_new(void)
+{
+        return ls_heap_new_arity(LS_HEAP_DEFAULT_ARITY);
+}
+
+LsHeap *ls_heap_new_arity(unsigned int arity)
+{
+        LsHeap *ret = NULL;
+
+        if (ls_unlikely(arity < 2)) {
+                return NULL;
+        }
+
+        ret = calloc(1, sizeof(struct LsHeap));
+        if (!ret) {
+                return NULL;
+        }
+        ret->arity = arity;
+        return ret;
+}
+
+void ls_heap_free(LsHeap *self)
+{
+        if (ls_unlikely(!self)) {
+                return;
+        }
+        free(self->entries.blob);
+        free(self->handles.positions);
+        free(self->handles.unused);
+        free(self);
+}
+
+/**
+ * Make room for at least @min entries and handles
+ */
+static bool ls_heap_reserve(LsHeap *self, uint32_t min)
+{
+        uint32_t size;
+        LsHeapEntry *entries = NULL;
+        uint32_t *positions = NULL;
+        uint32_t *unused = NULL;
+
+        if (ls_likely(min <= self->entries.size && min <= self->handles.size)) {
+                return true;
+        }
+        if (min >= LS_HEAP_INVALID_HANDLE / 2) {
+                return false;
+        }
+
+        size = self->entries.size ? self->entries.size : 16;
+        while (size < min) {
+                size *= 2;
+        }
+
+        entries = realloc(self->entries.blob, size * sizeof(LsHeapEntry));
+        if (!entries) {
+                return false;
+        }
+        self->entries.blob = entries;
+        self->entries.size = size;
+
+        positions = realloc(self->handles.positions, size * sizeof(uint32_t));
+        if (!positions) {
+                return false;
+        }
+        self->handles.positions = positions;
+
+        unused = realloc(self->handles.unused, size * sizeof(uint32_t));
+        if (!unused) {
+                return false;
+        }
+        self->handles.unused = unused;
+        self->handles.size = size;
+
+        return true;
+}
+
+/**
+ * Place @entry at @index and record its position
+ */
+static inline void ls_heap_place(LsHeap *self, uint32_t index, LsHeapEntry entry)
+{
+        self->entries.blob[index] = entry;
+        self->handles.positions[entry.handle] = index;
+}
+
+/**
+ * Move the entry at @index towards the root until its parent is smaller
+ */
+static void ls_heap_sift_up(LsHeap *self, uint32_t index)
+{
+        LsHeapEntry entry = self->entries.blob[index];
+
+        while (index > 0) {
+                uint32_t parent = (index - 1) / self->arity;
+                if (self->entries.blob[parent].priority <= entry.priority) {
+                        break;
+                }
+                ls_heap_place(self, index, self->entries.blob[parent]);
+                index = parent;
+        }
+        ls_heap_place(self, index, entry);
+}
+
+/**
+ * Move the entry at @index towards the leaves until no child is smaller
+ */
+static void ls_heap_sift_down(LsHeap *self, uint32_t index)
+{
+        LsHeapEntry entry = self->entries.blob[index];
+        uint32_t len = self->entries.len;
+
+        for (;;) {
+                uint32_t first = index * self->arity + 1;
+                uint32_t last = first + self->arity;
+                uint32_t best = first;
+
+                if (first >= len) {
+                        break;
+                }
+                if (last > len) {
+                        last = len;
+                }
+
+                /* Siblings are adjacent, so this is a short linear scan */
+                for (uint32_t child = first + 1; child < last; child++) {
+                        if (self->entries.blob[child].priority <
+                            self->entries.blob[best].priority) {
+                                best = child;
+                        }
+                }
+                if (self->entries.blob[best].priority >= entry.priority) {
+                        break;
+                }
+                ls_heap_place(self, index, self->entries.blob[best]);
+                index = best;
+        }
+        ls_heap_place(self, index, entry);
+}
+
+/**
+ * Grab an unused handle. Storage must already be reserved.
+ */
+static LsHeapHandle ls_heap_handle_new(LsHeap *self)
+{
+        if (self->handles.n_unused > 0) {
+                return self->handles.unused[--self->handles.n_unused];
+        }
+        return self->handles.len++;
+}
+
+LsHeap *ls_heap_new_from_array(LsArray *array, ls_heap_priority_func priority,
+                               unsigned int arity)
+{
+        LsHeap *ret = NULL;
+
+        if (ls_unlikely(!array || !priority)) {
+                return NULL;
+        }
+
+        ret = ls_heap_new_arity(arity);
+        if (!ret) {
+                return NULL;
+        }
+        if (!ls_heap_reserve(ret, array->len)) {
+                ls_heap_free(ret);
+                return NULL;
+        }
+
+        for (uint32_t i = 0; i < array->len; i++) {
+                LsHeapEntry entry = {
+                        .priority = priority(array->data[i]),
+                        .data = array->data[i],
+                        .handle = i,
+                };
+                ls_heap_place(ret, i, entry);
+        }
+        ret->entries.len = array->len;
+        ret->handles.len = array->len;
+
+        /* Floyd's bottom-up heapify, starting from the last parent */
+        if (ret->entries.len > 1) {
+                for (uint32_t i = (ret->entries.len - 2) / ret->arity + 1; i-- > 0;) {
+                        ls_heap_sift_down(ret, i);
+                }
+        }
+
+        return ret;
+}
+
+LsHeapHandle ls_heap_push(LsHeap *self, double priority, void *data)
+{
+        LsHeapEntry entry = { .priority = priority, .data = data };
+
+        if (ls_unlikely(!self)) {
+                return LS_HEAP_INVALID_HANDLE;
+        }
+        if (!ls_heap_reserve(self, self->entries.len + 1)) {
+                return LS_HEAP_INVALID_HANDLE;
+        }
+
+        entry.handle = ls_heap_handle_new(self);
+        ls_heap_place(self, self->entries.len, entry);
+        ls_heap_sift_up(self, self->entries.len++);
+
+        return entry.handle;
+}
+
+bool ls_heap_peek(LsHeap *self, double *priority, void **data)
+{
+        if (ls_unlikely(!self || self->entries.len == 0)) {
+                return false;
+        }
+        if (priority) {
+                *priority = self->entries.blob[0].priority;
+        }
+        if (data) {
+                *data = self->entries.blob[0].data;
+        }
+        return true;
+}
+
+bool ls_heap_pop(LsHeap *self, double *priority, void **data)
+{
+        LsHeapEntry top;
+
+        if (!ls_heap_peek(self, priority, data)) {
+                return false;
+        }
+
+        top = self->entries.blob[0];
+        self->handles.positions[top.handle] = LS_HEAP_INVALID_HANDLE;
+        self->handles.unused[self->handles.n_unused++] = top.handle;
+
+        /* Move the last entry into the hole and let it settle */
+        if (--self->entries.len > 0) {
+                ls_heap_place(self, 0, self->entries.blob[self->entries.len]);
+                ls_heap_sift_down(self, 0);
+        }
+
+        return true;
+}
+
+bool ls_heap_contains(LsHeap *self, LsHeapHandle handle)
+{
+        if (ls_unlikely(!self || handle >= self->handles.len)) {
+                return false;
+        }
+        return self->handles.positions[handle] != LS_HEAP_INVALID_HANDLE;
+}
+
+bool ls_heap_decrease_key(LsHeap *self, LsHeapHandle handle, double priority)
+{
+        uint32_t index;
+
+        if (!ls_heap_contains(self, handle)) {
+                return false;
+        }
+
+        index = self->handles.positions[handle];
+        if (priority > self->entries.blob[index].priority) {
+                return false;
+        }
+
+        self->entries.blob[index].priority = priority;
+        ls_heap_sift_up(self, index);
+        return true;
+}
+
+unsigned int ls_heap_size(LsHeap *self)
+{
+        if (ls_unlikely(!self)) {
+                return 0;
+        }
+        return self->entries.len;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,146 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "array.h"
+
+/**
+ * LsHeap is a d-ary min-heap priority queue. Entries hold their priority
+ * and data pointer inline in one contiguous array, and each level fans
+ * out to several children so that a sift touches few cache lines. The
+ * default arity of 4 places all children of a node side by side.
+ *
+ * Every push returns a stable handle, which may be used to lower the
+ * priority of an entry already in the queue (decrease-key), as required
+ * by A* and Dijkstra open sets.
+ */
+typedef struct LsHeap LsHeap;
+
+/**
+ * Stable reference to an entry in a heap, valid until it is popped
+ */
+typedef uint32_t LsHeapHandle;
+
+/**
+ * Returned when an entry could not be pushed
+ */
+#define LS_HEAP_INVALID_HANDLE UINT32_MAX
+
+/**
+ * Default arity, a good fit for 64-byte cache lines
+ */
+#define LS_HEAP_DEFAULT_ARITY 4
+
+/**
+ * Compute the priority for an item when heapifying an array
+ */
+typedef double (*ls_heap_priority_func)(const void *data);
+
+/**
+ * Construct a new, empty, 4-ary heap
+ */
+LsHeap *ls_heap_new(void);
+
+/**
+ * Construct a new, empty, heap with the given arity, which must be at
+ * least 2.
+ */
+LsHeap *ls_heap_new_arity(unsigned int arity);
+
+/**
+ * Construct a heap holding every item in @array, in O(N). The item at
+ * index i of the array is given the handle i.
+ *
+ * @param array Items to insert, which are not copied
+ * @param priority Function computing the priority of each item
+ * @param arity Arity of the new heap
+ */
+LsHeap *ls_heap_new_from_array(LsArray *array, ls_heap_priority_func priority,
+                               unsigned int arity);
+
+/**
+ * Free a previously allocated heap. Data pointers are not freed.
+ */
+void ls_heap_free(LsHeap *heap);
+
+/**
+ * Push @data with the given @priority, lower values being popped first
+ *
+ * @returns Handle for the new entry, or LS_HEAP_INVALID_HANDLE on failure
+ */
+LsHeapHandle ls_heap_push(LsHeap *heap, double priority, void *data);
+
+/**
+ * Look at the entry with the lowest priority without removing it
+ *
+ * @param priority Storage for the priority, may be NULL
+ * @param data Storage for the data pointer, may be NULL
+ *
+ * @returns False if the heap is empty
+ */
+bool ls_heap_peek(LsHeap *heap, double *priority, void **data);
+
+/**
+ * Remove the entry with the lowest priority. Its handle becomes invalid
+ * and may be reused by a later push.
+ *
+ * @param priority Storage for the priority, may be NULL
+ * @param data Storage for the data pointer, may be NULL
+ *
+ * @returns False if the heap is empty
+ */
+bool ls_heap_pop(LsHeap *heap, double *priority, void **data);
+
+/**
+ * Lower the priority of the entry referenced by @handle
+ *
+ * @returns False if the handle is not in the heap, or @priority is
+ * greater than the current priority
+ */
+bool ls_heap_decrease_key(LsHeap *heap, LsHeapHandle handle, double priority);
+
+/**
+ * Determine whether @handle still refers to an entry in the heap
+ */
+bool ls_heap_contains(LsHeap *heap, LsHeapHandle handle);
+
+/**
+ * Return the number of entries in the heap
+ */
+unsigned int ls_heap_size(LsHeap *heap);
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
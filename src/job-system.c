@@ -0,0 +1,744 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "job-system.h"
+#include "pool.h"
+
+/**
+ * Separate the hot atomics of each deque, and each worker, onto their
+ * own cache lines
+ */
+#define LS_JOB_CACHE_LINE 64
+
+/**
+ * Initial slots in each deque, doubled whenever it fills
+ */
+#define LS_JOB_DEQUE_SIZE 256
+
+/**
+ * Unsuccessful passes over every queue before a worker parks
+ */
+#define LS_JOB_SPIN_ROUNDS 64
+
+/**
+ * Pieces of a parallel_for handed to each thread when picking a grain
+ */
+#define LS_JOB_PIECES_PER_THREAD 4
+
+struct LsJob {
+        ls_job_func func;
+        void *data;
+        LsJobCounter *counter;
+        struct LsJob *next; /**<Chains the injection queue and counter waiters */
+};
+
+/**
+ * Circular slot array of a deque. Superseded buffers are kept until the
+ * deque is destroyed, as a thief may still be reading from one.
+ */
+typedef struct LsJobDequeBuffer {
+        struct LsJobDequeBuffer *retired;
+        int64_t mask;
+        _Atomic(LsJob *) slots[];
+} LsJobDequeBuffer;
+
+/**
+ * Chase-Lev deque: the owner pushes and pops at the bottom, thieves take
+ * from the top. Only the last remaining job is contended.
+ */
+typedef struct LsJobDeque {
+        _Alignas(LS_JOB_CACHE_LINE) _Atomic int64_t top;
+        _Alignas(LS_JOB_CACHE_LINE) _Atomic int64_t bottom;
+        _Atomic(LsJobDequeBuffer *) buffer;
+} LsJobDeque;
+
+typedef struct LsJobWorker {
+        LsJobDeque deque;
+        LsJobSystem *system;
+        pthread_t thread;
+        unsigned int index;
+} LsJobWorker;
+
+/**
+ * A slice of a parallel_for still to be split or run
+ */
+typedef struct LsJobRange {
+        LsJobSystem *system;
+        ls_job_range_func func;
+        void *data;
+        size_t begin;
+        size_t end;
+        size_t grain;
+        LsJobCounter *counter;
+} LsJobRange;
+
+/**
+ * Opaque LsJobSystem implementation
+ */
+struct LsJobSystem {
+        LsJobWorker *workers;       /**<Cache aligned worker array */
+        unsigned int n_workers;     /**<Number of workers, each with a deque */
+        unsigned int n_threads;     /**<Worker threads actually started */
+        LsPool *job_pool;           /**<Recycles LsJob */
+        LsPool *range_pool;         /**<Recycles LsJobRange */
+        atomic_size_t n_queued;     /**<Jobs sitting in any queue */
+        atomic_uint n_sleeping;     /**<Parked workers */
+        atomic_bool running;        /**<Cleared to stop the workers */
+        atomic_size_t n_injected;   /**<Jobs in the injection queue */
+        pthread_mutex_t inject_lock; /**<Guards the injection queue */
+        LsJob *inject_head;
+        LsJob *inject_tail;
+        pthread_mutex_t sleep_lock; /**<Guards parking */
+        pthread_cond_t sleep_cond;
+};
+
+/**
+ * Worker running on this thread, if any
+ */
+static _Thread_local LsJobWorker *ls_job_worker_self = NULL;
+
+/**
+ * Victim selection state for this thread
+ */
+static _Thread_local uint32_t ls_job_steal_seed = 0;
+
+/**
+ * Shared job system for callers that don't bring their own
+ */
+static LsJobSystem *ls_job_system_default = NULL;
+static pthread_once_t ls_job_system_default_once = PTHREAD_ONCE_INIT;
+
+static LsJobDequeBuffer *ls_job_deque_buffer_new(int64_t size)
+{
+        LsJobDequeBuffer *ret = NULL;
+
+        ret = calloc(1, sizeof(LsJobDequeBuffer) + (size_t)size * sizeof(_Atomic(LsJob *)));
+        if (ls_unlikely(!ret)) {
+                return NULL;
+        }
+        ret->mask = size - 1;
+        return ret;
+}
+
+static bool ls_job_deque_init(LsJobDeque *deque)
+{
+        LsJobDequeBuffer *buffer = ls_job_deque_buffer_new(LS_JOB_DEQUE_SIZE);
+
+        if (ls_unlikely(!buffer)) {
+                return false;
+        }
+        atomic_init(&deque->top, 0);
+        atomic_init(&deque->bottom, 0);
+        atomic_init(&deque->buffer, buffer);
+        return true;
+}
+
+static void ls_job_deque_destroy(LsJobDeque *deque)
+{
+        LsJobDequeBuffer *buffer = atomic_load_explicit(&deque->buffer, memory_order_relaxed);
+
+        while (buffer) {
+                LsJobDequeBuffer *retired = buffer->retired;
+                free(buffer);
+                buffer = retired;
+        }
+}
+
+/**
+ * Push a job onto the bottom of the deque. Owner only.
+ */
+static bool ls_job_deque_push(LsJobDeque *deque, LsJob *job)
+{
+        int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+        int64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+        LsJobDequeBuffer *buffer = atomic_load_explicit(&deque->buffer, memory_order_relaxed);
+
+        if (bottom - top > buffer->mask) {
+                LsJobDequeBuffer *grown = ls_job_deque_buffer_new((buffer->mask + 1) * 2);
+                if (ls_unlikely(!grown)) {
+                        return false;
+                }
+                for (int64_t i = top; i < bottom; i++) {
+                        LsJob *moved = atomic_load_explicit(&buffer->slots[i & buffer->mask],
+                                                            memory_order_relaxed);
+                        atomic_store_explicit(&grown->slots[i & grown->mask],
+                                              moved,
+                                              memory_order_relaxed);
+                }
+                grown->retired = buffer;
+                atomic_store_explicit(&deque->buffer, grown, memory_order_release);
+                buffer = grown;
+        }
+
+        atomic_store_explicit(&buffer->slots[bottom & buffer->mask], job, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return true;
+}
+
+/**
+ * Pop the most recently pushed job from the bottom of the deque. Owner only.
+ */
+static LsJob *ls_job_deque_pop(LsJobDeque *deque)
+{
+        int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+        LsJobDequeBuffer *buffer = atomic_load_explicit(&deque->buffer, memory_order_relaxed);
+        LsJob *ret = NULL;
+        int64_t top = 0;
+
+        atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+        if (top > bottom) {
+                /* Already empty */
+                atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+                return NULL;
+        }
+
+        ret = atomic_load_explicit(&buffer->slots[bottom & buffer->mask], memory_order_relaxed);
+        if (top == bottom) {
+                /* Last job, race any thieves for it */
+                if (!atomic_compare_exchange_strong_explicit(&deque->top,
+                                                             &top,
+                                                             top + 1,
+                                                             memory_order_seq_cst,
+                                                             memory_order_relaxed)) {
+                        ret = NULL;
+                }
+                atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        }
+        return ret;
+}
+
+/**
+ * Steal the oldest job from the top of the deque. Any thread.
+ */
+static LsJob *ls_job_deque_steal(LsJobDeque *deque)
+{
+        int64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+        int64_t bottom = 0;
+        LsJobDequeBuffer *buffer = NULL;
+        LsJob *ret = NULL;
+
+        atomic_thread_fence(memory_order_seq_cst);
+        bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+        if (top >= bottom) {
+                return NULL;
+        }
+
+        buffer = atomic_load_explicit(&deque->buffer, memory_order_acquire);
+        ret = atomic_load_explicit(&buffer->slots[top & buffer->mask], memory_order_relaxed);
+        if (!atomic_compare_exchange_strong_explicit(&deque->top,
+                                                     &top,
+                                                     top + 1,
+                                                     memory_order_seq_cst,
+                                                     memory_order_relaxed)) {
+                /* Lost to the owner or another thief */
+                return NULL;
+        }
+        return ret;
+}
+
+static inline void ls_job_counter_lock(LsJobCounter *counter)
+{
+        while (atomic_flag_test_and_set_explicit(&counter->lock, memory_order_acquire)) {
+                sched_yield();
+        }
+}
+
+static inline void ls_job_counter_unlock(LsJobCounter *counter)
+{
+        atomic_flag_clear_explicit(&counter->lock, memory_order_release);
+}
+
+void ls_job_counter_init(LsJobCounter *counter)
+{
+        atomic_init(&counter->pending, 0);
+        atomic_flag_clear(&counter->lock);
+        counter->waiters = NULL;
+}
+
+bool ls_job_counter_is_done(LsJobCounter *counter)
+{
+        return atomic_load_explicit(&counter->pending, memory_order_acquire) == 0;
+}
+
+/**
+ * Wake a parked worker if there are any
+ */
+static void ls_job_system_wake(LsJobSystem *self)
+{
+        if (atomic_load(&self->n_sleeping) == 0) {
+                return;
+        }
+        pthread_mutex_lock(&self->sleep_lock);
+        pthread_cond_signal(&self->sleep_cond);
+        pthread_mutex_unlock(&self->sleep_lock);
+}
+
+/**
+ * Make a job available to run, preferring the local deque when called
+ * from one of our own workers
+ */
+static void ls_job_system_enqueue(LsJobSystem *self, LsJob *job)
+{
+        LsJobWorker *worker = ls_job_worker_self;
+
+        /* Counted before it becomes visible so a taker can't underflow */
+        atomic_fetch_add(&self->n_queued, 1);
+
+        if (!worker || worker->system != self || !ls_job_deque_push(&worker->deque, job)) {
+                job->next = NULL;
+                pthread_mutex_lock(&self->inject_lock);
+                if (self->inject_tail) {
+                        self->inject_tail->next = job;
+                } else {
+                        self->inject_head = job;
+                }
+                self->inject_tail = job;
+                atomic_fetch_add_explicit(&self->n_injected, 1, memory_order_relaxed);
+                pthread_mutex_unlock(&self->inject_lock);
+        }
+
+        ls_job_system_wake(self);
+}
+
+static LsJob *ls_job_system_take_injected(LsJobSystem *self)
+{
+        LsJob *ret = NULL;
+
+        if (atomic_load_explicit(&self->n_injected, memory_order_relaxed) == 0) {
+                return NULL;
+        }
+
+        pthread_mutex_lock(&self->inject_lock);
+        ret = self->inject_head;
+        if (ret) {
+                self->inject_head = ret->next;
+                if (!self->inject_head) {
+                        self->inject_tail = NULL;
+                }
+                atomic_fetch_sub_explicit(&self->n_injected, 1, memory_order_relaxed);
+        }
+        pthread_mutex_unlock(&self->inject_lock);
+
+        return ret;
+}
+
+/**
+ * Find a job for this thread: our own deque first, then the injection
+ * queue, then the other workers starting from a random victim
+ */
+static LsJob *ls_job_system_find(LsJobSystem *self, LsJobWorker *worker)
+{
+        LsJob *ret = NULL;
+        unsigned int start = 0;
+
+        if (worker) {
+                ret = ls_job_deque_pop(&worker->deque);
+        }
+        if (!ret) {
+                ret = ls_job_system_take_injected(self);
+        }
+        if (!ret) {
+                /* xorshift, seeded lazily per thread */
+                uint32_t seed = ls_job_steal_seed;
+                if (seed == 0) {
+                        seed = (uint32_t)(uintptr_t)&ls_job_steal_seed | 1u;
+                }
+                seed ^= seed << 13;
+                seed ^= seed >> 17;
+                seed ^= seed << 5;
+                ls_job_steal_seed = seed;
+                start = seed % self->n_workers;
+
+                for (unsigned int i = 0; i < self->n_workers && !ret; i++) {
+                        unsigned int victim = (start + i) % self->n_workers;
+                        if (worker && victim == worker->index) {
+                                continue;
+                        }
+                        ret = ls_job_deque_steal(&self->workers[victim].deque);
+                }
+        }
+
+        if (ret) {
+                atomic_fetch_sub(&self->n_queued, 1);
+        }
+        return ret;
+}
+
+/**
+ * Drop one job from the counter, releasing its dependents on the last.
+ * The decrement happens under the counter lock so that a waiter, which
+ * takes the lock before returning, can't free the counter under us.
+ */
+static void ls_job_counter_finish(LsJobSystem *self, LsJobCounter *counter)
+{
+        LsJob *waiters = NULL;
+
+        ls_job_counter_lock(counter);
+        if (atomic_fetch_sub_explicit(&counter->pending, 1, memory_order_acq_rel) == 1) {
+                waiters = counter->waiters;
+                counter->waiters = NULL;
+        }
+        ls_job_counter_unlock(counter);
+
+        while (waiters) {
+                LsJob *next = waiters->next;
+                ls_job_system_enqueue(self, waiters);
+                waiters = next;
+        }
+}
+
+/**
+ * Run a job and retire it. The job is recycled first, so a job that
+ * submits more work can reuse its own slot.
+ */
+static void ls_job_system_run(LsJobSystem *self, LsJob *job)
+{
+        ls_job_func func = job->func;
+        void *data = job->data;
+        LsJobCounter *counter = job->counter;
+
+        ls_pool_release(self->job_pool, job);
+        func(data);
+
+        if (counter) {
+                ls_job_counter_finish(self, counter);
+        }
+}
+
+static void *ls_job_worker_main(void *v)
+{
+        LsJobWorker *self = v;
+        LsJobSystem *system = self->system;
+
+        ls_job_worker_self = self;
+
+        while (atomic_load_explicit(&system->running, memory_order_acquire)) {
+                LsJob *job = NULL;
+
+                for (int i = 0; i < LS_JOB_SPIN_ROUNDS && !job; i++) {
+                        job = ls_job_system_find(system, self);
+                        if (!job && i > LS_JOB_SPIN_ROUNDS / 2) {
+                                sched_yield();
+                        }
+                }
+                if (job) {
+                        ls_job_system_run(system, job);
+                        continue;
+                }
+
+                /* Announce we're parking before the final check, pairing
+                 * with the increment-then-check in ls_job_system_enqueue */
+                pthread_mutex_lock(&system->sleep_lock);
+                atomic_fetch_add(&system->n_sleeping, 1);
+                while (atomic_load(&system->n_queued) == 0 &&
+                       atomic_load_explicit(&system->running, memory_order_acquire)) {
+                        pthread_cond_wait(&system->sleep_cond, &system->sleep_lock);
+                }
+                atomic_fetch_sub(&system->n_sleeping, 1);
+                pthread_mutex_unlock(&system->sleep_lock);
+        }
+
+        ls_job_worker_self = NULL;
+        return NULL;
+}
+
+LsJobSystem *ls_job_system_new(unsigned int n_workers)
+{
+        LsJobSystem *ret = NULL;
+
+        if (n_workers == 0) {
+                long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+                n_workers = n_cpus > 0 ? (unsigned int)n_cpus : 1;
+        }
+
+        ret = calloc(1, sizeof(LsJobSystem));
+        if (ls_unlikely(!ret)) {
+                return NULL;
+        }
+
+        ret->workers = aligned_alloc(LS_JOB_CACHE_LINE, n_workers * sizeof(LsJobWorker));
+        ret->job_pool = ls_pool_new(sizeof(LsJob));
+        ret->range_pool = ls_pool_new(sizeof(LsJobRange));
+        if (ls_unlikely(!ret->workers || !ret->job_pool || !ret->range_pool)) {
+                goto fail;
+        }
+
+        ret->n_workers = n_workers;
+        atomic_init(&ret->n_queued, 0);
+        atomic_init(&ret->n_sleeping, 0);
+        atomic_init(&ret->running, true);
+        atomic_init(&ret->n_injected, 0);
+        pthread_mutex_init(&ret->inject_lock, NULL);
+        pthread_mutex_init(&ret->sleep_lock, NULL);
+        pthread_cond_init(&ret->sleep_cond, NULL);
+
+        /* Every deque must exist before any thief can look at it */
+        for (unsigned int i = 0; i < n_workers; i++) {
+                LsJobWorker *worker = &ret->workers[i];
+                if (ls_unlikely(!ls_job_deque_init(&worker->deque))) {
+                        for (unsigned int j = 0; j < i; j++) {
+                                ls_job_deque_destroy(&ret->workers[j].deque);
+                        }
+                        goto fail_sync;
+                }
+                worker->system = ret;
+                worker->index = i;
+        }
+
+        for (ret->n_threads = 0; ret->n_threads < n_workers; ret->n_threads++) {
+                LsJobWorker *worker = &ret->workers[ret->n_threads];
+                if (pthread_create(&worker->thread, NULL, ls_job_worker_main, worker) != 0) {
+                        ls_job_system_free(ret);
+                        return NULL;
+                }
+        }
+
+        return ret;
+
+fail_sync:
+        pthread_cond_destroy(&ret->sleep_cond);
+        pthread_mutex_destroy(&ret->sleep_lock);
+        pthread_mutex_destroy(&ret->inject_lock);
+fail:
+        if (ret->range_pool) {
+                ls_pool_free(ret->range_pool);
+        }
+        if (ret->job_pool) {
+                ls_pool_free(ret->job_pool);
+        }
+        free(ret->workers);
+        free(ret);
+        return NULL;
+}
+
+void ls_job_system_free(LsJobSystem *self)
+{
+        if (ls_unlikely(!self)) {
+                return;
+        }
+
+        atomic_store_explicit(&self->running, false, memory_order_release);
+        pthread_mutex_lock(&self->sleep_lock);
+        pthread_cond_broadcast(&self->sleep_cond);
+        pthread_mutex_unlock(&self->sleep_lock);
+
+        for (unsigned int i = 0; i < self->n_threads; i++) {
+                pthread_join(self->workers[i].thread, NULL);
+        }
+        for (unsigned int i = 0; i < self->n_workers; i++) {
+                ls_job_deque_destroy(&self->workers[i].deque);
+        }
+
+        pthread_cond_destroy(&self->sleep_cond);
+        pthread_mutex_destroy(&self->sleep_lock);
+        pthread_mutex_destroy(&self->inject_lock);
+        ls_pool_free(self->range_pool);
+        ls_pool_free(self->job_pool);
+        free(self->workers);
+        free(self);
+}
+
+static void ls_job_system_default_init(void)
+{
+        ls_job_system_default = ls_job_system_new(0);
+}
+
+LsJobSystem *ls_job_system_get_default(void)
+{
+        pthread_once(&ls_job_system_default_once, ls_job_system_default_init);
+        return ls_job_system_default;
+}
+
+unsigned int ls_job_system_n_workers(LsJobSystem *self)
+{
+        return self->n_workers;
+}
+
+/**
+ * Allocate a job, counting it against @counter
+ */
+static LsJob *ls_job_system_job_new(LsJobSystem *self, ls_job_func func, void *data,
+                                    LsJobCounter *counter)
+{
+        LsJob *ret = ls_pool_alloc(self->job_pool);
+
+        if (ls_unlikely(!ret)) {
+                return NULL;
+        }
+        ret->func = func;
+        ret->data = data;
+        ret->counter = counter;
+        ret->next = NULL;
+
+        if (counter) {
+                atomic_fetch_add_explicit(&counter->pending, 1, memory_order_relaxed);
+        }
+        return ret;
+}
+
+bool ls_job_system_submit(LsJobSystem *self, ls_job_func func, void *data, LsJobCounter *counter)
+{
+        LsJob *job = ls_job_system_job_new(self, func, data, counter);
+
+        if (ls_unlikely(!job)) {
+                return false;
+        }
+        ls_job_system_enqueue(self, job);
+        return true;
+}
+
+bool ls_job_system_submit_after(LsJobSystem *self, LsJobCounter *dependency, ls_job_func func,
+                                void *data, LsJobCounter *counter)
+{
+        LsJob *job = ls_job_system_job_new(self, func, data, counter);
+
+        if (ls_unlikely(!job)) {
+                return false;
+        }
+
+        ls_job_counter_lock(dependency);
+        if (atomic_load_explicit(&dependency->pending, memory_order_acquire) != 0) {
+                job->next = dependency->waiters;
+                dependency->waiters = job;
+                job = NULL;
+        }
+        ls_job_counter_unlock(dependency);
+
+        /* Dependency already satisfied */
+        if (job) {
+                ls_job_system_enqueue(self, job);
+        }
+        return true;
+}
+
+void ls_job_system_wait(LsJobSystem *self, LsJobCounter *counter)
+{
+        LsJobWorker *worker = ls_job_worker_self;
+
+        if (worker && worker->system != self) {
+                worker = NULL;
+        }
+
+        while (atomic_load_explicit(&counter->pending, memory_order_acquire) != 0) {
+                LsJob *job = ls_job_system_find(self, worker);
+                if (job) {
+                        ls_job_system_run(self, job);
+                } else {
+                        sched_yield();
+                }
+        }
+
+        /* The final decrement may still be holding the lock */
+        ls_job_counter_lock(counter);
+        ls_job_counter_unlock(counter);
+}
+
+static void ls_job_range_run(void *v);
+
+/**
+ * Keep splitting the upper half of the range off for thieves, then run
+ * whatever is left on this thread. If a split can't be queued we simply
+ * run the larger piece here.
+ */
+static void ls_job_range_execute(LsJobRange range)
+{
+        while (range.end - range.begin > range.grain) {
+                size_t mid = range.begin + (range.end - range.begin) / 2;
+                LsJobRange *upper = ls_pool_alloc(range.system->range_pool);
+
+                if (ls_unlikely(!upper)) {
+                        break;
+                }
+                *upper = range;
+                upper->begin = mid;
+                if (ls_unlikely(!ls_job_system_submit(range.system,
+                                                      ls_job_range_run,
+                                                      upper,
+                                                      range.counter))) {
+                        ls_pool_release(range.system->range_pool, upper);
+                        break;
+                }
+                range.end = mid;
+        }
+
+        range.func(range.data, range.begin, range.end);
+}
+
+static void ls_job_range_run(void *v)
+{
+        LsJobRange *range = v;
+        LsJobRange local = *range;
+
+        ls_pool_release(local.system->range_pool, range);
+        ls_job_range_execute(local);
+}
+
+void ls_job_system_parallel_for(LsJobSystem *self, size_t begin, size_t end, size_t grain,
+                                ls_job_range_func func, void *data)
+{
+        LsJobCounter counter = LS_JOB_COUNTER_INIT;
+
+        if (begin >= end) {
+                return;
+        }
+
+        if (grain == 0) {
+                size_t n_pieces = (size_t)(self->n_workers + 1) * LS_JOB_PIECES_PER_THREAD;
+                grain = (end - begin + n_pieces - 1) / n_pieces;
+        }
+
+        ls_job_range_execute((LsJobRange){
+            .system = self,
+            .func = func,
+            .data = data,
+            .begin = begin,
+            .end = end,
+            .grain = grain,
+            .counter = &counter,
+        });
+        ls_job_system_wait(self, &counter);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,168 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "macros.h"
+
+/**
+ * LsJobSystem is a fixed pool of worker threads sharing out small jobs,
+ * intended to replace ad-hoc threads in each subsystem so that the machine
+ * is never oversubscribed.
+ *
+ * Each worker owns a Chase-Lev deque: jobs submitted from a worker are
+ * pushed onto and popped from the bottom of its own deque without any
+ * locking, while idle workers steal from the top of another. Jobs
+ * submitted from outside the pool go through a shared injection queue.
+ * Workers with nothing to run park on a condition variable.
+ *
+ * Completion is tracked with an LsJobCounter, which may also gate the
+ * start of other jobs. Waiting on a counter runs pending jobs rather than
+ * blocking, so jobs may themselves submit and wait on nested work.
+ */
+typedef struct LsJobSystem LsJobSystem;
+
+/**
+ * Opaque unit of work, only exposed so counters may chain dependents
+ */
+typedef struct LsJob LsJob;
+
+/**
+ * Function run by a job
+ */
+typedef void (*ls_job_func)(void *data);
+
+/**
+ * Function run over the half-open index range [begin, end)
+ */
+typedef void (*ls_job_range_func)(void *data, size_t begin, size_t end);
+
+/**
+ * LsJobCounter tracks the number of outstanding jobs submitted against it,
+ * and any jobs waiting for it to reach zero. Counters are usually placed
+ * on the stack of the thread that waits on them.
+ *
+ * A counter must not gain new jobs while other jobs depend on it.
+ */
+typedef struct LsJobCounter {
+        atomic_uint pending; /**<Jobs submitted but not yet completed */
+        atomic_flag lock;    /**<Guards waiters and the final decrement */
+        LsJob *waiters;      /**<Jobs released when pending reaches zero */
+} LsJobCounter;
+
+/**
+ * Static initialiser for an idle LsJobCounter
+ */
+#define LS_JOB_COUNTER_INIT                                                                        \
+        {                                                                                          \
+                0, ATOMIC_FLAG_INIT, NULL                                                          \
+        }
+
+/**
+ * Initialise an idle counter
+ */
+void ls_job_counter_init(LsJobCounter *counter);
+
+/**
+ * Return true if every job submitted against the counter has completed
+ */
+bool ls_job_counter_is_done(LsJobCounter *counter);
+
+/**
+ * Construct a new LsJobSystem with @n_workers threads. Passing 0 uses one
+ * worker per online CPU.
+ *
+ * @note Free with ls_job_system_free
+ */
+LsJobSystem *ls_job_system_new(unsigned int n_workers);
+
+/**
+ * Return the process-wide job system, created with one worker per online
+ * CPU on first use, or NULL if it could not be created. It lives until
+ * the process exits and must not be freed.
+ *
+ * Helpers that take an LsJobSystem fall back to this one when given NULL,
+ * so that code without a job system of its own still shares one pool.
+ */
+LsJobSystem *ls_job_system_get_default(void);
+
+/**
+ * Stop and join every worker, then free the job system. All submitted
+ * jobs must have completed, and no other thread may be using it.
+ */
+void ls_job_system_free(LsJobSystem *system);
+
+/**
+ * Return the number of worker threads in the pool
+ */
+unsigned int ls_job_system_n_workers(LsJobSystem *system);
+
+/**
+ * Queue @func to run with @data on some worker. If @counter is non-NULL
+ * it is incremented now and decremented once the job completes.
+ *
+ * @returns True if the job was queued, false if memory is exhausted
+ */
+bool ls_job_system_submit(LsJobSystem *system, ls_job_func func, void *data,
+                          LsJobCounter *counter);
+
+/**
+ * As ls_job_system_submit, but the job is held back until every job on
+ * @dependency has completed. @counter is incremented immediately, so a
+ * wait on it covers the deferred job too.
+ *
+ * @returns True if the job was accepted, false if memory is exhausted
+ */
+bool ls_job_system_submit_after(LsJobSystem *system, LsJobCounter *dependency, ls_job_func func,
+                                void *data, LsJobCounter *counter);
+
+/**
+ * Return once every job on @counter has completed. The calling thread,
+ * which need not be a worker, runs queued jobs in the meantime.
+ */
+void ls_job_system_wait(LsJobSystem *system, LsJobCounter *counter);
+
+/**
+ * Run @func over [begin, end) in parallel and wait for completion. The
+ * range is split in half recursively, with one half left for thieves,
+ * until pieces are no larger than @grain indices. Passing a @grain of 0
+ * picks one giving a few pieces per worker.
+ */
+void ls_job_system_parallel_for(LsJobSystem *system, size_t begin, size_t end, size_t grain,
+                                ls_job_range_func func, void *data);
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -24,11 +24,29 @@
 #pragma once
 
 /* Include main libls headers for convenience */
+#include "arena.h"
 #include "array.h"
+#include "atomic-list.h"
+#include "btree.h"
+#include "dlist.h"
+#include "frame-allocator.h"
+#include "heap.h"
+#include "job-system.h"
 #include "list.h"
 #include "macros.h"
 #include "map.h"
+#include "mapped-file.h"
+#include "memory-usage.h"
+#include "multimap.h"
+#include "ordered-map.h"
+#include "pool.h"
 #include "ptr-array.h"
+#include "skip-list.h"
+#include "snapshot.h"
+#include "str-view.h"
+#include "string-builder.h"
+#include "timer-wheel.h"
+#include "unrolled-list.h"
 
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
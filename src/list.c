@@ -23,8 +23,46 @@
 
 #include <stdlib.h>
 
+#include "config.h"
+
 #include "list.h"
 
+/**
+ * Heap nodes are only accounted when built with `with-stats`, so that
+ * the default build pays nothing for it.
+ */
+#ifdef LS_ENABLE_STATS
+#define ls_list_account(op) ls_memory_account_##op(LS_MEMORY_TYPE_LIST, sizeof(struct LsList))
+#else
+#define ls_list_account(op)                                                                        \
+        do {                                                                                       \
+        } while (0)
+#endif
+
+/**
+ * 256 nodes per slab, or 4KiB on 64-bit
+ */
+#define LS_LIST_POOL_SLAB_NODES 256
+
+/**
+ * A slab is a contiguous block of nodes. Slabs are chained in the order
+ * they were allocated so that a reset can walk them again from the start.
+ */
+typedef struct LsListSlab {
+        struct LsListSlab *next;
+        LsList nodes[LS_LIST_POOL_SLAB_NODES];
+} LsListSlab;
+
+/**
+ * Opaque LsListPool implementation
+ */
+struct LsListPool {
+        LsListSlab *slabs;   /**<First slab in the chain */
+        LsListSlab *current; /**<Slab we're currently bump allocating from */
+        unsigned int used;   /**<Nodes handed out from the current slab */
+        LsList *free_nodes;  /**<Released nodes, linked through next */
+};
+
 /**
  * Main helper to create new nodes for a list. This will result in
  * a sparse memory layout, so if concerned you should probably use
@@ -38,25 +76,40 @@ static inline LsList *ls_node_calloc(void *data)
         if (!ret) {
                 return NULL;
         }
+        ls_list_account(alloc);
 
         ret->data = data;
         return ret;
 }
 
-LsList *ls_list_prepend(LsList *list, void *data)
+/**
+ * Return a node from ls_node_calloc to the heap
+ */
+static inline void ls_node_free(LsList *node)
 {
-        LsList *ret = NULL;
+        ls_list_account(free);
+        free(node);
+}
 
-        ret = ls_node_calloc(data);
-        if (!ret) {
+/**
+ * Link an allocated node onto the head of the list
+ */
+static inline LsList *ls_list_prepend_node(LsList *list, LsList *node)
+{
+        if (!node) {
                 return NULL;
         }
-        ret->next = list;
-        return ret;
+        node->next = list;
+        return node;
+}
+
+LsList *ls_list_prepend(LsList *list, void *data)
+{
+        return ls_list_prepend_node(list, ls_node_calloc(data));
 }
 
 /**
- * Attempt to find the tail of the list (O(1))
+ * Attempt to find the tail of the list (O(N))
  */
 static inline LsList *ls_list_tail(LsList *list)
 {
@@ -69,13 +122,13 @@ static inline LsList *ls_list_tail(LsList *list)
         return node;
 }
 
-LsList *ls_list_append(LsList *list, void *data)
+/**
+ * Link an allocated node onto the tail of the list
+ */
+static inline LsList *ls_list_append_node(LsList *list, LsList *node)
 {
         LsList *tail = NULL;
-        LsList *node = NULL;
 
-        /* Create new storage link */
-        node = ls_node_calloc(data);
         if (!node) {
                 return NULL;
         }
@@ -93,6 +146,61 @@ LsList *ls_list_append(LsList *list, void *data)
         return list;
 }
 
+LsList *ls_list_append(LsList *list, void *data)
+{
+        return ls_list_append_node(list, ls_node_calloc(data));
+}
+
+/**
+ * Counterpart to ls_node_calloc drawing from @allocator
+ */
+static inline LsList *ls_node_alloc(const LsAllocator *allocator, void *data)
+{
+        LsList *ret = NULL;
+
+        if (!allocator) {
+                return ls_node_calloc(data);
+        }
+
+        ret = ls_allocator_alloc0(allocator, sizeof(struct LsList));
+        if (!ret) {
+                return NULL;
+        }
+
+        ret->data = data;
+        return ret;
+}
+
+LsList *ls_list_prepend_with_allocator(const LsAllocator *allocator, LsList *list, void *data)
+{
+        return ls_list_prepend_node(list, ls_node_alloc(allocator, data));
+}
+
+LsList *ls_list_append_with_allocator(const LsAllocator *allocator, LsList *list, void *data)
+{
+        return ls_list_append_node(list, ls_node_alloc(allocator, data));
+}
+
+LsList *ls_list_prepend_arena(LsArena *arena, LsList *list, void *data)
+{
+        return ls_list_prepend_with_allocator(ls_arena_allocator(arena), list, data);
+}
+
+LsList *ls_list_append_arena(LsArena *arena, LsList *list, void *data)
+{
+        return ls_list_append_with_allocator(ls_arena_allocator(arena), list, data);
+}
+
+LsList *ls_list_prepend_frame(LsFrameAllocator *frame, LsList *list, void *data)
+{
+        return ls_list_prepend_with_allocator(ls_frame_allocator_allocator(frame), list, data);
+}
+
+LsList *ls_list_append_frame(LsFrameAllocator *frame, LsList *list, void *data)
+{
+        return ls_list_append_with_allocator(ls_frame_allocator_allocator(frame), list, data);
+}
+
 LsList *ls_list_reverse(LsList *list)
 {
         LsList *node, *prev, *next;
@@ -116,22 +224,57 @@ void ls_list_free(LsList *list)
 }
 
 void ls_list_free_full(LsList *list, ls_free_func freer)
+{
+        ls_list_free_full_with_allocator(NULL, list, freer);
+}
+
+void ls_list_free_with_allocator(const LsAllocator *allocator, LsList *list)
+{
+        ls_list_free_full_with_allocator(allocator, list, NULL);
+}
+
+void ls_list_free_full_with_allocator(const LsAllocator *allocator, LsList *list,
+                                      ls_free_func freer)
 {
         /* Walk the list and free each part. */
 
         LsList *node = list;
         LsList *next = NULL;
 
+        /* Nothing to do if the allocator reclaims the nodes itself */
+        if (!freer && ls_allocator_is_bulk(allocator)) {
+                return;
+        }
+
         while (node) {
                 next = node->next;
                 if (freer && node->data) {
                         freer(node->data);
                 }
-                free(node);
+                if (allocator) {
+                        ls_allocator_free(allocator, node, sizeof(struct LsList));
+                } else {
+                        ls_node_free(node);
+                }
                 node = next;
         }
 }
 
+bool ls_list_memory_usage(LsList *list, LsMemoryUsage *usage)
+{
+        unsigned int length = ls_list_length(list);
+
+        if (ls_unlikely(!usage)) {
+                return false;
+        }
+
+        /* Only the data pointer of each node holds anything useful */
+        usage->used = length * sizeof(void *);
+        usage->reserved = usage->used;
+        usage->overhead = length * (sizeof(struct LsList) - sizeof(void *));
+        return true;
+}
+
 unsigned int ls_list_length(LsList *list)
 {
         LsList *node = list;
@@ -145,6 +288,399 @@ unsigned int ls_list_length(LsList *list)
         return length;
 }
 
+LsList *ls_list_merge(LsList *a, LsList *b, ls_compare_func compare)
+{
+        LsList head = { 0 };
+        LsList *tail = &head;
+
+        while (a && b) {
+                /* <= keeps us stable */
+                if (compare(a->data, b->data) <= 0) {
+                        tail->next = a;
+                        a = a->next;
+                } else {
+                        tail->next = b;
+                        b = b->next;
+                }
+                tail = tail->next;
+        }
+        tail->next = a ? a : b;
+
+        return head.next;
+}
+
+/**
+ * Bottom-up merge sort. Each pass merges adjacent runs of @run_size nodes,
+ * doubling the run size until a single pass performs only one merge.
+ */
+LsList *ls_list_sort(LsList *list, ls_compare_func compare)
+{
+        size_t run_size = 1;
+
+        if (!list || !list->next) {
+                return list;
+        }
+
+        for (;;) {
+                LsList *p = list;
+                LsList *tail = NULL;
+                size_t n_merges = 0;
+
+                list = NULL;
+
+                while (p) {
+                        LsList *q = p;
+                        size_t p_size = 0;
+                        size_t q_size = run_size;
+
+                        ++n_merges;
+
+                        /* Step q along to the start of the second run */
+                        while (q && p_size < run_size) {
+                                ++p_size;
+                                q = q->next;
+                        }
+
+                        /* Merge the two runs, appending to the output as we go */
+                        while (p_size > 0 || (q_size > 0 && q)) {
+                                LsList *node = NULL;
+
+                                if (p_size == 0) {
+                                        node = q;
+                                        q = q->next;
+                                        --q_size;
+                                } else if (q_size == 0 || !q || compare(p->data, q->data) <= 0) {
+                                        node = p;
+                                        p = p->next;
+                                        --p_size;
+                                } else {
+                                        node = q;
+                                        q = q->next;
+                                        --q_size;
+                                }
+
+                                if (tail) {
+                                        tail->next = node;
+                                } else {
+                                        list = node;
+                                }
+                                tail = node;
+                        }
+
+                        /* Both runs consumed, q is the start of the next pair */
+                        p = q;
+                }
+
+                tail->next = NULL;
+
+                if (n_merges <= 1) {
+                        return list;
+                }
+                run_size *= 2;
+        }
+}
+
+LsList *ls_list_sort_unique(LsList *list, ls_compare_func compare, ls_free_func freer)
+{
+        LsList *node = NULL;
+
+        list = ls_list_sort(list, compare);
+
+        for (node = list; node && node->next;) {
+                LsList *next = node->next;
+
+                if (compare(node->data, next->data) != 0) {
+                        node = next;
+                        continue;
+                }
+
+                /* Drop the duplicate and compare against the new neighbour */
+                node->next = next->next;
+                if (freer && next->data) {
+                        freer(next->data);
+                }
+                ls_node_free(next);
+        }
+
+        return list;
+}
+
+LsListPool *ls_list_pool_new(void)
+{
+        return calloc(1, sizeof(struct LsListPool));
+}
+
+void ls_list_pool_free(LsListPool *pool)
+{
+        LsListSlab *slab = NULL;
+        LsListSlab *next = NULL;
+
+        if (!pool) {
+                return;
+        }
+
+        for (slab = pool->slabs; slab; slab = next) {
+                next = slab->next;
+                free(slab);
+        }
+        free(pool);
+}
+
+void ls_list_pool_reset(LsListPool *pool)
+{
+        if (!pool) {
+                return;
+        }
+
+        /* Keep every slab, just start carving from the first one again */
+        pool->current = pool->slabs;
+        pool->used = 0;
+        pool->free_nodes = NULL;
+}
+
+/**
+ * Take a node from the pool, preferring recycled nodes, then the current
+ * slab, then any slab retained by a reset, and finally a new slab.
+ */
+static LsList *ls_list_pool_node(LsListPool *pool, void *data)
+{
+        LsList *ret = NULL;
+
+        if (!pool) {
+                return NULL;
+        }
+
+        if (pool->free_nodes) {
+                ret = pool->free_nodes;
+                pool->free_nodes = ret->next;
+        } else {
+                if (!pool->current || pool->used == LS_LIST_POOL_SLAB_NODES) {
+                        LsListSlab *slab = pool->current ? pool->current->next : pool->slabs;
+
+                        if (!slab) {
+                                slab = malloc(sizeof(struct LsListSlab));
+                                if (!slab) {
+                                        return NULL;
+                                }
+                                slab->next = NULL;
+                                if (pool->current) {
+                                        pool->current->next = slab;
+                                } else {
+                                        pool->slabs = slab;
+                                }
+                        }
+                        pool->current = slab;
+                        pool->used = 0;
+                }
+                ret = &pool->current->nodes[pool->used++];
+        }
+
+        ret->data = data;
+        ret->next = NULL;
+        return ret;
+}
+
+LsList *ls_list_pool_prepend(LsListPool *pool, LsList *list, void *data)
+{
+        return ls_list_prepend_node(list, ls_list_pool_node(pool, data));
+}
+
+LsList *ls_list_pool_append(LsListPool *pool, LsList *list, void *data)
+{
+        return ls_list_append_node(list, ls_list_pool_node(pool, data));
+}
+
+void ls_list_pool_release(LsListPool *pool, LsList *list)
+{
+        ls_list_pool_release_full(pool, list, NULL);
+}
+
+void ls_list_pool_release_full(LsListPool *pool, LsList *list, ls_free_func freer)
+{
+        LsList *node = NULL;
+        LsList *tail = NULL;
+
+        if (!pool || !list) {
+                return;
+        }
+
+        for (node = list; node; node = node->next) {
+                if (freer && node->data) {
+                        freer(node->data);
+                }
+                tail = node;
+        }
+
+        /* Splice the whole chain onto the free list in one go */
+        tail->next = pool->free_nodes;
+        pool->free_nodes = list;
+}
+
+/**
+ * Allocate a node from the pool if we have one, otherwise the heap
+ */
+static inline LsList *ls_list_queue_node(LsListQueue *queue, void *data)
+{
+        if (queue->pool) {
+                return ls_list_pool_node(queue->pool, data);
+        }
+        return ls_node_calloc(data);
+}
+
+void ls_list_queue_init(LsListQueue *queue)
+{
+        ls_list_queue_init_pool(queue, NULL);
+}
+
+void ls_list_queue_init_pool(LsListQueue *queue, LsListPool *pool)
+{
+        queue->head = NULL;
+        queue->tail = NULL;
+        queue->length = 0;
+        queue->pool = pool;
+}
+
+bool ls_list_queue_append(LsListQueue *queue, void *data)
+{
+        LsList *node = NULL;
+
+        node = ls_list_queue_node(queue, data);
+        if (!node) {
+                return false;
+        }
+
+        if (queue->tail) {
+                queue->tail->next = node;
+        } else {
+                queue->head = node;
+        }
+        queue->tail = node;
+        queue->length++;
+
+        return true;
+}
+
+bool ls_list_queue_prepend(LsListQueue *queue, void *data)
+{
+        LsList *node = NULL;
+
+        node = ls_list_queue_node(queue, data);
+        if (!node) {
+                return false;
+        }
+
+        node->next = queue->head;
+        queue->head = node;
+        if (!queue->tail) {
+                queue->tail = node;
+        }
+        queue->length++;
+
+        return true;
+}
+
+bool ls_list_queue_pop(LsListQueue *queue, void **data)
+{
+        LsList *node = queue->head;
+
+        if (!node) {
+                return false;
+        }
+
+        queue->head = node->next;
+        if (!queue->head) {
+                queue->tail = NULL;
+        }
+        queue->length--;
+
+        if (data) {
+                *data = node->data;
+        }
+
+        node->next = NULL;
+        if (queue->pool) {
+                ls_list_pool_release(queue->pool, node);
+        } else {
+                ls_node_free(node);
+        }
+
+        return true;
+}
+
+unsigned int ls_list_queue_length(LsListQueue *queue)
+{
+        return queue->length;
+}
+
+bool ls_list_queue_concat(LsListQueue *queue, LsListQueue *other)
+{
+        if (queue->pool != other->pool) {
+                return false;
+        }
+
+        if (!other->head) {
+                return true;
+        }
+
+        if (queue->tail) {
+                queue->tail->next = other->head;
+        } else {
+                queue->head = other->head;
+        }
+        queue->tail = other->tail;
+        queue->length += other->length;
+
+        ls_list_queue_init_pool(other, other->pool);
+        return true;
+}
+
+void ls_list_queue_append_list(LsListQueue *queue, LsList *list)
+{
+        LsList *tail = list;
+        unsigned int length = 0;
+
+        if (!list) {
+                return;
+        }
+
+        for (LsList *node = list; node; node = node->next) {
+                tail = node;
+                ++length;
+        }
+
+        if (queue->tail) {
+                queue->tail->next = list;
+        } else {
+                queue->head = list;
+        }
+        queue->tail = tail;
+        queue->length += length;
+}
+
+LsList *ls_list_queue_steal(LsListQueue *queue)
+{
+        LsList *ret = queue->head;
+
+        ls_list_queue_init_pool(queue, queue->pool);
+        return ret;
+}
+
+void ls_list_queue_clear(LsListQueue *queue)
+{
+        ls_list_queue_clear_full(queue, NULL);
+}
+
+void ls_list_queue_clear_full(LsListQueue *queue, ls_free_func freer)
+{
+        LsList *list = ls_list_queue_steal(queue);
+
+        if (queue->pool) {
+                ls_list_pool_release_full(queue->pool, list, freer);
+        } else {
+                ls_list_free_full(list, freer);
+        }
+}
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
@@ -23,7 +23,12 @@
 
 #pragma once
 
+#include <stdbool.h>
+
+#include "arena.h"
+#include "frame-allocator.h"
 #include "macros.h"
+#include "memory-usage.h"
 
 /**
  * LsList is a singly-linked list type used for basic storage needs.
@@ -51,6 +56,43 @@ LsList *ls_list_prepend(LsList *list, void *data);
  */
 LsList *ls_list_append(LsList *list, void *data);
 
+/**
+ * Identical to ls_list_prepend, but the node is obtained from @allocator.
+ * Lists built this way must be freed with ls_list_free_with_allocator or
+ * ls_list_free_full_with_allocator, passing the same allocator.
+ */
+LsList *ls_list_prepend_with_allocator(const LsAllocator *allocator, LsList *list, void *data);
+
+/**
+ * Identical to ls_list_append, but the node is obtained from @allocator
+ */
+LsList *ls_list_append_with_allocator(const LsAllocator *allocator, LsList *list, void *data);
+
+/**
+ * Identical to ls_list_prepend, but the node is allocated from @arena.
+ * Nodes allocated this way are released with the arena, and must not be
+ * passed to ls_list_free.
+ */
+LsList *ls_list_prepend_arena(LsArena *arena, LsList *list, void *data);
+
+/**
+ * Identical to ls_list_append, but the node is allocated from @arena
+ */
+LsList *ls_list_append_arena(LsArena *arena, LsList *list, void *data);
+
+/**
+ * Identical to ls_list_prepend, but the node is allocated in the current
+ * frame of @frame. The node is released when its frame is recycled, and
+ * must not be passed to ls_list_free.
+ */
+LsList *ls_list_prepend_frame(LsFrameAllocator *frame, LsList *list, void *data);
+
+/**
+ * Identical to ls_list_append, but the node is allocated in the current
+ * frame of @frame
+ */
+LsList *ls_list_append_frame(LsFrameAllocator *frame, LsList *list, void *data);
+
 /**
  * Reverse the list order and return a pointer to the updated
  * start of the list
@@ -70,12 +112,187 @@ void ls_list_free(LsList *list);
  */
 void ls_list_free_full(LsList *list, ls_free_func freer);
 
+/**
+ * Identical to ls_list_free, returning each node to @allocator
+ */
+void ls_list_free_with_allocator(const LsAllocator *allocator, LsList *list);
+
+/**
+ * Identical to ls_list_free_full, returning each node to @allocator
+ */
+void ls_list_free_full_with_allocator(const LsAllocator *allocator, LsList *list,
+                                      ls_free_func freer);
+
 /**
  * Return the length of the list. If the list is NULL, this will
  * still return 0.
  */
 unsigned int ls_list_length(LsList *list);
 
+/**
+ * Report the memory held by the list nodes, not by the items they point
+ * to. A NULL list is empty. This walks the list, O(N).
+ *
+ * @returns True if the usage could be collected
+ */
+bool ls_list_memory_usage(LsList *list, LsMemoryUsage *usage);
+
+/**
+ * Sort the list in place using a stable, iterative, bottom-up merge sort
+ * and return the new head of the list. No memory is allocated and the
+ * nodes are relinked rather than copied, O(N log N).
+ *
+ * @param compare Called with the data pointers of two nodes
+ */
+LsList *ls_list_sort(LsList *list, ls_compare_func compare);
+
+/**
+ * Merge two lists that are already sorted by @compare into a single
+ * sorted list, returning its head. Where items are equal, those from @a
+ * are placed first. Both input lists are consumed.
+ */
+LsList *ls_list_merge(LsList *a, LsList *b, ls_compare_func compare);
+
+/**
+ * Sort the list, then remove every node that compares equal to the node
+ * before it, so that only the first of each run of equal items remains.
+ * Removed nodes are freed, and their data passed to @freer if it is set.
+ *
+ * @note Only for lists allocated with ls_list_prepend and ls_list_append
+ */
+LsList *ls_list_sort_unique(LsList *list, ls_compare_func compare, ls_free_func freer);
+
+/**
+ * LsListPool is a slab allocator for list nodes. Nodes are carved out of
+ * large contiguous slabs and recycled through a free list, so building a
+ * list from a pool is cheap and the nodes tend to sit together in memory.
+ *
+ * Lists built from a pool must only be released back to that pool, and
+ * must never be passed to ls_list_free or ls_list_free_full.
+ */
+typedef struct LsListPool LsListPool;
+
+/**
+ * Construct a new, empty, node pool
+ */
+LsListPool *ls_list_pool_new(void);
+
+/**
+ * Free the pool along with every slab. Any lists built from the pool are
+ * invalid once this returns.
+ */
+void ls_list_pool_free(LsListPool *pool);
+
+/**
+ * Return every node to the pool at once, in O(1), without freeing slabs.
+ * Any lists built from the pool are invalid once this returns.
+ */
+void ls_list_pool_reset(LsListPool *pool);
+
+/**
+ * Identical to ls_list_prepend, but takes the new node from @pool
+ */
+LsList *ls_list_pool_prepend(LsListPool *pool, LsList *list, void *data);
+
+/**
+ * Identical to ls_list_append, but takes the new node from @pool
+ */
+LsList *ls_list_pool_append(LsListPool *pool, LsList *list, void *data);
+
+/**
+ * Return every node in @list to @pool for reuse
+ */
+void ls_list_pool_release(LsListPool *pool, LsList *list);
+
+/**
+ * Identical to ls_list_pool_release, but will additionally call the passed
+ * free_func to deallocate data pointers in each link of the list.
+ */
+void ls_list_pool_release_full(LsListPool *pool, LsList *list, ls_free_func freer);
+
+/**
+ * LsListQueue is a small head structure tracking both ends and the length
+ * of an LsList chain, making appends, prepends, pops from the front,
+ * length queries and concatenation all O(1).
+ *
+ * The chain in @head is an ordinary LsList and may be walked directly.
+ * Nodes come from the heap unless the queue was initialised with a pool.
+ */
+typedef struct LsListQueue {
+        LsList *head;        /**<First node, or NULL if empty */
+        LsList *tail;        /**<Last node, or NULL if empty */
+        unsigned int length; /**<Number of nodes in the chain */
+        LsListPool *pool;    /**<Optional pool to take nodes from */
+} LsListQueue;
+
+/**
+ * Initialise an empty queue whose nodes come from the heap
+ */
+void ls_list_queue_init(LsListQueue *queue);
+
+/**
+ * Initialise an empty queue whose nodes come from @pool
+ */
+void ls_list_queue_init_pool(LsListQueue *queue, LsListPool *pool);
+
+/**
+ * Append data to the tail of the queue, O(1)
+ *
+ * @returns True if the data was appended
+ */
+bool ls_list_queue_append(LsListQueue *queue, void *data);
+
+/**
+ * Prepend data to the head of the queue, O(1)
+ *
+ * @returns True if the data was prepended
+ */
+bool ls_list_queue_prepend(LsListQueue *queue, void *data);
+
+/**
+ * Remove the head of the queue, storing its data in @data, O(1)
+ *
+ * @returns False if the queue was empty
+ */
+bool ls_list_queue_pop(LsListQueue *queue, void **data);
+
+/**
+ * Return the number of items in the queue, O(1)
+ */
+unsigned int ls_list_queue_length(LsListQueue *queue);
+
+/**
+ * Move every node from @other onto the tail of @queue, leaving @other
+ * empty, O(1). Both queues must take their nodes from the same place.
+ *
+ * @returns True if the queues were joined
+ */
+bool ls_list_queue_concat(LsListQueue *queue, LsListQueue *other);
+
+/**
+ * Adopt an existing chain onto the tail of the queue. The chain must have
+ * been allocated the same way as the queue's own nodes. This walks @list
+ * once to find its tail and length.
+ */
+void ls_list_queue_append_list(LsListQueue *queue, LsList *list);
+
+/**
+ * Detach and return the chain held by the queue, leaving it empty. The
+ * caller becomes responsible for freeing the chain.
+ */
+LsList *ls_list_queue_steal(LsListQueue *queue);
+
+/**
+ * Free every node in the queue, leaving it empty and reusable
+ */
+void ls_list_queue_clear(LsListQueue *queue);
+
+/**
+ * Identical to ls_list_queue_clear, but will additionally call the passed
+ * free_func to deallocate data pointers in each link of the queue.
+ */
+void ls_list_queue_clear_full(LsListQueue *queue, ls_free_func freer);
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
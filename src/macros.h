@@ -23,6 +23,12 @@
 
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
 /**
  * Define ls_unlikely(x) macro
  */
@@ -49,6 +55,14 @@
  */
 #define LS_ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
 
+/**
+ * Recover a pointer to the containing structure from a pointer to one of
+ * its members, for intrusive data structures.
+ */
+#ifndef ls_container_of
+#define ls_container_of(ptr, type, member) ((type *)((char *)(ptr)-offsetof(type, member)))
+#endif
+
 /**
  * Convert a pointer to an integer (for hashing)
  */
@@ -89,6 +103,92 @@
  */
 typedef void (*ls_free_func)(void *v);
 
+/**
+ * ls_compare_func defines the prototype for ordering helpers, returning
+ * less than, equal to or greater than zero as @a sorts before, equal to
+ * or after @b.
+ */
+typedef int (*ls_compare_func)(const void *a, const void *b);
+
+/**
+ * LsAllocator lets a container obtain its storage from somewhere other
+ * than the system heap, such as a tracking allocator, a jemalloc arena or
+ * NUMA-local memory. Sizes are always passed back on realloc and free, so
+ * sized allocators need no headers of their own.
+ *
+ * Containers constructed with a NULL allocator call calloc, realloc and
+ * free directly, so the default pays nothing for the indirection.
+ */
+typedef struct LsAllocator {
+        /**
+         * Return @size bytes of uninitialised memory, or NULL
+         */
+        void *(*alloc)(void *context, size_t size);
+
+        /**
+         * Resize @ptr (possibly NULL) from @old_size to @new_size bytes
+         */
+        void *(*realloc)(void *context, void *ptr, size_t old_size, size_t new_size);
+
+        /**
+         * Release @ptr of @size bytes. May be NULL when memory is only ever
+         * reclaimed in bulk by the owner, allowing containers to skip
+         * walking their storage on teardown.
+         */
+        void (*free)(void *context, void *ptr, size_t size);
+
+        void *context; /**<Passed to every call */
+} LsAllocator;
+
+/**
+ * Allocate @size zeroed bytes from @allocator, or the system heap if NULL
+ */
+static inline void *ls_allocator_alloc0(const LsAllocator *allocator, size_t size)
+{
+        void *ret = NULL;
+
+        if (!allocator) {
+                return calloc(1, size);
+        }
+        ret = allocator->alloc(allocator->context, size);
+        if (ret) {
+                memset(ret, 0, size);
+        }
+        return ret;
+}
+
+/**
+ * Resize @ptr through @allocator, or the system heap if NULL
+ */
+static inline void *ls_allocator_realloc(const LsAllocator *allocator, void *ptr, size_t old_size,
+                                         size_t new_size)
+{
+        if (!allocator) {
+                return realloc(ptr, new_size);
+        }
+        return allocator->realloc(allocator->context, ptr, old_size, new_size);
+}
+
+/**
+ * Release @ptr through @allocator, or the system heap if NULL
+ */
+static inline void ls_allocator_free(const LsAllocator *allocator, void *ptr, size_t size)
+{
+        if (!allocator) {
+                free(ptr);
+        } else if (ptr && allocator->free) {
+                allocator->free(allocator->context, ptr, size);
+        }
+}
+
+/**
+ * Return true if releasing storage from @allocator is a no-op
+ */
+static inline bool ls_allocator_is_bulk(const LsAllocator *allocator)
+{
+        return allocator && !allocator->free;
+}
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
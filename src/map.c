@@ -21,10 +21,16 @@
  * 3. This notice may not be removed or altered from any source distribution.
  */
 
+#define _GNU_SOURCE
+
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/random.h>
+#include <time.h>
 
+#include "arena.h"
+#include "config.h"
 #include "macros.h"
 #include "map.h"
 
@@ -47,14 +53,42 @@ typedef struct LsHashmapNode LsHashmapNode;
  */
 #define LS_HASH_GROWTH 4
 
+/**
+ * A seeded map that sees a chain longer than this is assumed to be under
+ * attack (or to have a leaked seed) and will rehash with a fresh seed.
+ */
+#define LS_HASH_MAX_CHAIN 16
+
 /**
  * Construct a new internal hashmap from the given hashmap and copy
  * all the relevant components.
  */
 static void ls_hashmap_from(LsHashmap *map, LsHashmap *target);
 static bool ls_hashmap_resize(LsHashmap *self);
+static bool ls_hashmap_rebuild(LsHashmap *self, unsigned int max, bool reseed);
 static bool ls_hashmap_insert_map(LsHashmap *self, const uint32_t hash, void *key, void *value);
-static LsHashmapNode *ls_hashmap_get_node(LsHashmap *self, void *key);
+static LsHashmapNode *ls_hashmap_get_node(LsHashmap *self, void *key, const uint32_t hash);
+
+/**
+ * Instrumentation counters only exist when built with `with-stats`, so that
+ * the default build pays nothing for them.
+ */
+#ifdef LS_ENABLE_STATS
+#define ls_hashmap_stat_inc(m, f) ((m)->stats.f++)
+#define ls_hashmap_account(m, op, size)                                                            \
+        do {                                                                                       \
+                if (!(m)->allocator) {                                                             \
+                        ls_memory_account_##op(LS_MEMORY_TYPE_HASHMAP, size);                      \
+                }                                                                                  \
+        } while (0)
+#else
+#define ls_hashmap_stat_inc(m, f)                                                                  \
+        do {                                                                                       \
+        } while (0)
+#define ls_hashmap_account(m, op, size)                                                            \
+        do {                                                                                       \
+        } while (0)
+#endif
 
 /**
  * Opaque LsHashmap implementation, simply an organised header for the
@@ -67,15 +101,31 @@ struct LsHashmap {
                 unsigned int current;     /**<How many items do we currently have? */
                 unsigned int mask;        /**< pow2 n_buckets - 1 */
                 unsigned int next_resize; /**<At what point do we perform resize? */
+                bool reseeded;            /**<Have we reseeded at this size already? */
         } buckets;
         struct {
-                ls_hashmap_hash_func hash;     /**<Key hash generator */
-                ls_hashmap_equal_func compare; /**<Key value comparison */
+                ls_hashmap_hash_func hash;               /**<Key hash generator */
+                ls_hashmap_seeded_hash_func seeded_hash; /**<Keyed hash generator */
+                LsHashmapSeed seed;                      /**<Secret for seeded_hash */
+                ls_hashmap_equal_func compare;           /**<Key value comparison */
         } key;
         struct {
                 ls_hashmap_free_func key;   /**<Key free function */
                 ls_hashmap_free_func value; /**<Value free function */
         } free;
+        const LsAllocator *allocator; /**<Source of storage, NULL for the heap */
+#ifdef LS_ENABLE_STATS
+        struct {
+                uint64_t n_resizes;   /**<Completed resizes */
+                uint64_t n_reseeds;   /**<Rehashes with a fresh seed */
+                uint64_t resize_nsec; /**<Time spent in resize */
+                uint64_t n_puts;      /**<Calls to put */
+                uint64_t n_gets;      /**<Calls to get */
+                uint64_t n_removes;   /**<Calls to remove */
+                uint64_t n_hits;      /**<Successful lookups */
+                uint64_t n_misses;    /**<Failed lookups */
+        } stats;
+#endif
 };
 
 /**
@@ -94,34 +144,57 @@ LsHashmap *ls_hashmap_new(ls_hashmap_hash_func hash, ls_hashmap_equal_func compa
         return ls_hashmap_new_full(hash, compare, NULL, NULL);
 }
 
-LsHashmap *ls_hashmap_new_full(ls_hashmap_hash_func hash, ls_hashmap_equal_func compare,
-                               ls_hashmap_free_func key_free, ls_hashmap_free_func value_free)
+/**
+ * Allocate zeroed storage through the map's allocator
+ */
+static inline void *ls_hashmap_calloc(LsHashmap *self, size_t n, size_t size)
+{
+        void *ret = ls_allocator_alloc0(self->allocator, n * size);
+
+        if (ret) {
+                ls_hashmap_account(self, alloc, n * size);
+        }
+        return ret;
+}
+
+/**
+ * Release storage of @size bytes through the map's allocator
+ */
+static inline void ls_hashmap_release(LsHashmap *self, void *ptr, size_t size)
+{
+        if (ptr) {
+                ls_hashmap_account(self, free, size);
+        }
+        ls_allocator_free(self->allocator, ptr, size);
+}
+
+/**
+ * Common construction for seeded and unseeded maps, takes a fully
+ * configured template and allocates the storage.
+ */
+static LsHashmap *ls_hashmap_new_internal(LsHashmap *clone)
 {
         LsHashmap *ret = NULL;
 
-        LsHashmap clone = {
-                .key.hash = hash,
-                .key.compare = compare,
-                .free.key = key_free,
-                .free.value = value_free,
-                .buckets.blob = NULL,
-                .buckets.current = 0,
-                .buckets.max = LS_HASH_INITIAL_SIZE,
-                .buckets.mask = LS_HASH_INITIAL_SIZE - 1,
-                .buckets.next_resize = (int)(((double)LS_HASH_INITIAL_SIZE) * LS_HASH_FILL_RATE),
-        };
+        clone->buckets.blob = NULL;
+        clone->buckets.current = 0;
+        clone->buckets.max = LS_HASH_INITIAL_SIZE;
+        clone->buckets.mask = LS_HASH_INITIAL_SIZE - 1;
+        clone->buckets.next_resize =
+            (unsigned int)(((double)LS_HASH_INITIAL_SIZE) * LS_HASH_FILL_RATE);
 
         /* Some things we actually do need, sorry programmer. */
-        assert(clone.key.hash);
-        assert(clone.key.compare);
+        assert(clone->key.hash || clone->key.seeded_hash);
+        assert(clone->key.compare);
 
-        ret = calloc(1, sizeof(struct LsHashmap));
+        ret = ls_hashmap_calloc(clone, 1, sizeof(struct LsHashmap));
         if (!ret) {
                 return NULL;
         }
-        *ret = clone;
+        *ret = *clone;
 
-        ret->buckets.blob = calloc((size_t)clone.buckets.max, sizeof(struct LsHashmapNode));
+        ret->buckets.blob =
+            ls_hashmap_calloc(ret, (size_t)clone->buckets.max, sizeof(struct LsHashmapNode));
         if (!ret->buckets.blob) {
                 ls_hashmap_free(ret);
                 return NULL;
@@ -130,6 +203,88 @@ LsHashmap *ls_hashmap_new_full(ls_hashmap_hash_func hash, ls_hashmap_equal_func
         return ret;
 }
 
+LsHashmap *ls_hashmap_new_full(ls_hashmap_hash_func hash, ls_hashmap_equal_func compare,
+                               ls_hashmap_free_func key_free, ls_hashmap_free_func value_free)
+{
+        LsHashmap clone = {
+                .key.hash = hash,
+                .key.compare = compare,
+                .free.key = key_free,
+                .free.value = value_free,
+        };
+
+        return ls_hashmap_new_internal(&clone);
+}
+
+LsHashmap *ls_hashmap_new_with_allocator(const LsAllocator *allocator, ls_hashmap_hash_func hash,
+                                         ls_hashmap_equal_func compare)
+{
+        return ls_hashmap_new_full_with_allocator(allocator, hash, compare, NULL, NULL);
+}
+
+LsHashmap *ls_hashmap_new_full_with_allocator(const LsAllocator *allocator,
+                                              ls_hashmap_hash_func hash,
+                                              ls_hashmap_equal_func compare,
+                                              ls_hashmap_free_func key_free,
+                                              ls_hashmap_free_func value_free)
+{
+        LsHashmap clone = {
+                .key.hash = hash,
+                .key.compare = compare,
+                .free.key = key_free,
+                .free.value = value_free,
+                .allocator = allocator,
+        };
+
+        return ls_hashmap_new_internal(&clone);
+}
+
+LsHashmap *ls_hashmap_new_arena(LsArena *arena, ls_hashmap_hash_func hash,
+                                ls_hashmap_equal_func compare)
+{
+        return ls_hashmap_new_with_allocator(ls_arena_allocator(arena), hash, compare);
+}
+
+/**
+ * Pick a new random seed. We'd rather degrade to a weak seed than fail
+ * construction outright, so mix in some address and clock entropy if the
+ * kernel won't give us any.
+ */
+static void ls_hashmap_seed_init(LsHashmapSeed *seed)
+{
+        struct timespec ts = { 0 };
+
+        if (getrandom(seed, sizeof(*seed), 0) == (ssize_t)sizeof(*seed)) {
+                return;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        seed->k0 ^= (uint64_t)(uintptr_t)seed ^ ((uint64_t)ts.tv_nsec << 32);
+        seed->k1 ^= (uint64_t)ts.tv_sec * 0x9e3779b97f4a7c15ULL ^ (uint64_t)(uintptr_t)&ts;
+}
+
+LsHashmap *ls_hashmap_new_seeded(ls_hashmap_seeded_hash_func hash, ls_hashmap_equal_func compare)
+{
+        return ls_hashmap_new_seeded_full(hash, compare, NULL, NULL);
+}
+
+LsHashmap *ls_hashmap_new_seeded_full(ls_hashmap_seeded_hash_func hash,
+                                      ls_hashmap_equal_func compare,
+                                      ls_hashmap_free_func key_free,
+                                      ls_hashmap_free_func value_free)
+{
+        LsHashmap clone = {
+                .key.seeded_hash = hash,
+                .key.compare = compare,
+                .free.key = key_free,
+                .free.value = value_free,
+        };
+
+        ls_hashmap_seed_init(&clone.key.seed);
+
+        return ls_hashmap_new_internal(&clone);
+}
+
 static inline void bucket_free_one(LsHashmap *self, LsHashmapNode *node)
 {
         if (self->free.key) {
@@ -149,11 +304,17 @@ static inline void bucket_free(LsHashmap *self, LsHashmapNode *node, bool free_v
         if (free_values) {
                 bucket_free_one(self, node);
         }
-        free(node);
+        ls_hashmap_release(self, node, sizeof(struct LsHashmapNode));
 }
 
 static void ls_hashmap_free_internal(LsHashmap *self, bool free_blobs)
 {
+        /* Nothing to walk if the allocator reclaims the storage itself */
+        if (ls_allocator_is_bulk(self->allocator) &&
+            (!free_blobs || (!self->free.key && !self->free.value))) {
+                return;
+        }
+
         for (size_t i = 0; i < self->buckets.max; i++) {
                 LsHashmapNode *node = &self->buckets.blob[i];
                 if (free_blobs) {
@@ -161,7 +322,14 @@ static void ls_hashmap_free_internal(LsHashmap *self, bool free_blobs)
                 }
                 bucket_free(self, node->next, free_blobs);
         }
-        free(self->buckets.blob);
+        ls_hashmap_release(self,
+                           self->buckets.blob,
+                           self->buckets.max * sizeof(struct LsHashmapNode));
+}
+
+size_t ls_hashmap_node_size(void)
+{
+        return sizeof(struct LsHashmapNode);
 }
 
 void ls_hashmap_free(LsHashmap *self)
@@ -170,7 +338,7 @@ void ls_hashmap_free(LsHashmap *self)
                 return;
         }
         ls_hashmap_free_internal(self, true);
-        free(self);
+        ls_hashmap_release(self, self, sizeof(struct LsHashmap));
         return;
 }
 
@@ -214,6 +382,87 @@ uint32_t ls_hashmap_string_hash(const void *v)
         return (uint32_t)hash;
 }
 
+#define LS_ROTL64(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+
+#define LS_SIPROUND(v0, v1, v2, v3)                                                                \
+        do {                                                                                       \
+                v0 += v1;                                                                          \
+                v1 = LS_ROTL64(v1, 13);                                                            \
+                v1 ^= v0;                                                                          \
+                v0 = LS_ROTL64(v0, 32);                                                            \
+                v2 += v3;                                                                          \
+                v3 = LS_ROTL64(v3, 16);                                                            \
+                v3 ^= v2;                                                                          \
+                v0 += v3;                                                                          \
+                v3 = LS_ROTL64(v3, 21);                                                            \
+                v3 ^= v0;                                                                          \
+                v2 += v1;                                                                          \
+                v1 = LS_ROTL64(v1, 17);                                                            \
+                v1 ^= v2;                                                                          \
+                v2 = LS_ROTL64(v2, 32);                                                            \
+        } while (0)
+
+/**
+ * SipHash-1-3: one compression round per block and three finalization
+ * rounds. This is the same tradeoff made by CPython and Rust for hash
+ * table keys, and is far cheaper than the full 2-4 variant.
+ */
+static uint64_t ls_siphash13(const uint8_t *in, size_t len, const LsHashmapSeed *seed)
+{
+        uint64_t v0 = 0x736f6d6570736575ULL ^ seed->k0;
+        uint64_t v1 = 0x646f72616e646f6dULL ^ seed->k1;
+        uint64_t v2 = 0x6c7967656e657261ULL ^ seed->k0;
+        uint64_t v3 = 0x7465646279746573ULL ^ seed->k1;
+        uint64_t b = ((uint64_t)len) << 56;
+        const uint8_t *end = in + (len & ~(size_t)7);
+
+        for (; in != end; in += 8) {
+                uint64_t m = 0;
+
+                for (int i = 0; i < 8; i++) {
+                        m |= ((uint64_t)in[i]) << (8 * i);
+                }
+                v3 ^= m;
+                LS_SIPROUND(v0, v1, v2, v3);
+                v0 ^= m;
+        }
+
+        for (size_t i = 0; i < (len & 7); i++) {
+                b |= ((uint64_t)in[i]) << (8 * i);
+        }
+
+        v3 ^= b;
+        LS_SIPROUND(v0, v1, v2, v3);
+        v0 ^= b;
+
+        v2 ^= 0xff;
+        LS_SIPROUND(v0, v1, v2, v3);
+        LS_SIPROUND(v0, v1, v2, v3);
+        LS_SIPROUND(v0, v1, v2, v3);
+
+        return v0 ^ v1 ^ v2 ^ v3;
+}
+
+uint32_t ls_hashmap_string_hash_seeded(const void *v, const LsHashmapSeed *seed)
+{
+        uint64_t hash = ls_siphash13(v, strlen(v), seed);
+        uint32_t ret = (uint32_t)(hash ^ (hash >> 32));
+
+        /* Zero marks an empty bucket */
+        return ret ? ret : 1;
+}
+
+/**
+ * Generate the hash for a key using whichever hash mode the map is in
+ */
+static inline uint32_t ls_hashmap_hash_key(LsHashmap *self, const void *key)
+{
+        if (self->key.seeded_hash) {
+                return self->key.seeded_hash(key, &self->key.seed);
+        }
+        return self->key.hash(key);
+}
+
 /**
  * Find the base bucket to work from
  */
@@ -222,6 +471,20 @@ static inline LsHashmapNode *ls_hashmap_initial_bucket(LsHashmap *self, const ui
         return &self->buckets.blob[hash & self->buckets.mask];
 }
 
+/**
+ * Count the nodes in the chain that would be walked for the given hash
+ */
+static inline unsigned int ls_hashmap_chain_length(LsHashmap *self, const uint32_t hash)
+{
+        unsigned int length = 0;
+
+        for (LsHashmapNode *node = ls_hashmap_initial_bucket(self, hash); node; node = node->next) {
+                ++length;
+        }
+
+        return length;
+}
+
 /**
  * Internal insert helper, will never attempt a resize, as that is only handled
  * by the public API.
@@ -261,7 +524,7 @@ static bool ls_hashmap_insert_map(LsHashmap *self, const uint32_t hash, void *ke
         }
 
         /* Construct a new input node */
-        candidate = calloc(1, sizeof(LsHashmapNode));
+        candidate = ls_hashmap_calloc(self, 1, sizeof(LsHashmapNode));
         if (!candidate) {
                 return false;
         }
@@ -277,38 +540,73 @@ static bool ls_hashmap_insert_map(LsHashmap *self, const uint32_t hash, void *ke
         return true;
 }
 
-bool ls_hashmap_put(LsHashmap *self, void *key, void *value)
+/**
+ * Shared put path. @hash is either precomputed by the caller, or computed
+ * once any resize (which may reseed) has been dealt with.
+ */
+static bool ls_hashmap_put_internal(LsHashmap *self, void *key, void *value, bool have_hash,
+                                    uint32_t hash)
 {
-        uint32_t hash;
-
-        if (ls_unlikely(!self)) {
-                return false;
-        }
+        ls_hashmap_stat_inc(self, n_puts);
 
         /* Check if we need a resize before the insert */
         if (!ls_hashmap_resize(self)) {
                 return false;
         }
 
-        hash = self->key.hash(key);
+        if (!have_hash) {
+                hash = ls_hashmap_hash_key(self, key);
+        }
 
         /* Ensure we have at least key *and* value together */
         if (ls_unlikely(!key && !value)) {
                 return true;
         }
 
-        return ls_hashmap_insert_map(self, hash, key, value);
+        if (!ls_hashmap_insert_map(self, hash, key, value)) {
+                return false;
+        }
+
+        /* Unseeded maps have no recourse against a long chain */
+        if (ls_likely(!self->key.seeded_hash || self->buckets.reseeded)) {
+                return true;
+        }
+
+        if (ls_unlikely(ls_hashmap_chain_length(self, hash) > LS_HASH_MAX_CHAIN)) {
+                /* Once per table size, otherwise we could thrash. Failure is non fatal. */
+                self->buckets.reseeded = true;
+                if (ls_hashmap_rebuild(self, self->buckets.max, true)) {
+                        ls_hashmap_stat_inc(self, n_reseeds);
+                }
+        }
+
+        return true;
+}
+
+bool ls_hashmap_put(LsHashmap *self, void *key, void *value)
+{
+        if (ls_unlikely(!self)) {
+                return false;
+        }
+        return ls_hashmap_put_internal(self, key, value, false, 0);
+}
+
+bool ls_hashmap_put_with_hash(LsHashmap *self, void *key, uint32_t hash, void *value)
+{
+        /* A seeded map's hashes depend on a secret the caller can't know */
+        if (ls_unlikely(!self || self->key.seeded_hash)) {
+                return false;
+        }
+        return ls_hashmap_put_internal(self, key, value, true, hash);
 }
 
 /**
  * Find the parent node for a key and return it
  */
-static LsHashmapNode *ls_hashmap_get_node(LsHashmap *self, void *key)
+static LsHashmapNode *ls_hashmap_get_node(LsHashmap *self, void *key, const uint32_t hash)
 {
         LsHashmapNode *bucket = NULL;
-        uint32_t hash;
 
-        hash = self->key.hash(key);
         bucket = ls_hashmap_initial_bucket(self, hash);
 
         for (LsHashmapNode *node = bucket; node; node = node->next) {
@@ -320,19 +618,38 @@ static LsHashmapNode *ls_hashmap_get_node(LsHashmap *self, void *key)
         return NULL;
 }
 
-void *ls_hashmap_get(LsHashmap *self, void *key)
+/**
+ * Shared lookup path, counting hits and misses
+ */
+static void *ls_hashmap_get_internal(LsHashmap *self, void *key, const uint32_t hash)
 {
         LsHashmapNode *node = NULL;
 
+        ls_hashmap_stat_inc(self, n_gets);
+
+        node = ls_hashmap_get_node(self, key, hash);
+        if (ls_unlikely(!node)) {
+                ls_hashmap_stat_inc(self, n_misses);
+                return NULL;
+        }
+        ls_hashmap_stat_inc(self, n_hits);
+        return node->value;
+}
+
+void *ls_hashmap_get(LsHashmap *self, void *key)
+{
         if (ls_unlikely(!self)) {
                 return NULL;
         }
+        return ls_hashmap_get_internal(self, key, ls_hashmap_hash_key(self, key));
+}
 
-        node = ls_hashmap_get_node(self, key);
-        if (ls_unlikely(!node)) {
+void *ls_hashmap_get_with_hash(LsHashmap *self, void *key, uint32_t hash)
+{
+        if (ls_unlikely(!self || self->key.seeded_hash)) {
                 return NULL;
         }
-        return node->value;
+        return ls_hashmap_get_internal(self, key, hash);
 }
 
 static void ls_hashmap_from(LsHashmap *source, LsHashmap *target)
@@ -347,25 +664,60 @@ static void ls_hashmap_from(LsHashmap *source, LsHashmap *target)
  */
 static bool ls_hashmap_resize(LsHashmap *self)
 {
-        LsHashmap target = { 0 };
+#ifdef LS_ENABLE_STATS
+        struct timespec start, end;
+#endif
 
         /* Continue unimpeded */
         if (ls_likely(self->buckets.next_resize != self->buckets.current)) {
                 return true;
         }
 
+#ifdef LS_ENABLE_STATS
+        clock_gettime(CLOCK_MONOTONIC, &start);
+#endif
+
+        if (!ls_hashmap_rebuild(self, LS_HASH_GROWTH * self->buckets.max, false)) {
+                return false;
+        }
+
+#ifdef LS_ENABLE_STATS
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        self->stats.n_resizes++;
+        self->stats.resize_nsec += (uint64_t)(end.tv_sec - start.tv_sec) * 1000000000ULL +
+                                   (uint64_t)end.tv_nsec - (uint64_t)start.tv_nsec;
+#endif
+
+        return true;
+}
+
+/**
+ * Move every item into a new bucket blob of @max buckets. When @reseed is
+ * set, a fresh seed is chosen and every key is rehashed, otherwise the
+ * stored hashes are preserved.
+ */
+static bool ls_hashmap_rebuild(LsHashmap *self, unsigned int max, bool reseed)
+{
+        LsHashmap target = { 0 };
+
         /* Set up the target from the source and bind up new blobs.. */
         ls_hashmap_from(self, &target);
-        target.buckets.max = LS_HASH_GROWTH * self->buckets.max;
+        target.buckets.max = max;
         target.buckets.mask = target.buckets.max - 1;
         target.buckets.next_resize =
-            (unsigned int)(((double)target.buckets.max) * LS_HASH_FILL_RATE),
-        target.buckets.blob = calloc(target.buckets.max, sizeof(struct LsHashmapNode));
+            (unsigned int)(((double)target.buckets.max) * LS_HASH_FILL_RATE);
+        target.buckets.reseeded = reseed;
+        target.buckets.blob =
+            ls_hashmap_calloc(&target, target.buckets.max, sizeof(struct LsHashmapNode));
         if (ls_unlikely(!target.buckets.blob)) {
                 return false;
         }
 
-        /* Start moving everything across and preserve the hash (no need to rehash) */
+        if (reseed) {
+                ls_hashmap_seed_init(&target.key.seed);
+        }
+
+        /* Start moving everything across and preserve the hash unless reseeding */
         for (unsigned int i = 0; i < self->buckets.max; i++) {
                 for (LsHashmapNode *node = &self->buckets.blob[i]; node; node = node->next) {
                         uint32_t hash = node->hash;
@@ -374,6 +726,10 @@ static bool ls_hashmap_resize(LsHashmap *self)
                                 continue;
                         }
 
+                        if (reseed) {
+                                hash = ls_hashmap_hash_key(&target, node->key);
+                        }
+
                         if (!ls_hashmap_insert_map(&target, hash, node->key, node->value)) {
                                 goto failed;
                         }
@@ -398,10 +754,14 @@ bool ls_hashmap_remove(LsHashmap *self, void *key)
                 return false;
         }
 
-        node = ls_hashmap_get_node(self, key);
+        ls_hashmap_stat_inc(self, n_removes);
+
+        node = ls_hashmap_get_node(self, key, ls_hashmap_hash_key(self, key));
         if (ls_unlikely(!node)) {
+                ls_hashmap_stat_inc(self, n_misses);
                 return false;
         }
+        ls_hashmap_stat_inc(self, n_hits);
 
         if (ls_likely(self->free.key != NULL)) {
                 self->free.key(node->key);
@@ -418,6 +778,254 @@ bool ls_hashmap_remove(LsHashmap *self, void *key)
         return true;
 }
 
+void ls_hashmap_iter_init(LsHashmap *self, LsHashmapIter *iter)
+{
+        iter->map = self;
+        iter->bucket = 0;
+        iter->node = self ? self->buckets.blob : NULL;
+}
+
+bool ls_hashmap_iter_next(LsHashmapIter *iter, void **key, void **value)
+{
+        LsHashmap *self = iter->map;
+        LsHashmapNode *node = iter->node;
+
+        if (ls_unlikely(!self)) {
+                return false;
+        }
+
+        while (iter->bucket < self->buckets.max) {
+                /* Exhausted this chain, move on to the next root */
+                if (!node) {
+                        ++iter->bucket;
+                        if (iter->bucket >= self->buckets.max) {
+                                break;
+                        }
+                        node = &self->buckets.blob[iter->bucket];
+                }
+
+                iter->node = node->next;
+                if (node->hash == 0) {
+                        node = node->next;
+                        continue;
+                }
+
+                if (key) {
+                        *key = node->key;
+                }
+                if (value) {
+                        *value = node->value;
+                }
+                return true;
+        }
+
+        iter->node = NULL;
+        return false;
+}
+
+bool ls_hashmap_save(LsHashmap *self, const char *path, ls_snapshot_write_func key_write,
+                     ls_snapshot_write_func value_write)
+{
+        LsSnapshotWriter *writer = NULL;
+        uint64_t count = 0;
+        bool ret = false;
+
+        if (ls_unlikely(!self || !path || !key_write || !value_write)) {
+                return false;
+        }
+
+        writer = ls_snapshot_writer_new(LS_SNAPSHOT_KIND_HASHMAP,
+                                        self->key.seeded_hash ? LS_SNAPSHOT_FLAG_SEEDED : 0);
+        if (!writer) {
+                return false;
+        }
+
+        for (unsigned int i = 0; i < self->buckets.max; i++) {
+                for (LsHashmapNode *node = &self->buckets.blob[i]; node; node = node->next) {
+                        if (node->hash == 0) {
+                                continue;
+                        }
+                        if (!ls_snapshot_writer_put_u32(writer, node->hash) ||
+                            !ls_snapshot_writer_put_item(writer, key_write, node->key) ||
+                            !ls_snapshot_writer_put_item(writer, value_write, node->value)) {
+                                goto cleanup;
+                        }
+                        ++count;
+                }
+        }
+
+        ret = ls_snapshot_writer_commit(writer, count, path);
+
+cleanup:
+        ls_snapshot_writer_free(writer);
+        return ret;
+}
+
+/**
+ * Grow the bucket table so that @n more items can be inserted without
+ * triggering a resize.
+ */
+static bool ls_hashmap_reserve(LsHashmap *self, uint64_t n)
+{
+        uint64_t max = self->buckets.max;
+
+        while ((uint64_t)((double)max * LS_HASH_FILL_RATE) < self->buckets.current + n) {
+                max *= LS_HASH_GROWTH;
+                if (max > UINT32_MAX) {
+                        return false;
+                }
+        }
+
+        if (max == self->buckets.max) {
+                return true;
+        }
+
+        return ls_hashmap_rebuild(self, (unsigned int)max, false);
+}
+
+bool ls_hashmap_load(LsHashmap *self, const char *path, ls_snapshot_read_func key_read,
+                     ls_snapshot_read_func value_read)
+{
+        LsSnapshotReader reader = { 0 };
+        bool rehash = false;
+        bool ret = false;
+
+        if (ls_unlikely(!self || !path || !key_read || !value_read)) {
+                return false;
+        }
+
+        if (!ls_snapshot_reader_open(&reader, path, LS_SNAPSHOT_KIND_HASHMAP)) {
+                return false;
+        }
+
+        if (!ls_hashmap_reserve(self, reader.count)) {
+                goto cleanup;
+        }
+
+        /* Seed-dependent hashes on either side can't be reused */
+        rehash = self->key.seeded_hash || (reader.flags & LS_SNAPSHOT_FLAG_SEEDED);
+
+        for (uint64_t i = 0; i < reader.count; i++) {
+                uint32_t hash = 0;
+                void *key = NULL;
+                void *value = NULL;
+
+                if (!ls_snapshot_reader_get_u32(&reader, &hash) ||
+                    !ls_snapshot_reader_get_item(&reader, key_read, &key)) {
+                        goto cleanup;
+                }
+                if (!ls_snapshot_reader_get_item(&reader, value_read, &value)) {
+                        if (self->free.key) {
+                                self->free.key(key);
+                        }
+                        goto cleanup;
+                }
+
+                if (rehash) {
+                        hash = ls_hashmap_hash_key(self, key);
+                }
+
+                if (ls_unlikely(hash == 0 || !ls_hashmap_insert_map(self, hash, key, value))) {
+                        if (self->free.key) {
+                                self->free.key(key);
+                        }
+                        if (self->free.value) {
+                                self->free.value(value);
+                        }
+                        goto cleanup;
+                }
+        }
+
+        ret = true;
+
+cleanup:
+        ls_snapshot_reader_close(&reader);
+        return ret;
+}
+
+bool ls_hashmap_memory_usage(LsHashmap *self, LsMemoryUsage *usage)
+{
+        const size_t slot_size = sizeof(void *) * 2;
+        size_t n_slots = 0;
+        size_t n_live = 0;
+
+        if (ls_unlikely(!self || !usage)) {
+                return false;
+        }
+
+        for (unsigned int i = 0; i < self->buckets.max; i++) {
+                for (LsHashmapNode *node = &self->buckets.blob[i]; node; node = node->next) {
+                        ++n_slots;
+                        if (node->hash != 0) {
+                                ++n_live;
+                        }
+                }
+        }
+
+        usage->used = n_live * slot_size;
+        usage->reserved = n_slots * slot_size;
+        usage->overhead = sizeof(struct LsHashmap) + n_slots * (sizeof(LsHashmapNode) - slot_size);
+        return true;
+}
+
+bool ls_hashmap_stats(LsHashmap *self, LsHashmapStats *stats)
+{
+        uint64_t probe_total = 0;
+
+        if (ls_unlikely(!self || !stats)) {
+                return false;
+        }
+
+        memset(stats, 0, sizeof(*stats));
+        stats->n_buckets = self->buckets.max;
+
+        /* Walk every chain, counting the position of each live item as its probe length */
+        for (unsigned int i = 0; i < self->buckets.max; i++) {
+                unsigned int depth = 0;
+                unsigned int n_live = 0;
+
+                for (LsHashmapNode *node = &self->buckets.blob[i]; node; node = node->next) {
+                        ++depth;
+                        if (node != &self->buckets.blob[i]) {
+                                stats->n_overflow_nodes++;
+                        }
+                        if (node->hash == 0) {
+                                continue;
+                        }
+                        ++n_live;
+                        probe_total += depth;
+                        if (depth > stats->max_probe) {
+                                stats->max_probe = depth;
+                        }
+                }
+
+                stats->n_items += n_live;
+                if (n_live >= LS_HASHMAP_STATS_CHAIN_MAX) {
+                        n_live = LS_HASHMAP_STATS_CHAIN_MAX - 1;
+                }
+                stats->chain_histogram[n_live]++;
+        }
+
+        if (stats->n_items > 0) {
+                stats->mean_probe = (double)probe_total / (double)stats->n_items;
+        }
+        stats->fill_ratio = (double)stats->n_items / (double)stats->n_buckets;
+
+#ifdef LS_ENABLE_STATS
+        stats->have_counters = true;
+        stats->n_resizes = self->stats.n_resizes;
+        stats->n_reseeds = self->stats.n_reseeds;
+        stats->resize_nsec = self->stats.resize_nsec;
+        stats->n_puts = self->stats.n_puts;
+        stats->n_gets = self->stats.n_gets;
+        stats->n_removes = self->stats.n_removes;
+        stats->n_hits = self->stats.n_hits;
+        stats->n_misses = self->stats.n_misses;
+#endif
+
+        return true;
+}
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
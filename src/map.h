@@ -26,12 +26,27 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "arena.h"
+#include "memory-usage.h"
+#include "snapshot.h"
+
 /**
  * LsHashmap is an in-memory hashed key-value data structure (dict/map)
  * typically suited to string key/value pairs.
  */
 typedef struct LsHashmap LsHashmap;
 
+/**
+ * LsHashmapIter is used to walk every key/value pair within a map, in no
+ * particular order. The map must not be modified while an iterator is in
+ * use.
+ */
+typedef struct LsHashmapIter {
+        LsHashmap *map;
+        unsigned int bucket;
+        void *node;
+} LsHashmapIter;
+
 /**
  * Required definition for a free function
  */
@@ -45,6 +60,24 @@ typedef void (*ls_hashmap_free_func)(void *v);
  */
 typedef uint32_t (*ls_hashmap_hash_func)(const void *v);
 
+/**
+ * LsHashmapSeed is the secret key for a seeded (keyed) hash function.
+ */
+typedef struct LsHashmapSeed {
+        uint64_t k0;
+        uint64_t k1;
+} LsHashmapSeed;
+
+/**
+ * Definition for a keyed hash generator function, for use with maps that
+ * hold untrusted keys.
+ *
+ * @param v Key to be hashed
+ * @param seed Secret seed owned by the map
+ * @returns Non-zero uint32_t hash for the key
+ */
+typedef uint32_t (*ls_hashmap_seeded_hash_func)(const void *v, const LsHashmapSeed *seed);
+
 /**
  * Required definition for key equality function
  *
@@ -74,6 +107,12 @@ bool ls_hashmap_string_equal(const void *a, const void *b);
  */
 uint32_t ls_hashmap_string_hash(const void *v);
 
+/**
+ * Keyed SipHash-1-3 for string keys, resistant to crafted collisions.
+ * Use with ls_hashmap_new_seeded when keys come from untrusted sources.
+ */
+uint32_t ls_hashmap_string_hash_seeded(const void *v, const LsHashmapSeed *seed);
+
 /**
  * Construct a new LsHashmap with the given @hash and @compare functions.
  *
@@ -101,6 +140,96 @@ LsHashmap *ls_hashmap_new(ls_hashmap_hash_func hash, ls_hashmap_equal_func compa
 LsHashmap *ls_hashmap_new_full(ls_hashmap_hash_func hash, ls_hashmap_equal_func compare,
                                ls_hashmap_free_func key_free, ls_hashmap_free_func value_free);
 
+/**
+ * Construct a new LsHashmap whose header, buckets and chain nodes are all
+ * obtained from @allocator, which must outlive the map. A NULL allocator
+ * is identical to ls_hashmap_new.
+ *
+ * @param allocator Allocator to obtain storage from
+ * @param hash A hash generator function
+ * @param compare A key equality function
+ *
+ * @note Free with ls_hashmap_free
+ *
+ * @return A newly allocated LsHashmap
+ */
+LsHashmap *ls_hashmap_new_with_allocator(const LsAllocator *allocator, ls_hashmap_hash_func hash,
+                                         ls_hashmap_equal_func compare);
+
+/**
+ * Construct a new LsHashmap with key/value free functions, obtaining all
+ * storage from @allocator
+ *
+ * @param allocator Allocator to obtain storage from
+ * @param hash A hash generator function
+ * @param compare A key equality function
+ * @param key_free Function to call to free any keys when replaced or the table is freed
+ * @param value_free Function to call to free any values when replaced or the table is freed
+ *
+ * @note Free with ls_hashmap_free
+ *
+ * @return A newly allocated LsHashmap
+ */
+LsHashmap *ls_hashmap_new_full_with_allocator(const LsAllocator *allocator,
+                                              ls_hashmap_hash_func hash,
+                                              ls_hashmap_equal_func compare,
+                                              ls_hashmap_free_func key_free,
+                                              ls_hashmap_free_func value_free);
+
+/**
+ * Construct a new LsHashmap whose header, buckets and chain nodes all
+ * live in @arena. Buckets outgrown by a resize are only reclaimed along
+ * with the arena, and ls_hashmap_free becomes a no-op.
+ *
+ * @param arena Arena to allocate from
+ * @param hash A hash generator function
+ * @param compare A key equality function
+ *
+ * @return A newly allocated LsHashmap
+ */
+LsHashmap *ls_hashmap_new_arena(LsArena *arena, ls_hashmap_hash_func hash,
+                                ls_hashmap_equal_func compare);
+
+/**
+ * Construct a new LsHashmap using a keyed hash function and a random
+ * per-map seed.
+ *
+ * Should any chain grow beyond a sane length, the map will pick a fresh
+ * seed and rehash every key, so that an attacker who has learned the
+ * seed cannot keep a chain degraded.
+ *
+ * @param hash A keyed hash generator function
+ * @param compare A key equality function
+ *
+ * @note Free with ls_hashmap_free
+ *
+ * @return A newly allocated LsHashmap
+ */
+LsHashmap *ls_hashmap_new_seeded(ls_hashmap_seeded_hash_func hash, ls_hashmap_equal_func compare);
+
+/**
+ * Construct a new seeded LsHashmap with key/value free functions
+ *
+ * @param hash A keyed hash generator function
+ * @param compare A key equality function
+ * @param key_free Function to call to free any keys when replaced or the table is freed
+ * @param value_free Function to call to free any values when replaced or the table is freed
+ *
+ * @note Free with ls_hashmap_free
+ *
+ * @return A newly allocated LsHashmap
+ */
+LsHashmap *ls_hashmap_new_seeded_full(ls_hashmap_seeded_hash_func hash,
+                                      ls_hashmap_equal_func compare,
+                                      ls_hashmap_free_func key_free,
+                                      ls_hashmap_free_func value_free);
+
+/**
+ * Return the size of each chain node the map allocates, for sizing an
+ * LsPool to serve them
+ */
+size_t ls_hashmap_node_size(void);
+
 /**
  * Free a previously allocated hashmap
  *
@@ -130,6 +259,26 @@ bool ls_hashmap_put(LsHashmap *map, void *key, void *b);
  */
 void *ls_hashmap_get(LsHashmap *map, void *key);
 
+/**
+ * Store a key/value mapping whose key hash is already known, such as the
+ * cached hash of an LsString. @hash must be exactly what the map's own
+ * hash function returns for @key.
+ *
+ * Seeded maps hash with a secret the caller can't reproduce, so they
+ * always reject this.
+ *
+ * @returns True if the key/value pair could be stored
+ */
+bool ls_hashmap_put_with_hash(LsHashmap *map, void *key, uint32_t hash, void *value);
+
+/**
+ * Retrieve the value for @key using an already known @hash, skipping the
+ * map's hash function. The same rules as ls_hashmap_put_with_hash apply.
+ *
+ * @returns The stored value, if found. Always NULL for seeded maps.
+ */
+void *ls_hashmap_get_with_hash(LsHashmap *map, void *key, uint32_t hash);
+
 /**
  * Remove key from the map that matches the given key
  *
@@ -140,6 +289,114 @@ void *ls_hashmap_get(LsHashmap *map, void *key);
  */
 bool ls_hashmap_remove(LsHashmap *map, void *key);
 
+/**
+ * Prepare @iter to walk every key/value pair in @map
+ */
+void ls_hashmap_iter_init(LsHashmap *map, LsHashmapIter *iter);
+
+/**
+ * Advance the iterator, storing the next key and value.
+ *
+ * @param iter Pointer to an initialised iterator
+ * @param key Storage for the key, may be NULL
+ * @param value Storage for the value, may be NULL
+ *
+ * @returns False once the iterator has been exhausted
+ */
+bool ls_hashmap_iter_next(LsHashmapIter *iter, void **key, void **value);
+
+/**
+ * Save every key/value pair in the map, along with its hash, to a
+ * snapshot at @path.
+ *
+ * @param map Pointer to an allocated map
+ * @param path Location of the snapshot, replaced atomically
+ * @param key_write Function to serialise each key
+ * @param value_write Function to serialise each value
+ *
+ * @returns True if the snapshot was written
+ */
+bool ls_hashmap_save(LsHashmap *map, const char *path, ls_snapshot_write_func key_write,
+                     ls_snapshot_write_func value_write);
+
+/**
+ * Load every key/value pair from the snapshot at @path into @map.
+ *
+ * The bucket table is sized for the whole snapshot up front, and the
+ * stored hashes are reused rather than hashing each key again. For this
+ * to be valid, @map must use the same hash function as the map that was
+ * saved. Seeded maps always rehash, as their seeds differ.
+ *
+ * @param map Pointer to an allocated map
+ * @param path Location of the snapshot
+ * @param key_read Function to deserialise each key
+ * @param value_read Function to deserialise each value
+ *
+ * @returns True if the entire snapshot was loaded
+ */
+bool ls_hashmap_load(LsHashmap *map, const char *path, ls_snapshot_read_func key_read,
+                     ls_snapshot_read_func value_read);
+
+/**
+ * Number of chain-length histogram slots reported by ls_hashmap_stats.
+ * The final slot accumulates every chain at or above that length.
+ */
+#define LS_HASHMAP_STATS_CHAIN_MAX 16
+
+/**
+ * LsHashmapStats is a snapshot of the internal state of a LsHashmap, used
+ * to diagnose poor hash distribution, load factors and resize churn.
+ *
+ * The structural fields are computed on demand by walking the table, and
+ * are always available. The counters are only maintained when libls is
+ * built with the `with-stats` option, and will otherwise read as zero.
+ */
+typedef struct LsHashmapStats {
+        unsigned int n_buckets;        /**<Allocated root buckets */
+        unsigned int n_items;          /**<Live key/value pairs */
+        unsigned int n_overflow_nodes; /**<Allocated chain nodes outside the root blob */
+        unsigned int max_probe;        /**<Longest walk required to find a live item */
+        double mean_probe;             /**<Mean walk required to find a live item */
+        double fill_ratio;             /**<Live items per root bucket */
+
+        /**
+         * Number of buckets holding a chain of N live items, where N is the
+         * index. The last slot counts chains of LS_HASHMAP_STATS_CHAIN_MAX - 1
+         * or more items.
+         */
+        unsigned int chain_histogram[LS_HASHMAP_STATS_CHAIN_MAX];
+
+        bool have_counters;    /**<True if the counters below are maintained */
+        uint64_t n_resizes;    /**<Number of completed resizes */
+        uint64_t n_reseeds;    /**<Number of rehashes with a fresh seed */
+        uint64_t resize_nsec;  /**<Total time spent resizing, in nanoseconds */
+        uint64_t n_puts;       /**<Calls to ls_hashmap_put */
+        uint64_t n_gets;       /**<Calls to ls_hashmap_get */
+        uint64_t n_removes;    /**<Calls to ls_hashmap_remove */
+        uint64_t n_hits;       /**<Lookups (get and remove) that found the key */
+        uint64_t n_misses;     /**<Lookups (get and remove) that did not find the key */
+} LsHashmapStats;
+
+/**
+ * Report the memory held by the map itself, not by the keys and values it
+ * points to. Each key/value slot in a bucket or chain node counts towards
+ * reserved, and is used if it holds a live item. Hashes, chain links and
+ * the map header are overhead. This walks the table, O(N).
+ *
+ * @returns True if the usage could be collected
+ */
+bool ls_hashmap_memory_usage(LsHashmap *map, LsMemoryUsage *usage);
+
+/**
+ * Collect statistics for the given map
+ *
+ * @param map Pointer to an allocated map
+ * @param stats Pointer to storage for the statistics
+ *
+ * @returns True if the statistics could be collected
+ */
+bool ls_hashmap_stats(LsHashmap *map, LsHashmapStats *stats);
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
@@ -0,0 +1,175 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mapped-file.h"
+
+/**
+ * Opaque LsMappedFile implementation
+ */
+struct LsMappedFile {
+        void *data;  /**<Start of the mapping, NULL when empty */
+        size_t size; /**<Length of the mapping */
+};
+
+static int ls_mapped_file_advice(LsMappedFileAccess access)
+{
+        switch (access) {
+        case LS_MAPPED_FILE_SEQUENTIAL:
+                return MADV_SEQUENTIAL;
+        case LS_MAPPED_FILE_RANDOM:
+                return MADV_RANDOM;
+        case LS_MAPPED_FILE_WILLNEED:
+                return MADV_WILLNEED;
+        case LS_MAPPED_FILE_DONTNEED:
+                return MADV_DONTNEED;
+        case LS_MAPPED_FILE_NORMAL:
+        default:
+                return MADV_NORMAL;
+        }
+}
+
+LsMappedFile *ls_mapped_file_open(const char *path, LsMappedFileAccess access)
+{
+        LsMappedFile *ret = NULL;
+        struct stat st = { 0 };
+        int fd = -1;
+
+        if (ls_unlikely(!path)) {
+                return NULL;
+        }
+
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+                return NULL;
+        }
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+            (uint64_t)st.st_size > (uint64_t)SIZE_MAX) {
+                close(fd);
+                return NULL;
+        }
+
+        ret = calloc(1, sizeof(struct LsMappedFile));
+        if (!ret) {
+                close(fd);
+                return NULL;
+        }
+
+        /* mmap refuses empty mappings, so an empty file just has no data */
+        ret->size = (size_t)st.st_size;
+        if (ret->size > 0) {
+                ret->data = mmap(NULL, ret->size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (ret->data == MAP_FAILED) {
+                        close(fd);
+                        free(ret);
+                        return NULL;
+                }
+        }
+        close(fd);
+
+        if (access != LS_MAPPED_FILE_NORMAL) {
+                ls_mapped_file_advise(ret, 0, ret->size, access);
+        }
+
+        return ret;
+}
+
+void ls_mapped_file_close(LsMappedFile *self)
+{
+        if (ls_unlikely(!self)) {
+                return;
+        }
+        if (self->data) {
+                munmap(self->data, self->size);
+        }
+        free(self);
+}
+
+const void *ls_mapped_file_data(LsMappedFile *self)
+{
+        return self->data;
+}
+
+size_t ls_mapped_file_size(LsMappedFile *self)
+{
+        return self->size;
+}
+
+bool ls_mapped_file_advise(LsMappedFile *self, size_t offset, size_t len,
+                           LsMappedFileAccess access)
+{
+        uintptr_t page_size = (uintptr_t)sysconf(_SC_PAGESIZE);
+        uintptr_t start;
+        uintptr_t end;
+
+        if (ls_unlikely(offset > self->size || len > self->size - offset)) {
+                return false;
+        }
+        if (len == 0) {
+                return true;
+        }
+
+        /* madvise wants a page aligned start, so widen to whole pages */
+        start = (uintptr_t)self->data + offset;
+        end = start + len;
+        start &= ~(page_size - 1);
+
+        return madvise((void *)start, (size_t)(end - start), ls_mapped_file_advice(access)) == 0;
+}
+
+bool ls_mapped_file_array_view(LsMappedFile *self, size_t offset, size_t item_size, size_t count,
+                               LsArrayView *view)
+{
+        if (ls_unlikely(!self || !view || item_size == 0)) {
+                return false;
+        }
+        if (offset > self->size || count > (self->size - offset) / item_size) {
+                return false;
+        }
+
+        ls_array_view_init(view,
+                           count ? (const char *)self->data + offset : NULL,
+                           item_size,
+                           count);
+        return true;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,106 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "array.h"
+#include "macros.h"
+
+/**
+ * LsMappedFile is a read-only memory mapping of an entire file. Pages are
+ * faulted in on demand and shared through the page cache with every other
+ * process mapping the same file, so opening even a very large table is
+ * constant time and nothing is ever copied.
+ */
+typedef struct LsMappedFile LsMappedFile;
+
+/**
+ * Access pattern hints, passed through to the kernel with madvise
+ */
+typedef enum LsMappedFileAccess {
+        LS_MAPPED_FILE_NORMAL = 0, /**<No particular pattern */
+        LS_MAPPED_FILE_SEQUENTIAL, /**<Read once front to back, read ahead aggressively */
+        LS_MAPPED_FILE_RANDOM,     /**<Scattered lookups, don't read ahead */
+        LS_MAPPED_FILE_WILLNEED,   /**<Start paging the range in now */
+        LS_MAPPED_FILE_DONTNEED,   /**<The range won't be needed again soon */
+} LsMappedFileAccess;
+
+/**
+ * Map the file at @path, advising the kernel of the expected @access
+ * pattern for the whole file. Empty files map successfully with no data.
+ *
+ * @note Close with ls_mapped_file_close
+ *
+ * @returns A new LsMappedFile, or NULL if the file could not be mapped
+ */
+LsMappedFile *ls_mapped_file_open(const char *path, LsMappedFileAccess access);
+
+/**
+ * Unmap the file, invalidating every pointer and view into it
+ */
+void ls_mapped_file_close(LsMappedFile *file);
+
+/**
+ * Return the start of the mapping, or NULL for an empty file
+ */
+const void *ls_mapped_file_data(LsMappedFile *file);
+
+/**
+ * Return the size of the mapping in bytes
+ */
+size_t ls_mapped_file_size(LsMappedFile *file);
+
+/**
+ * Advise the kernel how the @len bytes at @offset will be accessed, such
+ * as switching a region to random access after a sequential header scan
+ *
+ * @returns True if the range is valid and the hint was accepted
+ */
+bool ls_mapped_file_advise(LsMappedFile *file, size_t offset, size_t len,
+                           LsMappedFileAccess access);
+
+/**
+ * Wrap @count fixed-size records of @item_size bytes, starting @offset
+ * bytes into the file, as a read-only array view. Nothing is copied, and
+ * the view is valid until the file is closed. Records are only as aligned
+ * as @offset and @item_size make them.
+ *
+ * @returns True if the records lie entirely within the file
+ */
+bool ls_mapped_file_array_view(LsMappedFile *file, size_t offset, size_t item_size, size_t count,
+                               LsArrayView *view);
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,123 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdatomic.h>
+#include <string.h>
+
+#include "config.h"
+#include "macros.h"
+#include "memory-usage.h"
+
+/**
+ * Counters are only ever updated with relaxed atomics, they need to be
+ * cheap rather than a consistent snapshot.
+ */
+static struct {
+        atomic_uint_fast64_t live_bytes;
+        atomic_uint_fast64_t peak_bytes;
+        atomic_uint_fast64_t n_allocs;
+        atomic_uint_fast64_t n_frees;
+} ls_memory_counters_global[LS_MEMORY_TYPE_MAX];
+
+void ls_memory_account_alloc(LsMemoryType type, size_t size)
+{
+        uint_fast64_t live = 0;
+        uint_fast64_t peak = 0;
+
+        atomic_fetch_add_explicit(&ls_memory_counters_global[type].n_allocs,
+                                  1,
+                                  memory_order_relaxed);
+        live = atomic_fetch_add_explicit(&ls_memory_counters_global[type].live_bytes,
+                                         size,
+                                         memory_order_relaxed) +
+               size;
+
+        /* Raise the high-water mark unless someone beat us to it */
+        peak = atomic_load_explicit(&ls_memory_counters_global[type].peak_bytes,
+                                    memory_order_relaxed);
+        while (live > peak &&
+               !atomic_compare_exchange_weak_explicit(&ls_memory_counters_global[type].peak_bytes,
+                                                      &peak,
+                                                      live,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+        }
+}
+
+void ls_memory_account_free(LsMemoryType type, size_t size)
+{
+        atomic_fetch_add_explicit(&ls_memory_counters_global[type].n_frees,
+                                  1,
+                                  memory_order_relaxed);
+        atomic_fetch_sub_explicit(&ls_memory_counters_global[type].live_bytes,
+                                  size,
+                                  memory_order_relaxed);
+}
+
+bool ls_memory_counters(LsMemoryType type, LsMemoryCounters *counters)
+{
+        if (ls_unlikely(!counters)) {
+                return false;
+        }
+        memset(counters, 0, sizeof(*counters));
+        if (ls_unlikely(type >= LS_MEMORY_TYPE_MAX)) {
+                return false;
+        }
+
+#ifdef LS_ENABLE_STATS
+        counters->live_bytes =
+            atomic_load_explicit(&ls_memory_counters_global[type].live_bytes, memory_order_relaxed);
+        counters->peak_bytes =
+            atomic_load_explicit(&ls_memory_counters_global[type].peak_bytes, memory_order_relaxed);
+        counters->n_allocs =
+            atomic_load_explicit(&ls_memory_counters_global[type].n_allocs, memory_order_relaxed);
+        counters->n_frees =
+            atomic_load_explicit(&ls_memory_counters_global[type].n_frees, memory_order_relaxed);
+        return true;
+#else
+        return false;
+#endif
+}
+
+void ls_memory_counters_reset_peak(LsMemoryType type)
+{
+        if (ls_unlikely(type >= LS_MEMORY_TYPE_MAX)) {
+                return;
+        }
+        atomic_store_explicit(&ls_memory_counters_global[type].peak_bytes,
+                              atomic_load_explicit(&ls_memory_counters_global[type].live_bytes,
+                                                   memory_order_relaxed),
+                              memory_order_relaxed);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,93 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * LsMemoryUsage reports the heap footprint of a single container. The
+ * total footprint is reserved + overhead. Allocator headers and padding
+ * are not visible to libls and so are not included.
+ */
+typedef struct LsMemoryUsage {
+        size_t used;     /**<Bytes holding live items */
+        size_t reserved; /**<Bytes of item storage, including unused slack */
+        size_t overhead; /**<Bytes of bookkeeping: headers, links and hashes */
+} LsMemoryUsage;
+
+/**
+ * Container types with global accounting
+ */
+typedef enum LsMemoryType {
+        LS_MEMORY_TYPE_ARRAY = 0,
+        LS_MEMORY_TYPE_LIST,
+        LS_MEMORY_TYPE_HASHMAP,
+        LS_MEMORY_TYPE_MAX,
+} LsMemoryType;
+
+/**
+ * LsMemoryCounters totals the heap allocations of every container of one
+ * type, across all threads. Storage obtained through a custom LsAllocator
+ * is left for that allocator to account for.
+ */
+typedef struct LsMemoryCounters {
+        uint64_t live_bytes; /**<Bytes currently allocated */
+        uint64_t peak_bytes; /**<High-water mark of live_bytes */
+        uint64_t n_allocs;   /**<Allocations, including resizes */
+        uint64_t n_frees;    /**<Frees, including resizes */
+} LsMemoryCounters;
+
+/**
+ * Collect the global counters for @type. The counters are only maintained
+ * when libls is built with the `with-stats` option.
+ *
+ * @returns False, with @counters zeroed, if the counters are unavailable
+ */
+bool ls_memory_counters(LsMemoryType type, LsMemoryCounters *counters);
+
+/**
+ * Reset the high-water mark for @type to the current live bytes
+ */
+void ls_memory_counters_reset_peak(LsMemoryType type);
+
+/**
+ * Accounting hooks used by the containers themselves, which only call
+ * them when libls is built with the `with-stats` option.
+ */
+void ls_memory_account_alloc(LsMemoryType type, size_t size);
+void ls_memory_account_free(LsMemoryType type, size_t size);
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
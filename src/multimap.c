@@ -0,0 +1,265 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "multimap.h"
+
+/**
+ * Initial number of values a run can hold before it needs to grow
+ */
+#define LS_MULTIMAP_INITIAL_RUN 4
+
+/**
+ * LsMultimapRun holds every value for one key inline, directly after the
+ * header, and is stored as the value of the backing LsHashmap.
+ */
+typedef struct LsMultimapRun {
+        void *key;         /**<Owned key, as stored in the backing map */
+        unsigned int len;  /**<Number of values in use */
+        unsigned int size; /**<Number of values allocated */
+        void *values[];    /**<Contiguous values, in insertion order */
+} LsMultimapRun;
+
+/**
+ * Opaque LsMultimap implementation. Ownership of keys and values is
+ * handled here, the backing map has no free functions.
+ */
+struct LsMultimap {
+        LsHashmap *runs;
+        struct {
+                ls_hashmap_free_func key;   /**<Key free function */
+                ls_hashmap_free_func value; /**<Value free function */
+        } free;
+};
+
+LsMultimap *ls_multimap_new(ls_hashmap_hash_func hash, ls_hashmap_equal_func compare)
+{
+        return ls_multimap_new_full(hash, compare, NULL, NULL);
+}
+
+LsMultimap *ls_multimap_new_full(ls_hashmap_hash_func hash, ls_hashmap_equal_func compare,
+                                 ls_hashmap_free_func key_free, ls_hashmap_free_func value_free)
+{
+        LsMultimap *ret = NULL;
+
+        ret = calloc(1, sizeof(struct LsMultimap));
+        if (!ret) {
+                return NULL;
+        }
+
+        ret->runs = ls_hashmap_new(hash, compare);
+        if (!ret->runs) {
+                free(ret);
+                return NULL;
+        }
+        ret->free.key = key_free;
+        ret->free.value = value_free;
+
+        return ret;
+}
+
+/**
+ * Release a run along with its key and values
+ */
+static void ls_multimap_run_free(LsMultimap *self, LsMultimapRun *run)
+{
+        if (self->free.value) {
+                for (unsigned int i = 0; i < run->len; i++) {
+                        self->free.value(run->values[i]);
+                }
+        }
+        if (self->free.key) {
+                self->free.key(run->key);
+        }
+        free(run);
+}
+
+void ls_multimap_free(LsMultimap *self)
+{
+        LsHashmapIter iter = { 0 };
+        void *run = NULL;
+
+        if (ls_unlikely(!self)) {
+                return;
+        }
+
+        ls_hashmap_iter_init(self->runs, &iter);
+        while (ls_hashmap_iter_next(&iter, NULL, &run)) {
+                ls_multimap_run_free(self, run);
+        }
+
+        ls_hashmap_free(self->runs);
+        free(self);
+}
+
+bool ls_multimap_put(LsMultimap *self, void *key, void *value)
+{
+        LsMultimapRun *run = NULL;
+
+        if (ls_unlikely(!self)) {
+                return false;
+        }
+
+        run = ls_hashmap_get(self->runs, key);
+
+        /* New key, start a fresh run */
+        if (!run) {
+                run = malloc(sizeof(LsMultimapRun) + LS_MULTIMAP_INITIAL_RUN * sizeof(void *));
+                if (!run) {
+                        return false;
+                }
+                run->key = key;
+                run->len = 0;
+                run->size = LS_MULTIMAP_INITIAL_RUN;
+                if (!ls_hashmap_put(self->runs, key, run)) {
+                        free(run);
+                        return false;
+                }
+        } else if (run->len == run->size) {
+                /* Grow into a copy, so the old run stays valid if we can't repoint the map */
+                LsMultimapRun *grown = NULL;
+                unsigned int size = run->size * 2;
+
+                grown = malloc(sizeof(LsMultimapRun) + size * sizeof(void *));
+                if (!grown) {
+                        return false;
+                }
+                memcpy(grown, run, sizeof(LsMultimapRun) + run->len * sizeof(void *));
+                grown->size = size;
+                if (!ls_hashmap_put(self->runs, grown->key, grown)) {
+                        free(grown);
+                        return false;
+                }
+                free(run);
+                run = grown;
+        }
+
+        /* We only keep the first key we were given */
+        if (key != run->key && self->free.key) {
+                self->free.key(key);
+        }
+
+        run->values[run->len++] = value;
+        return true;
+}
+
+void *const *ls_multimap_get(LsMultimap *self, void *key, unsigned int *n_values)
+{
+        LsMultimapRun *run = NULL;
+
+        if (ls_unlikely(!self)) {
+                goto missing;
+        }
+
+        run = ls_hashmap_get(self->runs, key);
+        if (!run) {
+                goto missing;
+        }
+
+        if (n_values) {
+                *n_values = run->len;
+        }
+        return run->values;
+
+missing:
+        if (n_values) {
+                *n_values = 0;
+        }
+        return NULL;
+}
+
+unsigned int ls_multimap_count(LsMultimap *self, void *key)
+{
+        unsigned int ret = 0;
+
+        ls_multimap_get(self, key, &ret);
+        return ret;
+}
+
+bool ls_multimap_remove(LsMultimap *self, void *key, void *value)
+{
+        LsMultimapRun *run = NULL;
+
+        if (ls_unlikely(!self)) {
+                return false;
+        }
+
+        run = ls_hashmap_get(self->runs, key);
+        if (!run) {
+                return false;
+        }
+
+        for (unsigned int i = 0; i < run->len; i++) {
+                if (run->values[i] != value) {
+                        continue;
+                }
+
+                if (self->free.value) {
+                        self->free.value(value);
+                }
+                memmove(&run->values[i], &run->values[i + 1], (run->len - i - 1) * sizeof(void *));
+                run->len--;
+
+                /* Last value gone, so the key goes too */
+                if (run->len == 0) {
+                        ls_hashmap_remove(self->runs, run->key);
+                        ls_multimap_run_free(self, run);
+                }
+                return true;
+        }
+
+        return false;
+}
+
+bool ls_multimap_remove_all(LsMultimap *self, void *key)
+{
+        LsMultimapRun *run = NULL;
+
+        if (ls_unlikely(!self)) {
+                return false;
+        }
+
+        run = ls_hashmap_get(self->runs, key);
+        if (!run) {
+                return false;
+        }
+
+        ls_hashmap_remove(self->runs, run->key);
+        ls_multimap_run_free(self, run);
+        return true;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
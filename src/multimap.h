@@ -0,0 +1,136 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "map.h"
+
+/**
+ * LsMultimap associates any number of values with a single key.
+ *
+ * Every value for a key is held in one contiguous run, so a query is a
+ * single hash lookup followed by a linear scan, with no per-value node
+ * allocations.
+ *
+ * The hash, equality and free functions are shared with LsHashmap.
+ */
+typedef struct LsMultimap LsMultimap;
+
+/**
+ * Construct a new LsMultimap with the given @hash and @compare functions.
+ *
+ * @param hash A hash generator function
+ * @param compare A key equality function
+ *
+ * @note Free with ls_multimap_free
+ *
+ * @return A newly allocated LsMultimap
+ */
+LsMultimap *ls_multimap_new(ls_hashmap_hash_func hash, ls_hashmap_equal_func compare);
+
+/**
+ * Construct a new LsMultimap with key/value free functions
+ *
+ * @param hash A hash generator function
+ * @param compare A key equality function
+ * @param key_free Function to call to free keys when no longer required
+ * @param value_free Function to call to free values when removed or the map is freed
+ *
+ * @note Free with ls_multimap_free
+ *
+ * @return A newly allocated LsMultimap
+ */
+LsMultimap *ls_multimap_new_full(ls_hashmap_hash_func hash, ls_hashmap_equal_func compare,
+                                 ls_hashmap_free_func key_free, ls_hashmap_free_func value_free);
+
+/**
+ * Free a previously allocated multimap, including every stored value
+ *
+ * @param map Pointer to a previously allocated multimap
+ */
+void ls_multimap_free(LsMultimap *map);
+
+/**
+ * Append @value to the values associated with @key. Duplicate values are
+ * permitted.
+ *
+ * @note If @key is already present, the existing key is kept and the
+ * one passed in is released with the key free function.
+ *
+ * @param map Pointer to a valid LsMultimap instance
+ * @param key Key for the new mapping
+ * @param value Value to add for the key
+ *
+ * @returns True if the value could be stored
+ */
+bool ls_multimap_put(LsMultimap *map, void *key, void *value);
+
+/**
+ * Retrieve every value associated with @key, in insertion order.
+ *
+ * @note The returned run is only valid until the next modification of
+ * the map.
+ *
+ * @param map Pointer to an allocated multimap
+ * @param key Key to lookup values for
+ * @param n_values Storage for the number of values in the run
+ *
+ * @returns A contiguous run of values, or NULL if @key is not present.
+ */
+void *const *ls_multimap_get(LsMultimap *map, void *key, unsigned int *n_values);
+
+/**
+ * Return the number of values associated with @key
+ */
+unsigned int ls_multimap_count(LsMultimap *map, void *key);
+
+/**
+ * Remove a single (key, value) pair, compared by pointer. The order of
+ * the remaining values is preserved. The key is removed once it has no
+ * remaining values.
+ *
+ * @returns True if a matching pair was removed
+ */
+bool ls_multimap_remove(LsMultimap *map, void *key, void *value);
+
+/**
+ * Remove @key and every value associated with it
+ *
+ * @returns True if the key was present
+ */
+bool ls_multimap_remove_all(LsMultimap *map, void *key);
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,479 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "ordered-map.h"
+
+/**
+ * Smallest index we'll create. Must be a power of 2.
+ */
+#define LS_ORDERED_MAP_MIN_SIZE 8
+
+/**
+ * Index slot that has never been used, terminates a probe.
+ * Every byte is 0xff so we can memset the index regardless of width.
+ */
+#define LS_ORDERED_MAP_EMPTY (-1)
+
+/**
+ * Index slot whose entry was removed, the probe must continue past it.
+ */
+#define LS_ORDERED_MAP_DUMMY (-2)
+
+/**
+ * Perturbation shift for the probe sequence. Higher bits of the hash get
+ * mixed in as we go so that we don't cluster on the low bits alone.
+ */
+#define LS_ORDERED_MAP_PERTURB_SHIFT 5
+
+/**
+ * A single key/value pair within the dense entry storage. A zero hash
+ * marks an entry that has since been removed.
+ */
+typedef struct LsOrderedMapEntry {
+        uint32_t hash;
+        void *key;
+        void *value;
+} LsOrderedMapEntry;
+
+/**
+ * Opaque LsOrderedMap implementation. The index holds positions into the
+ * entry array, using the narrowest signed integer width that can address
+ * every entry.
+ */
+struct LsOrderedMap {
+        struct {
+                void *blob;         /**<Sparse table of entry positions */
+                uint32_t size;      /**<Number of slots, always pow2 */
+                uint32_t mask;      /**<size - 1 */
+                unsigned int width; /**<Width of a slot in bytes */
+        } index;
+        struct {
+                LsOrderedMapEntry *blob; /**<Dense entries in insertion order */
+                uint32_t len;            /**<Used entries, including removed ones */
+                uint32_t usable;         /**<Allocated entries */
+                uint32_t live;           /**<Entries that have not been removed */
+        } entries;
+        struct {
+                ls_hashmap_hash_func hash;     /**<Key hash generator */
+                ls_hashmap_equal_func compare; /**<Key value comparison */
+        } key;
+        struct {
+                ls_hashmap_free_func key;   /**<Key free function */
+                ls_hashmap_free_func value; /**<Value free function */
+        } free;
+        const LsAllocator *allocator; /**<Source of storage, NULL for the heap */
+};
+
+static bool ls_ordered_map_resize(LsOrderedMap *self, uint32_t min_usable);
+
+LsOrderedMap *ls_ordered_map_new(ls_hashmap_hash_func hash, ls_hashmap_equal_func compare)
+{
+        return ls_ordered_map_new_full_with_allocator(NULL, hash, compare, NULL, NULL);
+}
+
+LsOrderedMap *ls_ordered_map_new_full(ls_hashmap_hash_func hash, ls_hashmap_equal_func compare,
+                                      ls_hashmap_free_func key_free,
+                                      ls_hashmap_free_func value_free)
+{
+        return ls_ordered_map_new_full_with_allocator(NULL, hash, compare, key_free, value_free);
+}
+
+LsOrderedMap *ls_ordered_map_new_with_allocator(const LsAllocator *allocator,
+                                                ls_hashmap_hash_func hash,
+                                                ls_hashmap_equal_func compare)
+{
+        return ls_ordered_map_new_full_with_allocator(allocator, hash, compare, NULL, NULL);
+}
+
+LsOrderedMap *ls_ordered_map_new_full_with_allocator(const LsAllocator *allocator,
+                                                     ls_hashmap_hash_func hash,
+                                                     ls_hashmap_equal_func compare,
+                                                     ls_hashmap_free_func key_free,
+                                                     ls_hashmap_free_func value_free)
+{
+        LsOrderedMap *ret = NULL;
+
+        /* Some things we actually do need, sorry programmer. */
+        assert(hash);
+        assert(compare);
+
+        ret = ls_allocator_alloc0(allocator, sizeof(struct LsOrderedMap));
+        if (!ret) {
+                return NULL;
+        }
+
+        ret->allocator = allocator;
+        ret->key.hash = hash;
+        ret->key.compare = compare;
+        ret->free.key = key_free;
+        ret->free.value = value_free;
+
+        if (!ls_ordered_map_resize(ret, 0)) {
+                ls_ordered_map_free(ret);
+                return NULL;
+        }
+
+        return ret;
+}
+
+void ls_ordered_map_free(LsOrderedMap *self)
+{
+        if (ls_unlikely(!self)) {
+                return;
+        }
+
+        for (uint32_t i = 0; i < self->entries.len; i++) {
+                LsOrderedMapEntry *entry = &self->entries.blob[i];
+                if (entry->hash == 0) {
+                        continue;
+                }
+                if (self->free.key) {
+                        self->free.key(entry->key);
+                }
+                if (self->free.value) {
+                        self->free.value(entry->value);
+                }
+        }
+
+        ls_allocator_free(self->allocator,
+                          self->entries.blob,
+                          (size_t)self->entries.usable * sizeof(LsOrderedMapEntry));
+        ls_allocator_free(self->allocator,
+                          self->index.blob,
+                          (size_t)self->index.size * self->index.width);
+        ls_allocator_free(self->allocator, self, sizeof(struct LsOrderedMap));
+}
+
+/**
+ * Read an index slot at the current width
+ */
+static inline int32_t ls_ordered_map_index_get(LsOrderedMap *self, uint32_t slot)
+{
+        switch (self->index.width) {
+        case 1:
+                return ((int8_t *)self->index.blob)[slot];
+        case 2:
+                return ((int16_t *)self->index.blob)[slot];
+        default:
+                return ((int32_t *)self->index.blob)[slot];
+        }
+}
+
+/**
+ * Write an index slot at the current width. The caller guarantees the
+ * value fits, as the width is chosen by the capacity.
+ */
+static inline void ls_ordered_map_index_set(LsOrderedMap *self, uint32_t slot, int32_t value)
+{
+        switch (self->index.width) {
+        case 1:
+                ((int8_t *)self->index.blob)[slot] = (int8_t)value;
+                break;
+        case 2:
+                ((int16_t *)self->index.blob)[slot] = (int16_t)value;
+                break;
+        default:
+                ((int32_t *)self->index.blob)[slot] = value;
+                break;
+        }
+}
+
+/**
+ * Zero is reserved to mark removed entries
+ */
+static inline uint32_t ls_ordered_map_hash_key(LsOrderedMap *self, const void *key)
+{
+        uint32_t hash = self->key.hash(key);
+        return hash ? hash : 1;
+}
+
+/**
+ * Walk the probe sequence for @hash, returning the slot containing the
+ * matching entry, or the first empty slot if there is none. @found is set
+ * accordingly.
+ */
+static uint32_t ls_ordered_map_lookup(LsOrderedMap *self, uint32_t hash, const void *key,
+                                      bool *found)
+{
+        uint32_t slot = hash & self->index.mask;
+        uint32_t perturb = hash;
+
+        for (;;) {
+                int32_t ix = ls_ordered_map_index_get(self, slot);
+
+                if (ix == LS_ORDERED_MAP_EMPTY) {
+                        *found = false;
+                        return slot;
+                }
+
+                if (ix >= 0) {
+                        LsOrderedMapEntry *entry = &self->entries.blob[ix];
+                        if (entry->hash == hash && self->key.compare(entry->key, key)) {
+                                *found = true;
+                                return slot;
+                        }
+                }
+
+                perturb >>= LS_ORDERED_MAP_PERTURB_SHIFT;
+                slot = (slot * 5 + perturb + 1) & self->index.mask;
+        }
+}
+
+/**
+ * Find the first empty slot for a hash we know isn't in the index yet
+ */
+static uint32_t ls_ordered_map_find_empty(LsOrderedMap *self, uint32_t hash)
+{
+        uint32_t slot = hash & self->index.mask;
+        uint32_t perturb = hash;
+
+        while (ls_ordered_map_index_get(self, slot) != LS_ORDERED_MAP_EMPTY) {
+                perturb >>= LS_ORDERED_MAP_PERTURB_SHIFT;
+                slot = (slot * 5 + perturb + 1) & self->index.mask;
+        }
+
+        return slot;
+}
+
+/**
+ * Rebuild the index and compact the entries so that at least @min_usable
+ * entries may be stored. Removed entries are dropped, insertion order is
+ * preserved.
+ */
+static bool ls_ordered_map_resize(LsOrderedMap *self, uint32_t min_usable)
+{
+        uint32_t size = LS_ORDERED_MAP_MIN_SIZE;
+        uint32_t usable = 0;
+        unsigned int width = 0;
+        void *index = NULL;
+        LsOrderedMapEntry *entries = NULL;
+        uint32_t n = 0;
+
+        /* Keep the index at most 2/3 full */
+        while (((uint64_t)size * 2) / 3 < min_usable) {
+                size <<= 1;
+        }
+        usable = (size * 2) / 3;
+
+        if (size <= INT8_MAX + 1) {
+                width = 1;
+        } else if (size <= INT16_MAX + 1) {
+                width = 2;
+        } else {
+                width = 4;
+        }
+
+        /* Nothing is touched until both allocations succeed, so a failed
+         * grow leaves the map exactly as it was */
+        index = ls_allocator_alloc0(self->allocator, (size_t)size * width);
+        if (ls_unlikely(!index)) {
+                return false;
+        }
+        entries = ls_allocator_alloc0(self->allocator, (size_t)usable * sizeof(LsOrderedMapEntry));
+        if (ls_unlikely(!entries)) {
+                ls_allocator_free(self->allocator, index, (size_t)size * width);
+                return false;
+        }
+        memset(index, 0xff, (size_t)size * width);
+
+        /* Compact into the new storage, dropping removed entries */
+        for (uint32_t i = 0; i < self->entries.len; i++) {
+                if (self->entries.blob[i].hash != 0) {
+                        entries[n++] = self->entries.blob[i];
+                }
+        }
+
+        ls_allocator_free(self->allocator,
+                          self->entries.blob,
+                          (size_t)self->entries.usable * sizeof(LsOrderedMapEntry));
+        ls_allocator_free(self->allocator,
+                          self->index.blob,
+                          (size_t)self->index.size * self->index.width);
+        self->index.blob = index;
+        self->index.size = size;
+        self->index.mask = size - 1;
+        self->index.width = width;
+        self->entries.blob = entries;
+        self->entries.len = n;
+        self->entries.usable = usable;
+
+        for (uint32_t i = 0; i < n; i++) {
+                uint32_t slot = ls_ordered_map_find_empty(self, entries[i].hash);
+                ls_ordered_map_index_set(self, slot, (int32_t)i);
+        }
+
+        return true;
+}
+
+bool ls_ordered_map_put(LsOrderedMap *self, void *key, void *value)
+{
+        uint32_t hash;
+        uint32_t slot;
+        bool found = false;
+        LsOrderedMapEntry *entry = NULL;
+
+        if (ls_unlikely(!self)) {
+                return false;
+        }
+
+        hash = ls_ordered_map_hash_key(self, key);
+        slot = ls_ordered_map_lookup(self, hash, key, &found);
+
+        /* Replace in place, keeping the original position */
+        if (found) {
+                entry = &self->entries.blob[ls_ordered_map_index_get(self, slot)];
+                if (self->free.key) {
+                        self->free.key(entry->key);
+                }
+                if (self->free.value) {
+                        self->free.value(entry->value);
+                }
+                entry->key = key;
+                entry->value = value;
+                return true;
+        }
+
+        /* Out of entries, grow relative to what is really live */
+        if (ls_unlikely(self->entries.len == self->entries.usable)) {
+                if (!ls_ordered_map_resize(self, (self->entries.live + 1) * 2)) {
+                        return false;
+                }
+                slot = ls_ordered_map_find_empty(self, hash);
+        }
+
+        entry = &self->entries.blob[self->entries.len];
+        entry->hash = hash;
+        entry->key = key;
+        entry->value = value;
+        ls_ordered_map_index_set(self, slot, (int32_t)self->entries.len);
+        self->entries.len++;
+        self->entries.live++;
+
+        return true;
+}
+
+void *ls_ordered_map_get(LsOrderedMap *self, void *key)
+{
+        uint32_t slot;
+        bool found = false;
+
+        if (ls_unlikely(!self)) {
+                return NULL;
+        }
+
+        slot = ls_ordered_map_lookup(self, ls_ordered_map_hash_key(self, key), key, &found);
+        if (!found) {
+                return NULL;
+        }
+
+        return self->entries.blob[ls_ordered_map_index_get(self, slot)].value;
+}
+
+bool ls_ordered_map_remove(LsOrderedMap *self, void *key)
+{
+        uint32_t slot;
+        bool found = false;
+        LsOrderedMapEntry *entry = NULL;
+
+        if (ls_unlikely(!self)) {
+                return false;
+        }
+
+        slot = ls_ordered_map_lookup(self, ls_ordered_map_hash_key(self, key), key, &found);
+        if (!found) {
+                return false;
+        }
+
+        entry = &self->entries.blob[ls_ordered_map_index_get(self, slot)];
+        if (self->free.key) {
+                self->free.key(entry->key);
+        }
+        if (self->free.value) {
+                self->free.value(entry->value);
+        }
+
+        /* Leave a dummy so that later probes continue past this slot */
+        ls_ordered_map_index_set(self, slot, LS_ORDERED_MAP_DUMMY);
+        entry->hash = 0;
+        entry->key = NULL;
+        entry->value = NULL;
+        self->entries.live--;
+
+        return true;
+}
+
+unsigned int ls_ordered_map_size(LsOrderedMap *self)
+{
+        if (ls_unlikely(!self)) {
+                return 0;
+        }
+        return self->entries.live;
+}
+
+void ls_ordered_map_iter_init(LsOrderedMap *self, LsOrderedMapIter *iter)
+{
+        iter->map = self;
+        iter->position = 0;
+}
+
+bool ls_ordered_map_iter_next(LsOrderedMapIter *iter, void **key, void **value)
+{
+        LsOrderedMap *self = iter->map;
+
+        if (ls_unlikely(!self)) {
+                return false;
+        }
+
+        while (iter->position < self->entries.len) {
+                LsOrderedMapEntry *entry = &self->entries.blob[iter->position++];
+                if (entry->hash == 0) {
+                        continue;
+                }
+                if (key) {
+                        *key = entry->key;
+                }
+                if (value) {
+                        *value = entry->value;
+                }
+                return true;
+        }
+
+        return false;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
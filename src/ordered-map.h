@@ -0,0 +1,176 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "map.h"
+
+/**
+ * LsOrderedMap is a compact hashed key-value store that remembers the
+ * order in which keys were first inserted.
+ *
+ * Entries live in a dense array in insertion order, while buckets are
+ * held in a separate open-addressed index of small integers, sized to
+ * 8, 16 or 32 bits depending on capacity. This is considerably smaller
+ * than the chained LsHashmap and iteration is a linear scan, with a
+ * deterministic order that doesn't depend on the hash values.
+ *
+ * The hash, equality and free functions are shared with LsHashmap.
+ */
+typedef struct LsOrderedMap LsOrderedMap;
+
+/**
+ * LsOrderedMapIter is used to walk a map in insertion order. The map must
+ * not be modified while an iterator is in use.
+ */
+typedef struct LsOrderedMapIter {
+        LsOrderedMap *map;
+        uint32_t position;
+} LsOrderedMapIter;
+
+/**
+ * Construct a new LsOrderedMap with the given @hash and @compare functions.
+ *
+ * @param hash A hash generator function
+ * @param compare A key equality function
+ *
+ * @note Free with ls_ordered_map_free
+ *
+ * @return A newly allocated LsOrderedMap
+ */
+LsOrderedMap *ls_ordered_map_new(ls_hashmap_hash_func hash, ls_hashmap_equal_func compare);
+
+/**
+ * Construct a new LsOrderedMap with key/value free functions
+ *
+ * @param hash A hash generator function
+ * @param compare A key equality function
+ * @param key_free Function to call to free any keys when replaced or the map is freed
+ * @param value_free Function to call to free any values when replaced or the map is freed
+ *
+ * @note Free with ls_ordered_map_free
+ *
+ * @return A newly allocated LsOrderedMap
+ */
+LsOrderedMap *ls_ordered_map_new_full(ls_hashmap_hash_func hash, ls_hashmap_equal_func compare,
+                                      ls_hashmap_free_func key_free,
+                                      ls_hashmap_free_func value_free);
+
+/**
+ * Construct a new LsOrderedMap obtaining its header, index and entries
+ * from @allocator, which must outlive the map. A NULL allocator is
+ * identical to ls_ordered_map_new.
+ *
+ * @note Free with ls_ordered_map_free
+ */
+LsOrderedMap *ls_ordered_map_new_with_allocator(const LsAllocator *allocator,
+                                                ls_hashmap_hash_func hash,
+                                                ls_hashmap_equal_func compare);
+
+/**
+ * Construct a new LsOrderedMap with key/value free functions, obtaining
+ * all storage from @allocator
+ *
+ * @note Free with ls_ordered_map_free
+ */
+LsOrderedMap *ls_ordered_map_new_full_with_allocator(const LsAllocator *allocator,
+                                                     ls_hashmap_hash_func hash,
+                                                     ls_hashmap_equal_func compare,
+                                                     ls_hashmap_free_func key_free,
+                                                     ls_hashmap_free_func value_free);
+
+/**
+ * Free a previously allocated map
+ *
+ * @param map Pointer to a previously allocated map
+ */
+void ls_ordered_map_free(LsOrderedMap *map);
+
+/**
+ * Store a key/value mapping within the map. Replacing the value of an
+ * existing key will not change its position in the iteration order.
+ *
+ * @note This will not copy the key or value. Do this before insert
+ *
+ * @param map Pointer to a valid LsOrderedMap instance
+ * @param key Key for the new mapping
+ * @param value Value for the new mapping
+ *
+ * @returns True if the key/value pair could be stored
+ */
+bool ls_ordered_map_put(LsOrderedMap *map, void *key, void *value);
+
+/**
+ * Attempt to retrieve the value from the map associated with @key
+ *
+ * @param map Pointer to an allocated map
+ *
+ * @returns The stored value, if found.
+ */
+void *ls_ordered_map_get(LsOrderedMap *map, void *key);
+
+/**
+ * Remove key from the map that matches the given key
+ *
+ * @param map Pointer to an allocated map
+ * @param key Key to lookup a value for
+ *
+ * @returns True if we deleted a matching key/value
+ */
+bool ls_ordered_map_remove(LsOrderedMap *map, void *key);
+
+/**
+ * Return the number of key/value pairs currently stored in the map
+ */
+unsigned int ls_ordered_map_size(LsOrderedMap *map);
+
+/**
+ * Prepare @iter to walk @map from the oldest inserted key
+ */
+void ls_ordered_map_iter_init(LsOrderedMap *map, LsOrderedMapIter *iter);
+
+/**
+ * Advance the iterator, storing the next key and value.
+ *
+ * @param iter Pointer to an initialised iterator
+ * @param key Storage for the key, may be NULL
+ * @param value Storage for the value, may be NULL
+ *
+ * @returns False once the iterator has been exhausted
+ */
+bool ls_ordered_map_iter_next(LsOrderedMapIter *iter, void **key, void **value);
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,541 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dlist.h"
+#include "pool.h"
+
+/**
+ * Objects held by each magazine. Larger magazines visit the depot less
+ * often, at the cost of more objects sitting idle in each thread.
+ */
+#define LS_POOL_MAGAZINE_SIZE 64
+
+/**
+ * Target size of each slab
+ */
+#define LS_POOL_SLAB_SIZE (64 * 1024)
+
+/**
+ * A magazine is a small stack of free objects. Full and empty magazines
+ * are chained through next while sitting in the depot.
+ */
+typedef struct LsPoolMagazine {
+        struct LsPoolMagazine *next;
+        unsigned int count;
+        void *objects[LS_POOL_MAGAZINE_SIZE];
+} LsPoolMagazine;
+
+/**
+ * A slab is a contiguous run of objects, chained for teardown
+ */
+typedef struct LsPoolSlab {
+        struct LsPoolSlab *next;
+        max_align_t data[];
+} LsPoolSlab;
+
+/**
+ * Each thread owns a loaded magazine and the previously loaded one, so
+ * that alternating allocs and releases around a boundary can't thrash
+ * the depot.
+ */
+typedef struct LsPoolCache {
+        LsPoolMagazine *loaded;   /**<Magazine we allocate from and release to */
+        LsPoolMagazine *previous; /**<Either full or empty */
+        LsPool *pool;             /**<Owning pool, for thread exit */
+        LsDListNode link;         /**<Membership of the pool's cache list */
+} LsPoolCache;
+
+/**
+ * Opaque LsPool implementation
+ */
+struct LsPool {
+        size_t object_size;    /**<Rounded size of each object */
+        size_t slab_objects;   /**<Objects carved from each slab */
+        pthread_key_t key;     /**<Per-thread LsPoolCache */
+        pthread_mutex_t lock;  /**<Guards everything below */
+        LsPoolMagazine *full;  /**<Depot of full magazines */
+        LsPoolMagazine *empty; /**<Depot of empty magazines */
+        LsPoolSlab *slabs;     /**<Newest slab first */
+        size_t slab_used;      /**<Objects carved from the newest slab */
+        void *loose;           /**<Objects not in any magazine, linked through themselves */
+        LsDList caches;        /**<Every live thread cache */
+        LsAllocator allocator; /**<Exposes the pool to containers */
+};
+
+/**
+ * Push every object in a partially filled magazine onto the loose list,
+ * with the lock held
+ */
+static void ls_pool_scatter(LsPool *self, LsPoolMagazine *magazine)
+{
+        while (magazine->count > 0) {
+                void *object = magazine->objects[--magazine->count];
+                *(void **)object = self->loose;
+                self->loose = object;
+        }
+}
+
+/**
+ * Hand a magazine back to the depot, with the lock held
+ */
+static void ls_pool_depot_put(LsPool *self, LsPoolMagazine *magazine)
+{
+        if (magazine->count == LS_POOL_MAGAZINE_SIZE) {
+                magazine->next = self->full;
+                self->full = magazine;
+                return;
+        }
+        ls_pool_scatter(self, magazine);
+        magazine->next = self->empty;
+        self->empty = magazine;
+}
+
+/**
+ * Top up a magazine from the loose list and then fresh slab space, with
+ * the lock held. The magazine is left short only if we run out of memory.
+ */
+static void ls_pool_fill(LsPool *self, LsPoolMagazine *magazine)
+{
+        while (magazine->count < LS_POOL_MAGAZINE_SIZE && self->loose) {
+                void *object = self->loose;
+                self->loose = *(void **)object;
+                magazine->objects[magazine->count++] = object;
+        }
+
+        while (magazine->count < LS_POOL_MAGAZINE_SIZE) {
+                if (!self->slabs || self->slab_used == self->slab_objects) {
+                        LsPoolSlab *slab =
+                            malloc(sizeof(LsPoolSlab) + self->slab_objects * self->object_size);
+                        if (!slab) {
+                                return;
+                        }
+                        slab->next = self->slabs;
+                        self->slabs = slab;
+                        self->slab_used = 0;
+                }
+                magazine->objects[magazine->count++] =
+                    (char *)self->slabs->data + self->slab_used++ * self->object_size;
+        }
+}
+
+/**
+ * Thread exit, return both magazines to the depot
+ */
+static void ls_pool_cache_destroy(void *v)
+{
+        LsPoolCache *cache = v;
+        LsPool *self = cache->pool;
+
+        pthread_mutex_lock(&self->lock);
+        ls_pool_depot_put(self, cache->loaded);
+        ls_pool_depot_put(self, cache->previous);
+        ls_dlist_unlink(&cache->link);
+        pthread_mutex_unlock(&self->lock);
+
+        free(cache);
+}
+
+/**
+ * Set up the calling thread's cache with a pair of empty magazines
+ */
+static LsPoolCache *ls_pool_cache_new(LsPool *self)
+{
+        LsPoolCache *cache = NULL;
+
+        cache = calloc(1, sizeof(struct LsPoolCache));
+        if (!cache) {
+                return NULL;
+        }
+        cache->pool = self;
+        cache->loaded = calloc(1, sizeof(struct LsPoolMagazine));
+        cache->previous = calloc(1, sizeof(struct LsPoolMagazine));
+        if (!cache->loaded || !cache->previous || pthread_setspecific(self->key, cache) != 0) {
+                free(cache->loaded);
+                free(cache->previous);
+                free(cache);
+                return NULL;
+        }
+
+        pthread_mutex_lock(&self->lock);
+        ls_dlist_push_back(&self->caches, &cache->link);
+        pthread_mutex_unlock(&self->lock);
+
+        return cache;
+}
+
+static inline LsPoolCache *ls_pool_cache(LsPool *self)
+{
+        LsPoolCache *cache = pthread_getspecific(self->key);
+
+        if (ls_likely(cache != NULL)) {
+                return cache;
+        }
+        return ls_pool_cache_new(self);
+}
+
+static inline void ls_pool_cache_swap(LsPoolCache *cache)
+{
+        LsPoolMagazine *magazine = cache->loaded;
+
+        cache->loaded = cache->previous;
+        cache->previous = magazine;
+}
+
+/**
+ * Called when the loaded magazine is empty, to load a non-empty one
+ *
+ * @returns False if no memory could be found
+ */
+static bool ls_pool_cache_reload(LsPool *self, LsPoolCache *cache)
+{
+        LsPoolMagazine *magazine = NULL;
+
+        if (cache->previous->count > 0) {
+                ls_pool_cache_swap(cache);
+                return true;
+        }
+
+        /* Both empty, trade one for a full magazine from the depot */
+        pthread_mutex_lock(&self->lock);
+        magazine = self->full;
+        if (magazine) {
+                self->full = magazine->next;
+                cache->previous->next = self->empty;
+                self->empty = cache->previous;
+                cache->previous = cache->loaded;
+                cache->loaded = magazine;
+        } else {
+                ls_pool_fill(self, cache->loaded);
+        }
+        pthread_mutex_unlock(&self->lock);
+
+        return cache->loaded->count > 0;
+}
+
+/**
+ * Called when the loaded magazine is full, to load an empty one
+ *
+ * @returns False if no empty magazine could be found
+ */
+static bool ls_pool_cache_unload(LsPool *self, LsPoolCache *cache)
+{
+        LsPoolMagazine *magazine = NULL;
+
+        if (cache->previous->count == 0) {
+                ls_pool_cache_swap(cache);
+                return true;
+        }
+
+        /* Both full, trade one for an empty magazine from the depot */
+        pthread_mutex_lock(&self->lock);
+        magazine = self->empty;
+        if (magazine) {
+                self->empty = magazine->next;
+        }
+        pthread_mutex_unlock(&self->lock);
+
+        if (!magazine) {
+                magazine = malloc(sizeof(struct LsPoolMagazine));
+                if (!magazine) {
+                        return false;
+                }
+        }
+        magazine->count = 0;
+
+        pthread_mutex_lock(&self->lock);
+        cache->previous->next = self->full;
+        self->full = cache->previous;
+        pthread_mutex_unlock(&self->lock);
+
+        cache->previous = cache->loaded;
+        cache->loaded = magazine;
+        return true;
+}
+
+/**
+ * Slow path when no magazine can take the object, straight to the depot
+ */
+static void ls_pool_release_loose(LsPool *self, void *object)
+{
+        pthread_mutex_lock(&self->lock);
+        *(void **)object = self->loose;
+        self->loose = object;
+        pthread_mutex_unlock(&self->lock);
+}
+
+static void *ls_pool_allocator_alloc(void *context, size_t size);
+static void *ls_pool_allocator_realloc(void *context, void *ptr, size_t old_size,
+                                       size_t new_size);
+static void ls_pool_allocator_free(void *context, void *ptr, size_t size);
+
+LsPool *ls_pool_new(size_t object_size)
+{
+        LsPool *ret = NULL;
+
+        if (ls_unlikely(object_size == 0 || object_size > SIZE_MAX / LS_POOL_MAGAZINE_SIZE)) {
+                return NULL;
+        }
+
+        ret = calloc(1, sizeof(struct LsPool));
+        if (!ret) {
+                return NULL;
+        }
+
+        /* Objects double as loose list links, and must stay aligned */
+        ret->object_size = (object_size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+        ret->slab_objects = LS_POOL_SLAB_SIZE / ret->object_size;
+        if (ret->slab_objects < LS_POOL_MAGAZINE_SIZE) {
+                ret->slab_objects = LS_POOL_MAGAZINE_SIZE;
+        }
+        ls_dlist_init(&ret->caches);
+        ret->allocator = (LsAllocator){
+                .alloc = ls_pool_allocator_alloc,
+                .realloc = ls_pool_allocator_realloc,
+                .free = ls_pool_allocator_free,
+                .context = ret,
+        };
+
+        if (pthread_key_create(&ret->key, ls_pool_cache_destroy) != 0) {
+                free(ret);
+                return NULL;
+        }
+        if (pthread_mutex_init(&ret->lock, NULL) != 0) {
+                pthread_key_delete(ret->key);
+                free(ret);
+                return NULL;
+        }
+
+        return ret;
+}
+
+/**
+ * Free a chain of magazines
+ */
+static void ls_pool_magazines_free(LsPoolMagazine *magazine)
+{
+        LsPoolMagazine *next = NULL;
+
+        for (; magazine; magazine = next) {
+                next = magazine->next;
+                free(magazine);
+        }
+}
+
+void ls_pool_free(LsPool *self)
+{
+        LsDListNode *node = NULL;
+        LsDListNode *tmp = NULL;
+        LsPoolSlab *next = NULL;
+
+        if (ls_unlikely(!self)) {
+                return;
+        }
+
+        /* No more thread exit callbacks, we tear down every cache here */
+        pthread_key_delete(self->key);
+
+        ls_dlist_foreach_safe(&self->caches, node, tmp) {
+                LsPoolCache *cache = ls_dlist_entry(node, LsPoolCache, link);
+                free(cache->loaded);
+                free(cache->previous);
+                free(cache);
+        }
+
+        ls_pool_magazines_free(self->full);
+        ls_pool_magazines_free(self->empty);
+
+        for (LsPoolSlab *slab = self->slabs; slab; slab = next) {
+                next = slab->next;
+                free(slab);
+        }
+
+        pthread_mutex_destroy(&self->lock);
+        free(self);
+}
+
+size_t ls_pool_object_size(LsPool *self)
+{
+        return self->object_size;
+}
+
+void *ls_pool_alloc(LsPool *self)
+{
+        LsPoolCache *cache = ls_pool_cache(self);
+
+        if (ls_unlikely(!cache)) {
+                return NULL;
+        }
+        if (ls_unlikely(cache->loaded->count == 0) && !ls_pool_cache_reload(self, cache)) {
+                return NULL;
+        }
+        return cache->loaded->objects[--cache->loaded->count];
+}
+
+void ls_pool_release(LsPool *self, void *object)
+{
+        LsPoolCache *cache = NULL;
+
+        if (ls_unlikely(!object)) {
+                return;
+        }
+
+        cache = ls_pool_cache(self);
+        if (ls_unlikely(!cache) || (ls_unlikely(cache->loaded->count == LS_POOL_MAGAZINE_SIZE) &&
+                                    !ls_pool_cache_unload(self, cache))) {
+                ls_pool_release_loose(self, object);
+                return;
+        }
+        cache->loaded->objects[cache->loaded->count++] = object;
+}
+
+size_t ls_pool_alloc_bulk(LsPool *self, void **objects, size_t n)
+{
+        LsPoolCache *cache = ls_pool_cache(self);
+        size_t ret = 0;
+
+        if (ls_unlikely(!cache)) {
+                return 0;
+        }
+
+        while (ret < n) {
+                LsPoolMagazine *magazine = cache->loaded;
+                size_t take = n - ret;
+
+                if (magazine->count == 0) {
+                        if (!ls_pool_cache_reload(self, cache)) {
+                                break;
+                        }
+                        continue;
+                }
+
+                /* Copy a run straight off the top of the magazine */
+                if (take > magazine->count) {
+                        take = magazine->count;
+                }
+                magazine->count -= (unsigned int)take;
+                memcpy(objects + ret, magazine->objects + magazine->count, take * sizeof(void *));
+                ret += take;
+        }
+
+        return ret;
+}
+
+void ls_pool_release_bulk(LsPool *self, void **objects, size_t n)
+{
+        LsPoolCache *cache = ls_pool_cache(self);
+        size_t done = 0;
+
+        while (done < n) {
+                LsPoolMagazine *magazine = NULL;
+                size_t put = n - done;
+
+                if (ls_unlikely(!cache) ||
+                    (cache->loaded->count == LS_POOL_MAGAZINE_SIZE &&
+                     !ls_pool_cache_unload(self, cache))) {
+                        ls_pool_release_loose(self, objects[done++]);
+                        continue;
+                }
+
+                magazine = cache->loaded;
+                if (put > LS_POOL_MAGAZINE_SIZE - magazine->count) {
+                        put = LS_POOL_MAGAZINE_SIZE - magazine->count;
+                }
+                memcpy(magazine->objects + magazine->count, objects + done, put * sizeof(void *));
+                magazine->count += (unsigned int)put;
+                done += put;
+        }
+}
+
+/**
+ * Only requests which round up to our object size come from the pool
+ */
+static inline bool ls_pool_fits(LsPool *self, size_t size)
+{
+        return size > self->object_size - sizeof(void *) && size <= self->object_size;
+}
+
+static void *ls_pool_allocator_alloc(void *context, size_t size)
+{
+        if (ls_pool_fits(context, size)) {
+                return ls_pool_alloc(context);
+        }
+        return malloc(size);
+}
+
+static void ls_pool_allocator_free(void *context, void *ptr, size_t size)
+{
+        if (ls_pool_fits(context, size)) {
+                ls_pool_release(context, ptr);
+        } else {
+                free(ptr);
+        }
+}
+
+static void *ls_pool_allocator_realloc(void *context, void *ptr, size_t old_size, size_t new_size)
+{
+        bool old_fits = ptr && ls_pool_fits(context, old_size);
+        bool new_fits = ls_pool_fits(context, new_size);
+        void *ret = NULL;
+
+        if (!old_fits && !new_fits) {
+                return realloc(ptr, new_size);
+        }
+        if (old_fits && new_fits) {
+                return ptr;
+        }
+
+        /* Moving between the pool and the heap */
+        ret = ls_pool_allocator_alloc(context, new_size);
+        if (!ret) {
+                return NULL;
+        }
+        if (ptr) {
+                memcpy(ret, ptr, old_size < new_size ? old_size : new_size);
+                ls_pool_allocator_free(context, ptr, old_size);
+        }
+        return ret;
+}
+
+const LsAllocator *ls_pool_allocator(LsPool *self)
+{
+        return &self->allocator;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,112 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "macros.h"
+
+/**
+ * LsPool is a thread-safe allocator for objects of a single fixed size.
+ *
+ * Objects are carved out of large slabs and recycled through small
+ * per-thread magazines, so the common alloc and release touch no locks
+ * and no shared cache lines. Whole magazines are exchanged with a shared
+ * depot as threads run dry or fill up, which rebalances objects freed on
+ * a different thread to the one that allocated them.
+ *
+ * Slabs are only returned to the system when the pool is freed.
+ */
+typedef struct LsPool LsPool;
+
+/**
+ * Construct a new LsPool handing out objects of @object_size bytes. The
+ * size is rounded up to a multiple of the pointer size, and objects are
+ * suitably aligned for any type of that size.
+ *
+ * @note Free with ls_pool_free
+ */
+LsPool *ls_pool_new(size_t object_size);
+
+/**
+ * Free the pool and every slab it owns, invalidating all objects. No
+ * other thread may be using the pool at this point.
+ */
+void ls_pool_free(LsPool *pool);
+
+/**
+ * Return the (rounded) size of each object in the pool
+ */
+size_t ls_pool_object_size(LsPool *pool);
+
+/**
+ * Allocate a single uninitialised object, or NULL if memory is exhausted
+ */
+void *ls_pool_alloc(LsPool *pool);
+
+/**
+ * Return a single object to the pool. It may have been allocated on any
+ * thread.
+ */
+void ls_pool_release(LsPool *pool, void *object);
+
+/**
+ * Allocate up to @n objects into @objects at once
+ *
+ * @returns The number of objects allocated, less than @n only when memory
+ *          is exhausted
+ */
+size_t ls_pool_alloc_bulk(LsPool *pool, void **objects, size_t n);
+
+/**
+ * Return @n objects to the pool at once
+ */
+void ls_pool_release_bulk(LsPool *pool, void **objects, size_t n);
+
+/**
+ * Return an LsAllocator drawing from @pool, valid for the lifetime of the
+ * pool. Requests matching the object size are served by the pool, and
+ * anything else falls back to malloc, so containers may opt in without
+ * caring how large their other allocations are:
+ *
+ *      LsPool *pool = ls_pool_new(ls_hashmap_node_size());
+ *      LsHashmap *map = ls_hashmap_new_with_allocator(ls_pool_allocator(pool), ...);
+ *
+ *      LsPool *pool = ls_pool_new(sizeof(LsList));
+ *      list = ls_list_prepend_with_allocator(ls_pool_allocator(pool), list, data);
+ */
+const LsAllocator *ls_pool_allocator(LsPool *pool);
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -33,6 +33,16 @@ LsPtrArray *ls_ptr_array_new_size(uint16_t reserved)
         return ls_array_new_size(sizeof(void *), reserved);
 }
 
+LsPtrArray *ls_ptr_array_new_with_allocator(const LsAllocator *allocator, uint16_t reserved)
+{
+        return ls_array_new_with_allocator(allocator, sizeof(void *), reserved);
+}
+
+LsPtrArray *ls_ptr_array_new_frame(LsFrameAllocator *frame, uint16_t reserved)
+{
+        return ls_array_new_frame(frame, sizeof(void *), reserved);
+}
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
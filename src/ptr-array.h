@@ -38,6 +38,18 @@ LsPtrArray *ls_ptr_array_new(void);
  */
 LsPtrArray *ls_ptr_array_new_size(uint16_t reserved);
 
+/**
+ * Construct a new pointer-specific array with storage obtained from
+ * @allocator, pre-allocating the given number of blocks.
+ */
+LsPtrArray *ls_ptr_array_new_with_allocator(const LsAllocator *allocator, uint16_t reserved);
+
+/**
+ * Construct a new pointer-specific array in the current frame of @frame,
+ * released when its frame is recycled.
+ */
+LsPtrArray *ls_ptr_array_new_frame(LsFrameAllocator *frame, uint16_t reserved);
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
@@ -0,0 +1,402 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "skip-list.h"
+
+/**
+ * Enough levels for 4^16 keys at our branching factor
+ */
+#define LS_SKIP_LIST_MAX_HEIGHT 16
+
+/**
+ * Nodes are bump allocated from slabs of this many bytes
+ */
+#define LS_SKIP_LIST_SLAB_SIZE 4096
+
+/**
+ * A single node, with one forward link per level
+ */
+typedef struct LsSkipListNode {
+        void *key;
+        void *value;
+        unsigned int height;
+        struct LsSkipListNode *next[];
+} LsSkipListNode;
+
+/**
+ * Slabs are chained so they can be released together
+ */
+typedef struct LsSkipListSlab {
+        struct LsSkipListSlab *next;
+        size_t used;
+        void *blob[];
+} LsSkipListSlab;
+
+/**
+ * Opaque LsSkipList implementation
+ */
+struct LsSkipList {
+        LsSkipListNode *head; /**<Sentinel with every level */
+        unsigned int height;  /**<Tallest level currently in use */
+        unsigned int size;    /**<Number of stored keys */
+        uint32_t rng;         /**<xorshift state for node heights */
+        ls_compare_func compare;
+
+        struct {
+                LsSkipListSlab *slabs;                               /**<Newest slab first */
+                LsSkipListNode *free_nodes[LS_SKIP_LIST_MAX_HEIGHT]; /**<Released, by height */
+        } pool;
+
+        struct {
+                ls_free_func key;   /**<Key free function */
+                ls_free_func value; /**<Value free function */
+        } free;
+};
+
+/**
+ * Bytes required for a node of the given height
+ */
+static inline size_t ls_skip_list_node_size(unsigned int height)
+{
+        return sizeof(LsSkipListNode) + height * sizeof(LsSkipListNode *);
+}
+
+LsSkipList *ls_skip_list_new(ls_compare_func compare)
+{
+        return ls_skip_list_new_full(compare, NULL, NULL);
+}
+
+LsSkipList *ls_skip_list_new_full(ls_compare_func compare, ls_free_func key_free,
+                                  ls_free_func value_free)
+{
+        LsSkipList *ret = NULL;
+
+        /* Some things we actually do need, sorry programmer. */
+        assert(compare);
+
+        ret = calloc(1, sizeof(struct LsSkipList));
+        if (!ret) {
+                return NULL;
+        }
+
+        ret->head = calloc(1, ls_skip_list_node_size(LS_SKIP_LIST_MAX_HEIGHT));
+        if (!ret->head) {
+                free(ret);
+                return NULL;
+        }
+        ret->head->height = LS_SKIP_LIST_MAX_HEIGHT;
+        ret->height = 1;
+
+        /* Heights only need to be unpredictable enough to stay balanced */
+        ret->rng = (uint32_t)((uintptr_t)ret >> 4) | 1;
+        ret->compare = compare;
+        ret->free.key = key_free;
+        ret->free.value = value_free;
+
+        return ret;
+}
+
+void ls_skip_list_free(LsSkipList *self)
+{
+        LsSkipListSlab *slab = NULL;
+        LsSkipListSlab *next = NULL;
+
+        if (ls_unlikely(!self)) {
+                return;
+        }
+
+        if (self->free.key || self->free.value) {
+                for (LsSkipListNode *node = self->head->next[0]; node; node = node->next[0]) {
+                        if (self->free.key) {
+                                self->free.key(node->key);
+                        }
+                        if (self->free.value) {
+                                self->free.value(node->value);
+                        }
+                }
+        }
+
+        for (slab = self->pool.slabs; slab; slab = next) {
+                next = slab->next;
+                free(slab);
+        }
+
+        free(self->head);
+        free(self);
+}
+
+/**
+ * Pick a height with a 1/4 chance of each extra level
+ */
+static unsigned int ls_skip_list_random_height(LsSkipList *self)
+{
+        uint32_t r = self->rng;
+        unsigned int height = 1;
+
+        r ^= r << 13;
+        r ^= r >> 17;
+        r ^= r << 5;
+        self->rng = r;
+
+        while ((r & 3) == 0 && height < LS_SKIP_LIST_MAX_HEIGHT) {
+                ++height;
+                r >>= 2;
+        }
+
+        return height;
+}
+
+/**
+ * Grab a node of @height from the free lists, or carve a new one from
+ * the current slab.
+ */
+static LsSkipListNode *ls_skip_list_node_alloc(LsSkipList *self, unsigned int height)
+{
+        LsSkipListNode *node = self->pool.free_nodes[height - 1];
+        LsSkipListSlab *slab = self->pool.slabs;
+        size_t size = ls_skip_list_node_size(height);
+
+        if (node) {
+                self->pool.free_nodes[height - 1] = node->next[0];
+                return node;
+        }
+
+        if (!slab || slab->used + size > LS_SKIP_LIST_SLAB_SIZE - sizeof(LsSkipListSlab)) {
+                slab = malloc(LS_SKIP_LIST_SLAB_SIZE);
+                if (!slab) {
+                        return NULL;
+                }
+                slab->used = 0;
+                slab->next = self->pool.slabs;
+                self->pool.slabs = slab;
+        }
+
+        /* Sizes are whole pointers so every node stays aligned */
+        node = (LsSkipListNode *)((char *)slab->blob + slab->used);
+        slab->used += size;
+        node->height = height;
+        return node;
+}
+
+/**
+ * Return a node to the free list for its height
+ */
+static void ls_skip_list_node_release(LsSkipList *self, LsSkipListNode *node)
+{
+        node->next[0] = self->pool.free_nodes[node->height - 1];
+        self->pool.free_nodes[node->height - 1] = node;
+}
+
+/**
+ * Locate the last node before @key on every level, storing them in
+ * @update when non-NULL. Returns the first node not less than @key.
+ */
+static LsSkipListNode *ls_skip_list_find(LsSkipList *self, const void *key,
+                                         LsSkipListNode **update)
+{
+        LsSkipListNode *node = self->head;
+
+        for (unsigned int level = self->height; level-- > 0;) {
+                while (node->next[level] && self->compare(node->next[level]->key, key) < 0) {
+                        node = node->next[level];
+                }
+                if (update) {
+                        update[level] = node;
+                }
+        }
+
+        return node->next[0];
+}
+
+bool ls_skip_list_put(LsSkipList *self, void *key, void *value)
+{
+        LsSkipListNode *update[LS_SKIP_LIST_MAX_HEIGHT];
+        LsSkipListNode *node = NULL;
+        unsigned int height;
+
+        if (ls_unlikely(!self)) {
+                return false;
+        }
+
+        node = ls_skip_list_find(self, key, update);
+
+        /* Replace in place */
+        if (node && self->compare(node->key, key) == 0) {
+                if (self->free.key) {
+                        self->free.key(node->key);
+                }
+                if (self->free.value) {
+                        self->free.value(node->value);
+                }
+                node->key = key;
+                node->value = value;
+                return true;
+        }
+
+        height = ls_skip_list_random_height(self);
+        node = ls_skip_list_node_alloc(self, height);
+        if (!node) {
+                return false;
+        }
+
+        /* Levels above the old height start from the sentinel */
+        for (; self->height < height; self->height++) {
+                update[self->height] = self->head;
+        }
+
+        node->key = key;
+        node->value = value;
+        for (unsigned int level = 0; level < height; level++) {
+                node->next[level] = update[level]->next[level];
+                update[level]->next[level] = node;
+        }
+
+        ++self->size;
+        return true;
+}
+
+void *ls_skip_list_get(LsSkipList *self, const void *key)
+{
+        LsSkipListNode *node = NULL;
+
+        if (ls_unlikely(!self)) {
+                return NULL;
+        }
+
+        node = ls_skip_list_find(self, key, NULL);
+        if (!node || self->compare(node->key, key) != 0) {
+                return NULL;
+        }
+        return node->value;
+}
+
+bool ls_skip_list_remove(LsSkipList *self, const void *key)
+{
+        LsSkipListNode *update[LS_SKIP_LIST_MAX_HEIGHT];
+        LsSkipListNode *node = NULL;
+
+        if (ls_unlikely(!self)) {
+                return false;
+        }
+
+        node = ls_skip_list_find(self, key, update);
+        if (!node || self->compare(node->key, key) != 0) {
+                return false;
+        }
+
+        for (unsigned int level = 0; level < node->height; level++) {
+                update[level]->next[level] = node->next[level];
+        }
+
+        /* Drop any levels that are now empty */
+        while (self->height > 1 && !self->head->next[self->height - 1]) {
+                --self->height;
+        }
+
+        if (self->free.key) {
+                self->free.key(node->key);
+        }
+        if (self->free.value) {
+                self->free.value(node->value);
+        }
+        ls_skip_list_node_release(self, node);
+
+        --self->size;
+        return true;
+}
+
+bool ls_skip_list_lower_bound(LsSkipList *self, const void *key, void **found_key, void **value)
+{
+        LsSkipListNode *node = NULL;
+
+        if (ls_unlikely(!self)) {
+                return false;
+        }
+
+        node = ls_skip_list_find(self, key, NULL);
+        if (!node) {
+                return false;
+        }
+
+        if (found_key) {
+                *found_key = node->key;
+        }
+        if (value) {
+                *value = node->value;
+        }
+        return true;
+}
+
+unsigned int ls_skip_list_size(LsSkipList *self)
+{
+        if (ls_unlikely(!self)) {
+                return 0;
+        }
+        return self->size;
+}
+
+void ls_skip_list_iter_init(LsSkipList *self, LsSkipListIter *iter)
+{
+        iter->list = self;
+        iter->node = self ? self->head->next[0] : NULL;
+}
+
+void ls_skip_list_iter_init_at(LsSkipList *self, const void *key, LsSkipListIter *iter)
+{
+        iter->list = self;
+        iter->node = self ? ls_skip_list_find(self, key, NULL) : NULL;
+}
+
+bool ls_skip_list_iter_next(LsSkipListIter *iter, void **key, void **value)
+{
+        LsSkipListNode *node = iter->node;
+
+        if (!node) {
+                return false;
+        }
+
+        if (key) {
+                *key = node->key;
+        }
+        if (value) {
+                *value = node->value;
+        }
+        iter->node = node->next[0];
+        return true;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
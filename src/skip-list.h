@@ -0,0 +1,165 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#include "macros.h"
+
+/**
+ * LsSkipList is an ordered key-value store, kept sorted by a user
+ * supplied comparison function. Lookups, inserts and removals are
+ * O(log N) on average, and the keys may be walked in order starting
+ * from any point, making it suitable for range queries such as "every
+ * timer due before T".
+ *
+ * Nodes have a random height and are carved from 4KiB slabs owned by
+ * the list, with released nodes recycled by height.
+ */
+typedef struct LsSkipList LsSkipList;
+
+/**
+ * LsSkipListIter is used to walk a list in key order. The list must not
+ * be modified while an iterator is in use.
+ */
+typedef struct LsSkipListIter {
+        LsSkipList *list;
+        void *node;
+} LsSkipListIter;
+
+/**
+ * Construct a new LsSkipList ordered by @compare
+ *
+ * @param compare Function returning <0, 0 or >0 when comparing two keys
+ *
+ * @note Free with ls_skip_list_free
+ *
+ * @return A newly allocated LsSkipList
+ */
+LsSkipList *ls_skip_list_new(ls_compare_func compare);
+
+/**
+ * Construct a new LsSkipList with key/value free functions
+ *
+ * @param compare Function returning <0, 0 or >0 when comparing two keys
+ * @param key_free Function to call to free any keys when replaced or the list is freed
+ * @param value_free Function to call to free any values when replaced or the list is freed
+ *
+ * @note Free with ls_skip_list_free
+ *
+ * @return A newly allocated LsSkipList
+ */
+LsSkipList *ls_skip_list_new_full(ls_compare_func compare, ls_free_func key_free,
+                                  ls_free_func value_free);
+
+/**
+ * Free a previously allocated list
+ *
+ * @param list Pointer to a previously allocated list
+ */
+void ls_skip_list_free(LsSkipList *list);
+
+/**
+ * Store a key/value mapping within the list. An existing key and value
+ * that compare equal are released and replaced.
+ *
+ * @note This will not copy the key or value. Do this before insert
+ *
+ * @param list Pointer to a valid LsSkipList instance
+ * @param key Key for the new mapping
+ * @param value Value for the new mapping
+ *
+ * @returns True if the key/value pair could be stored
+ */
+bool ls_skip_list_put(LsSkipList *list, void *key, void *value);
+
+/**
+ * Attempt to retrieve the value from the list associated with @key
+ *
+ * @param list Pointer to an allocated list
+ *
+ * @returns The stored value, if found.
+ */
+void *ls_skip_list_get(LsSkipList *list, const void *key);
+
+/**
+ * Remove the key/value pair that matches the given key
+ *
+ * @param list Pointer to an allocated list
+ * @param key Key to lookup
+ *
+ * @returns True if we deleted a matching key/value
+ */
+bool ls_skip_list_remove(LsSkipList *list, const void *key);
+
+/**
+ * Find the first key that does not compare less than @key
+ *
+ * @param list Pointer to an allocated list
+ * @param key Key to search from
+ * @param found_key Storage for the located key, may be NULL
+ * @param value Storage for the located value, may be NULL
+ *
+ * @returns True if such a key exists
+ */
+bool ls_skip_list_lower_bound(LsSkipList *list, const void *key, void **found_key, void **value);
+
+/**
+ * Return the number of key/value pairs currently stored in the list
+ */
+unsigned int ls_skip_list_size(LsSkipList *list);
+
+/**
+ * Prepare @iter to walk @list from the smallest key
+ */
+void ls_skip_list_iter_init(LsSkipList *list, LsSkipListIter *iter);
+
+/**
+ * Prepare @iter to walk @list from the first key that does not compare
+ * less than @key
+ */
+void ls_skip_list_iter_init_at(LsSkipList *list, const void *key, LsSkipListIter *iter);
+
+/**
+ * Advance the iterator, storing the next key and value.
+ *
+ * @param iter Pointer to an initialised iterator
+ * @param key Storage for the key, may be NULL
+ * @param value Storage for the value, may be NULL
+ *
+ * @returns False once the iterator has been exhausted
+ */
+bool ls_skip_list_iter_next(LsSkipListIter *iter, void **key, void **value);
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
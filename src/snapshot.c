@@ -0,0 +1,380 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "macros.h"
+#include "snapshot.h"
+
+/**
+ * Identifies a libls snapshot
+ */
+#define LS_SNAPSHOT_MAGIC "LSSNAP\0\0"
+
+/**
+ * Written in host order, so reads back differently on a foreign host
+ */
+#define LS_SNAPSHOT_BYTE_ORDER 0x01020304
+
+/**
+ * Start the writer with 64KiB and double from there.
+ */
+#define LS_SNAPSHOT_INITIAL_SIZE 65536
+
+/**
+ * Names tried for the temporary file before giving up
+ */
+#define LS_SNAPSHOT_TEMP_ATTEMPTS 100
+
+/**
+ * On-disk header for every snapshot
+ */
+typedef struct LsSnapshotHeader {
+        char magic[8];       /**<LS_SNAPSHOT_MAGIC */
+        uint32_t version;    /**<LS_SNAPSHOT_VERSION */
+        uint32_t byte_order; /**<LS_SNAPSHOT_BYTE_ORDER */
+        uint32_t kind;       /**<LsSnapshotKind */
+        uint32_t flags;      /**<LS_SNAPSHOT_FLAG_* */
+        uint64_t count;      /**<Number of items */
+} LsSnapshotHeader;
+
+struct LsSnapshotWriter {
+        uint8_t *data; /**<Snapshot being built, header first */
+        size_t len;    /**<Bytes used */
+        size_t size;   /**<Bytes allocated */
+};
+
+LsSnapshotWriter *ls_snapshot_writer_new(LsSnapshotKind kind, uint32_t flags)
+{
+        LsSnapshotWriter *ret = NULL;
+        LsSnapshotHeader header = {
+                .version = LS_SNAPSHOT_VERSION,
+                .byte_order = LS_SNAPSHOT_BYTE_ORDER,
+                .kind = (uint32_t)kind,
+                .flags = flags,
+        };
+
+        memcpy(header.magic, LS_SNAPSHOT_MAGIC, sizeof(header.magic));
+
+        ret = calloc(1, sizeof(struct LsSnapshotWriter));
+        if (!ret) {
+                return NULL;
+        }
+
+        if (!ls_snapshot_writer_put(ret, &header, sizeof(header))) {
+                ls_snapshot_writer_free(ret);
+                return NULL;
+        }
+
+        return ret;
+}
+
+void ls_snapshot_writer_free(LsSnapshotWriter *self)
+{
+        if (ls_unlikely(!self)) {
+                return;
+        }
+        free(self->data);
+        free(self);
+}
+
+bool ls_snapshot_writer_put(LsSnapshotWriter *self, const void *data, size_t len)
+{
+        if (ls_unlikely(!self)) {
+                return false;
+        }
+
+        if (self->len + len > self->size) {
+                size_t new_size = self->size ? self->size : LS_SNAPSHOT_INITIAL_SIZE;
+                uint8_t *blob = NULL;
+
+                while (new_size < self->len + len) {
+                        new_size *= 2;
+                }
+                blob = realloc(self->data, new_size);
+                if (!blob) {
+                        return false;
+                }
+                self->data = blob;
+                self->size = new_size;
+        }
+
+        if (len > 0) {
+                memcpy(self->data + self->len, data, len);
+        }
+        self->len += len;
+
+        return true;
+}
+
+bool ls_snapshot_writer_put_u32(LsSnapshotWriter *self, uint32_t value)
+{
+        return ls_snapshot_writer_put(self, &value, sizeof(value));
+}
+
+bool ls_snapshot_writer_put_item(LsSnapshotWriter *self, ls_snapshot_write_func func,
+                                 const void *item)
+{
+        size_t start;
+        uint32_t item_len;
+
+        /* Reserve the length prefix and patch it once we know the size */
+        start = self->len;
+        if (!ls_snapshot_writer_put_u32(self, 0)) {
+                return false;
+        }
+        if (!func(self, item)) {
+                return false;
+        }
+        if (self->len - start - sizeof(uint32_t) > UINT32_MAX) {
+                return false;
+        }
+        item_len = (uint32_t)(self->len - start - sizeof(uint32_t));
+        memcpy(self->data + start, &item_len, sizeof(item_len));
+
+        return true;
+}
+
+/**
+ * Exclusively create a uniquely named file alongside @path. Unlike
+ * mkstemp the file is created 0666 less the umask, which the final
+ * snapshot inherits through the rename.
+ */
+static int ls_snapshot_open_temp(const char *path, char **tmp_path)
+{
+        struct timespec ts = { 0 };
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+
+        for (unsigned int i = 0; i < LS_SNAPSHOT_TEMP_ATTEMPTS; i++) {
+                unsigned long tag = (unsigned long)ts.tv_nsec ^ ((unsigned long)getpid() << 20) ^
+                                    ((unsigned long)i * 0x9e3779b9ul);
+                int fd = -1;
+
+                if (asprintf(tmp_path, "%s.%08lx", path, tag & 0xfffffffful) < 0) {
+                        *tmp_path = NULL;
+                        return -1;
+                }
+                fd = open(*tmp_path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+                if (fd >= 0 || errno != EEXIST) {
+                        return fd;
+                }
+                free(*tmp_path);
+                *tmp_path = NULL;
+        }
+
+        return -1;
+}
+
+bool ls_snapshot_writer_commit(LsSnapshotWriter *self, uint64_t count, const char *path)
+{
+        char *tmp_path = NULL;
+        int fd = -1;
+        size_t written = 0;
+        bool ret = false;
+
+        if (ls_unlikely(!self || !path)) {
+                return false;
+        }
+
+        memcpy(self->data + offsetof(LsSnapshotHeader, count), &count, sizeof(count));
+
+        /* Write alongside and rename so readers never see a partial snapshot */
+        fd = ls_snapshot_open_temp(path, &tmp_path);
+        if (fd < 0) {
+                goto cleanup;
+        }
+
+        while (written < self->len) {
+                ssize_t r = write(fd, self->data + written, self->len - written);
+                if (r < 0) {
+                        if (errno == EINTR) {
+                                continue;
+                        }
+                        goto cleanup;
+                }
+                written += (size_t)r;
+        }
+
+        /* The data must be on disk before the rename replaces the old file */
+        if (fsync(fd) != 0) {
+                goto cleanup;
+        }
+
+        if (close(fd) != 0) {
+                fd = -1;
+                goto cleanup;
+        }
+        fd = -1;
+
+        if (rename(tmp_path, path) != 0) {
+                goto cleanup;
+        }
+        ret = true;
+
+cleanup:
+        if (fd >= 0) {
+                close(fd);
+        }
+        if (!ret && tmp_path) {
+                unlink(tmp_path);
+        }
+        free(tmp_path);
+        return ret;
+}
+
+bool ls_snapshot_reader_open(LsSnapshotReader *self, const char *path, LsSnapshotKind kind)
+{
+        LsSnapshotHeader header = { 0 };
+        size_t min_item = 0;
+        struct stat st = { 0 };
+        void *data = NULL;
+        int fd = -1;
+
+        memset(self, 0, sizeof(*self));
+
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+                return false;
+        }
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(header)) {
+                close(fd);
+                return false;
+        }
+
+        data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+                return false;
+        }
+
+        /* We only ever walk forwards, so let the kernel read ahead */
+        madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+        self->data = data;
+        self->len = (size_t)st.st_size;
+
+        memcpy(&header, self->data, sizeof(header));
+        if (memcmp(header.magic, LS_SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != LS_SNAPSHOT_VERSION || header.byte_order != LS_SNAPSHOT_BYTE_ORDER ||
+            header.kind != (uint32_t)kind) {
+                ls_snapshot_reader_close(self);
+                return false;
+        }
+
+        /* Each item has at least its length prefixes, so reject counts the file can't hold
+         * before callers size anything from them */
+        min_item = kind == LS_SNAPSHOT_KIND_HASHMAP ? 3 * sizeof(uint32_t) : sizeof(uint32_t);
+        if (header.count > (self->len - sizeof(header)) / min_item) {
+                ls_snapshot_reader_close(self);
+                return false;
+        }
+
+        self->offset = sizeof(header);
+        self->count = header.count;
+        self->flags = header.flags;
+
+        return true;
+}
+
+bool ls_snapshot_reader_get_u32(LsSnapshotReader *self, uint32_t *value)
+{
+        if (ls_unlikely(self->len - self->offset < sizeof(*value))) {
+                return false;
+        }
+        memcpy(value, self->data + self->offset, sizeof(*value));
+        self->offset += sizeof(*value);
+        return true;
+}
+
+bool ls_snapshot_reader_get_item(LsSnapshotReader *self, ls_snapshot_read_func func,
+                                 void **item)
+{
+        uint32_t item_len = 0;
+        const uint8_t *item_data = NULL;
+
+        if (!ls_snapshot_reader_get_u32(self, &item_len)) {
+                return false;
+        }
+        if (ls_unlikely(self->len - self->offset < item_len)) {
+                return false;
+        }
+
+        item_data = self->data + self->offset;
+        self->offset += item_len;
+
+        return func(item_data, item_len, item);
+}
+
+void ls_snapshot_reader_close(LsSnapshotReader *self)
+{
+        if (self->data) {
+                munmap((void *)self->data, self->len);
+        }
+        memset(self, 0, sizeof(*self));
+}
+
+bool ls_snapshot_write_string(LsSnapshotWriter *writer, const void *item)
+{
+        if (!item) {
+                return false;
+        }
+        return ls_snapshot_writer_put(writer, item, strlen(item));
+}
+
+bool ls_snapshot_read_string(const void *data, size_t len, void **item)
+{
+        char *ret = NULL;
+
+        ret = malloc(len + 1);
+        if (!ret) {
+                return false;
+        }
+        memcpy(ret, data, len);
+        ret[len] = '\0';
+        *item = ret;
+
+        return true;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
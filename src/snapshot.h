@@ -0,0 +1,175 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Snapshots are a versioned binary image of a container, allowing large
+ * tables to be persisted once and reloaded with a single mapping of the
+ * file, rather than rebuilt entry by entry on every launch.
+ *
+ * Snapshots are written in host byte order and are rejected when loaded
+ * on a host of differing byte order. They are intended as a cache, not
+ * as an interchange format.
+ */
+
+/**
+ * Current on-disk format version.
+ */
+#define LS_SNAPSHOT_VERSION 1
+
+/**
+ * The stored hashes depend on a per-map seed and cannot be reused.
+ */
+#define LS_SNAPSHOT_FLAG_SEEDED (1 << 0)
+
+/**
+ * Identifies which container type produced a snapshot
+ */
+typedef enum {
+        LS_SNAPSHOT_KIND_HASHMAP = 1,
+        LS_SNAPSHOT_KIND_ARRAY,
+} LsSnapshotKind;
+
+/**
+ * LsSnapshotWriter accumulates a snapshot in memory before it is written
+ * out to disk in one go.
+ */
+typedef struct LsSnapshotWriter LsSnapshotWriter;
+
+/**
+ * Serialise a single key, value or array item into the snapshot. The
+ * implementation should call ls_snapshot_writer_put as many times as it
+ * needs to encode @item.
+ *
+ * @returns True if the item was encoded
+ */
+typedef bool (*ls_snapshot_write_func)(LsSnapshotWriter *writer, const void *item);
+
+/**
+ * Deserialise an item previously encoded by a ls_snapshot_write_func.
+ * @data points directly into the snapshot and is only valid for the
+ * duration of the call.
+ *
+ * @returns True if the item was decoded and stored in @item
+ */
+typedef bool (*ls_snapshot_read_func)(const void *data, size_t len, void **item);
+
+/**
+ * Append raw bytes for the item currently being serialised
+ */
+bool ls_snapshot_writer_put(LsSnapshotWriter *writer, const void *data, size_t len);
+
+/**
+ * Stock writer for NUL terminated strings
+ */
+bool ls_snapshot_write_string(LsSnapshotWriter *writer, const void *item);
+
+/**
+ * Stock reader for NUL terminated strings, returning a newly allocated copy
+ */
+bool ls_snapshot_read_string(const void *data, size_t len, void **item);
+
+/**
+ * The following are used by the container implementations to produce
+ * and consume snapshots, and are not generally needed otherwise.
+ */
+
+/**
+ * Construct a new writer for a snapshot of the given @kind
+ */
+LsSnapshotWriter *ls_snapshot_writer_new(LsSnapshotKind kind, uint32_t flags);
+
+/**
+ * Append a fixed size integer to the snapshot
+ */
+bool ls_snapshot_writer_put_u32(LsSnapshotWriter *writer, uint32_t value);
+
+/**
+ * Append a length-prefixed item to the snapshot, encoded by @func.
+ */
+bool ls_snapshot_writer_put_item(LsSnapshotWriter *writer, ls_snapshot_write_func func,
+                                 const void *item);
+
+/**
+ * Record the number of items and atomically replace @path with the
+ * snapshot.
+ *
+ * @returns True if the snapshot was written
+ */
+bool ls_snapshot_writer_commit(LsSnapshotWriter *writer, uint64_t count, const char *path);
+
+/**
+ * Free a previously allocated writer
+ */
+void ls_snapshot_writer_free(LsSnapshotWriter *writer);
+
+/**
+ * LsSnapshotReader walks a memory-mapped snapshot sequentially
+ */
+typedef struct LsSnapshotReader {
+        const uint8_t *data; /**<Start of the mapped snapshot */
+        size_t len;          /**<Length of the mapping */
+        size_t offset;       /**<Current read position */
+        uint64_t count;      /**<Number of items stored in the snapshot */
+        uint32_t flags;      /**<Flags the snapshot was written with */
+} LsSnapshotReader;
+
+/**
+ * Map the snapshot at @path and validate its header.
+ *
+ * @returns True if the snapshot is of the expected @kind and version
+ */
+bool ls_snapshot_reader_open(LsSnapshotReader *reader, const char *path, LsSnapshotKind kind);
+
+/**
+ * Consume a fixed size integer from the snapshot
+ */
+bool ls_snapshot_reader_get_u32(LsSnapshotReader *reader, uint32_t *value);
+
+/**
+ * Consume a length-prefixed item, decoding it with @func
+ */
+bool ls_snapshot_reader_get_item(LsSnapshotReader *reader, ls_snapshot_read_func func,
+                                 void **item);
+
+/**
+ * Unmap a previously opened snapshot
+ */
+void ls_snapshot_reader_close(LsSnapshotReader *reader);
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
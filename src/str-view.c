@@ -0,0 +1,261 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The AVX2 scan is compiled for any x86 target and only used when the CPU
+ * supports it at runtime, so the default build doesn't need -mavx2
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define LS_STR_SPLITTER_AVX2 1
+#endif
+
+#if defined(LS_STR_SPLITTER_AVX2) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "str-view.h"
+
+bool ls_str_view_equal_cstr(LsStrView view, const char *cstr)
+{
+        /* Never read past the end of a shorter cstr */
+        if (strnlen(cstr, view.len + 1) != view.len) {
+                return false;
+        }
+        return view.len == 0 || memcmp(view.data, cstr, view.len) == 0;
+}
+
+uint32_t ls_str_view_hash(LsStrView view)
+{
+        const signed char *c = (const signed char *)view.data;
+        unsigned int hash = 5381;
+
+        /* Same djb2 variant as ls_hashmap_string_hash, bounded by len */
+        for (size_t i = 0; i < view.len; i++) {
+                hash = (hash << 5) + hash + (unsigned)c[i];
+        }
+
+        return (uint32_t)hash;
+}
+
+uint32_t ls_str_view_key_hash(const void *v)
+{
+        return ls_str_view_hash(*(const LsStrView *)v);
+}
+
+bool ls_str_view_key_equal(const void *a, const void *b)
+{
+        if (!a || !b) {
+                return false;
+        }
+        return ls_str_view_equal(*(const LsStrView *)a, *(const LsStrView *)b);
+}
+
+static inline bool ls_str_is_space(char c)
+{
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+LsStrView ls_str_view_trim(LsStrView view)
+{
+        while (view.len > 0 && ls_str_is_space(view.data[0])) {
+                ++view.data;
+                --view.len;
+        }
+        while (view.len > 0 && ls_str_is_space(view.data[view.len - 1])) {
+                --view.len;
+        }
+        return view;
+}
+
+size_t ls_str_view_find(LsStrView view, char c)
+{
+        const char *found = NULL;
+
+        if (view.len == 0) {
+                return 0;
+        }
+        found = memchr(view.data, c, view.len);
+        return found ? (size_t)(found - view.data) : view.len;
+}
+
+char *ls_str_view_dup(LsStrView view)
+{
+        char *ret = malloc(view.len + 1);
+
+        if (!ret) {
+                return NULL;
+        }
+        if (view.len > 0) {
+                memcpy(ret, view.data, view.len);
+        }
+        ret[view.len] = '\0';
+        return ret;
+}
+
+bool ls_str_splitter_init(LsStrSplitter *self, LsStrView input, const char *delimiters)
+{
+        size_t n_delimiters = strlen(delimiters);
+
+        if (ls_unlikely(n_delimiters == 0 || n_delimiters > LS_STR_SPLITTER_MAX_DELIMITERS)) {
+                return false;
+        }
+
+        memset(self, 0, sizeof(*self));
+        memcpy(self->delimiters, delimiters, n_delimiters);
+        self->n_delimiters = (unsigned int)n_delimiters;
+        self->cursor = input.data;
+        self->end = input.len > 0 ? input.data + input.len : input.data;
+        return true;
+}
+
+#ifdef LS_STR_SPLITTER_AVX2
+/**
+ * Scan whole 32 byte vectors from *@pos, returning the first delimiter
+ * found. Otherwise NULL is returned, with *@pos left at the unscanned
+ * tail of fewer than 32 bytes.
+ */
+__attribute__((target("avx2"))) static const char *ls_str_splitter_scan_avx2(
+    const LsStrSplitter *self, const char **pos, const char *end)
+{
+        __m256i needles[LS_STR_SPLITTER_MAX_DELIMITERS];
+        const char *p = *pos;
+
+        for (unsigned int d = 0; d < self->n_delimiters; d++) {
+                needles[d] = _mm256_set1_epi8(self->delimiters[d]);
+        }
+        for (; end - p >= 32; p += 32) {
+                __m256i chunk = _mm256_loadu_si256((const __m256i *)p);
+                __m256i hits = _mm256_cmpeq_epi8(chunk, needles[0]);
+                unsigned int mask;
+
+                for (unsigned int d = 1; d < self->n_delimiters; d++) {
+                        hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(chunk, needles[d]));
+                }
+                mask = (unsigned int)_mm256_movemask_epi8(hits);
+                if (mask) {
+                        return p + __builtin_ctz(mask);
+                }
+        }
+
+        *pos = p;
+        return NULL;
+}
+#endif
+
+/**
+ * Return the first byte in [start, end) matching any delimiter, or end.
+ * Whole vectors are compared against every delimiter at once, and only
+ * the tail is scanned a byte at a time.
+ */
+static const char *ls_str_splitter_scan(const LsStrSplitter *self, const char *start,
+                                        const char *end)
+{
+        const char *p = start;
+
+        if (p == end) {
+                return end;
+        }
+
+#ifdef LS_STR_SPLITTER_AVX2
+        if (end - p >= 32 && __builtin_cpu_supports("avx2")) {
+                const char *found = ls_str_splitter_scan_avx2(self, &p, end);
+                if (found) {
+                        return found;
+                }
+        }
+#endif
+
+#ifdef __SSE2__
+        __m128i needles128[LS_STR_SPLITTER_MAX_DELIMITERS];
+
+        for (unsigned int d = 0; d < self->n_delimiters; d++) {
+                needles128[d] = _mm_set1_epi8(self->delimiters[d]);
+        }
+        for (; end - p >= 16; p += 16) {
+                __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+                __m128i hits = _mm_cmpeq_epi8(chunk, needles128[0]);
+                unsigned int mask;
+
+                for (unsigned int d = 1; d < self->n_delimiters; d++) {
+                        hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, needles128[d]));
+                }
+                mask = (unsigned int)_mm_movemask_epi8(hits);
+                if (mask) {
+                        return p + __builtin_ctz(mask);
+                }
+        }
+#endif
+
+        if (self->n_delimiters == 1) {
+                const char *found = memchr(p, self->delimiters[0], (size_t)(end - p));
+                return found ? found : end;
+        }
+
+        for (; p < end; p++) {
+                for (unsigned int d = 0; d < self->n_delimiters; d++) {
+                        if (*p == self->delimiters[d]) {
+                                return p;
+                        }
+                }
+        }
+
+        return end;
+}
+
+bool ls_str_splitter_next(LsStrSplitter *self, LsStrView *token)
+{
+        const char *found = NULL;
+
+        if (self->finished) {
+                return false;
+        }
+
+        found = ls_str_splitter_scan(self, self->cursor, self->end);
+        *token = ls_str_view(self->cursor, (size_t)(found - self->cursor));
+
+        /* No delimiter left, this is the final token */
+        if (found == self->end) {
+                self->finished = true;
+        } else {
+                self->cursor = found + 1;
+        }
+
+        return true;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
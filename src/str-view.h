@@ -0,0 +1,156 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "macros.h"
+
+/**
+ * LsStrView is a borrowed, read-only slice of a string: a pointer and a
+ * length. It owns nothing and need not be NUL terminated, so tokens can
+ * be carved out of a buffer without copying, and only duplicated with
+ * ls_str_view_dup once they are known to be worth keeping.
+ *
+ * A view is only valid as long as the buffer it points into.
+ */
+typedef struct LsStrView {
+        const char *data; /**<Start of the view, not NUL terminated */
+        size_t len;       /**<Length in bytes */
+} LsStrView;
+
+/**
+ * Maximum number of distinct delimiters an LsStrSplitter can search for
+ */
+#define LS_STR_SPLITTER_MAX_DELIMITERS 8
+
+/**
+ * LsStrSplitter walks a view, yielding the runs between delimiters as
+ * views into the original buffer. Delimiters are found with SSE2 byte
+ * scanning, or AVX2 when the CPU supports it at runtime.
+ *
+ * Like strsep, every delimiter ends a token, so adjacent delimiters yield
+ * an empty token between them and a trailing delimiter yields a final
+ * empty token.
+ */
+typedef struct LsStrSplitter {
+        const char *cursor;                             /**<Start of the next token */
+        const char *end;                                /**<End of the input */
+        char delimiters[LS_STR_SPLITTER_MAX_DELIMITERS]; /**<Bytes that end a token */
+        unsigned int n_delimiters;                      /**<Number of delimiters */
+        bool finished;                                  /**<Was the last token yielded? */
+} LsStrSplitter;
+
+/**
+ * Construct a view over @len bytes at @data
+ */
+static inline LsStrView ls_str_view(const char *data, size_t len)
+{
+        return (LsStrView){ .data = data, .len = len };
+}
+
+/**
+ * Construct a view over a NUL terminated string, excluding the terminator
+ */
+static inline LsStrView ls_str_view_from_cstr(const char *cstr)
+{
+        return ls_str_view(cstr, strlen(cstr));
+}
+
+/**
+ * Return true if both views hold the same bytes
+ */
+static inline bool ls_str_view_equal(LsStrView a, LsStrView b)
+{
+        return a.len == b.len && (a.len == 0 || memcmp(a.data, b.data, a.len) == 0);
+}
+
+/**
+ * Return true if the view holds exactly the NUL terminated @cstr
+ */
+bool ls_str_view_equal_cstr(LsStrView view, const char *cstr);
+
+/**
+ * Hash the view. The value is identical to that of ls_hashmap_string_hash
+ * over the same bytes.
+ */
+uint32_t ls_str_view_hash(LsStrView view);
+
+/**
+ * LsHashmap hash function for keys that are pointers to an LsStrView
+ */
+uint32_t ls_str_view_key_hash(const void *v);
+
+/**
+ * LsHashmap equality function for keys that are pointers to an LsStrView
+ */
+bool ls_str_view_key_equal(const void *a, const void *b);
+
+/**
+ * Return the view without any leading or trailing ASCII whitespace
+ */
+LsStrView ls_str_view_trim(LsStrView view);
+
+/**
+ * Return the offset of the first occurrence of @c, or view.len if absent
+ */
+size_t ls_str_view_find(LsStrView view, char c);
+
+/**
+ * Copy the view into a new NUL terminated heap string
+ *
+ * @note Free the result with free
+ */
+char *ls_str_view_dup(LsStrView view);
+
+/**
+ * Set up @splitter to walk @input, splitting on any byte in the NUL
+ * terminated @delimiters
+ *
+ * @returns False if @delimiters is empty or longer than
+ *          LS_STR_SPLITTER_MAX_DELIMITERS
+ */
+bool ls_str_splitter_init(LsStrSplitter *splitter, LsStrView input, const char *delimiters);
+
+/**
+ * Yield the next token into @token
+ *
+ * @returns False once every token has been yielded
+ */
+bool ls_str_splitter_next(LsStrSplitter *splitter, LsStrView *token);
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,254 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "string-builder.h"
+
+/**
+ * Smallest heap capacity, to avoid a flurry of reallocs just beyond the
+ * inline limit
+ */
+#define LS_STRING_MIN_HEAP_CAPACITY 63
+
+void ls_string_init(LsString *self)
+{
+        memset(self, 0, sizeof(*self));
+        self->capacity = LS_STRING_INLINE_CAPACITY;
+}
+
+void ls_string_clear(LsString *self)
+{
+        if (ls_string_is_heap(self)) {
+                free(self->storage.heap);
+        }
+        ls_string_init(self);
+}
+
+/**
+ * Writable access to the storage
+ */
+static inline char *ls_string_data(LsString *self)
+{
+        return ls_string_is_heap(self) ? self->storage.heap : self->storage.inline_data;
+}
+
+bool ls_string_reserve(LsString *self, size_t capacity)
+{
+        size_t new_capacity = self->capacity;
+        char *data = NULL;
+
+        if (ls_likely(capacity <= self->capacity)) {
+                return true;
+        }
+        if (ls_unlikely(capacity >= SIZE_MAX / 2)) {
+                return false;
+        }
+
+        /* Grow geometrically so a run of appends is amortised O(1) */
+        if (new_capacity < LS_STRING_MIN_HEAP_CAPACITY) {
+                new_capacity = LS_STRING_MIN_HEAP_CAPACITY;
+        }
+        while (new_capacity < capacity) {
+                new_capacity = new_capacity * 2 + 1;
+        }
+
+        if (ls_string_is_heap(self)) {
+                data = realloc(self->storage.heap, new_capacity + 1);
+                if (!data) {
+                        return false;
+                }
+        } else {
+                data = malloc(new_capacity + 1);
+                if (!data) {
+                        return false;
+                }
+                memcpy(data, self->storage.inline_data, self->len + 1);
+        }
+
+        self->storage.heap = data;
+        self->capacity = new_capacity;
+        return true;
+}
+
+void ls_string_truncate(LsString *self, size_t len)
+{
+        if (len >= self->len) {
+                return;
+        }
+        self->len = len;
+        ls_string_data(self)[len] = '\0';
+        self->hash_valid = false;
+}
+
+bool ls_string_set(LsString *self, const char *text)
+{
+        ls_string_truncate(self, 0);
+        return ls_string_append(self, text);
+}
+
+bool ls_string_append(LsString *self, const char *text)
+{
+        return ls_string_append_len(self, text, strlen(text));
+}
+
+bool ls_string_append_len(LsString *self, const char *text, size_t len)
+{
+        char *data = ls_string_data(self);
+        bool self_append = (uintptr_t)text >= (uintptr_t)data &&
+                           (uintptr_t)text <= (uintptr_t)(data + self->len);
+        size_t offset = self_append ? (size_t)(text - data) : 0;
+
+        if (ls_unlikely(len > SIZE_MAX / 2 - self->len)) {
+                return false;
+        }
+        if (!ls_string_reserve(self, self->len + len)) {
+                return false;
+        }
+
+        /* @text may point into our own, possibly just moved, storage */
+        data = ls_string_data(self);
+        if (self_append) {
+                text = data + offset;
+        }
+        memmove(data + self->len, text, len);
+        self->len += len;
+        data[self->len] = '\0';
+        self->hash_valid = false;
+
+        return true;
+}
+
+bool ls_string_append_char(LsString *self, char c)
+{
+        return ls_string_append_len(self, &c, 1);
+}
+
+bool ls_string_append_vprintf(LsString *self, const char *format, va_list args)
+{
+        va_list copy;
+        int n = 0;
+
+        /* Try formatting straight into the spare capacity first */
+        va_copy(copy, args);
+        n = vsnprintf(ls_string_data(self) + self->len,
+                      self->capacity - self->len + 1,
+                      format,
+                      copy);
+        va_end(copy);
+
+        if (ls_unlikely(n < 0)) {
+                ls_string_data(self)[self->len] = '\0';
+                return false;
+        }
+
+        if ((size_t)n > self->capacity - self->len) {
+                if (!ls_string_reserve(self, self->len + (size_t)n)) {
+                        ls_string_data(self)[self->len] = '\0';
+                        return false;
+                }
+                va_copy(copy, args);
+                vsnprintf(ls_string_data(self) + self->len, (size_t)n + 1, format, copy);
+                va_end(copy);
+        }
+
+        self->len += (size_t)n;
+        self->hash_valid = false;
+        return true;
+}
+
+bool ls_string_append_printf(LsString *self, const char *format, ...)
+{
+        va_list args;
+        bool ret = false;
+
+        va_start(args, format);
+        ret = ls_string_append_vprintf(self, format, args);
+        va_end(args);
+
+        return ret;
+}
+
+uint32_t ls_string_hash(LsString *self)
+{
+        const signed char *c = (const signed char *)ls_string_cstr(self);
+        unsigned int hash = 5381;
+
+        if (self->hash_valid) {
+                return self->hash;
+        }
+
+        /* Same djb2 variant as ls_hashmap_string_hash, but bounded by len */
+        for (size_t i = 0; i < self->len; i++) {
+                hash = (hash << 5) + hash + (unsigned)c[i];
+        }
+
+        self->hash = (uint32_t)hash;
+        self->hash_valid = true;
+        return self->hash;
+}
+
+bool ls_string_equal(const LsString *a, const LsString *b)
+{
+        if (a->len != b->len) {
+                return false;
+        }
+        if (a->hash_valid && b->hash_valid && a->hash != b->hash) {
+                return false;
+        }
+        return memcmp(ls_string_cstr(a), ls_string_cstr(b), a->len) == 0;
+}
+
+char *ls_string_steal(LsString *self)
+{
+        char *ret = NULL;
+
+        if (ls_string_is_heap(self)) {
+                ret = self->storage.heap;
+        } else {
+                ret = malloc(self->len + 1);
+                if (!ret) {
+                        return NULL;
+                }
+                memcpy(ret, self->storage.inline_data, self->len + 1);
+        }
+
+        ls_string_init(self);
+        return ret;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,181 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "macros.h"
+
+/**
+ * Strings up to this many bytes are stored inside the LsString itself and
+ * never touch the heap.
+ */
+#define LS_STRING_INLINE_CAPACITY 23
+
+/**
+ * LsString is a growable, always NUL terminated byte string.
+ *
+ * Short strings are kept inline, the length is cached so appends never
+ * rescan the contents, and heap storage grows geometrically so a series
+ * of appends costs amortised O(1) each. The hash is computed on demand and
+ * cached until the string next changes.
+ *
+ * An LsString lives wherever the caller puts it, typically on the stack
+ * or embedded in another structure, and must be set up with
+ * ls_string_init and released with ls_string_clear. It may be copied with
+ * memcpy only while inline, so use ls_string_set to duplicate one.
+ */
+typedef struct LsString {
+        size_t len;      /**<Length in bytes, excluding the terminator */
+        size_t capacity; /**<Bytes available excluding the terminator */
+        uint32_t hash;   /**<Cached hash, when hash_valid is set */
+        bool hash_valid; /**<Is the cached hash up to date? */
+        union {
+                char *heap;                                     /**<Heap storage */
+                char inline_data[LS_STRING_INLINE_CAPACITY + 1]; /**<Inline storage */
+        } storage;
+} LsString;
+
+/**
+ * Initialise an empty, inline, string
+ */
+void ls_string_init(LsString *string);
+
+/**
+ * Release any heap storage, leaving the string empty and inline
+ */
+void ls_string_clear(LsString *string);
+
+/**
+ * Return true if the string currently lives on the heap
+ */
+static inline bool ls_string_is_heap(const LsString *string)
+{
+        return string->capacity > LS_STRING_INLINE_CAPACITY;
+}
+
+/**
+ * Return the NUL terminated contents of the string. The pointer is only
+ * valid until the string is next modified.
+ */
+static inline const char *ls_string_cstr(const LsString *string)
+{
+        return ls_string_is_heap(string) ? string->storage.heap : string->storage.inline_data;
+}
+
+/**
+ * Return the cached length of the string, O(1)
+ */
+static inline size_t ls_string_len(const LsString *string)
+{
+        return string->len;
+}
+
+/**
+ * Ensure there is room for at least @capacity bytes without reallocating
+ *
+ * @returns False if memory could not be allocated
+ */
+bool ls_string_reserve(LsString *string, size_t capacity);
+
+/**
+ * Shorten the string to @len bytes, keeping its storage. Does nothing if
+ * the string is already no longer than @len.
+ */
+void ls_string_truncate(LsString *string, size_t len);
+
+/**
+ * Replace the contents of the string with @text, which must not point
+ * into @string itself
+ */
+bool ls_string_set(LsString *string, const char *text);
+
+/**
+ * Append a NUL terminated @text
+ */
+bool ls_string_append(LsString *string, const char *text);
+
+/**
+ * Append exactly @len bytes from @text
+ */
+bool ls_string_append_len(LsString *string, const char *text, size_t len);
+
+/**
+ * Append a single character
+ */
+bool ls_string_append_char(LsString *string, char c);
+
+/**
+ * Append printf-style formatted output, formatting directly into spare
+ * capacity where it fits
+ */
+bool ls_string_append_printf(LsString *string, const char *format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/**
+ * va_list variant of ls_string_append_printf
+ */
+bool ls_string_append_vprintf(LsString *string, const char *format, va_list args)
+    __attribute__((format(printf, 2, 0)));
+
+/**
+ * Return the hash of the string, computing it only if the string has
+ * changed since the last call. The value is identical to that of
+ * ls_hashmap_string_hash over ls_string_cstr, so it may be passed to
+ * ls_hashmap_get_with_hash and ls_hashmap_put_with_hash on maps keyed by
+ * C strings, skipping the strlen walk of rehashing:
+ *
+ *      value = ls_hashmap_get_with_hash(map, (void *)ls_string_cstr(&name),
+ *                                       ls_string_hash(&name));
+ */
+uint32_t ls_string_hash(LsString *string);
+
+/**
+ * Compare two strings for equality, rejecting differing lengths or
+ * cached hashes before comparing the bytes
+ */
+bool ls_string_equal(const LsString *a, const LsString *b);
+
+/**
+ * Take the contents as a heap allocated C string, suitable for handing to
+ * a container with a free function, leaving @string empty and inline
+ *
+ * @note Free the result with free
+ */
+char *ls_string_steal(LsString *string);
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
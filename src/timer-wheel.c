@@ -0,0 +1,307 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdlib.h>
+
+#include "timer-wheel.h"
+
+/**
+ * Number of wheels in the hierarchy
+ */
+#define LS_TIMER_WHEEL_LEVELS 4
+
+/**
+ * Slots are indexed by (expires >> shift) for each level. Each level
+ * covers both the current and the next bucket of the level above, so
+ * it has twice as many slots as there are children in a bucket, and no
+ * two pending deadlines ever share a slot by wrapping around.
+ *
+ * Level 0 covers 2 * 256 single ticks, and the levels above 2 * 64
+ * buckets each, reaching at least 2^26 ticks ahead. Later deadlines wait
+ * in an overflow list until the top level catches up with them.
+ */
+static const unsigned int ls_timer_wheel_shift[LS_TIMER_WHEEL_LEVELS + 1] = { 0, 8, 14, 20, 26 };
+
+/**
+ * Offset of each level within the flat slot array
+ */
+static const unsigned int ls_timer_wheel_offset[LS_TIMER_WHEEL_LEVELS + 1] = {
+        0, 512, 640, 768, 896,
+};
+
+/**
+ * Flat index of the overflow list
+ */
+#define LS_TIMER_WHEEL_OVERFLOW 896
+
+/**
+ * Total number of lists, including the overflow
+ */
+#define LS_TIMER_WHEEL_SLOTS (LS_TIMER_WHEEL_OVERFLOW + 1)
+
+/**
+ * Opaque LsTimerWheel implementation
+ */
+struct LsTimerWheel {
+        uint64_t now;                              /**<Last processed tick */
+        size_t count;                              /**<Pending timers */
+        LsDList slots[LS_TIMER_WHEEL_SLOTS];       /**<Timers by slot */
+        uint32_t slot_count[LS_TIMER_WHEEL_SLOTS]; /**<Timers in each slot */
+};
+
+void ls_timer_init(LsTimer *timer, ls_timer_func callback)
+{
+        ls_dlist_node_init(&timer->link);
+        timer->expires = 0;
+        timer->callback = callback;
+        timer->slot = 0;
+}
+
+bool ls_timer_is_pending(const LsTimer *timer)
+{
+        return ls_dlist_node_is_linked(&timer->link);
+}
+
+LsTimerWheel *ls_timer_wheel_new(uint64_t now)
+{
+        LsTimerWheel *ret = NULL;
+
+        ret = calloc(1, sizeof(struct LsTimerWheel));
+        if (!ret) {
+                return NULL;
+        }
+
+        ret->now = now;
+        for (unsigned int i = 0; i < LS_TIMER_WHEEL_SLOTS; i++) {
+                ls_dlist_init(&ret->slots[i]);
+        }
+        return ret;
+}
+
+void ls_timer_wheel_free(LsTimerWheel *self)
+{
+        if (ls_unlikely(!self)) {
+                return;
+        }
+
+        /* Leave every timer unlinked, so owners can tell they're dead */
+        for (unsigned int i = 0; i < LS_TIMER_WHEEL_SLOTS; i++) {
+                while (ls_dlist_pop_front(&self->slots[i])) {
+                }
+        }
+        free(self);
+}
+
+/**
+ * Number of slots in the given level
+ */
+static inline unsigned int ls_timer_wheel_level_size(unsigned int level)
+{
+        return ls_timer_wheel_offset[level + 1] - ls_timer_wheel_offset[level];
+}
+
+/**
+ * Flat slot index holding @expires at @level
+ */
+static inline unsigned int ls_timer_wheel_slot(unsigned int level, uint64_t expires)
+{
+        uint64_t bucket = expires >> ls_timer_wheel_shift[level];
+
+        return ls_timer_wheel_offset[level] +
+               (unsigned int)(bucket & (ls_timer_wheel_level_size(level) - 1));
+}
+
+/**
+ * Link a timer into the finest level whose window covers its deadline,
+ * relative to the current tick.
+ */
+static void ls_timer_wheel_place(LsTimerWheel *self, LsTimer *timer)
+{
+        unsigned int slot = LS_TIMER_WHEEL_OVERFLOW;
+
+        for (unsigned int level = 0; level < LS_TIMER_WHEEL_LEVELS; level++) {
+                unsigned int parent = ls_timer_wheel_shift[level + 1];
+                if ((timer->expires >> parent) - (self->now >> parent) <= 1) {
+                        slot = ls_timer_wheel_slot(level, timer->expires);
+                        break;
+                }
+        }
+
+        timer->slot = slot;
+        ls_dlist_push_back(&self->slots[slot], &timer->link);
+        ++self->slot_count[slot];
+}
+
+/**
+ * Unlink a pending timer and account for it
+ */
+static void ls_timer_wheel_unlink(LsTimerWheel *self, LsTimer *timer)
+{
+        ls_dlist_unlink(&timer->link);
+        --self->slot_count[timer->slot];
+}
+
+bool ls_timer_wheel_schedule(LsTimerWheel *self, LsTimer *timer, uint64_t expires)
+{
+        if (ls_unlikely(!self || !timer)) {
+                return false;
+        }
+
+        if (ls_timer_is_pending(timer)) {
+                ls_timer_wheel_unlink(self, timer);
+        } else {
+                ++self->count;
+        }
+
+        timer->expires = expires > self->now ? expires : self->now + 1;
+        ls_timer_wheel_place(self, timer);
+        return true;
+}
+
+void ls_timer_wheel_cancel(LsTimerWheel *self, LsTimer *timer)
+{
+        if (ls_unlikely(!self || !timer) || !ls_timer_is_pending(timer)) {
+                return;
+        }
+        ls_timer_wheel_unlink(self, timer);
+        --self->count;
+}
+
+/**
+ * Re-place up to @n timers from @slot, which move to finer levels
+ */
+static void ls_timer_wheel_cascade(LsTimerWheel *self, unsigned int slot, uint32_t n)
+{
+        LsDListNode *node = NULL;
+
+        while (n-- > 0 && (node = ls_dlist_pop_front(&self->slots[slot]))) {
+                --self->slot_count[slot];
+                ls_timer_wheel_place(self, ls_dlist_entry(node, LsTimer, link));
+        }
+}
+
+/**
+ * Process the single tick at self->now
+ */
+static size_t ls_timer_wheel_tick(LsTimerWheel *self)
+{
+        uint64_t now = self->now;
+        LsDListNode *node = NULL;
+        unsigned int slot;
+        size_t fired = 0;
+
+        /* Far deadlines come into reach once per top level bucket */
+        if ((now & ((UINT64_C(1) << ls_timer_wheel_shift[LS_TIMER_WHEEL_LEVELS]) - 1)) == 0) {
+                ls_timer_wheel_cascade(self,
+                                       LS_TIMER_WHEEL_OVERFLOW,
+                                       self->slot_count[LS_TIMER_WHEEL_OVERFLOW]);
+        }
+
+        /* Catch any stragglers from a bucket that has just come due */
+        for (unsigned int level = LS_TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+                uint64_t mask = (UINT64_C(1) << ls_timer_wheel_shift[level]) - 1;
+                if ((now & mask) == 0) {
+                        slot = ls_timer_wheel_slot(level, now);
+                        ls_timer_wheel_cascade(self, slot, self->slot_count[slot]);
+                }
+        }
+
+        /* Fire everything due now. Callbacks may schedule or cancel freely. */
+        slot = ls_timer_wheel_slot(0, now);
+        while ((node = ls_dlist_pop_front(&self->slots[slot]))) {
+                LsTimer *timer = ls_dlist_entry(node, LsTimer, link);
+
+                --self->slot_count[slot];
+                --self->count;
+                ++fired;
+                timer->callback(timer);
+        }
+
+        /*
+         * Move the next bucket of each level down ahead of time, spread
+         * evenly over the ticks remaining until it comes due, so that no
+         * single tick has to cascade a whole slot.
+         */
+        for (unsigned int level = 1; level < LS_TIMER_WHEEL_LEVELS; level++) {
+                uint64_t span = UINT64_C(1) << ls_timer_wheel_shift[level];
+                uint64_t left = span - (now & (span - 1));
+                uint32_t pending;
+
+                slot = ls_timer_wheel_slot(level, now + span);
+                pending = self->slot_count[slot];
+                if (pending > 0) {
+                        ls_timer_wheel_cascade(self, slot, (uint32_t)((pending + left - 1) / left));
+                }
+        }
+
+        return fired;
+}
+
+size_t ls_timer_wheel_advance(LsTimerWheel *self, uint64_t now)
+{
+        size_t fired = 0;
+
+        if (ls_unlikely(!self)) {
+                return 0;
+        }
+
+        while (self->now < now) {
+                /* Nothing pending, so there's nothing to walk through */
+                if (self->count == 0) {
+                        self->now = now;
+                        break;
+                }
+                ++self->now;
+                fired += ls_timer_wheel_tick(self);
+        }
+
+        return fired;
+}
+
+uint64_t ls_timer_wheel_now(LsTimerWheel *self)
+{
+        if (ls_unlikely(!self)) {
+                return 0;
+        }
+        return self->now;
+}
+
+size_t ls_timer_wheel_count(LsTimerWheel *self)
+{
+        if (ls_unlikely(!self)) {
+                return 0;
+        }
+        return self->count;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,132 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dlist.h"
+
+/**
+ * LsTimerWheel schedules large numbers of timers against an abstract,
+ * monotonically increasing tick count (frames, milliseconds, etc).
+ *
+ * Timers live in a hierarchy of four wheels of increasing granularity,
+ * so scheduling and cancelling are O(1) regardless of how many timers are
+ * pending. Timers migrate towards the finest wheel as they approach their
+ * deadline. That migration is spread evenly over the ticks leading up to
+ * each boundary instead of happening all at once, so the cost of a tick
+ * does not spike when a coarse slot comes due.
+ *
+ * LsTimer is intrusive: embed it in your own structure and recover the
+ * container with ls_container_of in the callback. Nothing is allocated
+ * per timer.
+ */
+typedef struct LsTimerWheel LsTimerWheel;
+
+typedef struct LsTimer LsTimer;
+
+/**
+ * Callback for an expired timer. The timer is no longer pending when
+ * called, and may be freed or scheduled again.
+ */
+typedef void (*ls_timer_func)(LsTimer *timer);
+
+/**
+ * A single timer, to be embedded within the owning object. Initialise
+ * with ls_timer_init before use.
+ */
+struct LsTimer {
+        LsDListNode link;       /**<Membership of a wheel slot */
+        uint64_t expires;       /**<Tick at which the timer fires */
+        ls_timer_func callback; /**<Called once the timer expires */
+        unsigned int slot;      /**<Slot currently holding the timer */
+};
+
+/**
+ * Prepare a timer for use, initially not pending
+ */
+void ls_timer_init(LsTimer *timer, ls_timer_func callback);
+
+/**
+ * Determine whether the timer is currently scheduled
+ */
+bool ls_timer_is_pending(const LsTimer *timer);
+
+/**
+ * Construct a new LsTimerWheel whose current time is @now
+ */
+LsTimerWheel *ls_timer_wheel_new(uint64_t now);
+
+/**
+ * Free a previously allocated wheel. Pending timers are cancelled without
+ * being fired, and may be freed by their owners afterwards.
+ */
+void ls_timer_wheel_free(LsTimerWheel *wheel);
+
+/**
+ * Schedule @timer to fire at the absolute tick @expires, O(1). A timer
+ * that is already pending is moved to the new deadline. Deadlines that
+ * are not in the future fire on the next tick.
+ *
+ * @returns True if the timer was scheduled
+ */
+bool ls_timer_wheel_schedule(LsTimerWheel *wheel, LsTimer *timer, uint64_t expires);
+
+/**
+ * Cancel a pending timer, O(1). Cancelling a timer that isn't pending is
+ * harmless.
+ */
+void ls_timer_wheel_cancel(LsTimerWheel *wheel, LsTimer *timer);
+
+/**
+ * Advance the wheel to @now, firing the callback of every timer that
+ * expires on the way, in deadline order.
+ *
+ * @returns The number of timers fired
+ */
+size_t ls_timer_wheel_advance(LsTimerWheel *wheel, uint64_t now);
+
+/**
+ * Return the current tick of the wheel
+ */
+uint64_t ls_timer_wheel_now(LsTimerWheel *wheel);
+
+/**
+ * Return the number of pending timers
+ */
+size_t ls_timer_wheel_count(LsTimerWheel *wheel);
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,313 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "unrolled-list.h"
+
+/**
+ * Each node occupies two 64-byte cache lines
+ */
+#define LS_UNROLLED_LIST_NODE_SIZE 128
+
+/**
+ * Data pointers that fit in a node after the link and length
+ */
+#define LS_UNROLLED_LIST_NODE_ITEMS                                                                \
+        ((LS_UNROLLED_LIST_NODE_SIZE - 2 * sizeof(void *)) / sizeof(void *))
+
+/**
+ * A single node, holding up to LS_UNROLLED_LIST_NODE_ITEMS contiguous
+ * data pointers.
+ */
+typedef struct LsUnrolledListNode {
+        struct LsUnrolledListNode *next;
+        size_t len;
+        void *items[LS_UNROLLED_LIST_NODE_ITEMS];
+} LsUnrolledListNode;
+
+/**
+ * Opaque LsUnrolledList implementation
+ */
+struct LsUnrolledList {
+        LsUnrolledListNode *head; /**<First node */
+        LsUnrolledListNode *tail; /**<Last node, for O(1) appends */
+        size_t length;            /**<Total number of items */
+};
+
+/**
+ * Allocate a cache line aligned, empty node
+ */
+static LsUnrolledListNode *ls_unrolled_list_node_new(void)
+{
+        LsUnrolledListNode *ret = NULL;
+
+        ret = aligned_alloc(64, sizeof(LsUnrolledListNode));
+        if (!ret) {
+                return NULL;
+        }
+        ret->next = NULL;
+        ret->len = 0;
+        return ret;
+}
+
+LsUnrolledList *ls_unrolled_list_new(void)
+{
+        return calloc(1, sizeof(struct LsUnrolledList));
+}
+
+void ls_unrolled_list_free(LsUnrolledList *self)
+{
+        ls_unrolled_list_free_full(self, NULL);
+}
+
+void ls_unrolled_list_free_full(LsUnrolledList *self, ls_free_func freer)
+{
+        LsUnrolledListNode *node = NULL;
+        LsUnrolledListNode *next = NULL;
+
+        if (ls_unlikely(!self)) {
+                return;
+        }
+
+        for (node = self->head; node; node = next) {
+                next = node->next;
+                if (freer) {
+                        for (size_t i = 0; i < node->len; i++) {
+                                if (node->items[i]) {
+                                        freer(node->items[i]);
+                                }
+                        }
+                }
+                free(node);
+        }
+        free(self);
+}
+
+bool ls_unrolled_list_append(LsUnrolledList *self, void *data)
+{
+        LsUnrolledListNode *tail = NULL;
+
+        if (ls_unlikely(!self)) {
+                return false;
+        }
+
+        /* Appends fill each node completely, as logs rarely insert mid-way */
+        tail = self->tail;
+        if (!tail || tail->len == LS_UNROLLED_LIST_NODE_ITEMS) {
+                LsUnrolledListNode *node = ls_unrolled_list_node_new();
+                if (!node) {
+                        return false;
+                }
+                if (tail) {
+                        tail->next = node;
+                } else {
+                        self->head = node;
+                }
+                self->tail = tail = node;
+        }
+
+        tail->items[tail->len++] = data;
+        self->length++;
+        return true;
+}
+
+bool ls_unrolled_list_prepend(LsUnrolledList *self, void *data)
+{
+        return ls_unrolled_list_insert(self, 0, data);
+}
+
+bool ls_unrolled_list_insert(LsUnrolledList *self, size_t index, void *data)
+{
+        LsUnrolledListNode *node = NULL;
+        size_t offset = index;
+
+        if (ls_unlikely(!self || index > self->length)) {
+                return false;
+        }
+
+        if (index == self->length) {
+                return ls_unrolled_list_append(self, data);
+        }
+
+        /* Find the node holding @index, we know it isn't past the end */
+        node = self->head;
+        while (offset >= node->len) {
+                offset -= node->len;
+                node = node->next;
+        }
+
+        /* Full, so split the upper half into a new node after this one */
+        if (node->len == LS_UNROLLED_LIST_NODE_ITEMS) {
+                LsUnrolledListNode *split = ls_unrolled_list_node_new();
+                size_t keep = LS_UNROLLED_LIST_NODE_ITEMS / 2;
+
+                if (!split) {
+                        return false;
+                }
+                split->len = node->len - keep;
+                memcpy(split->items, &node->items[keep], split->len * sizeof(void *));
+                node->len = keep;
+
+                split->next = node->next;
+                node->next = split;
+                if (self->tail == node) {
+                        self->tail = split;
+                }
+
+                if (offset > keep) {
+                        offset -= keep;
+                        node = split;
+                }
+        }
+
+        memmove(&node->items[offset + 1],
+                &node->items[offset],
+                (node->len - offset) * sizeof(void *));
+        node->items[offset] = data;
+        node->len++;
+        self->length++;
+
+        return true;
+}
+
+bool ls_unrolled_list_remove(LsUnrolledList *self, size_t index, void **data)
+{
+        LsUnrolledListNode *node = NULL;
+        LsUnrolledListNode *prev = NULL;
+        LsUnrolledListNode *next = NULL;
+        size_t offset = index;
+
+        if (ls_unlikely(!self || index >= self->length)) {
+                return false;
+        }
+
+        node = self->head;
+        while (offset >= node->len) {
+                offset -= node->len;
+                prev = node;
+                node = node->next;
+        }
+
+        if (data) {
+                *data = node->items[offset];
+        }
+        memmove(&node->items[offset],
+                &node->items[offset + 1],
+                (node->len - offset - 1) * sizeof(void *));
+        node->len--;
+        self->length--;
+
+        /* Drop empty nodes entirely */
+        if (node->len == 0) {
+                if (prev) {
+                        prev->next = node->next;
+                } else {
+                        self->head = node->next;
+                }
+                if (self->tail == node) {
+                        self->tail = prev;
+                }
+                free(node);
+                return true;
+        }
+
+        /* Merge an underfull node with its neighbour when they fit together */
+        next = node->next;
+        if (next && node->len < LS_UNROLLED_LIST_NODE_ITEMS / 2 &&
+            node->len + next->len <= LS_UNROLLED_LIST_NODE_ITEMS) {
+                memcpy(&node->items[node->len], next->items, next->len * sizeof(void *));
+                node->len += next->len;
+                node->next = next->next;
+                if (self->tail == next) {
+                        self->tail = node;
+                }
+                free(next);
+        }
+
+        return true;
+}
+
+void *ls_unrolled_list_get(LsUnrolledList *self, size_t index)
+{
+        LsUnrolledListNode *node = NULL;
+
+        if (ls_unlikely(!self || index >= self->length)) {
+                return NULL;
+        }
+
+        for (node = self->head; index >= node->len; node = node->next) {
+                index -= node->len;
+        }
+
+        return node->items[index];
+}
+
+size_t ls_unrolled_list_length(LsUnrolledList *self)
+{
+        if (ls_unlikely(!self)) {
+                return 0;
+        }
+        return self->length;
+}
+
+void ls_unrolled_list_iter_init(LsUnrolledList *self, LsUnrolledListIter *iter)
+{
+        iter->node = self ? self->head : NULL;
+        iter->index = 0;
+}
+
+bool ls_unrolled_list_iter_next(LsUnrolledListIter *iter, void **data)
+{
+        LsUnrolledListNode *node = iter->node;
+
+        /* Skip to the next node once this one is exhausted */
+        while (node && iter->index >= node->len) {
+                node = node->next;
+                iter->node = node;
+                iter->index = 0;
+        }
+
+        if (!node) {
+                return false;
+        }
+
+        if (data) {
+                *data = node->items[iter->index];
+        }
+        iter->index++;
+        return true;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
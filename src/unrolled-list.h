@@ -0,0 +1,128 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "macros.h"
+
+/**
+ * LsUnrolledList is a linked list where every node holds a small inline
+ * array of data pointers, sized to two cache lines. Sequential walks
+ * touch a fraction of the cache lines that an LsList would, while
+ * insertion and removal in the middle only move a handful of pointers.
+ *
+ * Nodes are split when an insert lands in a full node, and merged with
+ * their neighbour when a removal leaves them less than half full.
+ */
+typedef struct LsUnrolledList LsUnrolledList;
+
+/**
+ * LsUnrolledListIter is used to walk the list from front to back. The list
+ * must not be modified while an iterator is in use.
+ */
+typedef struct LsUnrolledListIter {
+        void *node;
+        unsigned int index;
+} LsUnrolledListIter;
+
+/**
+ * Construct a new, empty, unrolled list
+ */
+LsUnrolledList *ls_unrolled_list_new(void);
+
+/**
+ * Free a previously allocated list and all of its nodes
+ */
+void ls_unrolled_list_free(LsUnrolledList *list);
+
+/**
+ * Identical to ls_unrolled_list_free, but will additionally call the
+ * passed free_func to deallocate each data pointer in the list.
+ */
+void ls_unrolled_list_free_full(LsUnrolledList *list, ls_free_func freer);
+
+/**
+ * Append data to the tail of the list, O(1)
+ *
+ * @returns True if the data was appended
+ */
+bool ls_unrolled_list_append(LsUnrolledList *list, void *data);
+
+/**
+ * Prepend data to the head of the list, O(1)
+ *
+ * @returns True if the data was prepended
+ */
+bool ls_unrolled_list_prepend(LsUnrolledList *list, void *data);
+
+/**
+ * Insert data so that it ends up at @index, which may be at most the
+ * current length of the list.
+ *
+ * @returns True if the data was inserted
+ */
+bool ls_unrolled_list_insert(LsUnrolledList *list, size_t index, void *data);
+
+/**
+ * Remove the item at @index, storing its data pointer in @data.
+ *
+ * @returns True if an item was removed
+ */
+bool ls_unrolled_list_remove(LsUnrolledList *list, size_t index, void **data);
+
+/**
+ * Return the data pointer at @index, or NULL if out of range
+ */
+void *ls_unrolled_list_get(LsUnrolledList *list, size_t index);
+
+/**
+ * Return the number of items in the list, O(1)
+ */
+size_t ls_unrolled_list_length(LsUnrolledList *list);
+
+/**
+ * Prepare @iter to walk @list from the front
+ */
+void ls_unrolled_list_iter_init(LsUnrolledList *list, LsUnrolledListIter *iter);
+
+/**
+ * Advance the iterator, storing the next data pointer in @data.
+ *
+ * @returns False once the iterator has been exhausted
+ */
+bool ls_unrolled_list_iter_next(LsUnrolledListIter *iter, void **data);
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,236 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "array.h"
+#include "job-system.h"
+#include "macros.h"
+
+/**
+ * LsArray holds at most UINT16_MAX items, so each pass is repeated to
+ * get a measurable amount of work
+ */
+#define BENCH_SPRITES UINT16_MAX
+#define BENCH_PASSES 50
+#define BENCH_MAX_WORKERS 64
+
+typedef struct BenchSprite {
+        float x;
+        float y;
+        float dx;
+        float dy;
+} BenchSprite;
+
+typedef struct BenchBounds {
+        float min_x;
+        float max_x;
+} BenchBounds;
+
+/**
+ * Keeps the serial reduction from being optimised away
+ */
+static volatile float bench_sink = 0.0f;
+
+static double bench_now(void)
+{
+        struct timespec ts = { 0 };
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * Emulate a transform: integrate a few steps of motion
+ */
+static void bench_transform(void *item, __ls_unused__ void *user_data)
+{
+        BenchSprite *sprite = item;
+
+        for (int i = 0; i < 16; i++) {
+                sprite->dy = sprite->dy * 0.99f - 0.01f;
+                sprite->x += sprite->dx;
+                sprite->y += sprite->dy;
+                if (sprite->y < 0.0f) {
+                        sprite->y = -sprite->y;
+                        sprite->dy = -sprite->dy;
+                }
+        }
+}
+
+static bool bench_visible(void *item, __ls_unused__ void *user_data)
+{
+        BenchSprite *sprite = item;
+
+        return sprite->x > 100.0f && sprite->x < 900.0f && sprite->y < 500.0f;
+}
+
+static void bench_bounds(void *accumulator, void *item, __ls_unused__ void *user_data)
+{
+        BenchBounds *bounds = accumulator;
+        BenchSprite *sprite = item;
+
+        bounds->min_x = sprite->x < bounds->min_x ? sprite->x : bounds->min_x;
+        bounds->max_x = sprite->x > bounds->max_x ? sprite->x : bounds->max_x;
+}
+
+static void bench_bounds_combine(void *accumulator, const void *partial,
+                                 __ls_unused__ void *user_data)
+{
+        BenchBounds *bounds = accumulator;
+        const BenchBounds *other = partial;
+
+        bounds->min_x = other->min_x < bounds->min_x ? other->min_x : bounds->min_x;
+        bounds->max_x = other->max_x > bounds->max_x ? other->max_x : bounds->max_x;
+}
+
+/**
+ * Time each kind of pass over the array, in milliseconds per pass. A NULL
+ * system times the equivalent serial loop.
+ */
+static void bench_run(LsJobSystem *system, LsArray *array, double *transform, double *cull,
+                      double *bounds)
+{
+        double start = bench_now();
+
+        for (int pass = 0; pass < BENCH_PASSES; pass++) {
+                if (!system) {
+                        for (uint16_t i = 0; i < array->len; i++) {
+                                bench_transform(array->data[i], NULL);
+                        }
+                } else if (!ls_array_parallel_foreach(system, array, 0, bench_transform, NULL)) {
+                        abort();
+                }
+        }
+        *transform = (bench_now() - start) * 1e3 / BENCH_PASSES;
+
+        start = bench_now();
+        for (int pass = 0; pass < BENCH_PASSES; pass++) {
+                LsArray *visible = NULL;
+
+                if (!system) {
+                        visible = ls_array_new_size(array->item_size, array->len);
+                        for (uint16_t i = 0; i < array->len; i++) {
+                                if (bench_visible(array->data[i], NULL)) {
+                                        ls_array_add(visible, array->data[i]);
+                                }
+                        }
+                } else {
+                        visible = ls_array_parallel_filter(system, array, 0, bench_visible, NULL);
+                }
+                if (!visible) {
+                        abort();
+                }
+                ls_array_free(visible, NULL);
+        }
+        *cull = (bench_now() - start) * 1e3 / BENCH_PASSES;
+
+        start = bench_now();
+        for (int pass = 0; pass < BENCH_PASSES; pass++) {
+                BenchBounds result = { 1e30f, -1e30f };
+
+                if (!system) {
+                        for (uint16_t i = 0; i < array->len; i++) {
+                                bench_bounds(&result, array->data[i], NULL);
+                        }
+                } else if (!ls_array_parallel_reduce(system,
+                                                     array,
+                                                     0,
+                                                     &result,
+                                                     sizeof(result),
+                                                     bench_bounds,
+                                                     bench_bounds_combine,
+                                                     NULL)) {
+                        abort();
+                }
+                bench_sink = result.min_x;
+        }
+        *bounds = (bench_now() - start) * 1e3 / BENCH_PASSES;
+}
+
+int main(__ls_unused__ int argc, __ls_unused__ char **argv)
+{
+        BenchSprite *sprites = calloc(BENCH_SPRITES, sizeof(BenchSprite));
+        LsArray *array = ls_array_new_size(sizeof(void *), BENCH_SPRITES);
+        long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        unsigned int max_workers = n_cpus > 1 ? (unsigned int)n_cpus : 2;
+        double transform = 0.0;
+        double cull = 0.0;
+        double bounds = 0.0;
+
+        if (!sprites || !array) {
+                return EXIT_FAILURE;
+        }
+        if (max_workers > BENCH_MAX_WORKERS) {
+                max_workers = BENCH_MAX_WORKERS;
+        }
+
+        for (int i = 0; i < BENCH_SPRITES; i++) {
+                sprites[i].x = (float)(i % 1000);
+                sprites[i].y = (float)(i % 700);
+                sprites[i].dx = (float)(i % 7) - 3.0f;
+                if (!ls_array_add(array, &sprites[i])) {
+                        return EXIT_FAILURE;
+                }
+        }
+
+        printf("%d sprites, %ld online CPUs, ms per pass\n", BENCH_SPRITES, n_cpus);
+        printf("  workers  transform      cull    bounds\n");
+
+        bench_run(NULL, array, &transform, &cull, &bounds);
+        printf("   serial  %9.3f  %8.3f  %8.3f\n", transform, cull, bounds);
+
+        for (unsigned int n_workers = 1; n_workers <= max_workers; n_workers *= 2) {
+                LsJobSystem *system = ls_job_system_new(n_workers);
+
+                if (!system) {
+                        return EXIT_FAILURE;
+                }
+                bench_run(system, array, &transform, &cull, &bounds);
+                printf("  %7u  %9.3f  %8.3f  %8.3f\n", n_workers, transform, cull, bounds);
+                ls_job_system_free(system);
+        }
+
+        ls_array_free(array, NULL);
+        free(sprites);
+
+        return EXIT_SUCCESS;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,161 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "job-system.h"
+#include "macros.h"
+
+/**
+ * Elements transformed by the parallel_for pass, and the tiny jobs
+ * submitted by the fan-out pass
+ */
+#define BENCH_ITEMS (4 * 1024 * 1024)
+#define BENCH_JOBS 200000
+#define BENCH_MAX_WORKERS 64
+
+static double bench_now(void)
+{
+        struct timespec ts = { 0 };
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * Emulate a transform pass: a little arithmetic per element
+ */
+static void bench_transform(void *v, size_t begin, size_t end)
+{
+        float *items = v;
+
+        for (size_t i = begin; i < end; i++) {
+                float x = items[i];
+                for (int j = 0; j < 8; j++) {
+                        x = x * 0.999f + 1.0f / (x + 1.0f);
+                }
+                items[i] = x;
+        }
+}
+
+static void bench_empty(__ls_unused__ void *v)
+{
+}
+
+/**
+ * Time a parallel transform over every item, in milliseconds
+ */
+static double bench_parallel_for(LsJobSystem *system, float *items)
+{
+        double start = bench_now();
+
+        ls_job_system_parallel_for(system, 0, BENCH_ITEMS, 0, bench_transform, items);
+        return (bench_now() - start) * 1e3;
+}
+
+/**
+ * Time submitting and waiting on many empty jobs, in ns per job
+ */
+static double bench_fan_out(LsJobSystem *system)
+{
+        LsJobCounter counter = LS_JOB_COUNTER_INIT;
+        double start = bench_now();
+
+        for (int i = 0; i < BENCH_JOBS; i++) {
+                if (!ls_job_system_submit(system, bench_empty, NULL, &counter)) {
+                        abort();
+                }
+        }
+        ls_job_system_wait(system, &counter);
+        return (bench_now() - start) * 1e9 / BENCH_JOBS;
+}
+
+int main(__ls_unused__ int argc, __ls_unused__ char **argv)
+{
+        float *items = calloc(BENCH_ITEMS, sizeof(float));
+        long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        unsigned int max_workers = n_cpus > 1 ? (unsigned int)n_cpus : 2;
+        double serial = 0.0;
+        double start = 0.0;
+
+        if (!items) {
+                return EXIT_FAILURE;
+        }
+        if (max_workers > BENCH_MAX_WORKERS) {
+                max_workers = BENCH_MAX_WORKERS;
+        }
+
+        start = bench_now();
+        bench_transform(items, 0, BENCH_ITEMS);
+        serial = (bench_now() - start) * 1e3;
+
+        printf("%d items, %ld online CPUs, serial transform %.2f ms\n",
+               BENCH_ITEMS,
+               n_cpus,
+               serial);
+        printf("  workers  parallel_for ms  speedup  ns per empty job\n");
+
+        for (unsigned int n_workers = 1; n_workers <= max_workers; n_workers *= 2) {
+                LsJobSystem *system = ls_job_system_new(n_workers);
+                double elapsed = 0.0;
+                double fan_out = 0.0;
+
+                if (!system) {
+                        return EXIT_FAILURE;
+                }
+
+                /* Warm the pools and wake every worker before timing */
+                bench_fan_out(system);
+                elapsed = bench_parallel_for(system, items);
+                fan_out = bench_fan_out(system);
+
+                printf("  %7u  %15.2f  %7.2f  %16.2f\n",
+                       n_workers,
+                       elapsed,
+                       serial / elapsed,
+                       fan_out);
+
+                ls_job_system_free(system);
+        }
+
+        free(items);
+
+        return EXIT_SUCCESS;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,167 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "macros.h"
+#include "map.h"
+#include "pool.h"
+
+/**
+ * Objects each thread holds at once, and how many times it cycles them
+ */
+#define BENCH_BATCH 64
+#define BENCH_ROUNDS 20000
+#define BENCH_MAX_THREADS 16
+
+typedef struct BenchThread {
+        pthread_t thread;
+        LsPool *pool;
+        size_t object_size;
+} BenchThread;
+
+static double bench_now(void)
+{
+        struct timespec ts = { 0 };
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * Emulate map churn: allocate a batch of nodes, touch them, free them
+ */
+static void *bench_malloc_worker(void *v)
+{
+        BenchThread *self = v;
+        void *objects[BENCH_BATCH];
+
+        for (int round = 0; round < BENCH_ROUNDS; round++) {
+                for (int i = 0; i < BENCH_BATCH; i++) {
+                        objects[i] = malloc(self->object_size);
+                        *(volatile int *)objects[i] = i;
+                }
+                for (int i = 0; i < BENCH_BATCH; i++) {
+                        free(objects[i]);
+                }
+        }
+        return NULL;
+}
+
+static void *bench_pool_worker(void *v)
+{
+        BenchThread *self = v;
+        void *objects[BENCH_BATCH];
+
+        for (int round = 0; round < BENCH_ROUNDS; round++) {
+                for (int i = 0; i < BENCH_BATCH; i++) {
+                        objects[i] = ls_pool_alloc(self->pool);
+                        *(volatile int *)objects[i] = i;
+                }
+                for (int i = 0; i < BENCH_BATCH; i++) {
+                        ls_pool_release(self->pool, objects[i]);
+                }
+        }
+        return NULL;
+}
+
+static void *bench_pool_bulk_worker(void *v)
+{
+        BenchThread *self = v;
+        void *objects[BENCH_BATCH];
+
+        for (int round = 0; round < BENCH_ROUNDS; round++) {
+                if (ls_pool_alloc_bulk(self->pool, objects, BENCH_BATCH) != BENCH_BATCH) {
+                        abort();
+                }
+                for (int i = 0; i < BENCH_BATCH; i++) {
+                        *(volatile int *)objects[i] = i;
+                }
+                ls_pool_release_bulk(self->pool, objects, BENCH_BATCH);
+        }
+        return NULL;
+}
+
+/**
+ * Run @worker on @n_threads threads at once, returning ns per operation
+ */
+static double bench_run(void *(*worker)(void *), LsPool *pool, unsigned int n_threads)
+{
+        BenchThread threads[BENCH_MAX_THREADS];
+        double start = bench_now();
+
+        for (unsigned int i = 0; i < n_threads; i++) {
+                threads[i].pool = pool;
+                threads[i].object_size = ls_hashmap_node_size();
+                if (pthread_create(&threads[i].thread, NULL, worker, &threads[i]) != 0) {
+                        abort();
+                }
+        }
+        for (unsigned int i = 0; i < n_threads; i++) {
+                pthread_join(threads[i].thread, NULL);
+        }
+
+        return (bench_now() - start) * 1e9 /
+               ((double)n_threads * BENCH_ROUNDS * BENCH_BATCH * 2.0);
+}
+
+int main(__ls_unused__ int argc, __ls_unused__ char **argv)
+{
+        LsPool *pool = ls_pool_new(ls_hashmap_node_size());
+
+        if (!pool) {
+                return EXIT_FAILURE;
+        }
+
+        printf("%zu byte objects, ns per alloc or free\n", ls_hashmap_node_size());
+        printf("  threads    malloc      pool  pool bulk\n");
+
+        for (unsigned int n_threads = 1; n_threads <= BENCH_MAX_THREADS; n_threads *= 2) {
+                double heap = bench_run(bench_malloc_worker, NULL, n_threads);
+                double single = bench_run(bench_pool_worker, pool, n_threads);
+                double bulk = bench_run(bench_pool_bulk_worker, pool, n_threads);
+
+                printf("  %7u  %8.2f  %8.2f  %9.2f\n", n_threads, heap, single, bulk);
+        }
+
+        ls_pool_free(pool);
+
+        return EXIT_SUCCESS;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,142 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "macros.h"
+#include "map.h"
+#include "snapshot.h"
+
+/**
+ * Number of entries in the lookup table
+ */
+#define BENCH_N_ITEMS 500000
+
+static double bench_now(void)
+{
+        struct timespec ts = { 0 };
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static LsHashmap *bench_map_new(void)
+{
+        return ls_hashmap_new_full(ls_hashmap_string_hash, ls_hashmap_string_equal, free, free);
+}
+
+/**
+ * Emulate the current cold start: parse a text asset line by line and put
+ * each entry into the map.
+ */
+static LsHashmap *bench_rebuild(const char *text)
+{
+        LsHashmap *map = bench_map_new();
+        const char *line = text;
+
+        while (*line) {
+                const char *eq = strchr(line, '=');
+                const char *nl = strchr(eq, '\n');
+
+                if (!ls_hashmap_put(map,
+                                    strndup(line, (size_t)(eq - line)),
+                                    strndup(eq + 1, (size_t)(nl - eq - 1)))) {
+                        abort();
+                }
+                line = nl + 1;
+        }
+
+        return map;
+}
+
+int main(__ls_unused__ int argc, __ls_unused__ char **argv)
+{
+        LsHashmap *map = NULL;
+        char *text = NULL;
+        size_t text_len = 0;
+        FILE *fp = NULL;
+        char path[] = "/tmp/libls-bench-snapshot-XXXXXX";
+        double start, rebuild_time, load_time;
+        int fd;
+
+        /* Generate the text asset in memory so we only time the parse */
+        fp = open_memstream(&text, &text_len);
+        if (!fp) {
+                return EXIT_FAILURE;
+        }
+        for (size_t i = 0; i < BENCH_N_ITEMS; i++) {
+                fprintf(fp, "asset/entry/%zu=value for entry %zu\n", i, i);
+        }
+        fclose(fp);
+
+        start = bench_now();
+        map = bench_rebuild(text);
+        rebuild_time = bench_now() - start;
+
+        fd = mkstemp(path);
+        if (fd < 0) {
+                return EXIT_FAILURE;
+        }
+        close(fd);
+
+        if (!ls_hashmap_save(map, path, ls_snapshot_write_string, ls_snapshot_write_string)) {
+                return EXIT_FAILURE;
+        }
+        ls_hashmap_free(map);
+
+        start = bench_now();
+        map = bench_map_new();
+        if (!ls_hashmap_load(map, path, ls_snapshot_read_string, ls_snapshot_read_string)) {
+                return EXIT_FAILURE;
+        }
+        load_time = bench_now() - start;
+        ls_hashmap_free(map);
+
+        printf("%d entries\n", BENCH_N_ITEMS);
+        printf("  rebuild from text: %.3f ms\n", rebuild_time * 1000.0);
+        printf("  load snapshot:     %.3f ms\n", load_time * 1000.0);
+        printf("  speedup:           %.2fx\n", rebuild_time / load_time);
+
+        unlink(path);
+        free(text);
+
+        return EXIT_SUCCESS;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,303 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <check.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "list.h"
+#include "map.h"
+#include "ptr-array.h"
+
+/**
+ * Tracking allocator which records the size of each block ahead of it, so
+ * that every sized free and realloc can be validated.
+ */
+typedef struct TestTracker {
+        size_t live_bytes;
+        size_t n_allocs;
+        size_t n_frees;
+        size_t n_bad_sizes;
+} TestTracker;
+
+typedef struct TestHeader {
+        size_t size;
+        max_align_t pad[];
+} TestHeader;
+
+static void *test_alloc(void *context, size_t size)
+{
+        TestTracker *tracker = context;
+        TestHeader *header = malloc(sizeof(TestHeader) + size);
+
+        if (!header) {
+                return NULL;
+        }
+        /* Scribble over the block to prove callers zero what they need */
+        memset(header->pad, 0xAA, size);
+        header->size = size;
+        tracker->live_bytes += size;
+        tracker->n_allocs++;
+        return header->pad;
+}
+
+static void test_free(void *context, void *ptr, size_t size)
+{
+        TestTracker *tracker = context;
+        TestHeader *header = ls_container_of(ptr, TestHeader, pad);
+
+        if (header->size != size) {
+                tracker->n_bad_sizes++;
+        }
+        tracker->live_bytes -= header->size;
+        tracker->n_frees++;
+        free(header);
+}
+
+static void *test_realloc(void *context, void *ptr, size_t old_size, size_t new_size)
+{
+        void *ret = test_alloc(context, new_size);
+
+        if (!ret || !ptr) {
+                return ret;
+        }
+        memcpy(ret, ptr, old_size < new_size ? old_size : new_size);
+        test_free(context, ptr, old_size);
+        return ret;
+}
+
+#define TEST_ALLOCATOR(tracker)                                                                    \
+        {                                                                                          \
+                .alloc = test_alloc, .realloc = test_realloc, .free = test_free,                   \
+                .context = &(tracker),                                                             \
+        }
+
+START_TEST(test_allocator_array)
+{
+        TestTracker tracker = { 0 };
+        LsAllocator allocator = TEST_ALLOCATOR(tracker);
+        LsArray *array = NULL;
+        LsPtrArray *ptr_array = NULL;
+
+        array = ls_array_new_with_allocator(&allocator, sizeof(void *), 4);
+        fail_if(!array, "Failed to construct array");
+        fail_if(array->len != 0 || array->data[0] != NULL, "Reserved storage not zeroed");
+
+        for (int i = 0; i < 100; i++) {
+                fail_if(!ls_array_add(array, LS_INT_TO_PTR(i + 1)), "Failed to add to array");
+        }
+        for (int i = 0; i < 100; i++) {
+                fail_if(array->data[i] != LS_INT_TO_PTR(i + 1), "Lost data across resizes");
+        }
+        fail_if(tracker.live_bytes == 0, "Array did not use the allocator");
+        ls_array_free(array, NULL);
+
+        ptr_array = ls_ptr_array_new_with_allocator(&allocator, 0);
+        fail_if(!ptr_array, "Failed to construct pointer array");
+        fail_if(!ls_array_add(ptr_array, &tracker), "Failed to add to pointer array");
+        ls_array_free(ptr_array, NULL);
+
+        fail_if(tracker.live_bytes != 0, "Array leaked allocator memory");
+        fail_if(tracker.n_allocs != tracker.n_frees, "Unbalanced allocations");
+        fail_if(tracker.n_bad_sizes != 0, "Sized free did not match the allocation");
+}
+END_TEST
+
+/**
+ * Count each call via the data pointer itself
+ */
+static void test_count_free(void *v)
+{
+        ++(*(unsigned int *)v);
+}
+
+START_TEST(test_allocator_list)
+{
+        TestTracker tracker = { 0 };
+        LsAllocator allocator = TEST_ALLOCATOR(tracker);
+        LsList *list = NULL;
+        unsigned int n_freed = 0;
+        int i = 0;
+
+        for (i = 0; i < 50; i++) {
+                list = ls_list_append_with_allocator(&allocator, list, LS_INT_TO_PTR(i + 1));
+                list = ls_list_prepend_with_allocator(&allocator, list, LS_INT_TO_PTR(i + 1));
+        }
+        fail_if(ls_list_length(list) != 100, "Incorrect list length");
+        fail_if(tracker.n_allocs != 100, "List nodes not obtained from the allocator");
+
+        i = 50;
+        for (LsList *node = list; node; node = node->next) {
+                if (i > 0) {
+                        fail_if(node->data != LS_INT_TO_PTR(i), "Bad prepend order");
+                        --i;
+                }
+                fail_if(node->data == NULL, "List node not initialised");
+        }
+
+        ls_list_free_with_allocator(&allocator, list);
+        fail_if(tracker.live_bytes != 0, "List leaked allocator memory");
+        fail_if(tracker.n_bad_sizes != 0, "Sized free did not match the allocation");
+
+        /* Data is still handed to the free function */
+        list = NULL;
+        for (i = 0; i < 10; i++) {
+                list = ls_list_prepend_with_allocator(&allocator, list, &n_freed);
+        }
+        ls_list_free_full_with_allocator(&allocator, list, test_count_free);
+        fail_if(n_freed != 10, "Free function not called for each node");
+        fail_if(tracker.live_bytes != 0, "List leaked allocator memory");
+}
+END_TEST
+
+START_TEST(test_allocator_map)
+{
+        TestTracker tracker = { 0 };
+        LsAllocator allocator = TEST_ALLOCATOR(tracker);
+        LsHashmap *map = NULL;
+        void *v = NULL;
+
+        map = ls_hashmap_new_full_with_allocator(&allocator,
+                                                 ls_hashmap_string_hash,
+                                                 ls_hashmap_string_equal,
+                                                 free,
+                                                 NULL);
+        fail_if(!map, "Failed to construct map");
+
+        for (int i = 0; i < 5000; i++) {
+                char *key = NULL;
+                fail_if(asprintf(&key, "key-%d", i) < 0, "Failed to allocate key");
+                fail_if(!ls_hashmap_put(map, key, LS_INT_TO_PTR(i + 1)), "Failed to put");
+        }
+
+        for (int i = 0; i < 5000; i += 2) {
+                char key[32];
+                snprintf(key, sizeof(key), "key-%d", i);
+                fail_if(!ls_hashmap_remove(map, key), "Failed to remove");
+        }
+        for (int i = 1; i < 5000; i += 2) {
+                char key[32];
+                snprintf(key, sizeof(key), "key-%d", i);
+                v = ls_hashmap_get(map, key);
+                fail_if(v != LS_INT_TO_PTR(i + 1), "Lost value across resizes");
+        }
+
+        fail_if(tracker.n_frees == 0, "Outgrown buckets not returned to the allocator");
+        ls_hashmap_free(map);
+
+        fail_if(tracker.live_bytes != 0, "Map leaked allocator memory");
+        fail_if(tracker.n_allocs != tracker.n_frees, "Unbalanced allocations");
+        fail_if(tracker.n_bad_sizes != 0, "Sized free did not match the allocation");
+}
+END_TEST
+
+/**
+ * A NULL free marks an allocator that reclaims everything in bulk
+ */
+START_TEST(test_allocator_bulk)
+{
+        LsArena *arena = NULL;
+        const LsAllocator *allocator = NULL;
+        LsHashmap *map = NULL;
+        LsArray *array = NULL;
+        LsList *list = NULL;
+
+        arena = ls_arena_new(0);
+        fail_if(!arena, "Failed to construct arena");
+        allocator = ls_arena_allocator(arena);
+        fail_if(allocator->free != NULL, "Arena allocator should have no free");
+
+        map = ls_hashmap_new_with_allocator(allocator,
+                                            ls_hashmap_simple_hash,
+                                            ls_hashmap_simple_equal);
+        array = ls_array_new_with_allocator(allocator, sizeof(void *), 0);
+        fail_if(!map || !array, "Failed to construct containers");
+
+        for (int i = 1; i < 1000; i++) {
+                fail_if(!ls_hashmap_put(map, LS_INT_TO_PTR(i), LS_INT_TO_PTR(i)), "Failed to put");
+                fail_if(!ls_array_add(array, LS_INT_TO_PTR(i)), "Failed to add");
+                list = ls_list_prepend_with_allocator(allocator, list, LS_INT_TO_PTR(i));
+                fail_if(!list, "Failed to prepend");
+        }
+        fail_if(ls_hashmap_get(map, LS_INT_TO_PTR(500)) != LS_INT_TO_PTR(500), "Bad lookup");
+
+        ls_hashmap_free(map);
+        ls_array_free(array, NULL);
+        ls_list_free_with_allocator(allocator, list);
+        ls_arena_free(arena);
+}
+END_TEST
+
+/**
+ * Standard helper for running a test suite
+ */
+static int ls_test_run(Suite *suite)
+{
+        SRunner *runner = NULL;
+        int n_failed = 0;
+
+        runner = srunner_create(suite);
+        srunner_run_all(runner, CK_VERBOSE);
+        n_failed = srunner_ntests_failed(runner);
+        srunner_free(runner);
+
+        return n_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static Suite *test_create(void)
+{
+        Suite *s = NULL;
+        TCase *tc = NULL;
+
+        s = suite_create(__FILE__);
+        tc = tcase_create(__FILE__);
+        suite_add_tcase(s, tc);
+
+        tcase_add_test(tc, test_allocator_array);
+        tcase_add_test(tc, test_allocator_list);
+        tcase_add_test(tc, test_allocator_map);
+        tcase_add_test(tc, test_allocator_bulk);
+        return s;
+}
+
+int main(__attribute__((unused)) int argc, __attribute__((unused)) char **argv)
+{
+        return ls_test_run(test_create());
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,260 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <check.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "array.h"
+#include "list.h"
+#include "map.h"
+
+START_TEST(test_arena_alloc)
+{
+        LsArena *arena = NULL;
+        char *a = NULL;
+        char *b = NULL;
+        char *big = NULL;
+        uint8_t *zeroed = NULL;
+        void *aligned = NULL;
+
+        arena = ls_arena_new(1024);
+        fail_if(!arena, "Failed to construct arena");
+
+        a = ls_arena_alloc(arena, 3);
+        b = ls_arena_alloc(arena, 8);
+        fail_if(!a || !b, "Failed to allocate");
+        fail_if((uintptr_t)b % _Alignof(max_align_t) != 0, "Allocation is misaligned");
+        fail_if(b < a + 3, "Allocations overlap");
+
+        aligned = ls_arena_alloc_aligned(arena, 16, 256);
+        fail_if(!aligned || (uintptr_t)aligned % 256 != 0, "Aligned allocation is misaligned");
+        fail_if(ls_arena_alloc_aligned(arena, 16, 3) != NULL, "Non power of two alignment");
+
+        zeroed = ls_arena_alloc0(arena, 100);
+        fail_if(!zeroed, "Failed to allocate zeroed memory");
+        for (int i = 0; i < 100; i++) {
+                fail_if(zeroed[i] != 0, "Memory was not zeroed");
+        }
+
+        /* Larger than a chunk gets a chunk of its own */
+        big = ls_arena_alloc(arena, 10000);
+        fail_if(!big, "Failed to allocate oversized block");
+        memset(big, 'x', 10000);
+
+        /* Fill several chunks */
+        for (int i = 0; i < 1000; i++) {
+                char *p = ls_arena_alloc(arena, 48);
+                fail_if(!p, "Failed to allocate");
+                memset(p, i & 0xff, 48);
+        }
+
+        ls_arena_free(arena);
+}
+END_TEST
+
+START_TEST(test_arena_rewind)
+{
+        LsArena *arena = NULL;
+        LsArenaSavepoint empty;
+        LsArenaSavepoint mark;
+        char *first = NULL;
+        char *before = NULL;
+        char *after = NULL;
+
+        arena = ls_arena_new(256);
+        fail_if(!arena, "Failed to construct arena");
+
+        empty = ls_arena_save(arena);
+        first = ls_arena_alloc(arena, 32);
+        fail_if(!first, "Failed to allocate");
+        strcpy(first, "persistent");
+
+        mark = ls_arena_save(arena);
+        before = ls_arena_alloc(arena, 64);
+        fail_if(!before, "Failed to allocate");
+
+        /* Spill into further chunks, then rewind back across them */
+        for (int i = 0; i < 100; i++) {
+                fail_if(!ls_arena_alloc(arena, 64), "Failed to allocate");
+        }
+        ls_arena_rewind(arena, mark);
+        after = ls_arena_alloc(arena, 64);
+        fail_if(after != before, "Rewind should reuse the same memory");
+        fail_if(strcmp(first, "persistent") != 0, "Rewind clobbered earlier data");
+
+        /* Rewinding to before the first allocation is a reset */
+        ls_arena_rewind(arena, empty);
+        fail_if(ls_arena_alloc(arena, 32) != first, "Reset should start from the beginning");
+
+        /* Reset reuses every chunk without allocating */
+        for (int round = 0; round < 3; round++) {
+                ls_arena_reset(arena);
+                fail_if(ls_arena_alloc(arena, 32) != first, "Reset should reuse the first chunk");
+                for (int i = 0; i < 100; i++) {
+                        fail_if(!ls_arena_alloc(arena, 64), "Failed to allocate");
+                }
+        }
+
+        ls_arena_free(arena);
+}
+END_TEST
+
+START_TEST(test_arena_realloc)
+{
+        LsArena *arena = NULL;
+        char *p = NULL;
+        char *q = NULL;
+        char *r = NULL;
+
+        arena = ls_arena_new(1024);
+        fail_if(!arena, "Failed to construct arena");
+
+        p = ls_arena_realloc(arena, NULL, 0, 16);
+        fail_if(!p, "Failed to allocate through realloc");
+        memcpy(p, "0123456789abcdef", 16);
+
+        /* The last allocation grows in place */
+        q = ls_arena_realloc(arena, p, 16, 64);
+        fail_if(q != p, "Last allocation should grow in place");
+
+        /* Anything else moves */
+        r = ls_arena_alloc(arena, 8);
+        fail_if(!r, "Failed to allocate");
+        q = ls_arena_realloc(arena, p, 64, 128);
+        fail_if(!q || q == p, "Earlier allocation should move");
+        fail_if(memcmp(q, "0123456789abcdef", 16) != 0, "Contents lost on move");
+
+        /* Growing past the chunk moves too */
+        p = ls_arena_realloc(arena, q, 128, 4096);
+        fail_if(!p || memcmp(p, "0123456789abcdef", 16) != 0, "Contents lost on big move");
+
+        ls_arena_free(arena);
+}
+END_TEST
+
+START_TEST(test_arena_containers)
+{
+        LsArena *arena = NULL;
+        LsArray *array = NULL;
+        LsList *list = NULL;
+        LsHashmap *map = NULL;
+        char *key = NULL;
+
+        arena = ls_arena_new(0);
+        fail_if(!arena, "Failed to construct arena");
+
+        /* Simulate loading a few levels, each released in one go */
+        for (int level = 0; level < 3; level++) {
+                array = ls_array_new_arena(arena, sizeof(void *), 4);
+                fail_if(!array, "Failed to construct arena array");
+                for (uintptr_t i = 0; i < 1000; i++) {
+                        fail_if(!ls_array_add(array, (void *)(i + 1)), "Failed to add");
+                }
+                fail_if(array->len != 1000, "Array should hold 1000 items");
+                fail_if((uintptr_t)array->data[999] != 1000, "Array item lost on growth");
+
+                list = NULL;
+                for (uintptr_t i = 0; i < 100; i++) {
+                        list = ls_list_prepend_arena(arena, list, (void *)i);
+                        fail_if(!list, "Failed to prepend");
+                }
+                list = ls_list_append_arena(arena, list, (void *)100);
+                fail_if(ls_list_length(list) != 101, "List should hold 101 items");
+
+                map = ls_hashmap_new_arena(arena, ls_hashmap_string_hash, ls_hashmap_string_equal);
+                fail_if(!map, "Failed to construct arena map");
+
+                /* Enough to force resizes and chained nodes */
+                for (int i = 0; i < 2000; i++) {
+                        key = ls_arena_alloc(arena, 16);
+                        fail_if(!key, "Failed to allocate key");
+                        snprintf(key, 16, "key-%d", i);
+                        fail_if(!ls_hashmap_put(map, key, key), "Failed to put");
+                }
+                fail_if(strcmp(ls_hashmap_get(map, "key-1234"), "key-1234") != 0, "Lookup failed");
+                fail_if(!ls_hashmap_remove(map, "key-1234"), "Failed to remove");
+
+                /* These never free, so ASAN would catch any stray free() */
+                ls_array_free(array, NULL);
+                ls_hashmap_free(map);
+                ls_arena_reset(arena);
+        }
+
+        ls_arena_free(arena);
+}
+END_TEST
+
+/**
+ * Standard helper for running a test suite
+ */
+static int ls_test_run(Suite *suite)
+{
+        SRunner *runner = NULL;
+        int n_failed = 0;
+
+        runner = srunner_create(suite);
+        srunner_run_all(runner, CK_VERBOSE);
+        n_failed = srunner_ntests_failed(runner);
+        srunner_free(runner);
+
+        return n_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static Suite *test_create(void)
+{
+        Suite *s = NULL;
+        TCase *tc = NULL;
+
+        s = suite_create(__FILE__);
+        tc = tcase_create(__FILE__);
+        suite_add_tcase(s, tc);
+
+        tcase_add_test(tc, test_arena_alloc);
+        tcase_add_test(tc, test_arena_rewind);
+        tcase_add_test(tc, test_arena_realloc);
+        tcase_add_test(tc, test_arena_containers);
+        return s;
+}
+
+int main(__attribute__((unused)) int argc, __attribute__((unused)) char **argv)
+{
+        return ls_test_run(test_create());
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -24,6 +24,7 @@
 #define _GNU_SOURCE
 
 #include <check.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -95,6 +96,186 @@ START_TEST(test_ptr_array_simple_add)
 }
 END_TEST
 
+START_TEST(test_array_memory_usage)
+{
+        LsArray *array = NULL;
+        LsMemoryUsage usage = { 0 };
+        LsMemoryCounters before = { 0 };
+        LsMemoryCounters during = { 0 };
+        LsMemoryCounters after = { 0 };
+        bool have_counters = ls_memory_counters(LS_MEMORY_TYPE_ARRAY, &before);
+
+        array = ls_array_new_size(sizeof(void *), 10);
+        fail_if(!array, "Failed to construct array");
+        for (int i = 0; i < 3; i++) {
+                fail_if(!ls_array_add(array, LS_INT_TO_PTR(i + 1)), "Failed to add to array");
+        }
+
+        fail_if(!ls_array_memory_usage(array, &usage), "Failed to collect memory usage");
+        fail_if(usage.used != 3 * sizeof(void *), "Incorrect used bytes");
+        fail_if(usage.reserved != 10 * sizeof(void *), "Slack capacity not reported");
+        fail_if(usage.overhead != sizeof(LsArray), "Incorrect overhead");
+        fail_if(ls_array_memory_usage(NULL, &usage), "Collected usage for a NULL array");
+
+        if (have_counters) {
+                fail_if(!ls_memory_counters(LS_MEMORY_TYPE_ARRAY, &during), "Lost counters");
+                fail_if(during.live_bytes - before.live_bytes != usage.reserved + usage.overhead,
+                        "Live bytes do not match the array footprint");
+                fail_if(during.peak_bytes < during.live_bytes, "High-water mark too low");
+                fail_if(during.n_allocs - before.n_allocs != 2, "Incorrect allocation count");
+        }
+
+        ls_array_free(array, NULL);
+
+        if (have_counters) {
+                fail_if(!ls_memory_counters(LS_MEMORY_TYPE_ARRAY, &after), "Lost counters");
+                fail_if(after.live_bytes != before.live_bytes, "Freed array still counted");
+                fail_if(after.peak_bytes < during.live_bytes, "High-water mark was lost");
+                fail_if(after.n_frees - before.n_frees != 2, "Incorrect free count");
+        }
+}
+END_TEST
+
+#define TEST_N_SPRITES 60000
+
+typedef struct TestSprite {
+        int id;
+        int x;
+        bool visible;
+} TestSprite;
+
+typedef struct TestBounds {
+        long sum;
+        int min_x;
+        int max_x;
+        int n_items;
+} TestBounds;
+
+static void test_sprite_move(void *item, __ls_unused__ void *user_data)
+{
+        TestSprite *sprite = item;
+
+        sprite->x += 10;
+        sprite->visible = sprite->x % 3 == 0;
+}
+
+static void test_sprite_bounds(void *accumulator, void *item, __ls_unused__ void *user_data)
+{
+        TestBounds *bounds = accumulator;
+        TestSprite *sprite = item;
+
+        bounds->sum += sprite->id;
+        bounds->min_x = sprite->x < bounds->min_x ? sprite->x : bounds->min_x;
+        bounds->max_x = sprite->x > bounds->max_x ? sprite->x : bounds->max_x;
+        ++bounds->n_items;
+}
+
+static void test_bounds_combine(void *accumulator, const void *partial,
+                                __ls_unused__ void *user_data)
+{
+        TestBounds *bounds = accumulator;
+        const TestBounds *other = partial;
+
+        bounds->sum += other->sum;
+        bounds->min_x = other->min_x < bounds->min_x ? other->min_x : bounds->min_x;
+        bounds->max_x = other->max_x > bounds->max_x ? other->max_x : bounds->max_x;
+        bounds->n_items += other->n_items;
+}
+
+static bool test_sprite_visible(void *item, __ls_unused__ void *user_data)
+{
+        return ((TestSprite *)item)->visible;
+}
+
+START_TEST(test_array_parallel)
+{
+        TestSprite *sprites = calloc(TEST_N_SPRITES, sizeof(TestSprite));
+        LsJobSystem *system = ls_job_system_new(4);
+        LsJobSystem *systems[] = { NULL, system };
+        const size_t grains[] = { 0, 1, 1000 };
+        LsArray *array = ls_array_new_size(sizeof(void *), TEST_N_SPRITES);
+        LsArray *empty = ls_array_new(sizeof(void *));
+        LsArray *visible = NULL;
+
+        fail_if(!sprites || !system || !array || !empty, "Failed to construct array");
+
+        for (int i = 0; i < TEST_N_SPRITES; i++) {
+                sprites[i].id = i;
+                sprites[i].x = i;
+                fail_if(!ls_array_add(array, &sprites[i]), "Failed to add to array");
+        }
+
+        for (size_t s = 0; s < LS_ARRAY_SIZE(systems); s++) {
+                for (size_t g = 0; g < LS_ARRAY_SIZE(grains); g++) {
+                        TestBounds bounds = { 0, INT32_MAX, INT32_MIN, 0 };
+                        int expected = 0;
+
+                        fail_if(!ls_array_parallel_foreach(systems[s],
+                                                           array,
+                                                           grains[g],
+                                                           test_sprite_move,
+                                                           NULL),
+                                "Failed to run foreach");
+                        fail_if(sprites[0].x != sprites[0].id + 10 * (int)(s * 3 + g + 1),
+                                "Foreach missed the first item");
+
+                        fail_if(!ls_array_parallel_reduce(systems[s],
+                                                          array,
+                                                          grains[g],
+                                                          &bounds,
+                                                          sizeof(bounds),
+                                                          test_sprite_bounds,
+                                                          test_bounds_combine,
+                                                          NULL),
+                                "Failed to run reduce");
+                        fail_if(bounds.n_items != TEST_N_SPRITES, "Reduce missed items");
+                        fail_if(bounds.sum != (long)TEST_N_SPRITES * (TEST_N_SPRITES - 1) / 2,
+                                "Incorrect reduced sum");
+                        fail_if(bounds.min_x != sprites[0].x, "Incorrect reduced minimum");
+                        fail_if(bounds.max_x != sprites[TEST_N_SPRITES - 1].x,
+                                "Incorrect reduced maximum");
+
+                        visible = ls_array_parallel_filter(systems[s],
+                                                           array,
+                                                           grains[g],
+                                                           test_sprite_visible,
+                                                           NULL);
+                        fail_if(!visible, "Failed to run filter");
+                        fail_if(visible->item_size != array->item_size, "Wrong item size");
+
+                        /* Survivors must come out in their original order */
+                        for (int i = 0; i < TEST_N_SPRITES; i++) {
+                                if (!sprites[i].visible) {
+                                        continue;
+                                }
+                                fail_if(expected >= visible->len, "Too few survivors");
+                                fail_if(visible->data[expected] != &sprites[i],
+                                        "Survivor out of order");
+                                ++expected;
+                        }
+                        fail_if(expected != visible->len, "Too many survivors");
+                        ls_array_free(visible, NULL);
+                }
+        }
+
+        /* Empty arrays and bad arguments */
+        fail_if(!ls_array_parallel_foreach(system, empty, 0, test_sprite_move, NULL),
+                "Failed to run foreach on an empty array");
+        visible = ls_array_parallel_filter(system, empty, 0, test_sprite_visible, NULL);
+        fail_if(!visible || visible->len != 0, "Failed to filter an empty array");
+        ls_array_free(visible, NULL);
+        fail_if(ls_array_parallel_foreach(system, NULL, 0, test_sprite_move, NULL),
+                "Ran foreach on a NULL array");
+        fail_if(ls_array_parallel_reduce(system, array, 0, NULL, 0, NULL, NULL, NULL),
+                "Ran reduce without a result");
+
+        ls_array_free(empty, NULL);
+        ls_array_free(array, NULL);
+        ls_job_system_free(system);
+        free(sprites);
+}
+END_TEST
+
 /**
  * Standard helper for running a test suite
  */
@@ -122,6 +303,8 @@ static Suite *test_create(void)
 
         tcase_add_test(tc, test_array_simple_add);
         tcase_add_test(tc, test_ptr_array_simple_add);
+        tcase_add_test(tc, test_array_memory_usage);
+        tcase_add_test(tc, test_array_parallel);
 
         return s;
 }
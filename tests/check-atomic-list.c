@@ -0,0 +1,285 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <check.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "atomic-list.h"
+
+#define TEST_PRODUCERS 4
+#define TEST_CONSUMERS 4
+#define TEST_ITEMS_PER_PRODUCER 20000
+#define TEST_ITEMS (TEST_PRODUCERS * TEST_ITEMS_PER_PRODUCER)
+
+/**
+ * Shared state for the threaded test
+ */
+typedef struct TestShared {
+        LsAtomicList *list;
+        _Atomic unsigned int popped;
+        _Atomic unsigned char seen[TEST_ITEMS];
+        _Atomic bool failed;
+} TestShared;
+
+static TestShared test_shared;
+
+START_TEST(test_atomic_list_simple)
+{
+        LsAtomicList *list = NULL;
+        void *data = NULL;
+
+        list = ls_atomic_list_new();
+        fail_if(!list, "Failed to construct list");
+        fail_if(!ls_atomic_list_is_empty(list), "New list should be empty");
+        fail_if(ls_atomic_list_pop(list, &data), "Empty list should not pop");
+
+        for (uintptr_t i = 1; i <= 100; i++) {
+                fail_if(!ls_atomic_list_push(list, (void *)i), "Failed to push");
+        }
+        fail_if(ls_atomic_list_is_empty(list), "List should not be empty");
+
+        /* LIFO order */
+        for (uintptr_t i = 100; i >= 1; i--) {
+                fail_if(!ls_atomic_list_pop(list, &data), "Failed to pop");
+                fail_if((uintptr_t)data != i, "Popped wrong item");
+        }
+        fail_if(ls_atomic_list_pop(list, &data), "Drained list should not pop");
+        fail_if(!ls_atomic_list_is_empty(list), "Drained list should be empty");
+
+        ls_atomic_list_free(list);
+}
+END_TEST
+
+START_TEST(test_atomic_list_take_all)
+{
+        LsAtomicList *list = NULL;
+        LsList *chain = NULL;
+        uintptr_t expect = 1;
+
+        list = ls_atomic_list_new();
+        fail_if(!list, "Failed to construct list");
+        fail_if(ls_atomic_list_take_all(list) != NULL, "Empty take_all should be NULL");
+
+        for (uintptr_t i = 1; i <= 50; i++) {
+                fail_if(!ls_atomic_list_push(list, (void *)i), "Failed to push");
+        }
+
+        chain = ls_atomic_list_take_all(list);
+        fail_if(!ls_atomic_list_is_empty(list), "List should be empty after take_all");
+        fail_if(ls_list_length(chain) != 50, "Chain should hold every item");
+
+        /* Reversed back into push order */
+        chain = ls_list_reverse(chain);
+        for (LsList *node = chain; node; node = node->next) {
+                fail_if((uintptr_t)node->data != expect, "Chain out of order");
+                ++expect;
+        }
+        ls_list_free(chain);
+
+        /* Still usable afterwards */
+        fail_if(!ls_atomic_list_push(list, (void *)7), "Failed to push after take_all");
+        ls_atomic_list_free(list);
+}
+END_TEST
+
+static void *test_atomic_list_produce(void *userdata)
+{
+        uintptr_t base = (uintptr_t)userdata * TEST_ITEMS_PER_PRODUCER;
+
+        for (uintptr_t i = 0; i < TEST_ITEMS_PER_PRODUCER; i++) {
+                if (!ls_atomic_list_push(test_shared.list, (void *)(base + i + 1))) {
+                        test_shared.failed = true;
+                }
+        }
+        return NULL;
+}
+
+static void *test_atomic_list_consume(__ls_unused__ void *userdata)
+{
+        void *data = NULL;
+
+        while (test_shared.popped < TEST_ITEMS) {
+                if (!ls_atomic_list_pop(test_shared.list, &data)) {
+                        continue;
+                }
+                /* Every item must be seen exactly once */
+                if (test_shared.seen[(uintptr_t)data - 1]++ != 0) {
+                        test_shared.failed = true;
+                }
+                ++test_shared.popped;
+        }
+        return NULL;
+}
+
+START_TEST(test_atomic_list_threaded)
+{
+        pthread_t producers[TEST_PRODUCERS];
+        pthread_t consumers[TEST_CONSUMERS];
+
+        memset(&test_shared, 0, sizeof(test_shared));
+        test_shared.list = ls_atomic_list_new();
+        fail_if(!test_shared.list, "Failed to construct list");
+
+        for (uintptr_t i = 0; i < TEST_CONSUMERS; i++) {
+                fail_if(pthread_create(&consumers[i], NULL, test_atomic_list_consume, NULL) != 0,
+                        "Failed to start consumer");
+        }
+        for (uintptr_t i = 0; i < TEST_PRODUCERS; i++) {
+                fail_if(pthread_create(&producers[i],
+                                       NULL,
+                                       test_atomic_list_produce,
+                                       (void *)i) != 0,
+                        "Failed to start producer");
+        }
+
+        for (size_t i = 0; i < TEST_PRODUCERS; i++) {
+                pthread_join(producers[i], NULL);
+        }
+        for (size_t i = 0; i < TEST_CONSUMERS; i++) {
+                pthread_join(consumers[i], NULL);
+        }
+
+        fail_if(test_shared.failed, "Items were lost or duplicated");
+        fail_if(test_shared.popped != TEST_ITEMS, "Not every item was popped");
+        fail_if(!ls_atomic_list_is_empty(test_shared.list), "List should be drained");
+
+        ls_atomic_list_free(test_shared.list);
+}
+END_TEST
+
+START_TEST(test_atomic_list_free_full)
+{
+        LsAtomicList *list = NULL;
+        void *data = NULL;
+
+        list = ls_atomic_list_new();
+        fail_if(!list, "Failed to construct list");
+
+        for (int i = 0; i < 10; i++) {
+                fail_if(!ls_atomic_list_push(list, strdup("atomic")), "Failed to push");
+        }
+        fail_if(!ls_atomic_list_pop(list, &data), "Failed to pop");
+        free(data);
+
+        /* ASAN will complain about any leaked strings */
+        ls_atomic_list_free_full(list, free);
+}
+END_TEST
+
+/**
+ * Nodes are freed through ls_list_free after take_all, so with stats
+ * enabled every push must be accounted to balance those frees
+ */
+START_TEST(test_atomic_list_memory_counters)
+{
+        LsAtomicList *list = NULL;
+        LsList *taken = NULL;
+        LsMemoryCounters before = { 0 };
+        LsMemoryCounters after = { 0 };
+        void *data = NULL;
+
+        if (!ls_memory_counters(LS_MEMORY_TYPE_LIST, &before)) {
+                return;
+        }
+
+        list = ls_atomic_list_new();
+        fail_if(!list, "Failed to construct atomic list");
+
+        for (int cycle = 0; cycle < 10; cycle++) {
+                for (int i = 0; i < 8; i++) {
+                        fail_if(!ls_atomic_list_push(list, LS_INT_TO_PTR(i + 1)), "Failed to push");
+                }
+                taken = ls_atomic_list_take_all(list);
+                fail_if(ls_list_length(taken) != 8, "Incorrect take_all length");
+                ls_list_free(taken);
+        }
+
+        /* Popped nodes and those left for free_full must balance too */
+        for (int i = 0; i < 8; i++) {
+                fail_if(!ls_atomic_list_push(list, LS_INT_TO_PTR(i + 1)), "Failed to push");
+        }
+        fail_if(!ls_atomic_list_pop(list, &data), "Failed to pop");
+        ls_atomic_list_free(list);
+
+        fail_if(!ls_memory_counters(LS_MEMORY_TYPE_LIST, &after), "Lost counters");
+        fail_if(after.live_bytes != before.live_bytes, "Atomic list nodes still counted");
+        fail_if(after.n_allocs - before.n_allocs != 88, "Incorrect allocation count");
+        fail_if(after.n_frees - before.n_frees != 88, "Incorrect free count");
+}
+END_TEST
+
+/**
+ * Standard helper for running a test suite
+ */
+static int ls_test_run(Suite *suite)
+{
+        SRunner *runner = NULL;
+        int n_failed = 0;
+
+        runner = srunner_create(suite);
+        srunner_run_all(runner, CK_VERBOSE);
+        n_failed = srunner_ntests_failed(runner);
+        srunner_free(runner);
+
+        return n_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static Suite *test_create(void)
+{
+        Suite *s = NULL;
+        TCase *tc = NULL;
+
+        s = suite_create(__FILE__);
+        tc = tcase_create(__FILE__);
+        suite_add_tcase(s, tc);
+
+        tcase_add_test(tc, test_atomic_list_simple);
+        tcase_add_test(tc, test_atomic_list_take_all);
+        tcase_add_test(tc, test_atomic_list_threaded);
+        tcase_add_test(tc, test_atomic_list_free_full);
+        tcase_add_test(tc, test_atomic_list_memory_counters);
+        return s;
+}
+
+int main(__attribute__((unused)) int argc, __attribute__((unused)) char **argv)
+{
+        return ls_test_run(test_create());
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
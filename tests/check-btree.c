@@ -0,0 +1,319 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <check.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "btree.h"
+
+#define TEST_KEY_SPACE 50000
+
+/**
+ * Fixed size record used for bulk loading, key first
+ */
+typedef struct TestRecord {
+        uint64_t key;
+        uint32_t value;
+} __attribute__((packed)) TestRecord;
+
+/**
+ * Walk the tree and confirm it matches the model exactly, in order
+ */
+static bool test_btree_matches(LsBTree *tree, const uint32_t *model, const bool *present)
+{
+        LsBTreeIter iter = { 0 };
+        const void *key = NULL;
+        void *value = NULL;
+        uint64_t k = 0;
+        uint32_t v = 0;
+        uint64_t next = 0;
+        size_t n = 0;
+
+        ls_btree_iter_init(tree, &iter);
+        while (ls_btree_iter_next(&iter, &key, &value)) {
+                memcpy(&k, key, sizeof(k));
+                memcpy(&v, value, sizeof(v));
+
+                /* Every key we skipped over must be absent */
+                for (; next < k; next++) {
+                        if (present[next]) {
+                                return false;
+                        }
+                }
+                if (k >= TEST_KEY_SPACE || !present[k] || model[k] != v) {
+                        return false;
+                }
+                next = k + 1;
+                ++n;
+        }
+        for (; next < TEST_KEY_SPACE; next++) {
+                if (present[next]) {
+                        return false;
+                }
+        }
+
+        return n == ls_btree_size(tree);
+}
+
+START_TEST(test_btree_simple)
+{
+        LsBTree *tree = NULL;
+        uint64_t key = 42;
+        uint32_t value = 7;
+        uint32_t *found = NULL;
+
+        fail_if(ls_btree_new(4, 4, NULL) != NULL, "Native keys must be 64-bit");
+        fail_if(ls_btree_new(8, 4096, NULL) != NULL, "Oversized values should be refused");
+
+        tree = ls_btree_new(sizeof(uint64_t), sizeof(uint32_t), NULL);
+        fail_if(!tree, "Failed to construct tree");
+        fail_if(ls_btree_size(tree) != 0, "New tree should be empty");
+        fail_if(ls_btree_get(tree, &key) != NULL, "Empty tree should not find keys");
+        fail_if(ls_btree_remove(tree, &key), "Empty tree should not remove keys");
+
+        fail_if(!ls_btree_put(tree, &key, &value), "Failed to put");
+        found = ls_btree_get(tree, &key);
+        fail_if(!found || *found != 7, "Failed to get stored value");
+
+        value = 8;
+        fail_if(!ls_btree_put(tree, &key, &value), "Failed to replace");
+        fail_if(ls_btree_size(tree) != 1, "Replace should not change size");
+        found = ls_btree_get(tree, &key);
+        fail_if(!found || *found != 8, "Value was not replaced");
+
+        fail_if(!ls_btree_remove(tree, &key), "Failed to remove");
+        fail_if(ls_btree_get(tree, &key) != NULL, "Removed key still present");
+        fail_if(ls_btree_size(tree) != 0, "Tree should be empty again");
+
+        ls_btree_free(tree);
+}
+END_TEST
+
+START_TEST(test_btree_random)
+{
+        LsBTree *tree = NULL;
+        LsBTreeIter iter = { 0 };
+        uint32_t *model = NULL;
+        bool *present = NULL;
+        const void *key = NULL;
+        uint64_t k;
+
+        tree = ls_btree_new(sizeof(uint64_t), sizeof(uint32_t), NULL);
+        model = calloc(TEST_KEY_SPACE, sizeof(uint32_t));
+        present = calloc(TEST_KEY_SPACE, sizeof(bool));
+        fail_if(!tree || !model || !present, "Failed to allocate");
+
+        /* Grow to several levels, then churn until splits and merges interleave */
+        srand(1234);
+        for (uint32_t i = 0; i < 300000; i++) {
+                k = (uint64_t)rand() % TEST_KEY_SPACE;
+                if (i < 100000 || rand() % 2 == 0) {
+                        fail_if(!ls_btree_put(tree, &k, &i), "Failed to put");
+                        model[k] = i;
+                        present[k] = true;
+                } else {
+                        fail_if(ls_btree_remove(tree, &k) != present[k], "Remove mismatch");
+                        present[k] = false;
+                }
+        }
+        fail_if(!test_btree_matches(tree, model, present), "Tree diverged from the model");
+
+        /* Lower bound lands on the next present key */
+        k = TEST_KEY_SPACE / 2;
+        ls_btree_iter_init_at(tree, &k, &iter);
+        fail_if(!ls_btree_iter_next(&iter, &key, NULL), "No key past the midpoint");
+        while (!present[k]) {
+                ++k;
+        }
+        fail_if(memcmp(key, &k, sizeof(k)) != 0, "Lower bound is wrong");
+
+        /* Drain completely, which collapses every level */
+        for (k = 0; k < TEST_KEY_SPACE; k++) {
+                fail_if(ls_btree_remove(tree, &k) != present[k], "Drain mismatch");
+                present[k] = false;
+        }
+        fail_if(ls_btree_size(tree) != 0, "Drained tree should be empty");
+        fail_if(!test_btree_matches(tree, model, present), "Drained tree not empty");
+
+        free(model);
+        free(present);
+        ls_btree_free(tree);
+}
+END_TEST
+
+/**
+ * Order fixed size, NUL padded, string keys
+ */
+static int test_btree_name_compare(const void *a, const void *b)
+{
+        return strncmp(a, b, 16);
+}
+
+START_TEST(test_btree_compare)
+{
+        LsBTree *tree = NULL;
+        LsBTreeIter iter = { 0 };
+        char name[16];
+        char last[16] = { 0 };
+        const void *key = NULL;
+        int n = 0;
+
+        tree = ls_btree_new(sizeof(name), 0, test_btree_name_compare);
+        fail_if(!tree, "Failed to construct tree");
+
+        for (int i = 0; i < 5000; i++) {
+                memset(name, 0, sizeof(name));
+                snprintf(name, sizeof(name), "entity-%d", (i * 7919) % 5000);
+                fail_if(!ls_btree_put(tree, name, NULL), "Failed to put");
+        }
+        fail_if(ls_btree_size(tree) != 5000, "Size should be 5000");
+
+        memset(name, 0, sizeof(name));
+        snprintf(name, sizeof(name), "entity-42");
+        fail_if(!ls_btree_get(tree, name), "Failed to find key");
+
+        ls_btree_iter_init(tree, &iter);
+        while (ls_btree_iter_next(&iter, &key, NULL)) {
+                fail_if(n > 0 && strncmp(last, key, 16) >= 0, "Keys out of order");
+                memcpy(last, key, sizeof(last));
+                ++n;
+        }
+        fail_if(n != 5000, "Iteration missed keys");
+
+        ls_btree_free(tree);
+}
+END_TEST
+
+START_TEST(test_btree_bulk_load)
+{
+        LsBTree *tree = NULL;
+        LsArray *array = NULL;
+        TestRecord *records = NULL;
+        uint32_t *model = NULL;
+        bool *present = NULL;
+        uint32_t value = 0;
+        uint64_t k;
+
+        tree = ls_btree_new(sizeof(uint64_t), sizeof(uint32_t), NULL);
+        array = ls_array_new_size(sizeof(TestRecord), TEST_KEY_SPACE / 2);
+        records = calloc(TEST_KEY_SPACE / 2, sizeof(TestRecord));
+        model = calloc(TEST_KEY_SPACE, sizeof(uint32_t));
+        present = calloc(TEST_KEY_SPACE, sizeof(bool));
+        fail_if(!tree || !array || !records || !model || !present, "Failed to allocate");
+
+        /* Even keys only, already sorted */
+        for (uint32_t i = 0; i < TEST_KEY_SPACE / 2; i++) {
+                records[i].key = i * 2;
+                records[i].value = i;
+                model[i * 2] = i;
+                present[i * 2] = true;
+                fail_if(!ls_array_add(array, &records[i]), "Failed to add record");
+        }
+
+        fail_if(!ls_btree_bulk_load(tree, array), "Failed to bulk load");
+        fail_if(ls_btree_size(tree) != TEST_KEY_SPACE / 2, "Bulk load size mismatch");
+        fail_if(!test_btree_matches(tree, model, present), "Bulk loaded tree mismatch");
+        fail_if(ls_btree_bulk_load(tree, array), "Bulk load into a full tree should fail");
+
+        /* Packed nodes must still split and merge correctly */
+        for (k = 1; k < TEST_KEY_SPACE; k += 4) {
+                value = (uint32_t)k;
+                fail_if(!ls_btree_put(tree, &k, &value), "Failed to put after bulk load");
+                model[k] = value;
+                present[k] = true;
+        }
+        for (k = 0; k < TEST_KEY_SPACE; k += 3) {
+                fail_if(ls_btree_remove(tree, &k) != present[k], "Remove mismatch");
+                present[k] = false;
+        }
+        fail_if(!test_btree_matches(tree, model, present), "Mutated tree mismatch");
+        ls_btree_free(tree);
+
+        /* Unsorted input is refused */
+        tree = ls_btree_new(sizeof(uint64_t), sizeof(uint32_t), NULL);
+        fail_if(!tree, "Failed to construct tree");
+        records[10].key = 0;
+        fail_if(ls_btree_bulk_load(tree, array), "Unsorted bulk load should fail");
+        fail_if(ls_btree_size(tree) != 0, "Failed bulk load should leave tree empty");
+        ls_btree_free(tree);
+
+        ls_array_free(array, NULL);
+        free(records);
+        free(model);
+        free(present);
+}
+END_TEST
+
+/**
+ * Standard helper for running a test suite
+ */
+static int ls_test_run(Suite *suite)
+{
+        SRunner *runner = NULL;
+        int n_failed = 0;
+
+        runner = srunner_create(suite);
+        srunner_run_all(runner, CK_VERBOSE);
+        n_failed = srunner_ntests_failed(runner);
+        srunner_free(runner);
+
+        return n_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static Suite *test_create(void)
+{
+        Suite *s = NULL;
+        TCase *tc = NULL;
+
+        s = suite_create(__FILE__);
+        tc = tcase_create(__FILE__);
+        suite_add_tcase(s, tc);
+
+        tcase_add_test(tc, test_btree_simple);
+        tcase_add_test(tc, test_btree_random);
+        tcase_add_test(tc, test_btree_compare);
+        tcase_add_test(tc, test_btree_bulk_load);
+        return s;
+}
+
+int main(__attribute__((unused)) int argc, __attribute__((unused)) char **argv)
+{
+        return ls_test_run(test_create());
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,229 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "dlist.h"
+#include "macros.h"
+
+/**
+ * Object embedding its own list membership
+ */
+typedef struct TestTimer {
+        int id;
+        LsDListNode link;
+} TestTimer;
+
+/**
+ * Compare the list against the expected sequence of ids
+ */
+static bool test_dlist_matches(LsDList *list, const int *ids, size_t n_ids)
+{
+        LsDListNode *node = NULL;
+        size_t i = 0;
+
+        ls_dlist_foreach(list, node) {
+                if (i >= n_ids || ls_dlist_entry(node, TestTimer, link)->id != ids[i]) {
+                        return false;
+                }
+                ++i;
+        }
+        if (i != n_ids) {
+                return false;
+        }
+
+        /* Walk backwards too to validate prev links */
+        ls_dlist_foreach_reverse(list, node) {
+                if (ls_dlist_entry(node, TestTimer, link)->id != ids[--i]) {
+                        return false;
+                }
+        }
+
+        return true;
+}
+
+START_TEST(test_dlist_simple)
+{
+        LsDList list = LS_DLIST_INIT(list);
+        TestTimer timers[4] = { { .id = 0 }, { .id = 1 }, { .id = 2 }, { .id = 3 } };
+        const int expected[] = { 2, 0, 3, 1 };
+        const int removed[] = { 2, 3 };
+
+        fail_if(!ls_dlist_is_empty(&list), "New list should be empty");
+        fail_if(ls_dlist_first(&list) != NULL, "Empty list has a first node");
+
+        for (size_t i = 0; i < LS_ARRAY_SIZE(timers); i++) {
+                ls_dlist_node_init(&timers[i].link);
+                fail_if(ls_dlist_node_is_linked(&timers[i].link), "Node should be unlinked");
+        }
+
+        ls_dlist_push_back(&list, &timers[0].link);
+        ls_dlist_push_back(&list, &timers[1].link);
+        ls_dlist_push_front(&list, &timers[2].link);
+        ls_dlist_insert_before(&timers[1].link, &timers[3].link);
+
+        fail_if(!test_dlist_matches(&list, expected, LS_ARRAY_SIZE(expected)), "Bad list order");
+        fail_if(ls_dlist_length(&list) != 4, "Incorrect list length");
+        fail_if(ls_dlist_entry(ls_dlist_first(&list), TestTimer, link) != &timers[2],
+                "Incorrect first entry");
+        fail_if(ls_dlist_entry(ls_dlist_last(&list), TestTimer, link) != &timers[1],
+                "Incorrect last entry");
+
+        /* Unlink from the middle and the end */
+        ls_dlist_unlink(&timers[0].link);
+        fail_if(ls_dlist_pop_back(&list) != &timers[1].link, "Incorrect pop from back");
+        fail_if(ls_dlist_node_is_linked(&timers[0].link), "Unlinked node still linked");
+        ls_dlist_unlink(&timers[0].link);
+        fail_if(!test_dlist_matches(&list, removed, LS_ARRAY_SIZE(removed)), "Bad list order");
+
+        fail_if(ls_dlist_pop_front(&list) != &timers[2].link, "Incorrect pop from front");
+        fail_if(ls_dlist_pop_front(&list) != &timers[3].link, "Incorrect pop from front");
+        fail_if(ls_dlist_pop_front(&list) != NULL, "Popped from an empty list");
+        fail_if(!ls_dlist_is_empty(&list), "List should be empty");
+}
+END_TEST
+
+START_TEST(test_dlist_move_splice)
+{
+        LsDList a = { 0 };
+        LsDList b = { 0 };
+        TestTimer timers[6] = { { .id = 0 }, { .id = 1 }, { .id = 2 },
+                                { .id = 3 }, { .id = 4 }, { .id = 5 } };
+        const int moved[] = { 2, 0, 1 };
+        const int spliced_back[] = { 2, 0, 1, 3, 4 };
+        const int spliced_front[] = { 5, 2, 0, 1, 3, 4 };
+
+        ls_dlist_init(&a);
+        ls_dlist_init(&b);
+
+        for (size_t i = 0; i < 3; i++) {
+                ls_dlist_push_back(&a, &timers[i].link);
+                ls_dlist_push_back(&b, &timers[i + 3].link);
+        }
+
+        ls_dlist_move_to_front(&a, &timers[2].link);
+        fail_if(!test_dlist_matches(&a, moved, LS_ARRAY_SIZE(moved)), "Bad order after move");
+
+        /* Move across lists */
+        ls_dlist_move_to_front(&a, &timers[5].link);
+        ls_dlist_move_to_back(&b, &timers[5].link);
+
+        ls_dlist_unlink(&timers[5].link);
+        ls_dlist_splice_back(&a, &b);
+        fail_if(!ls_dlist_is_empty(&b), "Splice did not empty the source");
+        fail_if(!test_dlist_matches(&a, spliced_back, LS_ARRAY_SIZE(spliced_back)),
+                "Bad order after splice");
+
+        ls_dlist_push_back(&b, &timers[5].link);
+        ls_dlist_splice_front(&a, &b);
+        fail_if(!test_dlist_matches(&a, spliced_front, LS_ARRAY_SIZE(spliced_front)),
+                "Bad order after splice");
+
+        /* Splicing an empty list must be a no-op */
+        ls_dlist_splice_back(&a, &b);
+        ls_dlist_splice_front(&a, &b);
+        fail_if(ls_dlist_length(&a) != 6, "Empty splice changed the list");
+}
+END_TEST
+
+/**
+ * Unlink every other node mid-walk
+ */
+START_TEST(test_dlist_safe_iter)
+{
+        LsDList list = LS_DLIST_INIT(list);
+        TestTimer timers[100];
+        LsDListNode *node = NULL;
+        LsDListNode *tmp = NULL;
+        int expect = 1;
+
+        for (int i = 0; i < 100; i++) {
+                timers[i].id = i;
+                ls_dlist_push_back(&list, &timers[i].link);
+        }
+
+        ls_dlist_foreach_safe(&list, node, tmp) {
+                if (ls_dlist_entry(node, TestTimer, link)->id % 2 == 0) {
+                        ls_dlist_unlink(node);
+                }
+        }
+
+        fail_if(ls_dlist_length(&list) != 50, "Incorrect length after removals");
+        ls_dlist_foreach(&list, node) {
+                fail_if(ls_dlist_entry(node, TestTimer, link)->id != expect, "Wrong node removed");
+                expect += 2;
+        }
+}
+END_TEST
+
+/**
+ * Standard helper for running a test suite
+ */
+static int ls_test_run(Suite *suite)
+{
+        SRunner *runner = NULL;
+        int n_failed = 0;
+
+        runner = srunner_create(suite);
+        srunner_run_all(runner, CK_VERBOSE);
+        n_failed = srunner_ntests_failed(runner);
+        srunner_free(runner);
+
+        return n_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static Suite *test_create(void)
+{
+        Suite *s = NULL;
+        TCase *tc = NULL;
+
+        s = suite_create(__FILE__);
+        tc = tcase_create(__FILE__);
+        suite_add_tcase(s, tc);
+
+        tcase_add_test(tc, test_dlist_simple);
+        tcase_add_test(tc, test_dlist_move_splice);
+        tcase_add_test(tc, test_dlist_safe_iter);
+        return s;
+}
+
+int main(__attribute__((unused)) int argc, __attribute__((unused)) char **argv)
+{
+        return ls_test_run(test_create());
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
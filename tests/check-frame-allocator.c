@@ -0,0 +1,180 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <check.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "frame-allocator.h"
+#include "list.h"
+#include "ptr-array.h"
+
+START_TEST(test_frame_allocator_lifetime)
+{
+        LsFrameAllocator *frame = NULL;
+        char *blocks[3] = { 0 };
+        char *reused = NULL;
+        char *zeroed = NULL;
+
+        fail_if(ls_frame_allocator_new(0, 0) != NULL, "Constructed without any frames");
+
+        frame = ls_frame_allocator_new(3, 1024);
+        fail_if(!frame, "Failed to construct frame allocator");
+        fail_if(ls_frame_allocator_frame(frame) != 0, "First frame should be 0");
+
+        /* Each of the three frames in flight gets its own region */
+        for (int i = 0; i < 3; i++) {
+                blocks[i] = ls_frame_allocator_alloc(frame, 64);
+                fail_if(!blocks[i], "Failed to allocate");
+                memset(blocks[i], 'a' + i, 64);
+                if (i < 2) {
+                        fail_if(ls_frame_allocator_next_frame(frame) != (uint64_t)i + 1,
+                                "Incorrect frame number");
+                }
+        }
+
+        /* Frames 0, 1 and 2 are all still intact */
+        for (int i = 0; i < 3; i++) {
+                for (int j = 0; j < 64; j++) {
+                        fail_if(blocks[i][j] != 'a' + i, "Live frame data was clobbered");
+                }
+        }
+
+        /* Frame 3 recycles the region from frame 0 */
+        fail_if(ls_frame_allocator_next_frame(frame) != 3, "Incorrect frame number");
+        reused = ls_frame_allocator_alloc(frame, 64);
+        fail_if(reused != blocks[0], "Frame 0 region was not recycled");
+        for (int j = 0; j < 64; j++) {
+                fail_if(blocks[1][j] != 'b' || blocks[2][j] != 'c', "Live frame data clobbered");
+        }
+
+        zeroed = ls_frame_allocator_alloc0(frame, 256);
+        fail_if(!zeroed, "Failed to allocate");
+        for (int j = 0; j < 256; j++) {
+                fail_if(zeroed[j] != 0, "Memory not zeroed");
+        }
+
+        ls_frame_allocator_free(frame);
+        ls_frame_allocator_free(NULL);
+}
+END_TEST
+
+START_TEST(test_frame_allocator_containers)
+{
+        LsFrameAllocator *frame = NULL;
+        LsPtrArray *array = NULL;
+        LsArray *items = NULL;
+        LsList *list = NULL;
+        int values[500];
+
+        frame = ls_frame_allocator_new(2, 0);
+        fail_if(!frame, "Failed to construct frame allocator");
+
+        /* Simulate a long session building transient containers per frame */
+        for (int f = 0; f < 100; f++) {
+                ls_frame_allocator_next_frame(frame);
+
+                array = ls_ptr_array_new_frame(frame, 0);
+                items = ls_array_new_frame(frame, sizeof(void *), 16);
+                fail_if(!array || !items, "Failed to construct arrays");
+                list = NULL;
+
+                for (int i = 0; i < 500; i++) {
+                        values[i] = f * 1000 + i;
+                        fail_if(!ls_array_add(array, &values[i]), "Failed to add");
+                        fail_if(!ls_array_add(items, &values[i]), "Failed to add");
+                        list = ls_list_append_frame(frame, list, &values[i]);
+                        list = ls_list_prepend_frame(frame, list, &values[i]);
+                        fail_if(!list, "Failed to build list");
+                }
+
+                fail_if(array->len != 500 || items->len != 500, "Incorrect array length");
+                fail_if(ls_list_length(list) != 1000, "Incorrect list length");
+                for (int i = 0; i < 500; i++) {
+                        fail_if(*(int *)array->data[i] != f * 1000 + i, "Bad array item");
+                        fail_if(items->data[i] != &values[i], "Bad array item");
+                }
+
+                /* Freeing is optional, and only runs the free function */
+                ls_array_free(items, NULL);
+        }
+
+        /* The previous frame's array may still be grown in this one */
+        ls_frame_allocator_next_frame(frame);
+        fail_if(!ls_array_add(array, &values[0]), "Failed to grow array across frames");
+        fail_if(array->len != 501 || *(int *)array->data[0] != 99000, "Lost data across frames");
+
+        ls_frame_allocator_free(frame);
+}
+END_TEST
+
+/**
+ * Standard helper for running a test suite
+ */
+static int ls_test_run(Suite *suite)
+{
+        SRunner *runner = NULL;
+        int n_failed = 0;
+
+        runner = srunner_create(suite);
+        srunner_run_all(runner, CK_VERBOSE);
+        n_failed = srunner_ntests_failed(runner);
+        srunner_free(runner);
+
+        return n_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static Suite *test_create(void)
+{
+        Suite *s = NULL;
+        TCase *tc = NULL;
+
+        s = suite_create(__FILE__);
+        tc = tcase_create(__FILE__);
+        suite_add_tcase(s, tc);
+
+        tcase_add_test(tc, test_frame_allocator_lifetime);
+        tcase_add_test(tc, test_frame_allocator_containers);
+        return s;
+}
+
+int main(__attribute__((unused)) int argc, __attribute__((unused)) char **argv)
+{
+        return ls_test_run(test_create());
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,239 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <check.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "heap.h"
+
+START_TEST(test_heap_simple)
+{
+        LsHeap *heap = NULL;
+        double priority = 0;
+        void *data = NULL;
+
+        fail_if(ls_heap_new_arity(1) != NULL, "Arity below 2 should be refused");
+
+        heap = ls_heap_new();
+        fail_if(!heap, "Failed to construct heap");
+        fail_if(ls_heap_size(heap) != 0, "New heap should be empty");
+        fail_if(ls_heap_peek(heap, &priority, &data), "Empty heap should not peek");
+        fail_if(ls_heap_pop(heap, &priority, &data), "Empty heap should not pop");
+
+        fail_if(ls_heap_push(heap, 3.0, "three") == LS_HEAP_INVALID_HANDLE, "Failed to push");
+        fail_if(ls_heap_push(heap, 1.0, "one") == LS_HEAP_INVALID_HANDLE, "Failed to push");
+        fail_if(ls_heap_push(heap, 2.0, "two") == LS_HEAP_INVALID_HANDLE, "Failed to push");
+        fail_if(ls_heap_size(heap) != 3, "Size should be 3");
+
+        fail_if(!ls_heap_peek(heap, &priority, &data), "Failed to peek");
+        fail_if(priority != 1.0, "Peek should see the lowest priority");
+        fail_if(ls_heap_size(heap) != 3, "Peek should not remove");
+
+        fail_if(!ls_heap_pop(heap, &priority, &data), "Failed to pop");
+        fail_if(priority != 1.0 || strcmp(data, "one") != 0, "Popped wrong entry");
+        fail_if(!ls_heap_pop(heap, NULL, &data), "Failed to pop");
+        fail_if(strcmp(data, "two") != 0, "Popped wrong entry");
+        fail_if(!ls_heap_pop(heap, NULL, &data), "Failed to pop");
+        fail_if(strcmp(data, "three") != 0, "Popped wrong entry");
+        fail_if(ls_heap_size(heap) != 0, "Heap should be empty");
+
+        ls_heap_free(heap);
+}
+END_TEST
+
+START_TEST(test_heap_order)
+{
+        static const unsigned int arities[] = { 2, 3, 4, 8 };
+
+        for (size_t a = 0; a < sizeof(arities) / sizeof(arities[0]); a++) {
+                LsHeap *heap = ls_heap_new_arity(arities[a]);
+                double last = -1.0;
+                double priority = 0;
+
+                fail_if(!heap, "Failed to construct heap");
+
+                srand(99);
+                for (int i = 0; i < 5000; i++) {
+                        fail_if(ls_heap_push(heap, (double)(rand() % 1000), NULL) ==
+                                    LS_HEAP_INVALID_HANDLE,
+                                "Failed to push");
+                }
+
+                /* Interleave pops and pushes above the popped priority */
+                for (int i = 0; i < 2500; i++) {
+                        fail_if(!ls_heap_pop(heap, &priority, NULL), "Failed to pop");
+                        fail_if(priority < last, "Popped out of order");
+                        last = priority;
+                        fail_if(ls_heap_push(heap, last + (double)(rand() % 100), NULL) ==
+                                    LS_HEAP_INVALID_HANDLE,
+                                "Failed to push");
+                }
+                while (ls_heap_pop(heap, &priority, NULL)) {
+                        fail_if(priority < last, "Drained out of order");
+                        last = priority;
+                }
+
+                ls_heap_free(heap);
+        }
+}
+END_TEST
+
+START_TEST(test_heap_decrease_key)
+{
+        LsHeap *heap = NULL;
+        LsHeapHandle handles[100];
+        LsHeapHandle reused;
+        double priority = 0;
+        void *data = NULL;
+
+        heap = ls_heap_new();
+        fail_if(!heap, "Failed to construct heap");
+
+        for (uintptr_t i = 0; i < 100; i++) {
+                handles[i] = ls_heap_push(heap, (double)(100 + i), (void *)i);
+                fail_if(handles[i] == LS_HEAP_INVALID_HANDLE, "Failed to push");
+        }
+
+        /* Move the last entry to the front */
+        fail_if(!ls_heap_decrease_key(heap, handles[99], 1.0), "Failed to decrease key");
+        fail_if(ls_heap_decrease_key(heap, handles[50], 500.0), "Increase should be refused");
+        fail_if(!ls_heap_pop(heap, &priority, &data), "Failed to pop");
+        fail_if((uintptr_t)data != 99 || priority != 1.0, "Decreased entry should pop first");
+
+        fail_if(ls_heap_contains(heap, handles[99]), "Popped handle should be gone");
+        fail_if(ls_heap_decrease_key(heap, handles[99], 0.0), "Popped handle is invalid");
+        fail_if(!ls_heap_contains(heap, handles[10]), "Live handle should be present");
+        fail_if(ls_heap_contains(heap, 12345), "Unknown handle should not be present");
+
+        /* Handles are recycled once popped */
+        reused = ls_heap_push(heap, 1000.0, (void *)1000);
+        fail_if(reused != handles[99], "Popped handle should be reused");
+
+        /* Every remaining entry tracks its position through sifts */
+        for (uintptr_t i = 0; i < 99; i++) {
+                fail_if(!ls_heap_decrease_key(heap, handles[i], (double)(99 - i)),
+                        "Failed to decrease key");
+        }
+        for (uintptr_t i = 99; i-- > 0;) {
+                fail_if(!ls_heap_pop(heap, &priority, &data), "Failed to pop");
+                fail_if((uintptr_t)data != i, "Decreased entries popped out of order");
+        }
+        fail_if(!ls_heap_pop(heap, &priority, &data), "Failed to pop");
+        fail_if((uintptr_t)data != 1000, "Reused handle entry lost");
+
+        ls_heap_free(heap);
+}
+END_TEST
+
+static double test_heap_priority(const void *data)
+{
+        return (double)(uintptr_t)data;
+}
+
+START_TEST(test_heap_from_array)
+{
+        LsArray *array = NULL;
+        LsHeap *heap = NULL;
+        void *data = NULL;
+        double last = -1.0;
+        double priority = 0;
+
+        array = ls_array_new(sizeof(void *));
+        fail_if(!array, "Failed to construct array");
+
+        for (uintptr_t i = 0; i < 1000; i++) {
+                fail_if(!ls_array_add(array, (void *)((i * 7919) % 1000)), "Failed to add");
+        }
+
+        heap = ls_heap_new_from_array(array, test_heap_priority, LS_HEAP_DEFAULT_ARITY);
+        fail_if(!heap, "Failed to heapify array");
+        fail_if(ls_heap_size(heap) != 1000, "Heap should hold every item");
+
+        /* Array index doubles as the handle */
+        fail_if(!ls_heap_decrease_key(heap, 500, -1.0), "Failed to decrease heapified key");
+        fail_if(!ls_heap_pop(heap, &priority, &data), "Failed to pop");
+        fail_if(data != array->data[500], "Handle should match the array index");
+
+        while (ls_heap_pop(heap, &priority, NULL)) {
+                fail_if(priority < last, "Heapified entries out of order");
+                last = priority;
+        }
+
+        ls_heap_free(heap);
+        ls_array_free(array, NULL);
+}
+END_TEST
+
+/**
+ * Standard helper for running a test suite
+ */
+static int ls_test_run(Suite *suite)
+{
+        SRunner *runner = NULL;
+        int n_failed = 0;
+
+        runner = srunner_create(suite);
+        srunner_run_all(runner, CK_VERBOSE);
+        n_failed = srunner_ntests_failed(runner);
+        srunner_free(runner);
+
+        return n_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static Suite *test_create(void)
+{
+        Suite *s = NULL;
+        TCase *tc = NULL;
+
+        s = suite_create(__FILE__);
+        tc = tcase_create(__FILE__);
+        suite_add_tcase(s, tc);
+
+        tcase_add_test(tc, test_heap_simple);
+        tcase_add_test(tc, test_heap_order);
+        tcase_add_test(tc, test_heap_decrease_key);
+        tcase_add_test(tc, test_heap_from_array);
+        return s;
+}
+
+int main(__attribute__((unused)) int argc, __attribute__((unused)) char **argv)
+{
+        return ls_test_run(test_create());
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
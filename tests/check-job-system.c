@@ -0,0 +1,337 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <check.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "job-system.h"
+#include "macros.h"
+
+static void test_increment(void *v)
+{
+        atomic_fetch_add((atomic_int *)v, 1);
+}
+
+START_TEST(test_job_system_submit)
+{
+        LsJobSystem *system = NULL;
+        LsJobCounter counter = LS_JOB_COUNTER_INIT;
+        atomic_int total = 0;
+
+        system = ls_job_system_new(4);
+        fail_if(!system, "Failed to construct job system");
+        fail_if(ls_job_system_n_workers(system) != 4, "Incorrect worker count");
+        fail_if(!ls_job_counter_is_done(&counter), "Idle counter should be done");
+
+        for (int i = 0; i < 10000; i++) {
+                fail_if(!ls_job_system_submit(system, test_increment, &total, &counter),
+                        "Failed to submit job");
+        }
+        ls_job_system_wait(system, &counter);
+        fail_if(atomic_load(&total) != 10000, "Not every job ran");
+        fail_if(!ls_job_counter_is_done(&counter), "Counter should be done");
+
+        /* Counters may be reused once done, and 0 picks a worker per CPU */
+        ls_job_system_free(system);
+        system = ls_job_system_new(0);
+        fail_if(!system, "Failed to construct job system");
+        fail_if(ls_job_system_n_workers(system) < 1, "Incorrect default worker count");
+
+        for (int i = 0; i < 100; i++) {
+                fail_if(!ls_job_system_submit(system, test_increment, &total, &counter),
+                        "Failed to submit job");
+        }
+        ls_job_system_wait(system, &counter);
+        fail_if(atomic_load(&total) != 10100, "Not every job ran");
+
+        ls_job_system_free(system);
+}
+END_TEST
+
+#define TEST_STAGE_SIZE 256
+
+typedef struct TestStage {
+        atomic_int produced[TEST_STAGE_SIZE];
+        atomic_int n_produced;
+        atomic_int n_consumed;
+        atomic_int n_early;
+} TestStage;
+
+static void test_produce(void *v)
+{
+        TestStage *stage = v;
+        int slot = atomic_fetch_add(&stage->n_produced, 1);
+
+        atomic_store(&stage->produced[slot], 1);
+}
+
+static void test_consume(void *v)
+{
+        TestStage *stage = v;
+
+        for (int i = 0; i < TEST_STAGE_SIZE; i++) {
+                if (atomic_load(&stage->produced[i]) != 1) {
+                        atomic_fetch_add(&stage->n_early, 1);
+                }
+        }
+        atomic_fetch_add(&stage->n_consumed, 1);
+}
+
+static void test_check_consumed(void *v)
+{
+        TestStage *stage = v;
+
+        if (atomic_load(&stage->n_consumed) != 8) {
+                atomic_fetch_add(&stage->n_early, 1);
+        }
+}
+
+START_TEST(test_job_system_dependencies)
+{
+        LsJobSystem *system = ls_job_system_new(4);
+        LsJobCounter produced = LS_JOB_COUNTER_INIT;
+        LsJobCounter consumed = LS_JOB_COUNTER_INIT;
+        LsJobCounter all = LS_JOB_COUNTER_INIT;
+        TestStage *stage = calloc(1, sizeof(TestStage));
+
+        fail_if(!system || !stage, "Failed to construct job system");
+
+        for (int round = 0; round < 50; round++) {
+                for (int i = 0; i < TEST_STAGE_SIZE; i++) {
+                        atomic_store(&stage->produced[i], 0);
+                }
+                atomic_store(&stage->n_produced, 0);
+                atomic_store(&stage->n_consumed, 0);
+
+                /* Queue the dependents first so they must actually be held */
+                ls_job_counter_init(&produced);
+                ls_job_counter_init(&consumed);
+                for (int i = 0; i < TEST_STAGE_SIZE; i++) {
+                        fail_if(!ls_job_system_submit(system, test_produce, stage, &produced),
+                                "Failed to submit job");
+                }
+                for (int i = 0; i < 8; i++) {
+                        fail_if(!ls_job_system_submit_after(system,
+                                                            &produced,
+                                                            test_consume,
+                                                            stage,
+                                                            &consumed),
+                                "Failed to submit dependent job");
+                }
+                fail_if(!ls_job_system_submit_after(system,
+                                                    &consumed,
+                                                    test_check_consumed,
+                                                    stage,
+                                                    &all),
+                        "Failed to submit dependent job");
+
+                /* Waiting on the last stage covers the whole chain */
+                ls_job_system_wait(system, &all);
+                fail_if(!ls_job_counter_is_done(&consumed), "Chain did not complete");
+                fail_if(atomic_load(&stage->n_consumed) != 8, "Not every consumer ran");
+        }
+        fail_if(atomic_load(&stage->n_early) != 0, "Dependent job ran too early");
+
+        /* A satisfied dependency runs straight away */
+        fail_if(!ls_job_system_submit_after(system, &produced, test_consume, stage, &consumed),
+                "Failed to submit dependent job");
+        ls_job_system_wait(system, &consumed);
+        fail_if(atomic_load(&stage->n_consumed) != 9, "Dependent job did not run");
+
+        free(stage);
+        ls_job_system_free(system);
+}
+END_TEST
+
+typedef struct TestFib {
+        LsJobSystem *system;
+        unsigned int n;
+        unsigned long result;
+} TestFib;
+
+/**
+ * Naive fibonacci where every call waits on its children from inside a
+ * job, which only works if waiting runs other jobs
+ */
+static void test_fib(void *v)
+{
+        TestFib *self = v;
+        LsJobCounter counter = LS_JOB_COUNTER_INIT;
+        TestFib a = { .system = self->system, .n = self->n - 1 };
+        TestFib b = { .system = self->system, .n = self->n - 2 };
+
+        if (self->n < 2) {
+                self->result = self->n;
+                return;
+        }
+
+        ls_job_system_submit(self->system, test_fib, &a, &counter);
+        ls_job_system_submit(self->system, test_fib, &b, &counter);
+        ls_job_system_wait(self->system, &counter);
+        self->result = a.result + b.result;
+}
+
+START_TEST(test_job_system_nested)
+{
+        LsJobSystem *system = ls_job_system_new(4);
+        LsJobCounter counter = LS_JOB_COUNTER_INIT;
+        TestFib fib = { .system = system, .n = 20 };
+
+        fail_if(!system, "Failed to construct job system");
+        fail_if(!ls_job_system_submit(system, test_fib, &fib, &counter), "Failed to submit job");
+        ls_job_system_wait(system, &counter);
+        fail_if(fib.result != 6765, "Incorrect nested result");
+
+        ls_job_system_free(system);
+}
+END_TEST
+
+typedef struct TestRange {
+        atomic_uchar *visited;
+        atomic_ulong sum;
+        atomic_int n_calls;
+} TestRange;
+
+static void test_range(void *v, size_t begin, size_t end)
+{
+        TestRange *self = v;
+        unsigned long sum = 0;
+
+        for (size_t i = begin; i < end; i++) {
+                atomic_fetch_add(&self->visited[i], 1);
+                sum += i;
+        }
+        atomic_fetch_add(&self->sum, sum);
+        atomic_fetch_add(&self->n_calls, 1);
+}
+
+START_TEST(test_job_system_parallel_for)
+{
+        const size_t n_items = 100000;
+        const size_t grains[] = { 0, 1, 1000, n_items * 2 };
+        const unsigned int workers[] = { 1, 4 };
+        TestRange range = { 0 };
+
+        range.visited = calloc(n_items, sizeof(atomic_uchar));
+        fail_if(!range.visited, "oom");
+
+        for (size_t w = 0; w < LS_ARRAY_SIZE(workers); w++) {
+                LsJobSystem *system = ls_job_system_new(workers[w]);
+                fail_if(!system, "Failed to construct job system");
+
+                for (size_t g = 0; g < LS_ARRAY_SIZE(grains); g++) {
+                        atomic_store(&range.sum, 0);
+                        atomic_store(&range.n_calls, 0);
+                        for (size_t i = 0; i < n_items; i++) {
+                                atomic_store(&range.visited[i], 0);
+                        }
+
+                        ls_job_system_parallel_for(system,
+                                                   0,
+                                                   n_items,
+                                                   grains[g],
+                                                   test_range,
+                                                   &range);
+
+                        for (size_t i = 0; i < n_items; i++) {
+                                fail_if(atomic_load(&range.visited[i]) != 1,
+                                        "Index not visited exactly once");
+                        }
+                        fail_if(atomic_load(&range.sum) != n_items * (n_items - 1) / 2,
+                                "Incorrect sum");
+                        if (grains[g] == 1000) {
+                                fail_if(atomic_load(&range.n_calls) < 100,
+                                        "Range was not split to the grain");
+                        } else if (grains[g] > n_items) {
+                                fail_if(atomic_load(&range.n_calls) != 1,
+                                        "Range smaller than grain was split");
+                        }
+                }
+
+                /* Empty and offset ranges */
+                atomic_store(&range.n_calls, 0);
+                ls_job_system_parallel_for(system, 10, 10, 0, test_range, &range);
+                fail_if(atomic_load(&range.n_calls) != 0, "Empty range ran");
+                atomic_store(&range.sum, 0);
+                ls_job_system_parallel_for(system, 10, 20, 3, test_range, &range);
+                fail_if(atomic_load(&range.sum) != 145, "Incorrect offset range");
+
+                ls_job_system_free(system);
+        }
+
+        free(range.visited);
+}
+END_TEST
+
+/**
+ * Standard helper for running a test suite
+ */
+static int ls_test_run(Suite *suite)
+{
+        SRunner *runner = NULL;
+        int n_failed = 0;
+
+        runner = srunner_create(suite);
+        srunner_run_all(runner, CK_VERBOSE);
+        n_failed = srunner_ntests_failed(runner);
+        srunner_free(runner);
+
+        return n_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static Suite *test_create(void)
+{
+        Suite *s = NULL;
+        TCase *tc = NULL;
+
+        s = suite_create(__FILE__);
+        tc = tcase_create(__FILE__);
+        suite_add_tcase(s, tc);
+
+        tcase_add_test(tc, test_job_system_submit);
+        tcase_add_test(tc, test_job_system_dependencies);
+        tcase_add_test(tc, test_job_system_nested);
+        tcase_add_test(tc, test_job_system_parallel_for);
+        return s;
+}
+
+int main(__attribute__((unused)) int argc, __attribute__((unused)) char **argv)
+{
+        return ls_test_run(test_create());
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -26,6 +26,7 @@
 #include <check.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "list.h"
 #include "macros.h"
@@ -100,6 +101,314 @@ START_TEST(test_list_simple_prepend)
 }
 END_TEST
 
+/**
+ * Build lists from a pool across several slabs, recycle them, and reset
+ */
+START_TEST(test_list_pool)
+{
+        LsListPool *pool = NULL;
+        LsList *list = NULL;
+        LsList *other = NULL;
+        LsList *recycled = NULL;
+        LsList *first = NULL;
+        unsigned int i = 0;
+
+        pool = ls_list_pool_new();
+        fail_if(!pool, "Failed to construct pool");
+
+        for (i = 0; i < 1000; i++) {
+                list = ls_list_pool_prepend(pool, list, LS_INT_TO_PTR(i));
+                fail_if(!list, "Failed to prepend from pool");
+                if (!first) {
+                        first = list;
+                }
+        }
+        fail_if(ls_list_length(list) != 1000, "Incorrect list length");
+
+        other = ls_list_pool_append(pool, other, "rory");
+        other = ls_list_pool_append(pool, other, "jimmy");
+        fail_if(strcmp(other->data, "rory") != 0, "Invalid data at 0");
+        fail_if(strcmp(other->next->data, "jimmy") != 0, "Invalid data at 1");
+
+        /* Counting down, as we prepended */
+        i = 999;
+        for (LsList *node = list; node; node = node->next, i--) {
+                fail_if(LS_PTR_TO_INT(node->data) != i, "Invalid data in pooled list");
+        }
+
+        /* Released nodes should be handed straight back out */
+        ls_list_pool_release(pool, other);
+        recycled = ls_list_pool_prepend(pool, NULL, "bob");
+        fail_if(recycled != other, "Released node was not recycled");
+        ls_list_pool_release_full(pool, recycled, NULL);
+
+        /* After a reset the first slab is reused from the start */
+        ls_list_pool_reset(pool);
+        other = ls_list_pool_prepend(pool, NULL, "charles");
+        fail_if(other != first, "Pool reset did not reuse the first slab");
+        for (i = 0; i < 2000; i++) {
+                other = ls_list_pool_prepend(pool, other, LS_INT_TO_PTR(i));
+                fail_if(!other, "Failed to prepend after reset");
+        }
+        fail_if(ls_list_length(other) != 2001, "Incorrect list length after reset");
+
+        ls_list_pool_free(pool);
+}
+END_TEST
+
+/**
+ * Exercise every queue operation and interop with plain LsList chains
+ */
+START_TEST(test_list_queue)
+{
+        LsListQueue queue = { 0 };
+        LsListQueue other = { 0 };
+        LsList *list = NULL;
+        void *data = NULL;
+        unsigned int i = 0;
+
+        ls_list_queue_init(&queue);
+        ls_list_queue_init(&other);
+        fail_if(ls_list_queue_pop(&queue, &data), "Popped from an empty queue");
+
+        for (i = 0; i < 100; i++) {
+                fail_if(!ls_list_queue_append(&queue, LS_INT_TO_PTR(i)), "Failed to append");
+        }
+        fail_if(!ls_list_queue_prepend(&queue, LS_INT_TO_PTR(1000)), "Failed to prepend");
+        fail_if(ls_list_queue_length(&queue) != 101, "Incorrect queue length");
+        fail_if(ls_list_length(queue.head) != 101, "Chain does not match queue length");
+
+        fail_if(!ls_list_queue_pop(&queue, &data), "Failed to pop");
+        fail_if(LS_PTR_TO_INT(data) != 1000, "Popped the wrong item");
+        fail_if(!ls_list_queue_pop(&queue, &data), "Failed to pop");
+        fail_if(LS_PTR_TO_INT(data) != 0, "Popped the wrong item");
+
+        /* Adopt a normal list, and then another queue */
+        list = ls_list_append(list, "rory");
+        list = ls_list_append(list, "jimmy");
+        ls_list_queue_append_list(&other, list);
+        fail_if(!ls_list_queue_append(&other, "bob"), "Failed to append after adopting");
+        fail_if(ls_list_queue_length(&other) != 3, "Incorrect adopted length");
+
+        fail_if(!ls_list_queue_concat(&queue, &other), "Failed to concat queues");
+        fail_if(ls_list_queue_length(&other) != 0 || other.head, "Concat left other populated");
+        fail_if(ls_list_queue_length(&queue) != 102, "Incorrect length after concat");
+        fail_if(strcmp(queue.tail->data, "bob") != 0, "Incorrect tail after concat");
+
+        for (i = 1; i < 100; i++) {
+                fail_if(!ls_list_queue_pop(&queue, &data), "Failed to pop");
+                fail_if(LS_PTR_TO_INT(data) != i, "Popped out of order");
+        }
+        fail_if(!ls_list_queue_pop(&queue, &data), "Failed to pop");
+        fail_if(strcmp(data, "rory") != 0, "Popped out of order");
+
+        list = ls_list_queue_steal(&queue);
+        fail_if(ls_list_queue_length(&queue) != 0, "Steal left the queue populated");
+        fail_if(ls_list_length(list) != 2, "Stolen chain is incorrect");
+        ls_list_free(list);
+
+        /* Drain to empty and refill, ensuring tail is reset */
+        fail_if(!ls_list_queue_append(&queue, "charles"), "Failed to append");
+        fail_if(!ls_list_queue_pop(&queue, NULL), "Failed to pop");
+        fail_if(queue.head || queue.tail, "Queue ends not reset when drained");
+        fail_if(!ls_list_queue_append(&queue, "harry"), "Failed to append");
+        fail_if(queue.head != queue.tail, "Single item queue has mismatched ends");
+
+        ls_list_queue_clear(&queue);
+        fail_if(ls_list_queue_length(&queue) != 0, "Clear left the queue populated");
+}
+END_TEST
+
+/**
+ * Pooled queues must recycle nodes through their pool
+ */
+START_TEST(test_list_queue_pool)
+{
+        LsListPool *pool = NULL;
+        LsListQueue queue = { 0 };
+        LsListQueue heap = { 0 };
+        void *data = NULL;
+
+        pool = ls_list_pool_new();
+        fail_if(!pool, "Failed to construct pool");
+
+        ls_list_queue_init_pool(&queue, pool);
+        ls_list_queue_init(&heap);
+
+        for (unsigned int i = 0; i < 1000; i++) {
+                fail_if(!ls_list_queue_append(&queue, strdup("item")), "Failed to append");
+        }
+        fail_if(!ls_list_queue_pop(&queue, &data), "Failed to pop");
+        free(data);
+
+        fail_if(ls_list_queue_concat(&queue, &heap), "Concatenated mismatched allocators");
+
+        ls_list_queue_clear_full(&queue, free);
+        fail_if(ls_list_queue_length(&queue) != 0, "Clear left the queue populated");
+
+        ls_list_pool_free(pool);
+}
+END_TEST
+
+/**
+ * Test items carry a sort key and their original position for stability
+ */
+typedef struct TestEvent {
+        unsigned int timestamp;
+        unsigned int order;
+} TestEvent;
+
+static int test_event_compare(const void *a, const void *b)
+{
+        const TestEvent *ea = a;
+        const TestEvent *eb = b;
+
+        if (ea->timestamp < eb->timestamp) {
+                return -1;
+        }
+        return ea->timestamp > eb->timestamp ? 1 : 0;
+}
+
+/**
+ * Sort a large list with many duplicate keys, checking order, stability
+ * and that no nodes went missing.
+ */
+START_TEST(test_list_sort)
+{
+        const unsigned int n_items = 100001;
+        TestEvent *events = NULL;
+        LsList *list = NULL;
+        TestEvent *prev = NULL;
+        unsigned int len = 0;
+
+        fail_if(ls_list_sort(NULL, test_event_compare) != NULL, "Sorting NULL failed");
+
+        events = calloc(n_items, sizeof(TestEvent));
+        fail_if(!events, "Out of memory");
+
+        /* Prepend in reverse so that list order matches the order field */
+        for (unsigned int i = n_items; i > 0; i--) {
+                events[i - 1].timestamp = ((i - 1) * 7919) % 1000;
+                events[i - 1].order = i - 1;
+                list = ls_list_prepend(list, &events[i - 1]);
+        }
+
+        list = ls_list_sort(list, test_event_compare);
+        for (LsList *node = list; node; node = node->next) {
+                TestEvent *event = node->data;
+                if (prev) {
+                        fail_if(prev->timestamp > event->timestamp, "List is not sorted");
+                        fail_if(prev->timestamp == event->timestamp && prev->order > event->order,
+                                "Sort is not stable");
+                }
+                prev = event;
+                ++len;
+        }
+        fail_if(len != n_items, "Sort lost nodes");
+
+        ls_list_free(list);
+        free(events);
+}
+END_TEST
+
+START_TEST(test_list_merge)
+{
+        TestEvent events[] = { { 1, 0 }, { 3, 1 }, { 5, 2 }, { 1, 3 }, { 2, 4 }, { 5, 5 } };
+        const unsigned int expected[] = { 0, 3, 4, 1, 2, 5 };
+        LsList *a = NULL;
+        LsList *b = NULL;
+        LsList *list = NULL;
+        unsigned int i = 0;
+
+        for (i = 0; i < 3; i++) {
+                a = ls_list_append(a, &events[i]);
+                b = ls_list_append(b, &events[i + 3]);
+        }
+
+        list = ls_list_merge(a, b, test_event_compare);
+        i = 0;
+        for (LsList *node = list; node; node = node->next, i++) {
+                fail_if(i >= LS_ARRAY_SIZE(expected), "Merged list is too long");
+                fail_if(((TestEvent *)node->data)->order != expected[i], "Incorrect merge order");
+        }
+        fail_if(i != LS_ARRAY_SIZE(expected), "Merged list is too short");
+
+        fail_if(ls_list_merge(NULL, NULL, test_event_compare) != NULL, "Merging NULL failed");
+        ls_list_free(list);
+}
+END_TEST
+
+static int test_string_compare(const void *a, const void *b)
+{
+        return strcmp(a, b);
+}
+
+START_TEST(test_list_sort_unique)
+{
+        LsList *list = NULL;
+        const char *expected[] = { "alpha", "bravo", "charlie" };
+        unsigned int i = 0;
+
+        list = ls_list_prepend(list, strdup("charlie"));
+        list = ls_list_prepend(list, strdup("alpha"));
+        list = ls_list_prepend(list, strdup("bravo"));
+        list = ls_list_prepend(list, strdup("alpha"));
+        list = ls_list_prepend(list, strdup("charlie"));
+        list = ls_list_prepend(list, strdup("charlie"));
+
+        list = ls_list_sort_unique(list, test_string_compare, free);
+        fail_if(ls_list_length(list) != 3, "Duplicates were not removed");
+        for (LsList *node = list; node; node = node->next, i++) {
+                fail_if(strcmp(node->data, expected[i]) != 0, "Incorrect unique order");
+        }
+
+        ls_list_free_full(list, free);
+}
+END_TEST
+
+START_TEST(test_list_memory_usage)
+{
+        LsList *list = NULL;
+        LsMemoryUsage usage = { 0 };
+        LsMemoryCounters before = { 0 };
+        LsMemoryCounters during = { 0 };
+        LsMemoryCounters after = { 0 };
+        bool have_counters = ls_memory_counters(LS_MEMORY_TYPE_LIST, &before);
+
+        fail_if(!ls_list_memory_usage(NULL, &usage), "Failed to collect memory usage");
+        fail_if(usage.used != 0 || usage.reserved != 0 || usage.overhead != 0,
+                "Empty list should use nothing");
+
+        for (int i = 0; i < 10; i++) {
+                list = ls_list_prepend(list, LS_INT_TO_PTR(i + 1));
+        }
+
+        fail_if(!ls_list_memory_usage(list, &usage), "Failed to collect memory usage");
+        fail_if(usage.used != 10 * sizeof(void *), "Incorrect used bytes");
+        fail_if(usage.reserved != usage.used, "Lists have no slack");
+        fail_if(usage.used + usage.overhead != 10 * sizeof(LsList), "Incorrect overhead");
+
+        if (have_counters) {
+                fail_if(!ls_memory_counters(LS_MEMORY_TYPE_LIST, &during), "Lost counters");
+                fail_if(during.live_bytes - before.live_bytes != 10 * sizeof(LsList),
+                        "Live bytes do not match the list footprint");
+                fail_if(during.n_allocs - before.n_allocs != 10, "Incorrect allocation count");
+        }
+
+        ls_list_free(list);
+
+        if (have_counters) {
+                fail_if(!ls_memory_counters(LS_MEMORY_TYPE_LIST, &after), "Lost counters");
+                fail_if(after.live_bytes != before.live_bytes, "Freed list still counted");
+                fail_if(after.n_frees - before.n_frees != 10, "Incorrect free count");
+
+                ls_memory_counters_reset_peak(LS_MEMORY_TYPE_LIST);
+                fail_if(!ls_memory_counters(LS_MEMORY_TYPE_LIST, &after), "Lost counters");
+                fail_if(after.peak_bytes != after.live_bytes, "High-water mark not reset");
+        }
+}
+END_TEST
+
 /**
  * Standard helper for running a test suite
  */
@@ -127,6 +436,13 @@ static Suite *test_create(void)
 
         tcase_add_test(tc, test_list_simple_append);
         tcase_add_test(tc, test_list_simple_prepend);
+        tcase_add_test(tc, test_list_pool);
+        tcase_add_test(tc, test_list_queue);
+        tcase_add_test(tc, test_list_queue_pool);
+        tcase_add_test(tc, test_list_sort);
+        tcase_add_test(tc, test_list_merge);
+        tcase_add_test(tc, test_list_sort_unique);
+        tcase_add_test(tc, test_list_memory_usage);
 
         return s;
 }
@@ -26,6 +26,7 @@
 #include <check.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "macros.h"
 #include "map.h"
@@ -143,6 +144,261 @@ START_TEST(test_map_remove)
 }
 END_TEST
 
+/**
+ * Ensure the structural statistics agree with what we put in the map,
+ * regardless of whether the counters were compiled in.
+ */
+START_TEST(test_map_stats)
+{
+        LsHashmap *map = NULL;
+        LsHashmapStats stats = { 0 };
+        unsigned int n_chained = 0;
+
+        map = ls_hashmap_new(ls_hashmap_simple_hash, ls_hashmap_simple_equal);
+        fail_if(!map, "Failed to construct hashmap");
+
+        for (size_t i = 0; i < 1000; i++) {
+                fail_if(!ls_hashmap_put(map, LS_INT_TO_PTR(i), LS_INT_TO_PTR(i + 1)),
+                        "Failed to insert keypair");
+        }
+        for (size_t i = 0; i < 100; i++) {
+                fail_if(!ls_hashmap_remove(map, LS_INT_TO_PTR(i)), "Failed to remove keypair");
+        }
+        fail_if(ls_hashmap_get(map, LS_INT_TO_PTR(5)) != NULL, "Removed key still present");
+
+        fail_if(!ls_hashmap_stats(map, &stats), "Failed to collect stats");
+        fail_if(stats.n_items != 900, "Incorrect live item count");
+        fail_if(stats.n_buckets < 1024, "Map should have resized");
+        fail_if(stats.max_probe < 1, "Max probe should be at least 1");
+        fail_if(stats.mean_probe < 1.0, "Mean probe should be at least 1");
+
+        for (unsigned int i = 0; i < LS_HASHMAP_STATS_CHAIN_MAX; i++) {
+                n_chained += stats.chain_histogram[i];
+        }
+        fail_if(n_chained != stats.n_buckets, "Histogram should cover every bucket");
+
+        if (stats.have_counters) {
+                fail_if(stats.n_puts != 1000, "Incorrect put count");
+                fail_if(stats.n_removes != 100, "Incorrect remove count");
+                fail_if(stats.n_gets != 1, "Incorrect get count");
+                fail_if(stats.n_hits != 100, "Incorrect hit count");
+                fail_if(stats.n_misses != 1, "Incorrect miss count");
+                fail_if(stats.n_resizes < 1, "Resize was not counted");
+        }
+
+        ls_hashmap_free(map);
+}
+END_TEST
+
+START_TEST(test_map_memory_usage)
+{
+        LsHashmap *map = NULL;
+        LsHashmapStats stats = { 0 };
+        LsMemoryUsage usage = { 0 };
+        LsMemoryCounters before = { 0 };
+        LsMemoryCounters during = { 0 };
+        LsMemoryCounters after = { 0 };
+        bool have_counters = ls_memory_counters(LS_MEMORY_TYPE_HASHMAP, &before);
+
+        map = ls_hashmap_new(ls_hashmap_simple_hash, ls_hashmap_simple_equal);
+        fail_if(!map, "Failed to construct hashmap");
+
+        for (size_t i = 1; i <= 1000; i++) {
+                fail_if(!ls_hashmap_put(map, LS_INT_TO_PTR(i), LS_INT_TO_PTR(i)),
+                        "Failed to insert keypair");
+        }
+        for (size_t i = 1; i <= 100; i++) {
+                fail_if(!ls_hashmap_remove(map, LS_INT_TO_PTR(i)), "Failed to remove keypair");
+        }
+
+        fail_if(!ls_hashmap_stats(map, &stats), "Failed to collect stats");
+        fail_if(!ls_hashmap_memory_usage(map, &usage), "Failed to collect memory usage");
+        fail_if(usage.used != 900 * 2 * sizeof(void *), "Incorrect used bytes");
+        fail_if(usage.reserved !=
+                    (stats.n_buckets + stats.n_overflow_nodes) * 2 * sizeof(void *),
+                "Incorrect reserved bytes");
+        fail_if(usage.overhead <= (stats.n_buckets + stats.n_overflow_nodes) * sizeof(uint32_t),
+                "Overhead should include hashes, links and the header");
+        fail_if(ls_hashmap_memory_usage(NULL, &usage), "Collected usage for a NULL map");
+
+        if (have_counters) {
+                fail_if(!ls_memory_counters(LS_MEMORY_TYPE_HASHMAP, &during), "Lost counters");
+                fail_if(during.live_bytes - before.live_bytes != usage.reserved + usage.overhead,
+                        "Live bytes do not match the map footprint");
+                fail_if(during.n_frees == before.n_frees, "Resizes should free old buckets");
+        }
+
+        ls_hashmap_free(map);
+
+        if (have_counters) {
+                fail_if(!ls_memory_counters(LS_MEMORY_TYPE_HASHMAP, &after), "Lost counters");
+                fail_if(after.live_bytes != before.live_bytes, "Freed map still counted");
+                fail_if(after.n_allocs - before.n_allocs != after.n_frees - before.n_frees,
+                        "Unbalanced allocations");
+        }
+}
+END_TEST
+
+/**
+ * Every live pair must be visited exactly once, skipping removed buckets
+ */
+START_TEST(test_map_iter)
+{
+        LsHashmap *map = NULL;
+        LsHashmapIter iter = { 0 };
+        void *key = NULL;
+        void *value = NULL;
+        unsigned int seen[1000] = { 0 };
+        unsigned int n_seen = 0;
+
+        map = ls_hashmap_new(ls_hashmap_simple_hash, ls_hashmap_simple_equal);
+        fail_if(!map, "Failed to construct hashmap");
+
+        for (size_t i = 0; i < 1000; i++) {
+                fail_if(!ls_hashmap_put(map, LS_INT_TO_PTR(i), LS_INT_TO_PTR(i + 1)),
+                        "Failed to insert keypair");
+        }
+        for (size_t i = 0; i < 1000; i += 3) {
+                fail_if(!ls_hashmap_remove(map, LS_INT_TO_PTR(i)), "Failed to remove keypair");
+        }
+
+        ls_hashmap_iter_init(map, &iter);
+        while (ls_hashmap_iter_next(&iter, &key, &value)) {
+                unsigned int k = LS_PTR_TO_INT(key);
+                fail_if(k >= 1000, "Iterated unknown key");
+                fail_if(k % 3 == 0, "Iterated removed key");
+                fail_if(LS_PTR_TO_INT(value) != k + 1, "Incorrect value for key");
+                seen[k]++;
+                n_seen++;
+        }
+
+        fail_if(n_seen != 666, "Incorrect number of iterated pairs");
+        for (unsigned int i = 0; i < 1000; i++) {
+                fail_if(i % 3 != 0 && seen[i] != 1, "Key not visited exactly once");
+        }
+
+        ls_hashmap_free(map);
+}
+END_TEST
+
+/**
+ * "Ab" and "BA" share a DJB hash, so every string built from those blocks
+ * collides. Make sure a seeded map is immune to them.
+ */
+START_TEST(test_map_seeded_collisions)
+{
+        LsHashmap *map = NULL;
+        LsHashmapStats stats = { 0 };
+        LsHashmapSeed seed_a = { .k0 = 1, .k1 = 2 };
+        LsHashmapSeed seed_b = { .k0 = 3, .k1 = 4 };
+        const unsigned int n_blocks = 10;
+
+        fail_if(ls_hashmap_string_hash("Ab") != ls_hashmap_string_hash("BA"),
+                "Test keys should collide with DJB");
+        fail_if(ls_hashmap_string_hash_seeded("Ab", &seed_a) ==
+                    ls_hashmap_string_hash_seeded("BA", &seed_a),
+                "Test keys should not collide with SipHash");
+        fail_if(ls_hashmap_string_hash_seeded("Ab", &seed_a) !=
+                    ls_hashmap_string_hash_seeded("Ab", &seed_a),
+                "Seeded hash should be stable");
+        fail_if(ls_hashmap_string_hash_seeded("Ab", &seed_a) ==
+                    ls_hashmap_string_hash_seeded("Ab", &seed_b),
+                "Seeded hash should depend on the seed");
+
+        map = ls_hashmap_new_seeded_full(ls_hashmap_string_hash_seeded,
+                                         ls_hashmap_string_equal,
+                                         free,
+                                         NULL);
+        fail_if(!map, "Failed to construct seeded hashmap");
+
+        for (unsigned int i = 0; i < (1U << n_blocks); i++) {
+                char *key = calloc(n_blocks * 2 + 1, 1);
+                fail_if(!key, "Out of memory");
+                for (unsigned int j = 0; j < n_blocks; j++) {
+                        memcpy(key + j * 2, (i & (1U << j)) ? "Ab" : "BA", 2);
+                }
+                fail_if(!ls_hashmap_put(map, key, LS_INT_TO_PTR(i + 1)), "Failed to insert");
+        }
+
+        fail_if(LS_PTR_TO_INT(ls_hashmap_get(map, "BABABABABABABABABABA")) != 1,
+                "Failed to retrieve first key");
+        fail_if(LS_PTR_TO_INT(ls_hashmap_get(map, "AbAbAbAbAbAbAbAbAbAb")) != (1U << n_blocks),
+                "Failed to retrieve last key");
+
+        fail_if(!ls_hashmap_stats(map, &stats), "Failed to collect stats");
+        fail_if(stats.n_items != (1U << n_blocks), "Incorrect live item count");
+        fail_if(stats.max_probe > 16, "Seeded map has degenerate chains");
+
+        ls_hashmap_free(map);
+}
+END_TEST
+
+/**
+ * First seed handed to test_weak_seeded_hash, under which every key collides
+ */
+static LsHashmapSeed test_weak_seed;
+static bool test_have_weak_seed = false;
+
+/**
+ * Seeded hash that is degenerate under the map's initial seed, as if an
+ * attacker had learned it, and SipHash under any other
+ */
+static uint32_t test_weak_seeded_hash(const void *v, const LsHashmapSeed *seed)
+{
+        if (!test_have_weak_seed) {
+                test_weak_seed = *seed;
+                test_have_weak_seed = true;
+        }
+        if (seed->k0 == test_weak_seed.k0 && seed->k1 == test_weak_seed.k1) {
+                return 42;
+        }
+        return ls_hashmap_string_hash_seeded(v, seed);
+}
+
+/**
+ * A long chain in a seeded map must rehash every key under a fresh seed,
+ * and every key must still be found afterwards
+ */
+START_TEST(test_map_seeded_reseed)
+{
+        LsHashmap *map = NULL;
+        LsHashmapStats stats = { 0 };
+        const unsigned int n_items = 1000;
+
+        test_have_weak_seed = false;
+        map = ls_hashmap_new_seeded_full(test_weak_seeded_hash,
+                                         ls_hashmap_string_equal,
+                                         free,
+                                         NULL);
+        fail_if(!map, "Failed to construct seeded hashmap");
+
+        for (unsigned int i = 0; i < n_items; i++) {
+                char *key = NULL;
+                if (asprintf(&key, "KEY: %u", i) < 0) {
+                        abort();
+                }
+                fail_if(!ls_hashmap_put(map, key, LS_INT_TO_PTR(i + 1)), "Failed to insert");
+        }
+        fail_if(!test_have_weak_seed, "Map never hashed a key");
+
+        for (unsigned int i = 0; i < n_items; i++) {
+                char key[32];
+                snprintf(key, sizeof(key), "KEY: %u", i);
+                fail_if(LS_PTR_TO_INT(ls_hashmap_get(map, key)) != i + 1,
+                        "Key lost across reseed");
+        }
+
+        fail_if(!ls_hashmap_stats(map, &stats), "Failed to collect stats");
+        fail_if(stats.n_items != n_items, "Incorrect live item count");
+        fail_if(stats.max_probe > 16, "Map was never reseeded");
+        if (stats.have_counters) {
+                fail_if(stats.n_reseeds != 1, "Expected exactly one reseed");
+        }
+
+        ls_hashmap_free(map);
+}
+END_TEST
+
 /**
  * Standard helper for running a test suite
  */
@@ -171,6 +427,11 @@ static Suite *test_create(void)
         tcase_add_test(tc, test_map_simple);
         tcase_add_test(tc, test_map_null_zero);
         tcase_add_test(tc, test_map_remove);
+        tcase_add_test(tc, test_map_stats);
+        tcase_add_test(tc, test_map_memory_usage);
+        tcase_add_test(tc, test_map_iter);
+        tcase_add_test(tc, test_map_seeded_collisions);
+        tcase_add_test(tc, test_map_seeded_reseed);
 
         /* TODO: Add actual tests. */
         return s;
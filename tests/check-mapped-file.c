@@ -0,0 +1,226 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <check.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mapped-file.h"
+
+#define TEST_N_RECORDS 10000
+
+/**
+ * Record layout of our fake asset table, preceded by a uint64_t count
+ */
+typedef struct TestRecord {
+        uint32_t id;
+        float x, y, z;
+} TestRecord;
+
+static int test_record_compare(const void *key, const void *record)
+{
+        uint32_t a = *(const uint32_t *)key;
+        uint32_t b = ((const TestRecord *)record)->id;
+
+        return (a > b) - (a < b);
+}
+
+/**
+ * Write the table to a new temporary file, returning its path
+ */
+static char *test_write_table(void)
+{
+        char *path = strdup("/tmp/libls-check-mapped-XXXXXX");
+        uint64_t count = TEST_N_RECORDS;
+        FILE *fp = NULL;
+        int fd;
+
+        fd = mkstemp(path);
+        if (fd < 0) {
+                free(path);
+                return NULL;
+        }
+        fp = fdopen(fd, "wb");
+        fwrite(&count, sizeof(count), 1, fp);
+        for (uint32_t i = 0; i < TEST_N_RECORDS; i++) {
+                TestRecord record = { .id = i * 3, .x = (float)i, .y = 1.0f, .z = -1.0f };
+                fwrite(&record, sizeof(record), 1, fp);
+        }
+        fclose(fp);
+
+        return path;
+}
+
+START_TEST(test_mapped_file_view)
+{
+        LsMappedFile *file = NULL;
+        LsArrayView view = { 0 };
+        const TestRecord *record = NULL;
+        uint64_t count = 0;
+        uint32_t key;
+        char *path = test_write_table();
+
+        fail_if(!path, "Failed to write table");
+
+        file = ls_mapped_file_open(path, LS_MAPPED_FILE_SEQUENTIAL);
+        fail_if(!file, "Failed to map file");
+        fail_if(ls_mapped_file_size(file) != sizeof(count) + TEST_N_RECORDS * sizeof(TestRecord),
+                "Incorrect mapping size");
+
+        memcpy(&count, ls_mapped_file_data(file), sizeof(count));
+        fail_if(count != TEST_N_RECORDS, "Incorrect header");
+
+        /* Lookups into the table will be scattered */
+        fail_if(!ls_mapped_file_advise(file,
+                                       sizeof(count),
+                                       count * sizeof(TestRecord),
+                                       LS_MAPPED_FILE_RANDOM),
+                "Failed to advise");
+
+        fail_if(!ls_mapped_file_array_view(file, sizeof(count), sizeof(TestRecord), count, &view),
+                "Failed to create view");
+        fail_if(view.len != TEST_N_RECORDS, "Incorrect view length");
+        fail_if(view.data != (const char *)ls_mapped_file_data(file) + sizeof(count),
+                "View should point straight into the mapping");
+
+        for (size_t i = 0; i < view.len; i++) {
+                record = ls_array_view_get(&view, i);
+                fail_if(record->id != i * 3 || record->x != (float)i, "Incorrect record");
+        }
+        fail_if(ls_array_view_get(&view, view.len) != NULL, "Read past the end of the view");
+
+        key = 2997;
+        record = ls_array_view_search(&view, &key, test_record_compare);
+        fail_if(!record || record->x != 999.0f, "Failed to find record");
+        key = 2998;
+        fail_if(ls_array_view_search(&view, &key, test_record_compare) != NULL,
+                "Found a missing record");
+
+        ls_mapped_file_close(file);
+        unlink(path);
+        free(path);
+}
+END_TEST
+
+START_TEST(test_mapped_file_edges)
+{
+        LsMappedFile *file = NULL;
+        LsArrayView view = { 0 };
+        char path[] = "/tmp/libls-check-mapped-XXXXXX";
+        size_t size;
+        int fd;
+        char *table = test_write_table();
+
+        fail_if(ls_mapped_file_open("/nonexistent/libls/file", LS_MAPPED_FILE_NORMAL) != NULL,
+                "Mapped a missing file");
+        fail_if(ls_mapped_file_open("/tmp", LS_MAPPED_FILE_NORMAL) != NULL, "Mapped a directory");
+
+        /* Empty files map with no data */
+        fd = mkstemp(path);
+        fail_if(fd < 0, "Failed to create file");
+        close(fd);
+        file = ls_mapped_file_open(path, LS_MAPPED_FILE_WILLNEED);
+        fail_if(!file, "Failed to map empty file");
+        fail_if(ls_mapped_file_size(file) != 0 || ls_mapped_file_data(file) != NULL,
+                "Empty file has data");
+        fail_if(!ls_mapped_file_array_view(file, 0, 16, 0, &view) || view.len != 0,
+                "Failed to create empty view");
+        fail_if(ls_mapped_file_array_view(file, 0, 16, 1, &view), "View outside the file");
+        ls_mapped_file_close(file);
+        unlink(path);
+
+        /* Views and hints are bounds checked */
+        file = ls_mapped_file_open(table, LS_MAPPED_FILE_NORMAL);
+        fail_if(!file, "Failed to map file");
+        size = ls_mapped_file_size(file);
+        fail_if(ls_mapped_file_array_view(file, 8, sizeof(TestRecord), TEST_N_RECORDS + 1, &view),
+                "View past the end of the file");
+        fail_if(ls_mapped_file_array_view(file, size + 1, 1, 0, &view), "View offset out of range");
+        fail_if(ls_mapped_file_array_view(file, 0, 0, 1, &view), "Zero sized records");
+        fail_if(ls_mapped_file_array_view(file, 0, 2, SIZE_MAX, &view), "Overflowing view");
+        fail_if(!ls_mapped_file_array_view(file, 0, 1, size, &view), "Failed to view everything");
+        fail_if(ls_mapped_file_advise(file, 1, size, LS_MAPPED_FILE_DONTNEED),
+                "Advised past the end of the file");
+        fail_if(!ls_mapped_file_advise(file, 100, 10, LS_MAPPED_FILE_DONTNEED),
+                "Failed to advise an unaligned range");
+        fail_if(*(const uint64_t *)ls_mapped_file_data(file) != TEST_N_RECORDS,
+                "Data lost after dropping pages");
+        ls_mapped_file_close(file);
+        ls_mapped_file_close(NULL);
+
+        unlink(table);
+        free(table);
+}
+END_TEST
+
+/**
+ * Standard helper for running a test suite
+ */
+static int ls_test_run(Suite *suite)
+{
+        SRunner *runner = NULL;
+        int n_failed = 0;
+
+        runner = srunner_create(suite);
+        srunner_run_all(runner, CK_VERBOSE);
+        n_failed = srunner_ntests_failed(runner);
+        srunner_free(runner);
+
+        return n_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static Suite *test_create(void)
+{
+        Suite *s = NULL;
+        TCase *tc = NULL;
+
+        s = suite_create(__FILE__);
+        tc = tcase_create(__FILE__);
+        suite_add_tcase(s, tc);
+
+        tcase_add_test(tc, test_mapped_file_view);
+        tcase_add_test(tc, test_mapped_file_edges);
+        return s;
+}
+
+int main(__attribute__((unused)) int argc, __attribute__((unused)) char **argv)
+{
+        return ls_test_run(test_create());
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,183 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "multimap.h"
+
+START_TEST(test_multimap_simple)
+{
+        LsMultimap *map = NULL;
+        void *const *values = NULL;
+        unsigned int n_values = 0;
+
+        map = ls_multimap_new(ls_hashmap_string_hash, ls_hashmap_string_equal);
+        fail_if(!map, "Failed to construct multimap");
+
+        fail_if(!ls_multimap_put(map, "enemy", "orc"), "Failed to insert");
+        fail_if(!ls_multimap_put(map, "enemy", "goblin"), "Failed to insert");
+        fail_if(!ls_multimap_put(map, "friend", "dwarf"), "Failed to insert");
+        fail_if(!ls_multimap_put(map, "enemy", "troll"), "Failed to insert");
+
+        values = ls_multimap_get(map, "enemy", &n_values);
+        fail_if(!values, "Failed to get enemy values");
+        fail_if(n_values != 3, "Incorrect number of values");
+        fail_if(strcmp(values[0], "orc") != 0, "Incorrect value at 0");
+        fail_if(strcmp(values[1], "goblin") != 0, "Incorrect value at 1");
+        fail_if(strcmp(values[2], "troll") != 0, "Incorrect value at 2");
+
+        fail_if(ls_multimap_count(map, "friend") != 1, "Incorrect friend count");
+        fail_if(ls_multimap_count(map, "neutral") != 0, "Non existent key has values");
+        fail_if(ls_multimap_get(map, "neutral", &n_values) != NULL, "Got non existent key");
+        fail_if(n_values != 0, "Non existent key has values");
+
+        ls_multimap_free(map);
+}
+END_TEST
+
+/**
+ * Remove single pairs from the middle and ends of a run, making sure the
+ * key disappears with its final value, and that ownership is honoured.
+ */
+START_TEST(test_multimap_remove)
+{
+        LsMultimap *map = NULL;
+        void *const *values = NULL;
+        unsigned int n_values = 0;
+        char *orc = strdup("orc");
+        char *goblin = strdup("goblin");
+        char *troll = strdup("troll");
+
+        map = ls_multimap_new_full(ls_hashmap_string_hash, ls_hashmap_string_equal, free, free);
+        fail_if(!map, "Failed to construct multimap");
+
+        fail_if(!ls_multimap_put(map, strdup("enemy"), orc), "Failed to insert");
+        fail_if(!ls_multimap_put(map, strdup("enemy"), goblin), "Failed to insert");
+        fail_if(!ls_multimap_put(map, strdup("enemy"), troll), "Failed to insert");
+        fail_if(!ls_multimap_put(map, strdup("friend"), strdup("dwarf")), "Failed to insert");
+
+        fail_if(ls_multimap_remove(map, "enemy", "goblin"), "Removed by content, not pointer");
+        fail_if(!ls_multimap_remove(map, "enemy", goblin), "Failed to remove goblin");
+
+        values = ls_multimap_get(map, "enemy", &n_values);
+        fail_if(n_values != 2, "Incorrect number of values");
+        fail_if(values[0] != orc || values[1] != troll, "Order not preserved after remove");
+
+        fail_if(!ls_multimap_remove(map, "enemy", troll), "Failed to remove troll");
+        fail_if(!ls_multimap_remove(map, "enemy", orc), "Failed to remove orc");
+        fail_if(ls_multimap_count(map, "enemy") != 0, "Key should be gone");
+        fail_if(ls_multimap_remove(map, "enemy", orc), "Removed from missing key");
+
+        fail_if(!ls_multimap_remove_all(map, "friend"), "Failed to remove friend");
+        fail_if(ls_multimap_remove_all(map, "friend"), "Removed friend twice");
+
+        fail_if(!ls_multimap_put(map, strdup("enemy"), strdup("ogre")), "Failed to reinsert");
+
+        /* Valgrind will complain about any leaked keys or values */
+        ls_multimap_free(map);
+}
+END_TEST
+
+/**
+ * Force many runs to grow alongside resizes of the backing map
+ */
+START_TEST(test_multimap_many)
+{
+        LsMultimap *map = NULL;
+        void *const *values = NULL;
+        unsigned int n_values = 0;
+
+        map = ls_multimap_new(ls_hashmap_simple_hash, ls_hashmap_simple_equal);
+        fail_if(!map, "Failed to construct multimap");
+
+        for (size_t i = 0; i < 20000; i++) {
+                fail_if(!ls_multimap_put(map, LS_INT_TO_PTR(i % 1000), LS_INT_TO_PTR(i)),
+                        "Failed to insert");
+        }
+
+        for (size_t key = 0; key < 1000; key++) {
+                values = ls_multimap_get(map, LS_INT_TO_PTR(key), &n_values);
+                fail_if(n_values != 20, "Incorrect number of values");
+                for (unsigned int i = 0; i < n_values; i++) {
+                        fail_if((size_t)LS_PTR_TO_INT(values[i]) != key + i * 1000,
+                                "Incorrect value in run");
+                }
+        }
+
+        ls_multimap_free(map);
+}
+END_TEST
+
+/**
+ * Standard helper for running a test suite
+ */
+static int ls_test_run(Suite *suite)
+{
+        SRunner *runner = NULL;
+        int n_failed = 0;
+
+        runner = srunner_create(suite);
+        srunner_run_all(runner, CK_VERBOSE);
+        n_failed = srunner_ntests_failed(runner);
+        srunner_free(runner);
+
+        return n_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static Suite *test_create(void)
+{
+        Suite *s = NULL;
+        TCase *tc = NULL;
+
+        s = suite_create(__FILE__);
+        tc = tcase_create(__FILE__);
+        suite_add_tcase(s, tc);
+
+        tcase_add_test(tc, test_multimap_simple);
+        tcase_add_test(tc, test_multimap_remove);
+        tcase_add_test(tc, test_multimap_many);
+        return s;
+}
+
+int main(__attribute__((unused)) int argc, __attribute__((unused)) char **argv)
+{
+        return ls_test_run(test_create());
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,310 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macros.h"
+#include "ordered-map.h"
+
+START_TEST(test_ordered_map_simple)
+{
+        LsOrderedMap *map = NULL;
+        void *v = NULL;
+
+        map = ls_ordered_map_new(ls_hashmap_string_hash, ls_hashmap_string_equal);
+        fail_if(!map, "Failed to construct string map!");
+
+        fail_if(!ls_ordered_map_put(map, "charlie", LS_INT_TO_PTR(12)), "Failed to insert");
+        fail_if(!ls_ordered_map_put(map, "bob", LS_INT_TO_PTR(38)), "Failed to insert");
+        fail_if(ls_ordered_map_size(map) != 2, "Incorrect map size");
+
+        v = ls_ordered_map_get(map, "charlie");
+        fail_if(LS_PTR_TO_INT(v) != 12, "Retrieved value is incorrect");
+        v = ls_ordered_map_get(map, "bob");
+        fail_if(LS_PTR_TO_INT(v) != 38, "Retrieved value is incorrect");
+        fail_if(ls_ordered_map_get(map, "alice") != NULL, "Retrieved non existent key");
+
+        fail_if(!ls_ordered_map_remove(map, "charlie"), "Failed to remove key");
+        fail_if(ls_ordered_map_remove(map, "charlie"), "Removed key twice");
+        fail_if(ls_ordered_map_get(map, "charlie") != NULL, "Removed key still present");
+        fail_if(ls_ordered_map_size(map) != 1, "Incorrect map size");
+
+        ls_ordered_map_free(map);
+}
+END_TEST
+
+/**
+ * Iteration must follow first insertion, not replacement or hash order
+ */
+START_TEST(test_ordered_map_order)
+{
+        LsOrderedMap *map = NULL;
+        LsOrderedMapIter iter = { 0 };
+        const char *expected[] = { "zebra", "apple", "mango", "kiwi" };
+        void *key = NULL;
+        void *value = NULL;
+        size_t n = 0;
+
+        map = ls_ordered_map_new(ls_hashmap_string_hash, ls_hashmap_string_equal);
+        fail_if(!map, "Failed to construct string map!");
+
+        fail_if(!ls_ordered_map_put(map, "zebra", LS_INT_TO_PTR(1)), "Failed to insert");
+        fail_if(!ls_ordered_map_put(map, "apple", LS_INT_TO_PTR(2)), "Failed to insert");
+        fail_if(!ls_ordered_map_put(map, "banana", LS_INT_TO_PTR(3)), "Failed to insert");
+        fail_if(!ls_ordered_map_put(map, "mango", LS_INT_TO_PTR(4)), "Failed to insert");
+        fail_if(!ls_ordered_map_put(map, "apple", LS_INT_TO_PTR(5)), "Failed to replace");
+        fail_if(!ls_ordered_map_remove(map, "banana"), "Failed to remove");
+        fail_if(!ls_ordered_map_put(map, "kiwi", LS_INT_TO_PTR(6)), "Failed to insert");
+
+        ls_ordered_map_iter_init(map, &iter);
+        while (ls_ordered_map_iter_next(&iter, &key, &value)) {
+                fail_if(n >= LS_ARRAY_SIZE(expected), "Too many items in iteration");
+                fail_if(strcmp(key, expected[n]) != 0, "Iteration order is incorrect");
+                ++n;
+        }
+        fail_if(n != LS_ARRAY_SIZE(expected), "Too few items in iteration");
+        fail_if(LS_PTR_TO_INT(ls_ordered_map_get(map, "apple")) != 5, "Replacement failed");
+
+        ls_ordered_map_free(map);
+}
+END_TEST
+
+/**
+ * Push the map through every index width, with removals along the way,
+ * and make sure order and contents survive each rebuild.
+ */
+START_TEST(test_ordered_map_growth)
+{
+        LsOrderedMap *map = NULL;
+        LsOrderedMapIter iter = { 0 };
+        void *key = NULL;
+        void *value = NULL;
+        size_t expect = 0;
+        const size_t n_items = 100000;
+
+        map = ls_ordered_map_new_full(ls_hashmap_simple_hash, ls_hashmap_simple_equal, NULL, free);
+        fail_if(!map, "Failed to construct map");
+
+        for (size_t i = 0; i < n_items; i++) {
+                char *p = NULL;
+                if (asprintf(&p, "VALUE: %ld", i) < 0) {
+                        abort();
+                }
+                fail_if(!ls_ordered_map_put(map, LS_INT_TO_PTR(i), p), "Failed to insert keypair");
+
+                /* Drop every odd key shortly after insert */
+                if (i % 2 == 1) {
+                        fail_if(!ls_ordered_map_remove(map, LS_INT_TO_PTR(i)), "Failed to remove");
+                }
+        }
+
+        fail_if(ls_ordered_map_size(map) != n_items / 2, "Incorrect map size");
+        fail_if(strcmp(ls_ordered_map_get(map, LS_INT_TO_PTR(0)), "VALUE: 0") != 0,
+                "Failed to retrieve key 0");
+        fail_if(ls_ordered_map_get(map, LS_INT_TO_PTR(n_items - 1)) != NULL,
+                "Removed key still present");
+
+        ls_ordered_map_iter_init(map, &iter);
+        while (ls_ordered_map_iter_next(&iter, &key, &value)) {
+                fail_if((size_t)LS_PTR_TO_INT(key) != expect, "Iteration order is incorrect");
+                expect += 2;
+        }
+        fail_if(expect != n_items, "Iteration missed items");
+
+        ls_ordered_map_free(map);
+}
+END_TEST
+
+/**
+ * Allocator which fails every request once its budget is spent, so that
+ * a grow can be made to fail part way through
+ */
+typedef struct TestBudget {
+        int remaining;
+} TestBudget;
+
+static void *test_budget_alloc(void *context, size_t size)
+{
+        TestBudget *budget = context;
+
+        if (budget->remaining == 0) {
+                return NULL;
+        }
+        --budget->remaining;
+        return malloc(size);
+}
+
+static void *test_budget_realloc(void *context, void *ptr, __ls_unused__ size_t old_size,
+                                 size_t new_size)
+{
+        TestBudget *budget = context;
+
+        if (budget->remaining == 0) {
+                return NULL;
+        }
+        --budget->remaining;
+        return realloc(ptr, new_size);
+}
+
+static void test_budget_free(__ls_unused__ void *context, void *ptr, __ls_unused__ size_t size)
+{
+        free(ptr);
+}
+
+/**
+ * Check every key below @n_items is present with its own value, in order
+ */
+static bool test_ordered_map_intact(LsOrderedMap *map, size_t n_items)
+{
+        LsOrderedMapIter iter = { 0 };
+        void *key = NULL;
+        void *value = NULL;
+        size_t expect = 0;
+
+        if (ls_ordered_map_size(map) != n_items) {
+                return false;
+        }
+        for (size_t i = 0; i < n_items; i++) {
+                if (ls_ordered_map_get(map, LS_INT_TO_PTR(i)) != LS_INT_TO_PTR(i + 1)) {
+                        return false;
+                }
+        }
+        ls_ordered_map_iter_init(map, &iter);
+        while (ls_ordered_map_iter_next(&iter, &key, &value)) {
+                if ((size_t)LS_PTR_TO_INT(key) != expect++) {
+                        return false;
+                }
+        }
+        return expect == n_items;
+}
+
+/**
+ * A grow that fails on either allocation must leave the map untouched,
+ * even with removed entries that the grow would have compacted away
+ */
+START_TEST(test_ordered_map_grow_failure)
+{
+        TestBudget budget = { .remaining = -1 };
+        LsAllocator allocator = {
+                .alloc = test_budget_alloc,
+                .realloc = test_budget_realloc,
+                .free = test_budget_free,
+                .context = &budget,
+        };
+        LsOrderedMap *map = NULL;
+        size_t n_items = 0;
+
+        map = ls_ordered_map_new_with_allocator(&allocator,
+                                                ls_hashmap_simple_hash,
+                                                ls_hashmap_simple_equal);
+        fail_if(!map, "Failed to construct map");
+
+        /* Leave a removed entry at the front for compaction to move past */
+        fail_if(!ls_ordered_map_put(map, LS_INT_TO_PTR(1000), NULL), "Failed to insert keypair");
+        fail_if(!ls_ordered_map_remove(map, LS_INT_TO_PTR(1000)), "Failed to remove");
+
+        for (size_t allowed = 0; allowed < 2; allowed++) {
+                /* Fill until the next put needs a grow */
+                budget.remaining = 0;
+                while (ls_ordered_map_put(map,
+                                          LS_INT_TO_PTR(n_items),
+                                          LS_INT_TO_PTR(n_items + 1))) {
+                        ++n_items;
+                }
+
+                budget.remaining = (int)allowed;
+                fail_if(ls_ordered_map_put(map, LS_INT_TO_PTR(n_items), NULL),
+                        "Put succeeded without memory");
+                fail_if(!test_ordered_map_intact(map, n_items), "Failed grow corrupted the map");
+
+                budget.remaining = -1;
+                fail_if(!ls_ordered_map_put(map,
+                                            LS_INT_TO_PTR(n_items),
+                                            LS_INT_TO_PTR(n_items + 1)),
+                        "Failed to grow once memory was available");
+                ++n_items;
+                fail_if(!test_ordered_map_intact(map, n_items), "Map corrupted after grow");
+
+                fail_if(!ls_ordered_map_put(map, LS_INT_TO_PTR(1000 + allowed + 1), NULL),
+                        "Failed to insert keypair");
+                fail_if(!ls_ordered_map_remove(map, LS_INT_TO_PTR(1000 + allowed + 1)),
+                        "Failed to remove");
+        }
+
+        ls_ordered_map_free(map);
+}
+END_TEST
+
+/**
+ * Standard helper for running a test suite
+ */
+static int ls_test_run(Suite *suite)
+{
+        SRunner *runner = NULL;
+        int n_failed = 0;
+
+        runner = srunner_create(suite);
+        srunner_run_all(runner, CK_VERBOSE);
+        n_failed = srunner_ntests_failed(runner);
+        srunner_free(runner);
+
+        return n_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static Suite *test_create(void)
+{
+        Suite *s = NULL;
+        TCase *tc = NULL;
+
+        s = suite_create(__FILE__);
+        tc = tcase_create(__FILE__);
+        suite_add_tcase(s, tc);
+
+        tcase_add_test(tc, test_ordered_map_simple);
+        tcase_add_test(tc, test_ordered_map_order);
+        tcase_add_test(tc, test_ordered_map_growth);
+        tcase_add_test(tc, test_ordered_map_grow_failure);
+        return s;
+}
+
+int main(__attribute__((unused)) int argc, __attribute__((unused)) char **argv)
+{
+        return ls_test_run(test_create());
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
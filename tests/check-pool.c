@@ -0,0 +1,313 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <check.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "list.h"
+#include "map.h"
+#include "pool.h"
+
+#define TEST_N_THREADS 8
+#define TEST_N_OBJECTS 1000
+
+START_TEST(test_pool_simple)
+{
+        LsPool *pool = NULL;
+        void *objects[TEST_N_OBJECTS] = { 0 };
+        void *first = NULL;
+
+        fail_if(ls_pool_new(0) != NULL, "Constructed a pool of empty objects");
+
+        pool = ls_pool_new(20);
+        fail_if(!pool, "Failed to construct pool");
+        fail_if(ls_pool_object_size(pool) != 24, "Object size not rounded up");
+
+        for (int i = 0; i < TEST_N_OBJECTS; i++) {
+                objects[i] = ls_pool_alloc(pool);
+                fail_if(!objects[i], "Failed to allocate object");
+                fail_if((uintptr_t)objects[i] % sizeof(void *) != 0, "Misaligned object");
+                memset(objects[i], i & 0xFF, 20);
+        }
+
+        /* Nothing may overlap */
+        for (int i = 0; i < TEST_N_OBJECTS; i++) {
+                const unsigned char *p = objects[i];
+                for (int j = 0; j < 20; j++) {
+                        fail_if(p[j] != (i & 0xFF), "Objects overlap");
+                }
+        }
+
+        for (int i = 0; i < TEST_N_OBJECTS; i++) {
+                ls_pool_release(pool, objects[i]);
+        }
+
+        /* Last in, first out from this thread's cache */
+        first = ls_pool_alloc(pool);
+        fail_if(first != objects[TEST_N_OBJECTS - 1], "Released object not reused");
+        ls_pool_release(pool, first);
+        ls_pool_release(pool, NULL);
+
+        ls_pool_free(pool);
+        ls_pool_free(NULL);
+}
+END_TEST
+
+START_TEST(test_pool_bulk)
+{
+        LsPool *pool = NULL;
+        void *objects[TEST_N_OBJECTS] = { 0 };
+        void *again[TEST_N_OBJECTS] = { 0 };
+        size_t n = 0;
+
+        pool = ls_pool_new(sizeof(uint64_t));
+        fail_if(!pool, "Failed to construct pool");
+
+        n = ls_pool_alloc_bulk(pool, objects, TEST_N_OBJECTS);
+        fail_if(n != TEST_N_OBJECTS, "Failed to allocate in bulk");
+        for (size_t i = 0; i < n; i++) {
+                *(uint64_t *)objects[i] = i;
+        }
+        for (size_t i = 0; i < n; i++) {
+                fail_if(*(uint64_t *)objects[i] != i, "Bulk objects overlap");
+        }
+
+        /* Mix bulk with single operations */
+        ls_pool_release_bulk(pool, objects, 10);
+        ls_pool_release(pool, objects[10]);
+        ls_pool_release_bulk(pool, objects + 11, n - 11);
+
+        /* Everything comes back without carving new slab space */
+        n = ls_pool_alloc_bulk(pool, again, TEST_N_OBJECTS);
+        fail_if(n != TEST_N_OBJECTS, "Failed to allocate in bulk");
+        for (size_t i = 0; i < n; i++) {
+                bool found = false;
+                for (size_t j = 0; j < n && !found; j++) {
+                        found = again[i] == objects[j];
+                }
+                fail_if(!found, "Bulk allocation did not reuse released objects");
+        }
+        ls_pool_release_bulk(pool, again, n);
+
+        ls_pool_free(pool);
+}
+END_TEST
+
+typedef struct TestPoolShared {
+        LsPool *pool;
+        void *handoff[TEST_N_THREADS][TEST_N_OBJECTS];
+        pthread_barrier_t barrier;
+} TestPoolShared;
+
+typedef struct TestPoolThread {
+        TestPoolShared *shared;
+        pthread_t thread;
+        unsigned int id;
+        bool ok;
+} TestPoolThread;
+
+/**
+ * Churn through the pool, then free objects allocated by a neighbour so
+ * that magazines migrate between threads through the depot
+ */
+static void *test_pool_worker(void *v)
+{
+        TestPoolThread *self = v;
+        TestPoolShared *shared = self->shared;
+        void *objects[TEST_N_OBJECTS];
+        uintptr_t tag = (uintptr_t)self->id << 32;
+
+        self->ok = true;
+
+        for (int round = 0; round < 50; round++) {
+                for (uintptr_t i = 0; i < TEST_N_OBJECTS; i++) {
+                        objects[i] = ls_pool_alloc(shared->pool);
+                        if (!objects[i]) {
+                                self->ok = false;
+                                return NULL;
+                        }
+                        *(uintptr_t *)objects[i] = tag | i;
+                }
+                for (uintptr_t i = 0; i < TEST_N_OBJECTS; i++) {
+                        if (*(uintptr_t *)objects[i] != (tag | i)) {
+                                self->ok = false;
+                        }
+                }
+                if (round % 2) {
+                        ls_pool_release_bulk(shared->pool, objects, TEST_N_OBJECTS);
+                } else {
+                        for (int i = TEST_N_OBJECTS - 1; i >= 0; i--) {
+                                ls_pool_release(shared->pool, objects[i]);
+                        }
+                }
+        }
+
+        if (ls_pool_alloc_bulk(shared->pool, shared->handoff[self->id], TEST_N_OBJECTS) !=
+            TEST_N_OBJECTS) {
+                self->ok = false;
+        }
+        pthread_barrier_wait(&shared->barrier);
+
+        ls_pool_release_bulk(shared->pool,
+                             shared->handoff[(self->id + 1) % TEST_N_THREADS],
+                             TEST_N_OBJECTS);
+        return NULL;
+}
+
+START_TEST(test_pool_threads)
+{
+        static TestPoolShared shared;
+        TestPoolThread threads[TEST_N_THREADS];
+        void *object = NULL;
+
+        shared.pool = ls_pool_new(sizeof(uintptr_t));
+        fail_if(!shared.pool, "Failed to construct pool");
+        pthread_barrier_init(&shared.barrier, NULL, TEST_N_THREADS);
+
+        for (unsigned int i = 0; i < TEST_N_THREADS; i++) {
+                threads[i].shared = &shared;
+                threads[i].id = i;
+                fail_if(pthread_create(&threads[i].thread, NULL, test_pool_worker, &threads[i]) !=
+                            0,
+                        "Failed to create thread");
+        }
+        for (unsigned int i = 0; i < TEST_N_THREADS; i++) {
+                pthread_join(threads[i].thread, NULL);
+                fail_if(!threads[i].ok, "Worker saw corrupted objects");
+        }
+
+        /* Exited threads returned their caches to the depot */
+        object = ls_pool_alloc(shared.pool);
+        fail_if(!object, "Failed to allocate after thread exit");
+        ls_pool_release(shared.pool, object);
+
+        pthread_barrier_destroy(&shared.barrier);
+        ls_pool_free(shared.pool);
+}
+END_TEST
+
+START_TEST(test_pool_allocator)
+{
+        LsPool *pool = NULL;
+        const LsAllocator *allocator = NULL;
+        LsHashmap *map = NULL;
+        LsList *list = NULL;
+        LsPool *list_pool = NULL;
+        void *p = NULL;
+
+        pool = ls_pool_new(ls_hashmap_node_size());
+        fail_if(!pool, "Failed to construct pool");
+        allocator = ls_pool_allocator(pool);
+
+        /* Mismatched sizes go to the heap, and may move in and out */
+        p = allocator->alloc(allocator->context, ls_pool_object_size(pool));
+        fail_if(!p, "Failed to allocate from pool");
+        memset(p, 0x42, ls_pool_object_size(pool));
+        p = allocator->realloc(allocator->context, p, ls_pool_object_size(pool), 4096);
+        fail_if(!p || ((unsigned char *)p)[0] != 0x42, "Lost data moving out of the pool");
+        p = allocator->realloc(allocator->context, p, 4096, ls_pool_object_size(pool));
+        fail_if(!p || ((unsigned char *)p)[1] != 0x42, "Lost data moving into the pool");
+        allocator->free(allocator->context, p, ls_pool_object_size(pool));
+
+        map = ls_hashmap_new_with_allocator(allocator,
+                                            ls_hashmap_simple_hash,
+                                            ls_hashmap_simple_equal);
+        fail_if(!map, "Failed to construct map");
+        for (int i = 1; i < 10000; i++) {
+                fail_if(!ls_hashmap_put(map, LS_INT_TO_PTR(i), LS_INT_TO_PTR(i)), "Failed to put");
+        }
+        for (int i = 1; i < 10000; i++) {
+                fail_if(ls_hashmap_get(map, LS_INT_TO_PTR(i)) != LS_INT_TO_PTR(i), "Bad lookup");
+        }
+        ls_hashmap_free(map);
+
+        list_pool = ls_pool_new(sizeof(LsList));
+        fail_if(!list_pool, "Failed to construct pool");
+        for (int i = 1; i < 1000; i++) {
+                list = ls_list_prepend_with_allocator(ls_pool_allocator(list_pool),
+                                                      list,
+                                                      LS_INT_TO_PTR(i));
+                fail_if(!list, "Failed to prepend");
+        }
+        fail_if(ls_list_length(list) != 999, "Incorrect list length");
+        ls_list_free_with_allocator(ls_pool_allocator(list_pool), list);
+
+        ls_pool_free(list_pool);
+        ls_pool_free(pool);
+}
+END_TEST
+
+/**
+ * Standard helper for running a test suite
+ */
+static int ls_test_run(Suite *suite)
+{
+        SRunner *runner = NULL;
+        int n_failed = 0;
+
+        runner = srunner_create(suite);
+        srunner_run_all(runner, CK_VERBOSE);
+        n_failed = srunner_ntests_failed(runner);
+        srunner_free(runner);
+
+        return n_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static Suite *test_create(void)
+{
+        Suite *s = NULL;
+        TCase *tc = NULL;
+
+        s = suite_create(__FILE__);
+        tc = tcase_create(__FILE__);
+        suite_add_tcase(s, tc);
+
+        tcase_add_test(tc, test_pool_simple);
+        tcase_add_test(tc, test_pool_bulk);
+        tcase_add_test(tc, test_pool_threads);
+        tcase_add_test(tc, test_pool_allocator);
+        return s;
+}
+
+int main(__attribute__((unused)) int argc, __attribute__((unused)) char **argv)
+{
+        return ls_test_run(test_create());
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
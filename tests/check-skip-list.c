@@ -0,0 +1,233 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <check.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "skip-list.h"
+
+/**
+ * Order integer keys stored directly in the pointer
+ */
+static int test_skip_list_int_compare(const void *a, const void *b)
+{
+        uintptr_t x = (uintptr_t)a;
+        uintptr_t y = (uintptr_t)b;
+
+        return (x > y) - (x < y);
+}
+
+static int test_skip_list_str_compare(const void *a, const void *b)
+{
+        return strcmp(a, b);
+}
+
+START_TEST(test_skip_list_simple)
+{
+        LsSkipList *list = NULL;
+
+        list = ls_skip_list_new(test_skip_list_int_compare);
+        fail_if(!list, "Failed to construct list");
+        fail_if(ls_skip_list_size(list) != 0, "New list should be empty");
+        fail_if(ls_skip_list_get(list, (void *)1) != NULL, "Empty list should not find keys");
+        fail_if(ls_skip_list_remove(list, (void *)1), "Empty list should not remove keys");
+
+        fail_if(!ls_skip_list_put(list, (void *)5, "five"), "Failed to put");
+        fail_if(!ls_skip_list_put(list, (void *)1, "one"), "Failed to put");
+        fail_if(!ls_skip_list_put(list, (void *)9, "nine"), "Failed to put");
+        fail_if(ls_skip_list_size(list) != 3, "Size should be 3");
+
+        fail_if(strcmp(ls_skip_list_get(list, (void *)5), "five") != 0, "Wrong value for 5");
+        fail_if(ls_skip_list_get(list, (void *)6) != NULL, "Should not find missing key");
+
+        fail_if(!ls_skip_list_put(list, (void *)5, "FIVE"), "Failed to replace");
+        fail_if(ls_skip_list_size(list) != 3, "Replace should not change size");
+        fail_if(strcmp(ls_skip_list_get(list, (void *)5), "FIVE") != 0, "Value not replaced");
+
+        fail_if(!ls_skip_list_remove(list, (void *)5), "Failed to remove");
+        fail_if(ls_skip_list_remove(list, (void *)5), "Removed key twice");
+        fail_if(ls_skip_list_get(list, (void *)5) != NULL, "Removed key still present");
+        fail_if(ls_skip_list_size(list) != 2, "Size should be 2");
+
+        ls_skip_list_free(list);
+}
+END_TEST
+
+START_TEST(test_skip_list_order)
+{
+        LsSkipList *list = NULL;
+        LsSkipListIter iter = { 0 };
+        void *key = NULL;
+        void *value = NULL;
+        uintptr_t expect = 0;
+
+        list = ls_skip_list_new(test_skip_list_int_compare);
+        fail_if(!list, "Failed to construct list");
+
+        /* Scatter the insertion order with a stride coprime to the size */
+        for (uintptr_t i = 0; i < 10000; i++) {
+                uintptr_t k = (i * 7919) % 10000;
+                fail_if(!ls_skip_list_put(list, (void *)k, (void *)(k * 2)), "Failed to put");
+        }
+        fail_if(ls_skip_list_size(list) != 10000, "Size should be 10000");
+
+        ls_skip_list_iter_init(list, &iter);
+        while (ls_skip_list_iter_next(&iter, &key, &value)) {
+                fail_if((uintptr_t)key != expect, "Keys out of order");
+                fail_if((uintptr_t)value != expect * 2, "Wrong value for key");
+                ++expect;
+        }
+        fail_if(expect != 10000, "Iteration missed keys");
+
+        /* Remove every odd key, recycling their nodes for new keys */
+        for (uintptr_t k = 1; k < 10000; k += 2) {
+                fail_if(!ls_skip_list_remove(list, (void *)k), "Failed to remove");
+        }
+        for (uintptr_t k = 10000; k < 15000; k++) {
+                fail_if(!ls_skip_list_put(list, (void *)k, (void *)(k * 2)), "Failed to put");
+        }
+
+        expect = 0;
+        ls_skip_list_iter_init(list, &iter);
+        while (ls_skip_list_iter_next(&iter, &key, NULL)) {
+                fail_if((uintptr_t)key != expect, "Keys out of order after removal");
+                expect += expect < 10000 ? 2 : 1;
+        }
+        fail_if(expect != 15000, "Iteration missed keys after removal");
+        fail_if(ls_skip_list_size(list) != 10000, "Size should be 10000 after churn");
+
+        ls_skip_list_free(list);
+}
+END_TEST
+
+START_TEST(test_skip_list_range)
+{
+        LsSkipList *list = NULL;
+        LsSkipListIter iter = { 0 };
+        void *key = NULL;
+        void *value = NULL;
+        int n = 0;
+
+        list = ls_skip_list_new(test_skip_list_int_compare);
+        fail_if(!list, "Failed to construct list");
+
+        for (uintptr_t k = 10; k <= 100; k += 10) {
+                fail_if(!ls_skip_list_put(list, (void *)k, (void *)k), "Failed to put");
+        }
+
+        fail_if(!ls_skip_list_lower_bound(list, (void *)35, &key, &value), "No lower bound");
+        fail_if((uintptr_t)key != 40, "Lower bound should be 40");
+        fail_if(!ls_skip_list_lower_bound(list, (void *)40, &key, NULL), "No exact bound");
+        fail_if((uintptr_t)key != 40, "Exact lower bound should be 40");
+        fail_if(!ls_skip_list_lower_bound(list, (void *)0, &key, NULL), "No lowest bound");
+        fail_if((uintptr_t)key != 10, "Lowest bound should be 10");
+        fail_if(ls_skip_list_lower_bound(list, (void *)101, &key, NULL), "Bound past the end");
+
+        /* Scan the band [25, 65) */
+        ls_skip_list_iter_init_at(list, (void *)25, &iter);
+        while (ls_skip_list_iter_next(&iter, &key, NULL) && (uintptr_t)key < 65) {
+                ++n;
+        }
+        fail_if(n != 4, "Range should hold 30, 40, 50 and 60");
+
+        ls_skip_list_iter_init_at(list, (void *)200, &iter);
+        fail_if(ls_skip_list_iter_next(&iter, &key, NULL), "Iteration past the end");
+
+        ls_skip_list_free(list);
+}
+END_TEST
+
+START_TEST(test_skip_list_free_full)
+{
+        LsSkipList *list = NULL;
+        char buf[32];
+
+        list = ls_skip_list_new_full(test_skip_list_str_compare, free, free);
+        fail_if(!list, "Failed to construct list");
+
+        for (int i = 0; i < 200; i++) {
+                snprintf(buf, sizeof(buf), "key-%03d", i);
+                fail_if(!ls_skip_list_put(list, strdup(buf), strdup("value")), "Failed to put");
+        }
+        fail_if(!ls_skip_list_put(list, strdup("key-000"), strdup("replaced")), "Failed to put");
+        fail_if(strcmp(ls_skip_list_get(list, "key-000"), "replaced") != 0, "Not replaced");
+        fail_if(!ls_skip_list_remove(list, "key-100"), "Failed to remove");
+
+        /* ASAN will complain about any leaked strings */
+        ls_skip_list_free(list);
+}
+END_TEST
+
+/**
+ * Standard helper for running a test suite
+ */
+static int ls_test_run(Suite *suite)
+{
+        SRunner *runner = NULL;
+        int n_failed = 0;
+
+        runner = srunner_create(suite);
+        srunner_run_all(runner, CK_VERBOSE);
+        n_failed = srunner_ntests_failed(runner);
+        srunner_free(runner);
+
+        return n_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static Suite *test_create(void)
+{
+        Suite *s = NULL;
+        TCase *tc = NULL;
+
+        s = suite_create(__FILE__);
+        tc = tcase_create(__FILE__);
+        suite_add_tcase(s, tc);
+
+        tcase_add_test(tc, test_skip_list_simple);
+        tcase_add_test(tc, test_skip_list_order);
+        tcase_add_test(tc, test_skip_list_range);
+        tcase_add_test(tc, test_skip_list_free_full);
+        return s;
+}
+
+int main(__attribute__((unused)) int argc, __attribute__((unused)) char **argv)
+{
+        return ls_test_run(test_create());
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,300 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <check.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "array.h"
+#include "macros.h"
+#include "map.h"
+#include "ptr-array.h"
+#include "snapshot.h"
+
+/**
+ * Create a unique scratch path for a snapshot
+ */
+static char *test_snapshot_path(void)
+{
+        char *path = strdup("/tmp/libls-snapshot-XXXXXX");
+        int fd = mkstemp(path);
+
+        if (fd < 0) {
+                abort();
+        }
+        close(fd);
+        return path;
+}
+
+/**
+ * Save a string map and reload it into both an unseeded and a seeded map
+ */
+START_TEST(test_snapshot_map)
+{
+        LsHashmap *map = NULL;
+        LsHashmap *loaded = NULL;
+        char *path = test_snapshot_path();
+
+        map = ls_hashmap_new_full(ls_hashmap_string_hash, ls_hashmap_string_equal, free, free);
+        fail_if(!map, "Failed to construct hashmap");
+
+        for (size_t i = 0; i < 5000; i++) {
+                char *k = NULL;
+                char *v = NULL;
+                if (asprintf(&k, "KEY: %ld", i) < 0 || asprintf(&v, "VALUE: %ld", i) < 0) {
+                        abort();
+                }
+                fail_if(!ls_hashmap_put(map, k, v), "Failed to insert keypair");
+        }
+
+        fail_if(!ls_hashmap_save(map, path, ls_snapshot_write_string, ls_snapshot_write_string),
+                "Failed to save hashmap");
+
+        loaded = ls_hashmap_new_full(ls_hashmap_string_hash, ls_hashmap_string_equal, free, free);
+        fail_if(!loaded, "Failed to construct hashmap");
+        fail_if(!ls_hashmap_load(loaded, path, ls_snapshot_read_string, ls_snapshot_read_string),
+                "Failed to load hashmap");
+        fail_if(strcmp(ls_hashmap_get(loaded, "KEY: 0"), "VALUE: 0") != 0, "Incorrect value");
+        fail_if(strcmp(ls_hashmap_get(loaded, "KEY: 4999"), "VALUE: 4999") != 0,
+                "Incorrect value");
+
+        /* Map must keep working normally after a bulk load */
+        fail_if(!ls_hashmap_put(loaded, strdup("KEY: 5000"), strdup("VALUE: 5000")),
+                "Failed to insert after load");
+        fail_if(strcmp(ls_hashmap_get(loaded, "KEY: 5000"), "VALUE: 5000") != 0,
+                "Incorrect value");
+        ls_hashmap_free(loaded);
+
+        loaded = ls_hashmap_new_seeded_full(ls_hashmap_string_hash_seeded,
+                                            ls_hashmap_string_equal,
+                                            free,
+                                            free);
+        fail_if(!loaded, "Failed to construct seeded hashmap");
+        fail_if(!ls_hashmap_load(loaded, path, ls_snapshot_read_string, ls_snapshot_read_string),
+                "Failed to load seeded hashmap");
+        fail_if(strcmp(ls_hashmap_get(loaded, "KEY: 1234"), "VALUE: 1234") != 0,
+                "Incorrect value in seeded map");
+        ls_hashmap_free(loaded);
+
+        ls_hashmap_free(map);
+        unlink(path);
+        free(path);
+}
+END_TEST
+
+START_TEST(test_snapshot_array)
+{
+        LsPtrArray *array = NULL;
+        LsPtrArray *loaded = NULL;
+        char *path = test_snapshot_path();
+        struct stat st = { 0 };
+        mode_t mask = 0;
+
+        array = ls_ptr_array_new();
+        fail_if(!array, "Failed to construct pointer array");
+
+        fail_if(!ls_array_add(array, strdup("john")), "Failed to add john");
+        fail_if(!ls_array_add(array, strdup("bobby")), "Failed to add bobby");
+        fail_if(!ls_array_add(array, strdup("")), "Failed to add empty string");
+
+        fail_if(!ls_array_save(array, path, ls_snapshot_write_string), "Failed to save array");
+
+        /* Saved snapshots get the usual 0666 less umask, not mkstemp's 0600 */
+        mask = umask(022);
+        fail_if(!ls_array_save(array, path, ls_snapshot_write_string), "Failed to save array");
+        umask(mask);
+        fail_if(stat(path, &st) != 0, "Failed to stat snapshot");
+        fail_if((st.st_mode & 0777) != 0644, "Snapshot has the wrong mode");
+
+        loaded = ls_ptr_array_new();
+        fail_if(!loaded, "Failed to construct pointer array");
+        fail_if(!ls_array_add(loaded, strdup("rupert")), "Failed to add rupert");
+        fail_if(!ls_array_load(loaded, path, ls_snapshot_read_string), "Failed to load array");
+
+        fail_if(loaded->len != 4, "Incorrect array length");
+        fail_if(strcmp(loaded->data[0], "rupert") != 0, "Existing item was lost");
+        fail_if(strcmp(loaded->data[1], "john") != 0, "Failed to get john");
+        fail_if(strcmp(loaded->data[2], "bobby") != 0, "Failed to get bobby");
+        fail_if(strcmp(loaded->data[3], "") != 0, "Failed to get empty string");
+
+        ls_array_free(loaded, free);
+        ls_array_free(array, free);
+        unlink(path);
+        free(path);
+}
+END_TEST
+
+/**
+ * Mismatched kinds and garbage must be rejected cleanly
+ */
+START_TEST(test_snapshot_invalid)
+{
+        LsPtrArray *array = NULL;
+        LsHashmap *map = NULL;
+        char *path = test_snapshot_path();
+        FILE *fp = NULL;
+
+        array = ls_ptr_array_new();
+        fail_if(!array, "Failed to construct pointer array");
+        fail_if(!ls_array_add(array, strdup("john")), "Failed to add john");
+        fail_if(!ls_array_save(array, path, ls_snapshot_write_string), "Failed to save array");
+
+        map = ls_hashmap_new_full(ls_hashmap_string_hash, ls_hashmap_string_equal, free, free);
+        fail_if(!map, "Failed to construct hashmap");
+        fail_if(ls_hashmap_load(map, path, ls_snapshot_read_string, ls_snapshot_read_string),
+                "Loaded an array snapshot as a hashmap");
+
+        fp = fopen(path, "w");
+        fail_if(!fp, "Failed to open snapshot for writing");
+        fputs("this is not a snapshot, it is just some text", fp);
+        fclose(fp);
+        fail_if(ls_array_load(array, path, ls_snapshot_read_string), "Loaded garbage");
+        fail_if(array->len != 1, "Array modified by failed load");
+
+        fail_if(ls_array_load(array, "/nonexistent/snapshot", ls_snapshot_read_string),
+                "Loaded a missing file");
+
+        ls_hashmap_free(map);
+        ls_array_free(array, free);
+        unlink(path);
+        free(path);
+}
+END_TEST
+
+/**
+ * Overwrite the item count stored in a snapshot header
+ */
+static void test_snapshot_forge_count(const char *path, uint64_t count)
+{
+        /* magic[8] followed by four uint32_t fields */
+        const long count_offset = 24;
+        FILE *fp = fopen(path, "r+");
+
+        if (!fp || fseek(fp, count_offset, SEEK_SET) != 0 ||
+            fwrite(&count, sizeof(count), 1, fp) != 1) {
+                abort();
+        }
+        fclose(fp);
+}
+
+/**
+ * A forged count must be rejected before anything is sized from it
+ */
+START_TEST(test_snapshot_forged_count)
+{
+        LsPtrArray *array = NULL;
+        LsHashmap *map = NULL;
+        LsHashmapStats before = { 0 };
+        LsHashmapStats after = { 0 };
+        char *path = test_snapshot_path();
+
+        map = ls_hashmap_new_full(ls_hashmap_string_hash, ls_hashmap_string_equal, free, free);
+        fail_if(!map, "Failed to construct hashmap");
+        fail_if(!ls_hashmap_put(map, strdup("john"), strdup("smith")), "Failed to insert john");
+        fail_if(!ls_hashmap_save(map, path, ls_snapshot_write_string, ls_snapshot_write_string),
+                "Failed to save hashmap");
+        ls_hashmap_free(map);
+
+        map = ls_hashmap_new_full(ls_hashmap_string_hash, ls_hashmap_string_equal, free, free);
+        fail_if(!map, "Failed to construct hashmap");
+        fail_if(!ls_hashmap_stats(map, &before), "Failed to get hashmap stats");
+        test_snapshot_forge_count(path, 1ULL << 40);
+        fail_if(ls_hashmap_load(map, path, ls_snapshot_read_string, ls_snapshot_read_string),
+                "Loaded a hashmap with a forged count");
+        test_snapshot_forge_count(path, 2);
+        fail_if(ls_hashmap_load(map, path, ls_snapshot_read_string, ls_snapshot_read_string),
+                "Loaded a hashmap with a count beyond the file size");
+        fail_if(!ls_hashmap_stats(map, &after), "Failed to get hashmap stats");
+        fail_if(after.n_items != 0, "Hashmap modified by failed load");
+        fail_if(after.n_buckets != before.n_buckets, "Hashmap sized from a forged count");
+        ls_hashmap_free(map);
+
+        array = ls_ptr_array_new();
+        fail_if(!array, "Failed to construct pointer array");
+        fail_if(!ls_array_add(array, strdup("john")), "Failed to add john");
+        fail_if(!ls_array_save(array, path, ls_snapshot_write_string), "Failed to save array");
+        test_snapshot_forge_count(path, UINT64_MAX);
+        fail_if(ls_array_load(array, path, ls_snapshot_read_string),
+                "Loaded an array with a forged count");
+        fail_if(array->len != 1, "Array modified by failed load");
+
+        ls_array_free(array, free);
+        unlink(path);
+        free(path);
+}
+END_TEST
+
+/**
+ * Standard helper for running a test suite
+ */
+static int ls_test_run(Suite *suite)
+{
+        SRunner *runner = NULL;
+        int n_failed = 0;
+
+        runner = srunner_create(suite);
+        srunner_run_all(runner, CK_VERBOSE);
+        n_failed = srunner_ntests_failed(runner);
+        srunner_free(runner);
+
+        return n_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static Suite *test_create(void)
+{
+        Suite *s = NULL;
+        TCase *tc = NULL;
+
+        s = suite_create(__FILE__);
+        tc = tcase_create(__FILE__);
+        suite_add_tcase(s, tc);
+
+        tcase_add_test(tc, test_snapshot_map);
+        tcase_add_test(tc, test_snapshot_array);
+        tcase_add_test(tc, test_snapshot_invalid);
+        tcase_add_test(tc, test_snapshot_forged_count);
+        return s;
+}
+
+int main(__attribute__((unused)) int argc, __attribute__((unused)) char **argv)
+{
+        return ls_test_run(test_create());
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
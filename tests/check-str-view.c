@@ -0,0 +1,270 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "map.h"
+#include "ptr-array.h"
+#include "str-view.h"
+
+START_TEST(test_str_view_simple)
+{
+        const char *text = "  \tkey = value\r\n";
+        LsStrView view = ls_str_view_from_cstr(text);
+        LsStrView trimmed = ls_str_view_trim(view);
+        LsStrView key;
+        char *dup = NULL;
+        size_t eq;
+
+        fail_if(view.len != strlen(text), "Incorrect view length");
+        fail_if(!ls_str_view_equal_cstr(trimmed, "key = value"), "Incorrect trim");
+        fail_if(ls_str_view_equal_cstr(trimmed, "key = valu"), "Shorter string compared equal");
+        fail_if(ls_str_view_equal_cstr(trimmed, "key = values"), "Longer string compared equal");
+
+        eq = ls_str_view_find(trimmed, '=');
+        fail_if(eq != 4, "Incorrect find offset");
+        fail_if(ls_str_view_find(trimmed, '#') != trimmed.len, "Found a missing byte");
+
+        key = ls_str_view_trim(ls_str_view(trimmed.data, eq));
+        fail_if(!ls_str_view_equal(key, ls_str_view("key", 3)), "Incorrect key view");
+        fail_if(ls_str_view_equal(key, ls_str_view("kez", 3)), "Different views compared equal");
+        fail_if(ls_str_view_trim(ls_str_view_from_cstr(" \n ")).len != 0, "Blank trim not empty");
+
+        dup = ls_str_view_dup(key);
+        fail_if(!dup || strcmp(dup, "key") != 0, "Incorrect duplicate");
+        free(dup);
+
+        fail_if(ls_str_view_hash(key) != ls_hashmap_string_hash("key"),
+                "Hash differs from the map string hash");
+        fail_if(ls_str_view_hash(ls_str_view_from_cstr("\xc3\xa9t\xc3\xa9")) !=
+                    ls_hashmap_string_hash("\xc3\xa9t\xc3\xa9"),
+                "Hash differs for high bytes");
+}
+END_TEST
+
+/**
+ * Views work directly as map keys, with no copies made for lookups
+ */
+START_TEST(test_str_view_map)
+{
+        const char *text = "alpha beta gamma delta";
+        LsStrView keys[4];
+        LsStrView needle;
+        LsStrSplitter splitter;
+        LsHashmap *map = NULL;
+        int n = 0;
+
+        map = ls_hashmap_new(ls_str_view_key_hash, ls_str_view_key_equal);
+        fail_if(!map, "Failed to construct map");
+
+        fail_if(!ls_str_splitter_init(&splitter, ls_str_view_from_cstr(text), " "),
+                "Failed to init splitter");
+        while (ls_str_splitter_next(&splitter, &keys[n])) {
+                fail_if(!ls_hashmap_put(map, &keys[n], LS_INT_TO_PTR(n + 1)), "Failed to put");
+                ++n;
+        }
+        fail_if(n != 4, "Incorrect token count");
+
+        needle = ls_str_view("gamma", 5);
+        fail_if(ls_hashmap_get(map, &needle) != LS_INT_TO_PTR(3), "Failed view lookup");
+        needle = ls_str_view("gamm", 4);
+        fail_if(ls_hashmap_get(map, &needle) != NULL, "Prefix should not match");
+
+        ls_hashmap_free(map);
+}
+END_TEST
+
+/**
+ * Parse a small config, keeping only the keys we want
+ */
+START_TEST(test_str_splitter)
+{
+        const char *config = "# comment\nwidth=1920\n\nheight = 1080\r\nvsync=on\nbad line\n";
+        const char *expected[] = { "# comment", "width=1920", "", "height = 1080\r",
+                                   "vsync=on",  "bad line",   "" };
+        LsStrSplitter lines;
+        LsStrSplitter fields;
+        LsStrView line;
+        LsStrView field;
+        LsPtrArray *kept = NULL;
+        size_t n = 0;
+
+        fail_if(ls_str_splitter_init(&lines, ls_str_view_from_cstr(config), ""),
+                "Accepted an empty delimiter set");
+        fail_if(ls_str_splitter_init(&lines, ls_str_view_from_cstr(config), "0123456789"),
+                "Accepted too many delimiters");
+
+        /* strsep semantics, every delimiter ends a token */
+        fail_if(!ls_str_splitter_init(&lines, ls_str_view_from_cstr(config), "\n"),
+                "Failed to init splitter");
+        while (ls_str_splitter_next(&lines, &line)) {
+                fail_if(n >= LS_ARRAY_SIZE(expected), "Too many lines");
+                fail_if(!ls_str_view_equal_cstr(line, expected[n]), "Incorrect line");
+                ++n;
+        }
+        fail_if(n != LS_ARRAY_SIZE(expected), "Too few lines");
+        fail_if(ls_str_splitter_next(&lines, &line), "Splitter restarted");
+
+        kept = ls_ptr_array_new();
+        fail_if(!ls_str_splitter_init(&lines, ls_str_view_from_cstr(config), "\r\n"),
+                "Failed to init splitter");
+        while (ls_str_splitter_next(&lines, &line)) {
+                LsStrView key;
+
+                line = ls_str_view_trim(line);
+                if (line.len == 0 || line.data[0] == '#') {
+                        continue;
+                }
+                fail_if(!ls_str_splitter_init(&fields, line, "="), "Failed to init splitter");
+                fail_if(!ls_str_splitter_next(&fields, &key), "Missing key");
+                if (!ls_str_splitter_next(&fields, &field)) {
+                        continue;
+                }
+                key = ls_str_view_trim(key);
+                if (ls_str_view_equal_cstr(key, "width") || ls_str_view_equal_cstr(key, "vsync")) {
+                        fail_if(!ls_array_add(kept, ls_str_view_dup(ls_str_view_trim(field))),
+                                "Failed to keep value");
+                }
+        }
+        fail_if(kept->len != 2, "Incorrect kept value count");
+        fail_if(strcmp(kept->data[0], "1920") != 0, "Incorrect kept value");
+        fail_if(strcmp(kept->data[1], "on") != 0, "Incorrect kept value");
+        ls_array_free(kept, free);
+
+        /* An empty input has a single empty token */
+        fail_if(!ls_str_splitter_init(&lines, ls_str_view("", 0), ","), "Failed to init");
+        fail_if(!ls_str_splitter_next(&lines, &line) || line.len != 0, "Expected empty token");
+        fail_if(ls_str_splitter_next(&lines, &line), "Expected a single token");
+
+        /* As does a NULL view, without touching the pointer */
+        fail_if(!ls_str_splitter_init(&lines, ls_str_view(NULL, 0), ","), "Failed to init");
+        fail_if(!ls_str_splitter_next(&lines, &line) || line.len != 0, "Expected empty token");
+        fail_if(ls_str_splitter_next(&lines, &line), "Expected a single token");
+        fail_if(ls_str_view_find(ls_str_view(NULL, 0), ',') != 0, "Found a byte in nothing");
+        fail_if(!ls_str_view_equal(ls_str_view(NULL, 0), ls_str_view("", 0)),
+                "Empty views differ");
+        fail_if(!ls_str_view_equal_cstr(ls_str_view(NULL, 0), ""), "Empty view differs");
+}
+END_TEST
+
+/**
+ * Check the vector scan against a naive split for delimiters at every
+ * position across vector boundaries
+ */
+START_TEST(test_str_splitter_scan)
+{
+        char buffer[300];
+        const char *delimiter_sets[] = { ",", ",;", ",;:|\t \n\xff" };
+
+        for (size_t s = 0; s < LS_ARRAY_SIZE(delimiter_sets); s++) {
+                const char *delimiters = delimiter_sets[s];
+                size_t n_delimiters = strlen(delimiters);
+
+                for (unsigned int seed = 1; seed < 200; seed++) {
+                        LsStrSplitter splitter;
+                        LsStrView token;
+                        size_t len = (seed * 7) % sizeof(buffer);
+                        size_t start = 0;
+                        unsigned int state = seed;
+
+                        for (size_t i = 0; i < len; i++) {
+                                state = state * 1103515245 + 12345;
+                                if ((state >> 16) % 13 == 0) {
+                                        buffer[i] = delimiters[(state >> 8) % n_delimiters];
+                                } else {
+                                        buffer[i] = (char)('a' + (state >> 20) % 26);
+                                }
+                        }
+
+                        fail_if(!ls_str_splitter_init(&splitter, ls_str_view(buffer, len),
+                                                      delimiters),
+                                "Failed to init splitter");
+
+                        for (size_t i = 0; i <= len; i++) {
+                                if (i < len && !strchr(delimiters, buffer[i])) {
+                                        continue;
+                                }
+                                fail_if(!ls_str_splitter_next(&splitter, &token), "Lost a token");
+                                fail_if(token.data != buffer + start || token.len != i - start,
+                                        "Token does not match the naive split");
+                                start = i + 1;
+                        }
+                        fail_if(ls_str_splitter_next(&splitter, &token), "Extra token");
+                }
+        }
+}
+END_TEST
+
+/**
+ * Standard helper for running a test suite
+ */
+static int ls_test_run(Suite *suite)
+{
+        SRunner *runner = NULL;
+        int n_failed = 0;
+
+        runner = srunner_create(suite);
+        srunner_run_all(runner, CK_VERBOSE);
+        n_failed = srunner_ntests_failed(runner);
+        srunner_free(runner);
+
+        return n_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static Suite *test_create(void)
+{
+        Suite *s = NULL;
+        TCase *tc = NULL;
+
+        s = suite_create(__FILE__);
+        tc = tcase_create(__FILE__);
+        suite_add_tcase(s, tc);
+
+        tcase_add_test(tc, test_str_view_simple);
+        tcase_add_test(tc, test_str_view_map);
+        tcase_add_test(tc, test_str_splitter);
+        tcase_add_test(tc, test_str_splitter_scan);
+        return s;
+}
+
+int main(__attribute__((unused)) int argc, __attribute__((unused)) char **argv)
+{
+        return ls_test_run(test_create());
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,291 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "map.h"
+#include "string-builder.h"
+
+START_TEST(test_string_inline)
+{
+        LsString string;
+        char expected[LS_STRING_INLINE_CAPACITY + 1] = { 0 };
+
+        ls_string_init(&string);
+        fail_if(ls_string_len(&string) != 0, "New string should be empty");
+        fail_if(strcmp(ls_string_cstr(&string), "") != 0, "New string should be terminated");
+
+        /* Fill the inline storage exactly */
+        for (int i = 0; i < LS_STRING_INLINE_CAPACITY; i++) {
+                expected[i] = (char)('a' + i);
+                fail_if(!ls_string_append_char(&string, (char)('a' + i)), "Failed to append");
+        }
+        fail_if(ls_string_is_heap(&string), "Inline capacity string moved to the heap");
+        fail_if(strcmp(ls_string_cstr(&string), expected) != 0, "Incorrect inline contents");
+        fail_if(ls_string_len(&string) != LS_STRING_INLINE_CAPACITY, "Incorrect length");
+
+        ls_string_truncate(&string, 3);
+        fail_if(strcmp(ls_string_cstr(&string), "abc") != 0, "Incorrect truncation");
+        ls_string_truncate(&string, 10);
+        fail_if(ls_string_len(&string) != 3, "Truncate should never lengthen");
+
+        fail_if(!ls_string_set(&string, "assets"), "Failed to set");
+        fail_if(strcmp(ls_string_cstr(&string), "assets") != 0, "Incorrect contents after set");
+
+        ls_string_clear(&string);
+        fail_if(ls_string_len(&string) != 0, "Cleared string should be empty");
+}
+END_TEST
+
+START_TEST(test_string_growth)
+{
+        LsString string;
+        LsString copy;
+        const char *cstr = NULL;
+        char *stolen = NULL;
+
+        ls_string_init(&string);
+        ls_string_init(&copy);
+
+        fail_if(!ls_string_append(&string, "0123456789"), "Failed to append");
+        fail_if(!ls_string_append(&string, "0123456789"), "Failed to append");
+        fail_if(!ls_string_append(&string, "0123456789"), "Failed to append");
+        fail_if(!ls_string_is_heap(&string), "Overlong string should be on the heap");
+        fail_if(ls_string_len(&string) != 30, "Incorrect length");
+
+        /* Reserving up front means appends never move the storage */
+        fail_if(!ls_string_reserve(&string, 10000), "Failed to reserve");
+        cstr = ls_string_cstr(&string);
+        for (int i = 0; i < 997; i++) {
+                fail_if(!ls_string_append_len(&string, "0123456789", 10), "Failed to append");
+        }
+        fail_if(ls_string_cstr(&string) != cstr, "Reserved storage was reallocated");
+        fail_if(ls_string_len(&string) != 10000, "Incorrect length");
+        fail_if(strlen(ls_string_cstr(&string)) != 10000, "Length and terminator disagree");
+
+        /* Appending from our own storage must survive a reallocation */
+        ls_string_truncate(&string, 40);
+        fail_if(!ls_string_set(&copy, ls_string_cstr(&string)), "Failed to copy");
+        fail_if(!ls_string_append(&copy, ls_string_cstr(&copy)), "Failed to self append");
+        fail_if(ls_string_len(&copy) != 80, "Incorrect self append length");
+        fail_if(strncmp(ls_string_cstr(&copy), ls_string_cstr(&copy) + 40, 40) != 0,
+                "Incorrect self append contents");
+
+        stolen = ls_string_steal(&string);
+        fail_if(!stolen || strlen(stolen) != 40, "Failed to steal heap contents");
+        fail_if(ls_string_len(&string) != 0 || ls_string_is_heap(&string), "Steal did not reset");
+        free(stolen);
+
+        fail_if(!ls_string_append(&string, "short"), "Failed to append");
+        stolen = ls_string_steal(&string);
+        fail_if(!stolen || strcmp(stolen, "short") != 0, "Failed to steal inline contents");
+        free(stolen);
+
+        ls_string_clear(&string);
+        ls_string_clear(&copy);
+}
+END_TEST
+
+START_TEST(test_string_printf)
+{
+        LsString string;
+        char expected[256];
+
+        ls_string_init(&string);
+
+        fail_if(!ls_string_append_printf(&string, "%s/%d", "level", 3), "Failed to format");
+        fail_if(strcmp(ls_string_cstr(&string), "level/3") != 0, "Incorrect inline format");
+        fail_if(ls_string_is_heap(&string), "Short format moved to the heap");
+
+        /* Formatting past the spare capacity must retry into new storage */
+        fail_if(!ls_string_append_printf(&string, "/%s/%08x.%s", "textures", 0xbeef, "png"),
+                "Failed to format");
+        snprintf(expected, sizeof(expected), "level/3/textures/%08x.png", 0xbeef);
+        fail_if(strcmp(ls_string_cstr(&string), expected) != 0, "Incorrect heap format");
+        fail_if(ls_string_len(&string) != strlen(expected), "Incorrect length");
+
+        fail_if(!ls_string_append_printf(&string, "%s", ""), "Failed to format nothing");
+        fail_if(ls_string_len(&string) != strlen(expected), "Empty format changed length");
+
+        ls_string_clear(&string);
+}
+END_TEST
+
+START_TEST(test_string_hash)
+{
+        LsString a;
+        LsString b;
+        LsHashmap *map = NULL;
+        const char *path = "assets/levels/forest/terrain.mesh";
+
+        ls_string_init(&a);
+        ls_string_init(&b);
+
+        fail_if(!ls_string_append_printf(&a, "assets/%s/%s", "levels", "forest"), "Format failed");
+        fail_if(ls_string_hash(&a) != ls_hashmap_string_hash(ls_string_cstr(&a)),
+                "Hash differs from the map string hash");
+        fail_if(!ls_string_append(&a, "/terrain.mesh"), "Failed to append");
+        fail_if(ls_string_hash(&a) != ls_hashmap_string_hash(path), "Stale cached hash");
+
+        /* Non-ASCII bytes must hash the same way too */
+        fail_if(!ls_string_set(&b, "caf\xc3\xa9"), "Failed to set");
+        fail_if(ls_string_hash(&b) != ls_hashmap_string_hash("caf\xc3\xa9"),
+                "Hash differs for high bytes");
+
+        fail_if(ls_string_equal(&a, &b), "Different strings compare equal");
+        fail_if(!ls_string_set(&b, path), "Failed to set");
+        fail_if(!ls_string_equal(&a, &b), "Equal strings compare different");
+        ls_string_hash(&b);
+        fail_if(!ls_string_equal(&a, &b), "Equal hashed strings compare different");
+
+        /* The contents work directly as a string map key */
+        map = ls_hashmap_new(ls_hashmap_string_hash, ls_hashmap_string_equal);
+        fail_if(!map, "Failed to construct map");
+        fail_if(!ls_hashmap_put(map, (void *)path, &a), "Failed to put");
+        fail_if(ls_hashmap_get(map, (void *)ls_string_cstr(&b)) != &a, "Failed lookup");
+        ls_hashmap_free(map);
+
+        ls_string_clear(&a);
+        ls_string_clear(&b);
+}
+END_TEST
+
+static unsigned int test_n_hashes = 0;
+
+/**
+ * String hash that counts its calls, to prove a pre-hashed path skips it
+ */
+static uint32_t test_counting_hash(const void *v)
+{
+        ++test_n_hashes;
+        return ls_hashmap_string_hash(v);
+}
+
+START_TEST(test_string_prehashed_lookup)
+{
+        LsString names[200];
+        LsHashmap *map = NULL;
+        LsHashmap *seeded = NULL;
+
+        map = ls_hashmap_new(test_counting_hash, ls_hashmap_string_equal);
+        fail_if(!map, "Failed to construct map");
+
+        for (size_t i = 0; i < LS_ARRAY_SIZE(names); i++) {
+                ls_string_init(&names[i]);
+                fail_if(!ls_string_append_printf(&names[i], "entity/%zu/transform", i),
+                        "Format failed");
+                fail_if(!ls_hashmap_put_with_hash(map,
+                                                  (void *)ls_string_cstr(&names[i]),
+                                                  ls_string_hash(&names[i]),
+                                                  &names[i]),
+                        "Failed to put with hash");
+        }
+
+        /* Growing the map keeps the stored hashes, so nothing is rehashed */
+        for (size_t i = 0; i < LS_ARRAY_SIZE(names); i++) {
+                fail_if(ls_hashmap_get_with_hash(map,
+                                                 (void *)ls_string_cstr(&names[i]),
+                                                 ls_string_hash(&names[i])) != &names[i],
+                        "Failed pre-hashed lookup");
+        }
+        fail_if(test_n_hashes != 0, "Pre-hashed path called the hash function");
+
+        /* Ordinary lookups agree with pre-hashed puts */
+        fail_if(ls_hashmap_get(map, "entity/42/transform") != &names[42], "Failed lookup");
+        fail_if(test_n_hashes != 1, "Ordinary lookup did not hash");
+
+        /* Seeded maps can't be pre-hashed by the caller */
+        seeded = ls_hashmap_new_seeded(ls_hashmap_string_hash_seeded, ls_hashmap_string_equal);
+        fail_if(!seeded, "Failed to construct seeded map");
+        fail_if(ls_hashmap_put_with_hash(seeded,
+                                         (void *)ls_string_cstr(&names[0]),
+                                         ls_string_hash(&names[0]),
+                                         &names[0]),
+                "Seeded map accepted a caller hash");
+        fail_if(ls_hashmap_get_with_hash(seeded,
+                                         (void *)ls_string_cstr(&names[0]),
+                                         ls_string_hash(&names[0])) != NULL,
+                "Seeded map accepted a caller hash");
+
+        ls_hashmap_free(seeded);
+        ls_hashmap_free(map);
+        for (size_t i = 0; i < LS_ARRAY_SIZE(names); i++) {
+                ls_string_clear(&names[i]);
+        }
+}
+END_TEST
+
+/**
+ * Standard helper for running a test suite
+ */
+static int ls_test_run(Suite *suite)
+{
+        SRunner *runner = NULL;
+        int n_failed = 0;
+
+        runner = srunner_create(suite);
+        srunner_run_all(runner, CK_VERBOSE);
+        n_failed = srunner_ntests_failed(runner);
+        srunner_free(runner);
+
+        return n_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static Suite *test_create(void)
+{
+        Suite *s = NULL;
+        TCase *tc = NULL;
+
+        s = suite_create(__FILE__);
+        tc = tcase_create(__FILE__);
+        suite_add_tcase(s, tc);
+
+        tcase_add_test(tc, test_string_inline);
+        tcase_add_test(tc, test_string_growth);
+        tcase_add_test(tc, test_string_printf);
+        tcase_add_test(tc, test_string_hash);
+        tcase_add_test(tc, test_string_prehashed_lookup);
+        return s;
+}
+
+int main(__attribute__((unused)) int argc, __attribute__((unused)) char **argv)
+{
+        return ls_test_run(test_create());
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
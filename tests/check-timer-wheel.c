@@ -0,0 +1,250 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <check.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "macros.h"
+#include "timer-wheel.h"
+
+/**
+ * Object embedding its own timer
+ */
+typedef struct TestEntity {
+        int id;
+        unsigned int fired;
+        uint64_t fired_at;
+        uint64_t period;
+        LsTimer timer;
+} TestEntity;
+
+static LsTimerWheel *test_wheel = NULL;
+static int test_order[16];
+static size_t test_n_order = 0;
+
+static void test_timer_fire(LsTimer *timer)
+{
+        TestEntity *entity = ls_container_of(timer, TestEntity, timer);
+
+        entity->fired++;
+        entity->fired_at = ls_timer_wheel_now(test_wheel);
+        if (test_n_order < LS_ARRAY_SIZE(test_order)) {
+                test_order[test_n_order++] = entity->id;
+        }
+}
+
+static void test_timer_fire_periodic(LsTimer *timer)
+{
+        TestEntity *entity = ls_container_of(timer, TestEntity, timer);
+
+        test_timer_fire(timer);
+        ls_timer_wheel_schedule(test_wheel, timer, timer->expires + entity->period);
+}
+
+START_TEST(test_timer_wheel_simple)
+{
+        TestEntity entities[4] = { { .id = 0 }, { .id = 1 }, { .id = 2 }, { .id = 3 } };
+
+        test_wheel = ls_timer_wheel_new(1000);
+        test_n_order = 0;
+        fail_if(!test_wheel, "Failed to construct wheel");
+        fail_if(ls_timer_wheel_now(test_wheel) != 1000, "Wheel should start at 1000");
+
+        for (int i = 0; i < 4; i++) {
+                ls_timer_init(&entities[i].timer, test_timer_fire);
+                fail_if(ls_timer_is_pending(&entities[i].timer), "New timer should be idle");
+        }
+
+        fail_if(!ls_timer_wheel_schedule(test_wheel, &entities[0].timer, 1300), "Failed");
+        fail_if(!ls_timer_wheel_schedule(test_wheel, &entities[1].timer, 1005), "Failed");
+        fail_if(!ls_timer_wheel_schedule(test_wheel, &entities[2].timer, 1100), "Failed");
+        fail_if(!ls_timer_wheel_schedule(test_wheel, &entities[3].timer, 900), "Failed");
+        fail_if(ls_timer_wheel_count(test_wheel) != 4, "Should have 4 pending timers");
+
+        /* Moving an already pending timer doesn't count it twice */
+        fail_if(!ls_timer_wheel_schedule(test_wheel, &entities[2].timer, 1200), "Failed");
+        fail_if(ls_timer_wheel_count(test_wheel) != 4, "Reschedule should not add a timer");
+
+        ls_timer_wheel_cancel(test_wheel, &entities[0].timer);
+        ls_timer_wheel_cancel(test_wheel, &entities[0].timer);
+        fail_if(ls_timer_is_pending(&entities[0].timer), "Cancelled timer still pending");
+        fail_if(ls_timer_wheel_count(test_wheel) != 3, "Should have 3 pending timers");
+
+        /* Past deadlines fire on the very next tick */
+        fail_if(ls_timer_wheel_advance(test_wheel, 1001) != 1, "Past deadline should fire");
+        fail_if(entities[3].fired_at != 1001, "Past deadline fired late");
+
+        fail_if(ls_timer_wheel_advance(test_wheel, 2000) != 2, "Should fire two timers");
+        fail_if(entities[1].fired_at != 1005, "Timer fired at the wrong tick");
+        fail_if(entities[2].fired_at != 1200, "Moved timer fired at the wrong tick");
+        fail_if(entities[0].fired != 0, "Cancelled timer fired");
+        fail_if(test_n_order != 3 || test_order[1] != 1 || test_order[2] != 2, "Wrong order");
+        fail_if(ls_timer_wheel_count(test_wheel) != 0, "No timers should be pending");
+
+        ls_timer_wheel_free(test_wheel);
+}
+END_TEST
+
+START_TEST(test_timer_wheel_random)
+{
+        TestEntity *entities = NULL;
+        size_t n = 20000;
+        size_t fired = 0;
+        size_t cancelled = 0;
+        uint64_t now = 12345;
+
+        test_wheel = ls_timer_wheel_new(now);
+        entities = calloc(n, sizeof(TestEntity));
+        fail_if(!test_wheel || !entities, "Failed to allocate");
+
+        /* Deadlines land on every level */
+        srand(7);
+        for (size_t i = 0; i < n; i++) {
+                uint64_t delay = (uint64_t)rand() % (i % 2 ? 300 : 200000) + 1;
+                ls_timer_init(&entities[i].timer, test_timer_fire);
+                fail_if(!ls_timer_wheel_schedule(test_wheel, &entities[i].timer, now + delay),
+                        "Failed to schedule");
+        }
+        for (size_t i = 0; i < n; i += 7) {
+                ls_timer_wheel_cancel(test_wheel, &entities[i].timer);
+                ++cancelled;
+        }
+
+        /* Advance in uneven frames */
+        while (ls_timer_wheel_count(test_wheel) > 0) {
+                now += (uint64_t)rand() % 50;
+                fired += ls_timer_wheel_advance(test_wheel, now);
+        }
+        fail_if(fired != n - cancelled, "Every remaining timer should fire");
+
+        for (size_t i = 0; i < n; i++) {
+                if (i % 7 == 0) {
+                        fail_if(entities[i].fired != 0, "Cancelled timer fired");
+                        continue;
+                }
+                fail_if(entities[i].fired != 1, "Timer should fire exactly once");
+                fail_if(entities[i].fired_at != entities[i].timer.expires,
+                        "Timer fired at the wrong tick");
+        }
+
+        free(entities);
+        ls_timer_wheel_free(test_wheel);
+}
+END_TEST
+
+START_TEST(test_timer_wheel_periodic)
+{
+        TestEntity entity = { .id = 1, .period = 1000 };
+
+        test_wheel = ls_timer_wheel_new(0);
+        fail_if(!test_wheel, "Failed to construct wheel");
+
+        ls_timer_init(&entity.timer, test_timer_fire_periodic);
+        fail_if(!ls_timer_wheel_schedule(test_wheel, &entity.timer, 1000), "Failed to schedule");
+
+        fail_if(ls_timer_wheel_advance(test_wheel, 100000) != 100, "Should fire 100 times");
+        fail_if(entity.fired_at != 100000, "Last firing at the wrong tick");
+        fail_if(!ls_timer_is_pending(&entity.timer), "Periodic timer should be pending");
+
+        /* Freeing the wheel leaves the timer idle */
+        ls_timer_wheel_free(test_wheel);
+        fail_if(ls_timer_is_pending(&entity.timer), "Timer should be idle after free");
+}
+END_TEST
+
+START_TEST(test_timer_wheel_far)
+{
+        TestEntity near = { .id = 1 };
+        TestEntity far = { .id = 2 };
+        uint64_t deadline = (UINT64_C(1) << 27) + 5;
+
+        test_wheel = ls_timer_wheel_new(0);
+        fail_if(!test_wheel, "Failed to construct wheel");
+
+        /* Beyond the reach of every level */
+        ls_timer_init(&near.timer, test_timer_fire);
+        ls_timer_init(&far.timer, test_timer_fire);
+        fail_if(!ls_timer_wheel_schedule(test_wheel, &far.timer, deadline), "Failed");
+        fail_if(!ls_timer_wheel_schedule(test_wheel, &near.timer, 10), "Failed");
+
+        fail_if(ls_timer_wheel_advance(test_wheel, deadline - 1) != 1, "Only near should fire");
+        fail_if(far.fired != 0, "Far timer fired early");
+        fail_if(ls_timer_wheel_advance(test_wheel, deadline) != 1, "Far timer should fire");
+        fail_if(far.fired_at != deadline, "Far timer fired at the wrong tick");
+
+        ls_timer_wheel_free(test_wheel);
+}
+END_TEST
+
+/**
+ * Standard helper for running a test suite
+ */
+static int ls_test_run(Suite *suite)
+{
+        SRunner *runner = NULL;
+        int n_failed = 0;
+
+        runner = srunner_create(suite);
+        srunner_run_all(runner, CK_VERBOSE);
+        n_failed = srunner_ntests_failed(runner);
+        srunner_free(runner);
+
+        return n_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static Suite *test_create(void)
+{
+        Suite *s = NULL;
+        TCase *tc = NULL;
+
+        s = suite_create(__FILE__);
+        tc = tcase_create(__FILE__);
+        suite_add_tcase(s, tc);
+
+        tcase_add_test(tc, test_timer_wheel_simple);
+        tcase_add_test(tc, test_timer_wheel_random);
+        tcase_add_test(tc, test_timer_wheel_periodic);
+        tcase_add_test(tc, test_timer_wheel_far);
+        return s;
+}
+
+int main(__attribute__((unused)) int argc, __attribute__((unused)) char **argv)
+{
+        return ls_test_run(test_create());
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,236 @@
+/*
+ * This file is part of libls.
+ *
+ * Copyright (c) 2019 Lispy Snake, Ltd.
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define _GNU_SOURCE
+
+#include <check.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unrolled-list.h"
+
+/**
+ * Compare the list contents, via both iterator and index, against @expect
+ */
+static bool test_unrolled_list_matches(LsUnrolledList *list, const uintptr_t *expect, size_t n)
+{
+        LsUnrolledListIter iter = { 0 };
+        void *data = NULL;
+        size_t i = 0;
+
+        if (ls_unrolled_list_length(list) != n) {
+                return false;
+        }
+
+        ls_unrolled_list_iter_init(list, &iter);
+        while (ls_unrolled_list_iter_next(&iter, &data)) {
+                if (i >= n || (uintptr_t)data != expect[i]) {
+                        return false;
+                }
+                if ((uintptr_t)ls_unrolled_list_get(list, i) != expect[i]) {
+                        return false;
+                }
+                ++i;
+        }
+        return i == n;
+}
+
+START_TEST(test_unrolled_list_append)
+{
+        LsUnrolledList *list = NULL;
+        LsUnrolledListIter iter = { 0 };
+        uintptr_t expect[1000];
+        void *data = NULL;
+
+        list = ls_unrolled_list_new();
+        fail_if(!list, "Failed to construct list");
+        fail_if(ls_unrolled_list_length(list) != 0, "New list should be empty");
+
+        ls_unrolled_list_iter_init(list, &iter);
+        fail_if(ls_unrolled_list_iter_next(&iter, &data), "Empty list should not iterate");
+        fail_if(ls_unrolled_list_get(list, 0) != NULL, "Empty list should not return data");
+
+        for (uintptr_t i = 0; i < 1000; i++) {
+                fail_if(!ls_unrolled_list_append(list, (void *)(i + 1)), "Failed to append");
+                expect[i] = i + 1;
+        }
+        fail_if(!test_unrolled_list_matches(list, expect, 1000), "Appended list mismatch");
+        fail_if(ls_unrolled_list_get(list, 1000) != NULL, "Out of range get should fail");
+
+        fail_if(!ls_unrolled_list_prepend(list, (void *)0), "Failed to prepend");
+        fail_if(ls_unrolled_list_get(list, 0) != NULL, "Prepended item should be first");
+        fail_if((uintptr_t)ls_unrolled_list_get(list, 1) != 1, "Head should shift along");
+        fail_if(ls_unrolled_list_length(list) != 1001, "Length should include prepend");
+
+        ls_unrolled_list_free(list);
+}
+END_TEST
+
+START_TEST(test_unrolled_list_insert_remove)
+{
+        LsUnrolledList *list = NULL;
+        uintptr_t expect[64];
+        size_t n = 0;
+        void *data = NULL;
+
+        list = ls_unrolled_list_new();
+        fail_if(!list, "Failed to construct list");
+
+        fail_if(ls_unrolled_list_insert(list, 1, (void *)1), "Insert past the end should fail");
+        fail_if(ls_unrolled_list_remove(list, 0, &data), "Remove from empty list should fail");
+
+        /* Repeated inserts in the middle force node splits */
+        for (uintptr_t i = 0; i < 64; i++) {
+                size_t at = n / 2;
+                fail_if(!ls_unrolled_list_insert(list, at, (void *)(i + 1)), "Failed to insert");
+                memmove(&expect[at + 1], &expect[at], (n - at) * sizeof(uintptr_t));
+                expect[at] = i + 1;
+                ++n;
+        }
+        fail_if(!test_unrolled_list_matches(list, expect, n), "Inserted list mismatch");
+
+        /* Appending after splits must still land at the tail */
+        fail_if(!ls_unrolled_list_append(list, (void *)100), "Failed to append after split");
+        fail_if((uintptr_t)ls_unrolled_list_get(list, n) != 100, "Append should land at tail");
+        fail_if(!ls_unrolled_list_remove(list, n, &data), "Failed to remove tail");
+        fail_if((uintptr_t)data != 100, "Removed wrong tail item");
+
+        /* Drain from the front, which empties and merges nodes */
+        while (n > 0) {
+                fail_if(!ls_unrolled_list_remove(list, 0, &data), "Failed to remove head");
+                fail_if((uintptr_t)data != expect[0], "Removed wrong head item");
+                memmove(&expect[0], &expect[1], (n - 1) * sizeof(uintptr_t));
+                --n;
+                fail_if(!test_unrolled_list_matches(list, expect, n), "Drained list mismatch");
+        }
+
+        /* Empty again, so appends must rebuild head and tail */
+        fail_if(!ls_unrolled_list_append(list, (void *)7), "Failed to append to drained list");
+        fail_if((uintptr_t)ls_unrolled_list_get(list, 0) != 7, "Drained list append mismatch");
+
+        ls_unrolled_list_free(list);
+}
+END_TEST
+
+START_TEST(test_unrolled_list_random)
+{
+        LsUnrolledList *list = NULL;
+        uintptr_t *expect = NULL;
+        size_t n = 0;
+        void *data = NULL;
+
+        list = ls_unrolled_list_new();
+        expect = calloc(2000, sizeof(uintptr_t));
+        fail_if(!list || !expect, "Failed to allocate");
+
+        srand(42);
+        for (uintptr_t i = 0; i < 4000; i++) {
+                size_t at = n ? (size_t)rand() % (n + 1) : 0;
+
+                if (n < 2000 && (n == 0 || rand() % 3 != 0)) {
+                        fail_if(!ls_unrolled_list_insert(list, at, (void *)i), "Failed to insert");
+                        memmove(&expect[at + 1], &expect[at], (n - at) * sizeof(uintptr_t));
+                        expect[at] = i;
+                        ++n;
+                } else {
+                        at %= n;
+                        fail_if(!ls_unrolled_list_remove(list, at, &data), "Failed to remove");
+                        fail_if((uintptr_t)data != expect[at], "Removed wrong item");
+                        memmove(&expect[at], &expect[at + 1], (n - at - 1) * sizeof(uintptr_t));
+                        --n;
+                }
+        }
+        fail_if(!test_unrolled_list_matches(list, expect, n), "Random list mismatch");
+
+        free(expect);
+        ls_unrolled_list_free(list);
+}
+END_TEST
+
+START_TEST(test_unrolled_list_free_full)
+{
+        LsUnrolledList *list = NULL;
+
+        list = ls_unrolled_list_new();
+        fail_if(!list, "Failed to construct list");
+
+        for (int i = 0; i < 100; i++) {
+                fail_if(!ls_unrolled_list_append(list, strdup("unrolled")), "Failed to append");
+        }
+        fail_if(!ls_unrolled_list_insert(list, 50, NULL), "Failed to insert NULL");
+
+        /* ASAN will complain about any leaked strings */
+        ls_unrolled_list_free_full(list, free);
+}
+END_TEST
+
+/**
+ * Standard helper for running a test suite
+ */
+static int ls_test_run(Suite *suite)
+{
+        SRunner *runner = NULL;
+        int n_failed = 0;
+
+        runner = srunner_create(suite);
+        srunner_run_all(runner, CK_VERBOSE);
+        n_failed = srunner_ntests_failed(runner);
+        srunner_free(runner);
+
+        return n_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static Suite *test_create(void)
+{
+        Suite *s = NULL;
+        TCase *tc = NULL;
+
+        s = suite_create(__FILE__);
+        tc = tcase_create(__FILE__);
+        suite_add_tcase(s, tc);
+
+        tcase_add_test(tc, test_unrolled_list_append);
+        tcase_add_test(tc, test_unrolled_list_insert_remove);
+        tcase_add_test(tc, test_unrolled_list_random);
+        tcase_add_test(tc, test_unrolled_list_free_full);
+        return s;
+}
+
+int main(__attribute__((unused)) int argc, __attribute__((unused)) char **argv)
+{
+        return ls_test_run(test_create());
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 expandtab:
+ * :indentSize=8:tabSize=8:noTabs=true:
+ */